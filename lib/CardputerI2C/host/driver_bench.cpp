@@ -0,0 +1,111 @@
+/*
+ * Host check and bus-time comparison for the CardputerI2C drivers
+ *
+ * Build and run on a PC:
+ *   g++ -O2 -std=c++11 -I../src -o driver_bench driver_bench.cpp && ./driver_bench
+ *
+ * Runs the drivers against MockBus (100 kHz) and compares bus time with
+ * the per-register reads the sketches used before: Joystick2 X/Y burst,
+ * and Unit-Scroll LED write-combining while the encoder turns.
+ */
+
+#include <cstdio>
+
+#include "i2c_bus_mock.h"
+#include "joystick2.h"
+#include "unit_scroll.h"
+#include "card_keyboard.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                              \
+    do {                                                         \
+        if (!(cond)) {                                           \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                          \
+        }                                                        \
+    } while (0)
+
+static void clearOnRead(MockDevice& dev, uint8_t reg, void*) {
+    if (reg == UnitScroll::REG_INC_ENCODER || reg == UnitScroll::REG_INC_ENCODER + 1) dev.regs[reg] = 0;
+}
+
+int main() {
+    MockBus bus;
+    MockDevice* joy = bus.attach(Joystick2::DEFAULT_ADDR);
+    joy->regs[0x10] = 200;
+    joy->regs[0x11] = 30;
+    joy->regs[0x20] = 0;
+    MockDevice* scroll = bus.attach(UnitScroll::DEFAULT_ADDR);
+    scroll->regs[0x20] = 1;
+    scroll->onRead = clearOnRead;
+    MockDevice* kb = bus.attach(CardKeyBoard::DEFAULT_ADDR, true);
+
+    Joystick2 joystick(bus);
+    UnitScroll unit(bus);
+    CardKeyBoard keyboard(bus);
+    CHECK(joystick.begin() && unit.begin() && keyboard.begin());
+    CHECK(!Joystick2(bus, 0x10).begin());
+
+    // Joystick2: burst vs three single-register reads
+    const int READS = 1000;
+    Joystick2State s = {0, 0, false};
+    uint64_t t0 = bus.nowUs();
+    for (int i = 0; i < READS; i++) CHECK(joystick.read(&s));
+    uint64_t burstUs = bus.nowUs() - t0;
+    CHECK(s.x == 200 && s.y == 30 && s.pressed);
+
+    t0 = bus.nowUs();
+    I2CTiming t = Joystick2::defaultTiming();
+    for (int i = 0; i < READS; i++) {
+        uint8_t v;
+        bus.readRegs(Joystick2::DEFAULT_ADDR, 0x10, &v, 1, t);
+        bus.readRegs(Joystick2::DEFAULT_ADDR, 0x11, &v, 1, t);
+        bus.readRegs(Joystick2::DEFAULT_ADDR, 0x20, &v, 1, t);
+    }
+    uint64_t singleUs = bus.nowUs() - t0;
+    printf("Joystick2 x%d: burst %llu us, per register %llu us (%.0f%%)\n", READS,
+           (unsigned long long)burstUs, (unsigned long long)singleUs, 100.0 * burstUs / singleUs);
+
+    // Unit-Scroll: increment clears on read, button, LED combining
+    scroll->regs[0x50] = 0xFD;  // -3
+    scroll->regs[0x51] = 0xFF;
+    int16_t inc = 0;
+    CHECK(unit.readIncrement(&inc) && inc == -3);
+    CHECK(unit.readIncrement(&inc) && inc == 0);
+    bool pressed = true;
+    CHECK(unit.readButton(&pressed) && !pressed);
+
+    // 100 encoder steps, color follows the direction (changes 3 times),
+    // one flush per poll
+    t0 = bus.nowUs();
+    for (int i = 0; i < 100; i++) {
+        unit.setLed(i < 30 ? 0x00FF00 : i < 60 ? 0xFF0000 : i < 90 ? 0x00FF00 : 0x000000);
+        unit.flushLed();
+    }
+    uint64_t combinedUs = bus.nowUs() - t0;
+    CHECK(unit.ledWrites() == 4 && unit.ledSkipped() == 96);
+    CHECK(scroll->regs[0x31] == 0 && scroll->regs[0x32] == 0 && scroll->regs[0x33] == 0);
+    printf("Unit-Scroll LED x100: %u writes, %llu us (every step: ~%llu us)\n",
+           (unsigned)unit.ledWrites(), (unsigned long long)combinedUs,
+           (unsigned long long)(combinedUs / unit.ledWrites() * 100));
+
+    // A failed write is retried on the next flush
+    unit.setLed(0x123456);
+    bus.failNext(1);
+    CHECK(!unit.flushLed());
+    CHECK(unit.flushLed() && scroll->regs[0x31] == 0x12 && scroll->regs[0x33] == 0x56);
+
+    // CardKeyBoard: queued keys, then 0
+    kb->pushRaw('a');
+    kb->pushRaw(0x0D);
+    uint8_t key = 0;
+    CHECK(keyboard.readKey(&key) && key == 'a');
+    CHECK(keyboard.readKey(&key) && key == 0x0D);
+    CHECK(keyboard.readKey(&key) && key == 0);
+
+    printf("bus: %u transactions, %u errors\n", (unsigned)bus.stats().transactions,
+           (unsigned)bus.stats().errors);
+    printf(failures ? "%d check(s) FAILED\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
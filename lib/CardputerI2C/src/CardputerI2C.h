@@ -0,0 +1,18 @@
+/*
+ * CardputerI2C - shared I2C device drivers for the Cardputer sketches
+ *
+ * Buses:   WireBus (Wire / Wire1), PaHubChannel (behind a PA Hub),
+ *          MockBus (host, include i2c_bus_mock.h directly)
+ * Devices: Joystick2, UnitScroll, CardKeyBoard
+ */
+
+#pragma once
+
+#include "i2c_bus.h"
+#if defined(ARDUINO)
+#include "i2c_bus_wire.h"
+#endif
+#include "pahub.h"
+#include "joystick2.h"
+#include "unit_scroll.h"
+#include "card_keyboard.h"
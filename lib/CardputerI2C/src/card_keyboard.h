@@ -0,0 +1,49 @@
+/*
+ * M5Stack CardKeyBoard (0x5F)
+ *
+ * No registers: every 1-byte read returns the next key code, 0 when no
+ * key is waiting. See docs/CARDKEYBOARD_KEYCODES.md for the codes.
+ */
+
+#pragma once
+
+#include "i2c_bus.h"
+
+class CardKeyBoard {
+public:
+    static constexpr uint8_t DEFAULT_ADDR = 0x5F;
+
+    // The sketches waited 500 us after each read before the next
+    // transaction; keep that spacing
+    static I2CTiming defaultTiming() {
+        I2CTiming t = {0, 500, 0, false};
+        return t;
+    }
+
+    CardKeyBoard(I2CBus& bus, uint8_t addr = DEFAULT_ADDR)
+        : _bus(bus), _addr(addr), _timing(defaultTiming()) {}
+
+    void setTiming(const I2CTiming& t) { _timing = t; }
+
+    // Presence = a successful read (as the sketches have always
+    // detected it); a key pressed at that moment is dropped
+    bool begin() {
+        uint8_t key;
+        return readKey(&key);
+    }
+
+    // true = the read worked; *key is 0 when no key is waiting
+    bool readKey(uint8_t* key) {
+        uint8_t k = 0;
+        if (!_bus.readRaw(_addr, &k, 1, _timing)) return false;
+        *key = (k == 0xFF) ? 0 : k;
+        return true;
+    }
+
+    uint8_t address() const { return _addr; }
+
+private:
+    I2CBus& _bus;
+    uint8_t _addr;
+    I2CTiming _timing;
+};
@@ -0,0 +1,93 @@
+/*
+ * Pluggable I2C bus for the Cardputer device drivers
+ *
+ * Drivers only talk to this interface, so the same driver runs on
+ * Wire / Wire1 (WireBus), behind a PA Hub channel (PaHubChannel) or
+ * against a host mock (MockBus) without changes.
+ *
+ * A backend implements three primitives: write bytes (with or without
+ * STOP), read bytes, and wait. Register access, timing quirks and the
+ * transaction counters are built on top of them here, once.
+ *
+ * No Arduino dependency: this header also compiles on a PC.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Per-device timing quirks (data, not code). Slow MCU firmware (the
+// STM32F030 on the Unit-Scroll) needs time between the register write
+// and the read; others need none.
+struct I2CTiming {
+    uint16_t writeReadGapUs;  // After the register write, before the read
+    uint16_t afterReadUs;     // After a read, before the next transaction
+    uint16_t afterWriteUs;    // After a plain register write
+    bool repeatedStart;       // Register write ends with repeated start (no STOP)
+};
+
+class I2CBus {
+public:
+    static constexpr size_t MAX_WRITE = 16;  // Register + data bytes per write
+
+    struct Stats {
+        uint32_t transactions;  // Bus transactions (each write and each read)
+        uint32_t errors;
+        uint32_t bytes;
+    };
+
+    I2CBus() { resetStats(); }
+    virtual ~I2CBus() {}
+
+    // Backend primitives
+    virtual bool write(uint8_t addr, const uint8_t* data, size_t len, bool stop = true) = 0;
+    virtual size_t read(uint8_t addr, uint8_t* buf, size_t len) = 0;
+    virtual void delayUs(uint32_t us) = 0;
+
+    // Address-only write: does anything answer at addr?
+    virtual bool probe(uint8_t addr) {
+        return count(write(addr, nullptr, 0, true), 0);
+    }
+
+    // Read len consecutive registers starting at reg in one transaction
+    // (the device must auto-increment its register pointer)
+    bool readRegs(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len, const I2CTiming& t) {
+        if (!count(write(addr, &reg, 1, !t.repeatedStart), 1)) return false;
+        if (t.writeReadGapUs) delayUs(t.writeReadGapUs);
+        bool ok = count(read(addr, buf, len) == len, len);
+        if (t.afterReadUs) delayUs(t.afterReadUs);
+        return ok;
+    }
+
+    bool writeRegs(uint8_t addr, uint8_t reg, const uint8_t* data, size_t len, const I2CTiming& t) {
+        if (len + 1 > MAX_WRITE) return false;
+        uint8_t buf[MAX_WRITE];
+        buf[0] = reg;
+        memcpy(buf + 1, data, len);
+        bool ok = count(write(addr, buf, len + 1, true), len + 1);
+        if (t.afterWriteUs) delayUs(t.afterWriteUs);
+        return ok;
+    }
+
+    // Plain read without a register (CardKeyBoard)
+    bool readRaw(uint8_t addr, uint8_t* buf, size_t len, const I2CTiming& t) {
+        bool ok = count(read(addr, buf, len) == len, len);
+        if (t.afterReadUs) delayUs(t.afterReadUs);
+        return ok;
+    }
+
+    const Stats& stats() const { return _stats; }
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+protected:
+    bool count(bool ok, size_t bytes) {
+        _stats.transactions++;
+        if (ok) _stats.bytes += bytes;
+        else _stats.errors++;
+        return ok;
+    }
+
+    Stats _stats;
+};
@@ -0,0 +1,119 @@
+/*
+ * Host mock I2CBus: register-file devices and a simulated clock
+ *
+ * Each attached device is 256 registers with an auto-incrementing
+ * pointer (a write sets the pointer, then stores data; a read returns
+ * data from the pointer on). A device can instead be "raw" (reads pop
+ * from a byte queue, like the CardKeyBoard), and an onRead hook can
+ * model clear-on-read registers such as the Unit-Scroll's incremental
+ * encoder.
+ *
+ * The clock advances by the wire time of every transaction (9 bits per
+ * byte plus start/stop at the configured speed) and by delayUs(), so
+ * host code can compare bus time between driver versions.
+ */
+
+#pragma once
+
+#include "i2c_bus.h"
+
+struct MockDevice {
+    uint8_t addr;
+    uint8_t regs[256];
+    uint8_t ptr;
+    bool raw;             // No register pointer: reads pop rawQueue
+    uint8_t rawQueue[32];
+    uint8_t rawHead, rawTail;
+    bool autoIncrement;   // false: the pointer stays on the register
+    // Called after reg was read (clear-on-read registers)
+    void (*onRead)(MockDevice& dev, uint8_t reg, void* ctx);
+    void* ctx;
+
+    void pushRaw(uint8_t b) {
+        uint8_t next = (uint8_t)((rawTail + 1) % sizeof(rawQueue));
+        if (next != rawHead) {
+            rawQueue[rawTail] = b;
+            rawTail = next;
+        }
+    }
+};
+
+class MockBus : public I2CBus {
+public:
+    static constexpr int MAX_DEVICES = 8;
+
+    explicit MockBus(uint32_t hz = 100000) : _hz(hz), _count(0), _nowUs(0), _failNext(0) {}
+
+    MockDevice* attach(uint8_t addr, bool raw = false) {
+        if (_count >= MAX_DEVICES) return nullptr;
+        MockDevice& d = _devs[_count++];
+        memset(&d, 0, sizeof(d));
+        d.addr = addr;
+        d.raw = raw;
+        d.autoIncrement = true;
+        return &d;
+    }
+
+    MockDevice* find(uint8_t addr) {
+        for (int i = 0; i < _count; i++) {
+            if (_devs[i].addr == addr) return &_devs[i];
+        }
+        return nullptr;
+    }
+
+    bool write(uint8_t addr, const uint8_t* data, size_t len, bool stop = true) override {
+        (void)stop;
+        advance(len + 1);
+        MockDevice* d = find(addr);
+        if (!d || fail()) return false;
+        if (d->raw || len == 0) return true;
+        d->ptr = data[0];
+        for (size_t i = 1; i < len; i++) d->regs[d->ptr++] = data[i];
+        if (len > 1) d->ptr = data[0];
+        return true;
+    }
+
+    size_t read(uint8_t addr, uint8_t* buf, size_t len) override {
+        advance(len + 1);
+        MockDevice* d = find(addr);
+        if (!d || fail()) return 0;
+        for (size_t i = 0; i < len; i++) {
+            if (d->raw) {
+                if (d->rawHead == d->rawTail) {
+                    buf[i] = 0;
+                } else {
+                    buf[i] = d->rawQueue[d->rawHead];
+                    d->rawHead = (uint8_t)((d->rawHead + 1) % sizeof(d->rawQueue));
+                }
+                continue;
+            }
+            uint8_t reg = d->autoIncrement ? (uint8_t)(d->ptr + i) : d->ptr;
+            buf[i] = d->regs[reg];
+            if (d->onRead) d->onRead(*d, reg, d->ctx);
+        }
+        return len;
+    }
+
+    void delayUs(uint32_t us) override { _nowUs += us; }
+
+    // Fail the next n transactions (NACK)
+    void failNext(int n) { _failNext = n; }
+
+    uint64_t nowUs() const { return _nowUs; }
+
+private:
+    // Address byte + data bytes, 9 clocks each, plus start and stop
+    void advance(size_t bytes) { _nowUs += ((uint64_t)bytes * 9 + 2) * 1000000ULL / _hz; }
+
+    bool fail() {
+        if (_failNext <= 0) return false;
+        _failNext--;
+        return true;
+    }
+
+    uint32_t _hz;
+    MockDevice _devs[MAX_DEVICES];
+    int _count;
+    uint64_t _nowUs;
+    int _failNext;
+};
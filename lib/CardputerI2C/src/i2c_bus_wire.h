@@ -0,0 +1,37 @@
+/*
+ * I2CBus backend on an Arduino TwoWire (Wire or Wire1)
+ *
+ * The TwoWire must already be started (begin(sda, scl, hz)) by the
+ * sketch; pins and speed stay the sketch's business.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "i2c_bus.h"
+
+class WireBus : public I2CBus {
+public:
+    explicit WireBus(TwoWire& wire) : _wire(wire) {}
+
+    bool write(uint8_t addr, const uint8_t* data, size_t len, bool stop = true) override {
+        _wire.beginTransmission(addr);
+        if (len) _wire.write(data, len);
+        return _wire.endTransmission(stop) == 0;
+    }
+
+    size_t read(uint8_t addr, uint8_t* buf, size_t len) override {
+        size_t got = _wire.requestFrom(addr, (uint8_t)len);
+        size_t n = 0;
+        while (n < got && n < len && _wire.available()) buf[n++] = _wire.read();
+        return n;
+    }
+
+    void delayUs(uint32_t us) override { delayMicroseconds(us); }
+
+    TwoWire& wire() { return _wire; }
+
+private:
+    TwoWire& _wire;
+};
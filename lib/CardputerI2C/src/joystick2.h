@@ -0,0 +1,62 @@
+/*
+ * M5Stack Joystick2 Unit (0x63)
+ *
+ * X and Y 8-bit ADC values sit in consecutive registers (0x10, 0x11),
+ * so they come in one 2-byte burst; the button is a separate register.
+ * Two transactions per read instead of three.
+ */
+
+#pragma once
+
+#include "i2c_bus.h"
+
+struct Joystick2State {
+    uint8_t x;       // 0-255, center ~127
+    uint8_t y;       // 0-255, center ~127
+    bool pressed;
+};
+
+class Joystick2 {
+public:
+    static constexpr uint8_t DEFAULT_ADDR = 0x63;
+    static constexpr uint8_t REG_ADC_X_8 = 0x10;  // X, then Y at 0x11
+    static constexpr uint8_t REG_BUTTON = 0x20;   // 0 = pressed
+
+    static I2CTiming defaultTiming() {
+        I2CTiming t = {0, 0, 0, true};
+        return t;
+    }
+
+    Joystick2(I2CBus& bus, uint8_t addr = DEFAULT_ADDR)
+        : _bus(bus), _addr(addr), _timing(defaultTiming()) {}
+
+    void setTiming(const I2CTiming& t) { _timing = t; }
+
+    bool begin() { return _bus.probe(_addr); }
+
+    bool readXY(uint8_t* x, uint8_t* y) {
+        uint8_t xy[2];
+        if (!_bus.readRegs(_addr, REG_ADC_X_8, xy, 2, _timing)) return false;
+        *x = xy[0];
+        *y = xy[1];
+        return true;
+    }
+
+    bool readButton(bool* pressed) {
+        uint8_t btn;
+        if (!_bus.readRegs(_addr, REG_BUTTON, &btn, 1, _timing)) return false;
+        *pressed = (btn == 0);
+        return true;
+    }
+
+    bool read(Joystick2State* s) {
+        return readXY(&s->x, &s->y) && readButton(&s->pressed);
+    }
+
+    uint8_t address() const { return _addr; }
+
+private:
+    I2CBus& _bus;
+    uint8_t _addr;
+    I2CTiming _timing;
+};
@@ -0,0 +1,135 @@
+/*
+ * PA Hub (PCA9548A) channel switching as an I2CBus backend
+ *
+ * PaHub owns the hub on a parent bus and remembers which channels are
+ * enabled. PaHubChannel is an I2CBus view of one channel: every access
+ * selects the channel first (nothing is written when it is already
+ * enabled), so a driver behind the hub is the same as one on Wire.
+ *
+ * Address map: record what was found on each channel with
+ * setChannelAddress(), then buildMap(). Channels whose address is unique
+ * form a shared set that is enabled in every mask; channels whose
+ * address collides (two Unit-Scrolls at 0x40) get the shared set plus
+ * only themselves. Every mask written is collision-free, so an enabled
+ * channel is always reachable as it is.
+ */
+
+#pragma once
+
+#include "i2c_bus.h"
+
+class PaHub {
+public:
+    static constexpr uint8_t DEFAULT_ADDR = 0x70;
+    static constexpr int CHANNELS = 6;  // PaHub v2.1 uses channels 0-5
+    static constexpr uint8_t ANY = 0xFF;  // Group of channels in the shared set
+
+    PaHub(I2CBus& parent, uint8_t addr = DEFAULT_ADDR, uint16_t settleUs = 500)
+        : _parent(parent), _addr(addr), _settleUs(settleUs), _current(0), _shared(0),
+          _multi(true), _switches(0) {
+        memset(_chAddr, 0, sizeof(_chAddr));
+        memset(_mask, 0, sizeof(_mask));
+    }
+
+    bool probe() { return _parent.write(_addr, nullptr, 0, true); }
+
+    // Disable all channels and forget the map
+    bool reset() {
+        memset(_chAddr, 0, sizeof(_chAddr));
+        memset(_mask, 0, sizeof(_mask));
+        _shared = 0;
+        return writeMask(0);
+    }
+
+    bool select(uint8_t channel) {
+        if (channel >= CHANNELS) return false;
+        if (_current & (1 << channel)) return true;
+        uint8_t mask = _multi && _mask[channel] ? _mask[channel] : (uint8_t)(1 << channel);
+        return writeMask(mask);
+    }
+
+    // Address map (see top of file)
+    void setChannelAddress(uint8_t channel, uint8_t addr) {
+        if (channel < CHANNELS) _chAddr[channel] = addr;
+    }
+
+    void buildMap() {
+        _shared = 0;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            uint8_t addr = _chAddr[ch];
+            if (addr == 0 || addr == _addr) continue;
+            bool unique = true;
+            for (int other = 0; other < CHANNELS; other++) {
+                if (other != ch && _chAddr[other] == addr) unique = false;
+            }
+            if (unique) _shared |= 1 << ch;
+        }
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            _mask[ch] = _chAddr[ch] ? (uint8_t)(_shared | (1 << ch)) : (uint8_t)(1 << ch);
+        }
+        _current = 0;  // Next select writes a map mask
+    }
+
+    // false = one channel at a time (1 << channel), as without a map
+    void setMultiChannel(bool on) { _multi = on; _current = 0; }
+    bool multiChannel() const { return _multi; }
+
+    // Channels that share a selection: ANY for the shared set
+    uint8_t groupFor(uint8_t channel) const {
+        return (_multi && (_shared & (1 << channel))) ? ANY : channel;
+    }
+
+    uint8_t sharedMask() const { return _shared; }
+    uint8_t maskFor(uint8_t channel) const { return channel < CHANNELS ? _mask[channel] : 0; }
+    uint8_t currentMask() const { return _current; }
+    uint32_t switches() const { return _switches; }
+
+    // Another master (or code) wrote the hub: rewrite on the next select
+    void invalidate() { _current = 0; }
+
+    I2CBus& parent() { return _parent; }
+
+private:
+    bool writeMask(uint8_t mask) {
+        _switches++;
+        if (_parent.write(_addr, &mask, 1, true)) {
+            _current = mask;
+            if (_settleUs) _parent.delayUs(_settleUs);
+            return true;
+        }
+        _current = 0;  // Unknown state: rewrite on the next select
+        return false;
+    }
+
+    I2CBus& _parent;
+    uint8_t _addr;
+    uint16_t _settleUs;
+    uint8_t _current;  // Channels enabled right now
+    uint8_t _shared;   // Channels with a unique address
+    bool _multi;
+    uint32_t _switches;
+    uint8_t _chAddr[CHANNELS];  // Device found on each channel, 0 = none
+    uint8_t _mask[CHANNELS];    // Mask written to reach each channel
+};
+
+class PaHubChannel : public I2CBus {
+public:
+    PaHubChannel(PaHub& hub, uint8_t channel) : _hub(hub), _channel(channel) {}
+
+    bool write(uint8_t addr, const uint8_t* data, size_t len, bool stop = true) override {
+        return _hub.select(_channel) && _hub.parent().write(addr, data, len, stop);
+    }
+
+    size_t read(uint8_t addr, uint8_t* buf, size_t len) override {
+        return _hub.select(_channel) ? _hub.parent().read(addr, buf, len) : 0;
+    }
+
+    void delayUs(uint32_t us) override { _hub.parent().delayUs(us); }
+
+    uint8_t channel() const { return _channel; }
+    PaHub& hub() { return _hub; }
+
+private:
+    PaHub& _hub;
+    uint8_t _channel;
+};
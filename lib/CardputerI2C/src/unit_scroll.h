@@ -0,0 +1,103 @@
+/*
+ * M5Stack Unit-Scroll (0x40, STM32F030 firmware)
+ *
+ * The firmware needs time between the register write and the read
+ * (500 us) and after the read (300 us) - kept as timing data, so a
+ * sketch that runs a faster firmware can shorten it in one place.
+ *
+ * LED writes are combined: setLed() only records the color, flushLed()
+ * writes it if it differs from what the LED already shows. A sketch
+ * that recolors on every encoder step ends up with one write per flush,
+ * and none at all while the color stays the same.
+ */
+
+#pragma once
+
+#include "i2c_bus.h"
+
+class UnitScroll {
+public:
+    static constexpr uint8_t DEFAULT_ADDR = 0x40;
+    static constexpr uint8_t REG_ENCODER = 0x10;      // Absolute, 16-bit little-endian
+    static constexpr uint8_t REG_BUTTON = 0x20;       // 0 = pressed
+    static constexpr uint8_t REG_RGB = 0x31;          // R, G, B (0x30 is unused)
+    static constexpr uint8_t REG_RESET = 0x40;        // Write 1: reset the encoder
+    static constexpr uint8_t REG_INC_ENCODER = 0x50;  // 16-bit, cleared by reading
+
+    static I2CTiming defaultTiming() {
+        I2CTiming t = {500, 300, 0, true};
+        return t;
+    }
+
+    UnitScroll(I2CBus& bus, uint8_t addr = DEFAULT_ADDR)
+        : _bus(bus), _addr(addr), _timing(defaultTiming()),
+          _ledPending(0), _ledShown(0), _ledKnown(false), _ledWrites(0), _ledSkipped(0) {}
+
+    void setTiming(const I2CTiming& t) { _timing = t; }
+
+    bool begin() { return _bus.probe(_addr); }
+
+    bool readButton(bool* pressed) {
+        uint8_t btn;
+        if (!_bus.readRegs(_addr, REG_BUTTON, &btn, 1, _timing)) return false;
+        *pressed = (btn == 0);
+        return true;
+    }
+
+    bool readEncoder(int16_t* value) { return read16(REG_ENCODER, value); }
+
+    // Detents since the previous call (the register clears on read)
+    bool readIncrement(int16_t* increment) { return read16(REG_INC_ENCODER, increment); }
+
+    bool resetEncoder() {
+        uint8_t one = 1;
+        return _bus.writeRegs(_addr, REG_RESET, &one, 1, _timing);
+    }
+
+    // Record a 0xRRGGBB color; written by flushLed()
+    void setLed(uint32_t rgb) { _ledPending = rgb & 0xFFFFFF; }
+
+    // Write the pending color if the LED doesn't show it yet
+    bool flushLed() {
+        if (_ledKnown && _ledPending == _ledShown) {
+            _ledSkipped++;
+            return true;
+        }
+        uint8_t rgb[3] = {(uint8_t)(_ledPending >> 16), (uint8_t)(_ledPending >> 8),
+                          (uint8_t)_ledPending};
+        if (!_bus.writeRegs(_addr, REG_RGB, rgb, 3, _timing)) {
+            _ledKnown = false;  // Retry on the next flush
+            return false;
+        }
+        _ledShown = _ledPending;
+        _ledKnown = true;
+        _ledWrites++;
+        return true;
+    }
+
+    bool setLedNow(uint32_t rgb) {
+        setLed(rgb);
+        return flushLed();
+    }
+
+    uint32_t ledWrites() const { return _ledWrites; }
+    uint32_t ledSkipped() const { return _ledSkipped; }
+    uint8_t address() const { return _addr; }
+
+private:
+    bool read16(uint8_t reg, int16_t* value) {
+        uint8_t b[2];
+        if (!_bus.readRegs(_addr, reg, b, 2, _timing)) return false;
+        *value = (int16_t)(b[0] | (b[1] << 8));  // little-endian
+        return true;
+    }
+
+    I2CBus& _bus;
+    uint8_t _addr;
+    I2CTiming _timing;
+    uint32_t _ledPending;  // Color asked for
+    uint32_t _ledShown;    // Color last written
+    bool _ledKnown;        // _ledShown is what the LED shows
+    uint32_t _ledWrites;
+    uint32_t _ledSkipped;  // Flushes with nothing to write
+};
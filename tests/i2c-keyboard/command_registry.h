@@ -0,0 +1,231 @@
+/*
+ * Terminal command registry with a compile-time perfect hash
+ *
+ * Commands are listed once in a constexpr CommandDef table. The compiler
+ * searches for a hash seed that maps every name to its own slot of a
+ * power-of-two table (static_assert fails on duplicate names), and
+ * builds the slot -> command index table at compile time.
+ *
+ * Dispatch hashes the command token in place (case-insensitive, no
+ * copies), does one slot lookup and one name compare. Arguments are
+ * passed as a StrView into the input line, so nothing is allocated
+ * until a handler decides to.
+ *
+ * Written for C++11 constexpr (single-return functions) so it builds
+ * with the gnu++11 Arduino-ESP32 toolchains as well as newer ones.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+// ============================================
+// StrView - non-owning view into a char buffer
+// ============================================
+
+struct StrView {
+    const char* ptr;
+    uint16_t len;
+
+    StrView() : ptr(""), len(0) {}
+    StrView(const char* p, size_t n) : ptr(p), len((uint16_t)n) {}
+    explicit StrView(const char* s) : ptr(s), len((uint16_t)strlen(s)) {}
+
+    bool empty() const { return len == 0; }
+    char operator[](int i) const { return ptr[i]; }
+
+    static char lower(char c) { return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c; }
+
+    bool equalsIgnoreCase(const char* s) const {
+        for (int i = 0; i < len; i++) {
+            if (s[i] == '\0' || lower(ptr[i]) != lower(s[i])) return false;
+        }
+        return s[len] == '\0';
+    }
+
+    StrView trim() const {
+        int start = 0, end = len;
+        while (start < end && isspace((unsigned char)ptr[start])) start++;
+        while (end > start && isspace((unsigned char)ptr[end - 1])) end--;
+        return StrView(ptr + start, end - start);
+    }
+
+    // count < 0 = to the end
+    StrView sub(int start, int count = -1) const {
+        if (start < 0) start = 0;
+        if (start > len) start = len;
+        int avail = len - start;
+        if (count < 0 || count > avail) count = avail;
+        return StrView(ptr + start, count);
+    }
+
+    int indexOf(char c) const {
+        for (int i = 0; i < len; i++) {
+            if (ptr[i] == c) return i;
+        }
+        return -1;
+    }
+
+    int lastIndexOf(char c) const {
+        for (int i = len - 1; i >= 0; i--) {
+            if (ptr[i] == c) return i;
+        }
+        return -1;
+    }
+
+    bool startsWith(char c) const { return len > 0 && ptr[0] == c; }
+    bool endsWith(char c) const { return len > 0 && ptr[len - 1] == c; }
+
+    // Decimal integer (leading sign allowed); 0 if not a number
+    long toInt() const {
+        int i = 0;
+        bool neg = false;
+        if (i < len && (ptr[i] == '-' || ptr[i] == '+')) neg = (ptr[i++] == '-');
+        long v = 0;
+        for (; i < len && ptr[i] >= '0' && ptr[i] <= '9'; i++) {
+            v = v * 10 + (ptr[i] - '0');
+        }
+        return neg ? -v : v;
+    }
+
+    // Copy into a String (for the output buffer)
+    String toString() const {
+        String s;
+        s.reserve(len);
+        for (int i = 0; i < len; i++) s += ptr[i];
+        return s;
+    }
+};
+
+// ============================================
+// Command table
+// ============================================
+
+typedef void (*CommandHandler)(StrView args);
+
+struct CommandDef {
+    const char* name;     // Lowercase; matched case-insensitively
+    CommandHandler handler;
+    const char* help;
+};
+
+namespace cmdhash {
+
+constexpr uint32_t NO_SEED = 0xFFFFFFFF;
+constexpr uint32_t MAX_SEED = 256;
+constexpr uint8_t EMPTY = 0xFF;
+
+constexpr char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// FNV-1a over lowercase bytes, seeded through the offset basis
+constexpr uint32_t fnv(const char* s, uint32_t h) {
+    return *s ? fnv(s + 1, (h ^ (uint8_t)lower(*s)) * 16777619u) : h;
+}
+
+constexpr uint32_t fold(uint32_t h, uint32_t mask) {
+    return (h ^ (h >> 15)) & mask;
+}
+
+constexpr uint32_t slotOf(const char* name, uint32_t seed, uint32_t mask) {
+    return fold(fnv(name, 2166136261u ^ (seed * 0x9E3779B9u)), mask);
+}
+
+// Runtime version for a token that is not NUL-terminated
+inline uint32_t slotOf(StrView name, uint32_t seed, uint32_t mask) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (int i = 0; i < name.len; i++) {
+        h = (h ^ (uint8_t)lower(name.ptr[i])) * 16777619u;
+    }
+    return fold(h, mask);
+}
+
+// Smallest power of two >= 4 * n (load factor <= 1/4 keeps the seed search short)
+constexpr size_t slotsFor(size_t n, size_t s = 4) {
+    return s >= 4 * n ? s : slotsFor(n, s * 2);
+}
+
+template <size_t N>
+constexpr bool clashFrom(const CommandDef (&t)[N], size_t i, size_t j, uint32_t seed, uint32_t mask) {
+    return j >= N ? false
+         : (slotOf(t[i].name, seed, mask) == slotOf(t[j].name, seed, mask)
+            || clashFrom(t, i, j + 1, seed, mask));
+}
+
+template <size_t N>
+constexpr bool anyClash(const CommandDef (&t)[N], size_t i, uint32_t seed, uint32_t mask) {
+    return i >= N ? false
+         : (clashFrom(t, i, i + 1, seed, mask) || anyClash(t, i + 1, seed, mask));
+}
+
+template <size_t N>
+constexpr uint32_t findSeed(const CommandDef (&t)[N], uint32_t mask, uint32_t seed = 0) {
+    return seed >= MAX_SEED ? NO_SEED
+         : (!anyClash(t, 0, seed, mask) ? seed : findSeed(t, mask, seed + 1));
+}
+
+template <size_t N>
+constexpr uint8_t indexForSlot(const CommandDef (&t)[N], uint32_t slot, uint32_t seed,
+                               uint32_t mask, size_t i = 0) {
+    return i >= N ? EMPTY
+         : (slotOf(t[i].name, seed, mask) == slot ? (uint8_t)i
+            : indexForSlot(t, slot, seed, mask, i + 1));
+}
+
+// C++11 stand-in for std::index_sequence
+template <size_t... I> struct IndexSeq {};
+template <size_t N, size_t... I> struct MakeSeq : MakeSeq<N - 1, N - 1, I...> {};
+template <size_t... I> struct MakeSeq<0, I...> { typedef IndexSeq<I...> type; };
+
+}  // namespace cmdhash
+
+template <size_t N, size_t SLOTS>
+struct CommandRegistry {
+    const CommandDef* table;
+    uint32_t seed;
+    uint8_t slots[SLOTS];
+
+    static constexpr size_t count() { return N; }
+    const CommandDef& at(size_t i) const { return table[i]; }
+
+    // nullptr if the token is not a registered command
+    const CommandDef* find(StrView name) const {
+        uint8_t idx = slots[cmdhash::slotOf(name, seed, SLOTS - 1)];
+        if (idx == cmdhash::EMPTY) return nullptr;
+        return name.equalsIgnoreCase(table[idx].name) ? &table[idx] : nullptr;
+    }
+};
+
+namespace cmdhash {
+
+template <size_t N, size_t SLOTS, size_t... I>
+constexpr CommandRegistry<N, SLOTS> build(const CommandDef (&t)[N], uint32_t seed, IndexSeq<I...>) {
+    return CommandRegistry<N, SLOTS>{t, seed, {indexForSlot(t, I, seed, SLOTS - 1)...}};
+}
+
+}  // namespace cmdhash
+
+// constexpr auto registry = makeCommandRegistry(TABLE);
+// static_assert(registry.seed != cmdhash::NO_SEED, "...");
+template <size_t N>
+constexpr CommandRegistry<N, cmdhash::slotsFor(N)> makeCommandRegistry(const CommandDef (&t)[N]) {
+    return cmdhash::build<N, cmdhash::slotsFor(N)>(
+        t, cmdhash::findSeed(t, cmdhash::slotsFor(N) - 1),
+        typename cmdhash::MakeSeq<cmdhash::slotsFor(N)>::type());
+}
+
+// ============================================
+// Line splitting
+// ============================================
+
+// Split "name args" / "name(args)" into a command token and arguments.
+// The token ends at whitespace or '('; a '(' stays in args so call-style
+// commands like print("text") see their parentheses.
+inline void splitCommandLine(StrView line, StrView& name, StrView& args) {
+    line = line.trim();
+    int i = 0;
+    while (i < line.len && line[i] != '(' && !isspace((unsigned char)line[i])) i++;
+    name = line.sub(0, i);
+    args = line.sub(i).trim();
+}
@@ -0,0 +1,102 @@
+/*
+ * Host benchmark for tiny_vm.h
+ *
+ * Build and run on a PC:
+ *   g++ -O2 -std=c++11 -o vm_bench vm_bench.cpp && ./vm_bench
+ *
+ * Each script is compiled and run several times; the best run is
+ * reported with instructions executed, code size and arena use. The
+ * checks after it run edge cases once and compare one variable; the exit
+ * status is the number that failed.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "../tiny_vm.h"
+
+struct Script {
+    const char* name;
+    const char* src;
+    const char* resultVar;
+};
+
+static const Script SCRIPTS[] = {
+    {"sum for", "s = 0; for i in range(60000): s += i", "s"},
+    {"while mod", "n = 0; i = 0; while i < 50000: i += 1; n += i % 7", "n"},
+    {"float math", "x = 0.0; for i in range(20000): x = x + i * 0.5 / (i + 1)", "x"},
+    {"nested", "c = 0; for i in range(300): for j in range(300): c += 1", "c"},
+    {"natives", "t = 0; for i in range(20000): t = t + abs(i - 10000) + min(i, 5)", "t"},
+    {"collatz", "t = 0; for s in range(1, 1000): n = s; while n != 1: t += 1; "
+                "n = (n % 2) * (3 * n + 1) + (1 - n % 2) * (n // 2)", "t"},
+    {"if break", "p = 0; for i in range(100000): p = i; if i * i > 50000000: break", "p"},
+};
+
+struct Check {
+    const char* src;
+    const char* var;
+    const char* expect;  // As the REPL echoes it
+};
+
+static const Check CHECKS[] = {
+    {"n = 0; for i in range(2147483646, 2147483647, 5): n += 1", "n", "1"},
+    {"n = 0; for i in range(-2147483647, -2147483647 - 1, -5): n += 1", "n", "1"},
+    {"n = 0; for i in range(2147483640, 2147483647, 3): n += 1", "n", "3"},
+    {"n = 0; for i in range(3): i = 10; n += 1", "n", "3"},
+    {"for i in range(3): i = 10", "i", "10"},
+    {"for i in range(5, 0, -2): pass", "i", "1"},
+    {"a = abs(-2147483647 - 1)", "a", "-2147483648"},
+    {"a = (2147483647 + 1) // -1", "a", "-"},  // OverflowError
+};
+
+static const int RUNS = 5;
+
+int main() {
+    TinyVm vm;
+    vm.setStepLimit(100000000);
+
+    printf("%-11s %9s %10s %8s %6s %6s  %s\n",
+           "script", "best us", "steps", "Msteps/s", "code", "arena", "result");
+
+    for (const Script& s : SCRIPTS) {
+        double best = 1e30;
+        bool ok = true;
+        for (int r = 0; r < RUNS && ok; r++) {
+            vm.clearVars();
+            auto t0 = std::chrono::steady_clock::now();
+            ok = vm.run(s.src, strlen(s.src));
+            auto t1 = std::chrono::steady_clock::now();
+            double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+            if (us < best) best = us;
+        }
+        if (!ok) {
+            printf("%-11s error: %s\n", s.name, vm.error());
+            continue;
+        }
+
+        char result[32] = "-";
+        const TinyVm::Value* v = vm.findVar(s.resultVar);
+        if (v) TinyVm::format(*v, result, sizeof(result), true);
+        printf("%-11s %9.0f %10lu %8.1f %6u %6u  %s=%s\n",
+               s.name, best, (unsigned long)vm.lastSteps(), vm.lastSteps() / best,
+               (unsigned)vm.codeBytes(), (unsigned)vm.arenaBytes(), s.resultVar, result);
+    }
+
+    int failed = 0;
+    for (const Check& c : CHECKS) {
+        vm.clearVars();
+        char result[32] = "-";
+        if (vm.run(c.src, strlen(c.src))) {
+            const TinyVm::Value* v = vm.findVar(c.var);
+            if (v) TinyVm::format(*v, result, sizeof(result), true);
+        }
+        if (strcmp(result, c.expect) != 0) {
+            printf("check failed: %s -> %s=%s, want %s\n", c.src, c.var, result, c.expect);
+            failed++;
+        }
+    }
+    printf("checks: %d of %d passed\n", (int)(sizeof(CHECKS) / sizeof(CHECKS[0])) - failed,
+           (int)(sizeof(CHECKS) / sizeof(CHECKS[0])));
+    return failed;
+}
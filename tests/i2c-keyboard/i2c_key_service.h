@@ -0,0 +1,187 @@
+/*
+ * CardKeyBoard reader task with a lock-free event queue
+ *
+ * A FreeRTOS task polls the keyboard at a fixed period, timestamps each
+ * key code and pushes it into a single-producer/single-consumer ring that
+ * loop() drains. The UI thread never waits on the I2C bus.
+ *
+ * CardKeyBoard only holds the last key pressed, so a second key before
+ * the next poll overwrites the first. That loss cannot be seen directly;
+ * instead the service records the gap between consecutive keys in poll
+ * periods. Keys seen on back-to-back polls are counted as suspected
+ * drops (the keyboard had a key every time we looked, so anything typed
+ * faster was overwritten). If the gap histogram piles up in the "1 poll"
+ * bucket, the poll interval is too long.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <atomic>
+
+struct KeyEvent {
+    uint8_t code;
+    uint32_t timeUs;  // micros() at the start of the poll that saw the key
+};
+
+// Single-producer/single-consumer ring (N must be a power of two)
+template <typename T, uint32_t N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    // Producer side. Returns false when full.
+    bool push(const T& item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            return false;
+        }
+        _items[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when empty.
+    bool pop(T& item) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+};
+
+class I2CKeyService {
+public:
+    static constexpr uint32_t QUEUE_SIZE = 32;
+    static constexpr int GAP_BUCKETS = 6;  // Gap in polls: 1, 2, 3-4, 5-8, 9-16, >16
+
+    struct Stats {
+        uint32_t polls;
+        uint32_t keys;
+        uint32_t busErrors;       // requestFrom() returned no data
+        uint32_t queueDrops;      // Queue full (loop() not draining)
+        uint32_t suspectedDrops;  // Keys on back-to-back polls
+        uint32_t maxPollUs;       // Slowest single bus read
+        uint32_t gapHist[GAP_BUCKETS];
+        uint16_t pollMs;
+    };
+
+    I2CKeyService() : _wire(nullptr), _address(0), _pollMs(10), _task(nullptr),
+                      _resetRequested(false), _lastKeyPoll(0) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    // Start the reader task. The task owns the bus from now on - do not
+    // use the same TwoWire from other code while it runs.
+    bool begin(TwoWire* wire, uint8_t address, uint16_t pollMs,
+               BaseType_t core = 0, UBaseType_t priority = 2) {
+        _wire = wire;
+        _address = address;
+        setPollInterval(pollMs);
+        return xTaskCreatePinnedToCore(taskEntry, "i2c_kbd", 3072, this, priority,
+                                       &_task, core) == pdPASS;
+    }
+
+    bool running() const { return _task != nullptr; }
+
+    // Consumer side (loop())
+    bool pop(KeyEvent& ev) { return _queue.pop(ev); }
+
+    void setPollInterval(uint16_t ms) { _pollMs = max((uint16_t)1, ms); }
+    uint16_t pollInterval() const { return _pollMs; }
+
+    // Cleared by the task before its next poll
+    void resetStats() { _resetRequested = true; }
+
+    // Snapshot for display. Fields are written by the reader task and may
+    // be one poll apart from each other; fine for diagnostics.
+    Stats stats() const {
+        Stats s;
+        memcpy(&s, &_stats, sizeof(s));
+        s.pollMs = _pollMs;
+        return s;
+    }
+
+    static const char* gapBucketLabel(int i) {
+        static const char* const labels[GAP_BUCKETS] = {"1", "2", "3-4", "5-8", "9-16", ">16"};
+        return (i >= 0 && i < GAP_BUCKETS) ? labels[i] : "?";
+    }
+
+private:
+    static void taskEntry(void* arg) {
+        static_cast<I2CKeyService*>(arg)->run();
+    }
+
+    static int gapBucket(uint32_t gap) {
+        if (gap <= 1) return 0;
+        if (gap == 2) return 1;
+        if (gap <= 4) return 2;
+        if (gap <= 8) return 3;
+        if (gap <= 16) return 4;
+        return 5;
+    }
+
+    void run() {
+        TickType_t lastWake = xTaskGetTickCount();
+        for (;;) {
+            if (_resetRequested) {
+                memset(&_stats, 0, sizeof(_stats));
+                _lastKeyPoll = 0;
+                _resetRequested = false;
+            }
+
+            uint32_t t0 = micros();
+            uint8_t received = _wire->requestFrom(_address, (uint8_t)1);
+            uint8_t key = (received > 0 && _wire->available()) ? _wire->read() : 0;
+            uint32_t busUs = micros() - t0;
+
+            _stats.polls++;
+            if (busUs > _stats.maxPollUs) _stats.maxPollUs = busUs;
+            if (received == 0) {
+                _stats.busErrors++;
+            } else if (key != 0 && key != 255) {  // 0 / 255 = no key
+                onKey(key, t0);
+            }
+
+            TickType_t period = pdMS_TO_TICKS(_pollMs);
+            vTaskDelayUntil(&lastWake, period > 0 ? period : 1);
+        }
+    }
+
+    void onKey(uint8_t key, uint32_t timeUs) {
+        uint32_t poll = _stats.polls;
+        if (_lastKeyPoll != 0) {
+            uint32_t gap = poll - _lastKeyPoll;
+            _stats.gapHist[gapBucket(gap)]++;
+            if (gap <= 1) _stats.suspectedDrops++;
+        }
+        _lastKeyPoll = poll;
+        _stats.keys++;
+
+        KeyEvent ev = {key, timeUs};
+        if (!_queue.push(ev)) {
+            _stats.queueDrops++;
+        }
+    }
+
+    TwoWire* _wire;
+    uint8_t _address;
+    volatile uint16_t _pollMs;
+    TaskHandle_t _task;
+    volatile bool _resetRequested;
+
+    SpscQueue<KeyEvent, QUEUE_SIZE> _queue;
+    Stats _stats;  // Written only by the reader task
+    uint32_t _lastKeyPoll;
+};
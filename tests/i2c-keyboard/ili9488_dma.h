@@ -0,0 +1,106 @@
+/*
+ * Double-buffered RGB565 -> ILI9488 pixel pusher
+ *
+ * Over SPI the ILI9488 only accepts 18-bit pixels (3 bytes, 6 significant
+ * bits each), so every RGB565 pixel has to be expanded before it goes on
+ * the bus. ili9488_expand565() does that four pixels at a time with three
+ * 32-bit stores. ILI9488LinePusher expands chunks of rows into two
+ * DMA-capable buffers and alternates between them: while the SPI DMA
+ * sends one buffer, the CPU converts the next chunk into the other.
+ *
+ * Requires the bus to be configured with a DMA channel
+ * (b.dma_channel = SPI_DMA_CH_AUTO); without it pushPixelsDMA() blocks
+ * and conversion and transfer simply run back to back.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <esp_heap_caps.h>
+
+// Expand count RGB565 pixels into 3-byte R,G,B (RGB666 in the top bits)
+static inline void ili9488_expand565(uint8_t* dst, const uint16_t* src, int count) {
+    int i = 0;
+
+    // Word path: 4 pixels -> 12 bytes -> 3 aligned 32-bit stores
+    if (((uintptr_t)dst & 3) == 0) {
+        uint32_t* out = (uint32_t*)dst;
+        for (; i + 4 <= count; i += 4) {
+            uint32_t c0 = src[i], c1 = src[i + 1], c2 = src[i + 2], c3 = src[i + 3];
+            uint32_t r0 = (c0 >> 8) & 0xF8, g0 = (c0 >> 3) & 0xFC, b0 = (c0 << 3) & 0xF8;
+            uint32_t r1 = (c1 >> 8) & 0xF8, g1 = (c1 >> 3) & 0xFC, b1 = (c1 << 3) & 0xF8;
+            uint32_t r2 = (c2 >> 8) & 0xF8, g2 = (c2 >> 3) & 0xFC, b2 = (c2 << 3) & 0xF8;
+            uint32_t r3 = (c3 >> 8) & 0xF8, g3 = (c3 >> 3) & 0xFC, b3 = (c3 << 3) & 0xF8;
+            *out++ = r0 | (g0 << 8) | (b0 << 16) | (r1 << 24);
+            *out++ = g1 | (b1 << 8) | (r2 << 16) | (g2 << 24);
+            *out++ = b2 | (r3 << 8) | (g3 << 16) | (b3 << 24);
+        }
+        dst = (uint8_t*)out;
+    }
+
+    // Tail (or unaligned destination)
+    for (; i < count; i++) {
+        uint16_t c = src[i];
+        *dst++ = (c >> 8) & 0xF8;
+        *dst++ = (c >> 3) & 0xFC;
+        *dst++ = (c << 3) & 0xF8;
+    }
+}
+
+class ILI9488LinePusher {
+public:
+    ILI9488LinePusher() : _lcd(nullptr), _maxWidth(0), _chunkPixels(0) {
+        _buf[0] = _buf[1] = nullptr;
+    }
+
+    // chunkPixels: size of each of the two DMA buffers in pixels
+    // (default 480 x 8 rows = 11.5 KB each)
+    bool begin(lgfx::LGFX_Device* lcd, int maxWidth, int chunkPixels = 480 * 8) {
+        _lcd = lcd;
+        _maxWidth = maxWidth;
+        _chunkPixels = max(chunkPixels, maxWidth);
+        for (int i = 0; i < 2; i++) {
+            _buf[i] = (uint8_t*)heap_caps_malloc((size_t)_chunkPixels * 3,
+                                                 MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+            if (!_buf[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ready() const { return _buf[1] != nullptr; }
+
+    // Push a w x h block of RGB565 pixels. srcStride is in pixels;
+    // 0 repeats the same source line for every row.
+    void pushRGB565(int x, int y, int w, int h, const uint16_t* src, int srcStride) {
+        if (!_buf[1] || w <= 0 || h <= 0 || w > _maxWidth) return;
+
+        int rowsPerChunk = _chunkPixels / w;
+        size_t rowBytes = (size_t)w * 3;
+        int active = 0;
+
+        _lcd->startWrite();
+        _lcd->setAddrWindow(x, y, w, h);
+        for (int row = 0; row < h; row += rowsPerChunk) {
+            int rows = min(rowsPerChunk, h - row);
+            uint8_t* dst = _buf[active];
+
+            // This buffer's previous transfer finished before the other
+            // buffer's transfer was started, so it is free to overwrite
+            for (int r = 0; r < rows; r++) {
+                ili9488_expand565(dst + r * rowBytes, src + (size_t)(row + r) * srcStride, w);
+            }
+            _lcd->pushPixelsDMA((const lgfx::bgr888_t*)dst, (uint32_t)w * rows);
+            active ^= 1;
+        }
+        _lcd->waitDMA();
+        _lcd->endWrite();
+    }
+
+private:
+    lgfx::LGFX_Device* _lcd;
+    int _maxWidth;
+    int _chunkPixels;
+    uint8_t* _buf[2];
+};
@@ -17,6 +17,12 @@
  * - Command history navigation with arrow keys (Up/Down)
  * - Complete key codes documentation: docs/CARDKEYBOARD_KEYCODES.md
  * 
+ * Python subset (anything that is not a command; see tiny_vm.h):
+ *   x = 2; print("x is", x * 1.5)
+ *   for i in range(5): print(i, i * i)
+ *   while x < 100: x *= 2
+ *   battery(), voltage(), charging(), heap(), millis()
+ * 
  * Commands:
  *   help     - list commands
  *   clear    - clear screen
@@ -24,6 +30,10 @@
  *   test     - test components
  *   echo     - echo text
  *   version  - firmware version
+ *   bench    - display fill-rate benchmark (MB/s, FPS)
+ *   kbstat   - I2C keyboard reader statistics ('kbstat reset' clears)
+ *   kbpoll   - set I2C keyboard poll interval in ms
+ *   pystat   - time, steps and code size of the last Python statement
  * 
  * Scrolling:
  *   Fn + . (period) - scroll down
@@ -51,16 +61,25 @@
 #include <M5GFX.h>
 #include <Wire.h>
 #include "lgfx/v1/panel/Panel_LCD.hpp"
+#include "term_grid.h"
+#include "ili9488_dma.h"
+#include "i2c_key_service.h"
+#include "command_registry.h"
+#include "tiny_vm.h"
 
 // I2C settings for CardKeyBoard
 #define CARDKEYBOARD_I2C_ADDRESS 0x5F
 #define I2C_SDA_PIN 2  // GPIO 2 (G2) - PORT.A
 #define I2C_SCL_PIN 1  // GPIO 1 (G1) - PORT.A
-#define I2C_KEYBOARD_POLL_INTERVAL 50  // Keyboard poll interval (ms)
+#define I2C_KEYBOARD_POLL_INTERVAL 10  // Reader task poll interval (ms), see 'kbstat'
+
+// External display: 1 = SPI DMA (double-buffered pixel pushes), 0 = blocking
+// CPU writes. Flip to 0 and run 'bench' to get the "before" numbers.
+#define ILI9488_USE_DMA 1
 
 // I2C Keyboard support
 bool i2cKeyboardEnabled = false;  // I2C keyboard enabled flag
-unsigned long lastI2CKeyboardRead = 0;  // Last read time
+I2CKeyService keyService;  // Reader task + event queue (owns Wire once started)
 
 // ============================================
 // Local Panel_ILI9488 Definition
@@ -129,8 +148,13 @@ public:
         b.freq_write = 20000000;    // 20 MHz
         b.freq_read  = 16000000;
         b.spi_3wire  = true;        // 3-wire SPI
+#if ILI9488_USE_DMA
+        b.use_lock   = true;        // Hold the bus while DMA transfers run
+        b.dma_channel = SPI_DMA_CH_AUTO;  // DMA for pushImageDMA / pushPixelsDMA
+#else
         b.use_lock   = false;       // No SPI lock
-        b.dma_channel = 0;          // No DMA
+        b.dma_channel = 0;          // No DMA (blocking CPU writes)
+#endif
 
         b.pin_sclk = 40;            // SCK  -> PIN 7
         b.pin_mosi = 14;            // MOSI -> PIN 9
@@ -173,10 +197,11 @@ LGFX_ILI9488 lcd;  // External ILI9488 display
 #define MAX_HISTORY 10
 #define CURSOR_BLINK_PERIOD 500
 #define MAX_OUTPUT_LINES 100  // Maximum lines in buffer
-#define INPUT_LINE_Y 300  // Fixed input line position (for external display 320px)
 #define TEXT_AREA_HEIGHT 300  // Text output area height
 #define LINE_HEIGHT 24  // Single line height (font size 2)
 #define VISIBLE_LINES (TEXT_AREA_HEIGHT / LINE_HEIGHT)  // Number of visible lines (~12)
+#define INPUT_ROW VISIBLE_LINES  // Input line grid row (directly below the output rows)
+#define PROMPT_LEN 4  // ">>> "
 
 // ============================================
 // Global Variables
@@ -194,18 +219,21 @@ int outputLineCount = 0;
 int scrollOffset = 0;  // Scroll offset (how many lines scrolled)
 bool needRedraw = false;  // Flag for deferred redraw (batching)
 
+// Screen model: only damaged cells are pushed to the display
+TermGrid grid;
+int cursorCol = PROMPT_LEN;  // Grid column of the blinking cursor
+
+// RGB565 -> 18-bit pixel pusher (used by 'bench')
+ILI9488LinePusher pusher;
+
+// Python-subset interpreter (statements that are not commands)
+TinyVm vm;
+
 // ============================================
 // Terminal Functions
 // ============================================
 
-void printPrompt() {
-    lcd.setTextColor(TFT_GREEN, TFT_BLACK);
-    lcd.print(">>> ");
-    lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-}
-
-void addOutputLine(const String& text, uint16_t color = TFT_WHITE) {
-    // Add line to buffer
+void appendOutputLine(const String& text) {
     if (outputLineCount < MAX_OUTPUT_LINES) {
         outputLines[outputLineCount] = text;
         outputLineCount++;
@@ -216,6 +244,17 @@ void addOutputLine(const String& text, uint16_t color = TFT_WHITE) {
         }
         outputLines[MAX_OUTPUT_LINES - 1] = text;
     }
+}
+
+void addOutputLine(const String& text, uint16_t color = TFT_WHITE) {
+    // Add line to buffer, wrapping long lines at the grid width
+    if (text.length() <= TermGrid::COLS) {
+        appendOutputLine(text);
+    } else {
+        for (unsigned int pos = 0; pos < text.length(); pos += TermGrid::COLS) {
+            appendOutputLine(text.substring(pos, pos + TermGrid::COLS));
+        }
+    }
     
     // Automatically scroll down on new output
     scrollOffset = max(0, outputLineCount - VISIBLE_LINES);
@@ -229,17 +268,16 @@ void printOutput(const String& text, uint16_t color = TFT_WHITE) {
 }
 
 void redrawScreen() {
-    // Clear text output area
-    lcd.fillRect(0, 0, 480, TEXT_AREA_HEIGHT, TFT_BLACK);
-    
-    // Draw visible lines
+    // Write visible lines into the grid; unchanged cells stay clean
     int startLine = scrollOffset;
-    int endLine = min(startLine + VISIBLE_LINES, outputLineCount);
     
-    lcd.setTextSize(2);  // Font size for external display
-    lcd.setCursor(0, 0);
-    
-    for (int i = startLine; i < endLine; i++) {
+    for (int row = 0; row < VISIBLE_LINES; row++) {
+        int i = startLine + row;
+        if (i >= outputLineCount) {
+            grid.clearToEol(0, row);
+            continue;
+        }
+        
         // Determine color by prefix or use white
         uint16_t color = TFT_WHITE;
         if (outputLines[i].startsWith(">>>")) {
@@ -254,11 +292,11 @@ void redrawScreen() {
             color = TFT_YELLOW;
         }
         
-        lcd.setTextColor(color, TFT_BLACK);
-        lcd.println(outputLines[i]);
+        int col = grid.putText(0, row, outputLines[i].c_str(), outputLines[i].length(), color);
+        grid.clearToEol(col, row);
     }
     
-    // Draw input line
+    // Draw input line (flushes the grid)
     renderInputLine();
 }
 
@@ -280,6 +318,7 @@ void scrollDown() {
 void clearScreen() {
     // Clear entire screen physically
     lcd.fillScreen(TFT_BLACK);
+    grid.reset();  // Grid now matches the black screen
     
     // Clear output buffer completely
     outputLineCount = 0;
@@ -304,21 +343,25 @@ void clearScreen() {
     redrawScreen();
 }
 
+void renderCursor() {
+    grid.putChar(cursorCol, INPUT_ROW, cursorVisible ? '_' : ' ', TFT_WHITE);
+    grid.flush();
+}
+
 void renderInputLine() {
-    // Always draw input line at fixed position at bottom
-    lcd.fillRect(0, INPUT_LINE_Y, 480, 30, TFT_BLACK);
-    lcd.setCursor(0, INPUT_LINE_Y);
-    lcd.setTextSize(2);  // Font size for external display
+    // Input line is the grid row below the output area
+    int col = grid.putText(0, INPUT_ROW, ">>> ", PROMPT_LEN, TFT_GREEN);
     
-    printPrompt();
-    lcd.print(inputBuffer);
+    // Show the tail of long input so the cursor stays visible
+    int maxChars = TermGrid::COLS - PROMPT_LEN - 1;
+    int start = max(0, (int)inputBuffer.length() - maxChars);
+    col = grid.putText(col, INPUT_ROW, inputBuffer.c_str() + start,
+                       inputBuffer.length() - start, TFT_WHITE);
+    grid.clearToEol(col, INPUT_ROW);
     
     // Blinking cursor
-    if (cursorVisible) {
-        lcd.print("_");
-    } else {
-        lcd.print(" ");
-    }
+    cursorCol = col;
+    renderCursor();
 }
 
 void addToHistory(const String& cmd) {
@@ -347,6 +390,41 @@ String getHistory(int index) {
 // Command Processing
 // ============================================
 
+// Command handlers (defined below)
+void cmdHelp(StrView args);
+void cmdClear(StrView args);
+void cmdInfo(StrView args);
+void cmdTest(StrView args);
+void cmdEcho(StrView args);
+void cmdVersion(StrView args);
+void cmdBench(StrView args);
+void cmdKbStat(StrView args);
+void cmdKbPoll(StrView args);
+void cmdPyStat(StrView args);
+
+// Command table - add a line here to register a command. Names must be
+// unique (checked at compile time by the perfect hash).
+constexpr CommandDef COMMANDS[] = {
+    // Terminal
+    {"help",    cmdHelp,    "Show this help"},
+    {"clear",   cmdClear,   "Clear screen"},
+    {"info",    cmdInfo,    "System information"},
+    {"test",    cmdTest,    "Test components"},
+    {"echo",    cmdEcho,    "Echo text"},
+    {"version", cmdVersion, "Show version"},
+    // Display
+    {"bench",   cmdBench,   "Display benchmark"},
+    // I2C keyboard
+    {"kbstat",  cmdKbStat,  "Keyboard reader stats"},
+    {"kbpoll",  cmdKbPoll,  "Keyboard poll interval"},
+    // Python
+    {"pystat",  cmdPyStat,  "Last statement timing"},
+};
+
+constexpr auto commandRegistry = makeCommandRegistry(COMMANDS);
+static_assert(commandRegistry.seed != cmdhash::NO_SEED,
+              "Command names collide (duplicate name?)");
+
 void executeCommand(const String& cmd) {
     if (cmd.length() == 0) {
         return;
@@ -358,58 +436,111 @@ void executeCommand(const String& cmd) {
     // Show command in output area
     addOutputLine(">>> " + cmd, TFT_GREEN);
     
-    // Check for Python-like commands: print("text") or print('text')
-    if (cmd.startsWith("print(") || cmd.startsWith("Print(")) {
-        cmdPrint(cmd);
+    // Split into token and arguments (views into cmd, no copies)
+    StrView name, args;
+    splitCommandLine(StrView(cmd.c_str(), cmd.length()), name, args);
+    if (name.empty()) {
         return;
     }
     
-    // Parse command
-    int spaceIndex = cmd.indexOf(' ');
-    String command = (spaceIndex > 0) ? cmd.substring(0, spaceIndex) : cmd;
-    String args = (spaceIndex > 0) ? cmd.substring(spaceIndex + 1) : "";
-    
-    command.toLowerCase();
-    
-    // Execute command
-    if (command == "help") {
-        cmdHelp();
-    } else if (command == "clear") {
-        cmdClear();
-    } else if (command == "info") {
-        cmdInfo();
-    } else if (command == "test") {
-        cmdTest();
-    } else if (command == "echo") {
-        cmdEcho(args);
-    } else if (command == "version") {
-        cmdVersion();
+    // "test = 1" is an assignment, not the test command
+    bool assignment = args.startsWith('=') && !(args.len > 1 && args[1] == '=');
+    const CommandDef* def = assignment ? nullptr : commandRegistry.find(name);
+    if (def) {
+        def->handler(args);
     } else {
-        addOutputLine("Error: Unknown command '" + command + "'", TFT_RED);
-        addOutputLine("Type 'help' for available commands", TFT_YELLOW);
+        runPython(cmd);
     }
 }
 
-void cmdHelp() {
+// ============================================
+// Python Interpreter
+// ============================================
+
+void vmOutput(const char* line, void* ctx) {
+    addOutputLine(String(line), TFT_CYAN);
+}
+
+bool vmBattery(TinyVm& vm, const TinyVm::Value* args, int argc, TinyVm::Value& result) {
+    result = TinyVm::fromInt(M5Cardputer.Power.getBatteryLevel());
+    return true;
+}
+
+bool vmVoltage(TinyVm& vm, const TinyVm::Value* args, int argc, TinyVm::Value& result) {
+    result = TinyVm::fromInt(M5Cardputer.Power.getBatteryVoltage());
+    return true;
+}
+
+bool vmCharging(TinyVm& vm, const TinyVm::Value* args, int argc, TinyVm::Value& result) {
+    result = TinyVm::fromInt(M5Cardputer.Power.isCharging() ? 1 : 0);
+    return true;
+}
+
+bool vmHeap(TinyVm& vm, const TinyVm::Value* args, int argc, TinyVm::Value& result) {
+    result = TinyVm::fromInt(ESP.getFreeHeap());
+    return true;
+}
+
+bool vmMillis(TinyVm& vm, const TinyVm::Value* args, int argc, TinyVm::Value& result) {
+    result = TinyVm::fromInt((int32_t)millis());
+    return true;
+}
+
+void initPython() {
+    vm.setOutput(vmOutput, nullptr);
+    vm.registerNative("battery", vmBattery, 0, 0);
+    vm.registerNative("voltage", vmVoltage, 0, 0);
+    vm.registerNative("charging", vmCharging, 0, 0);
+    vm.registerNative("heap", vmHeap, 0, 0);
+    vm.registerNative("millis", vmMillis, 0, 0);
+}
+
+// Last statement, for 'pystat'
+static bool py_last_ok = false;
+static unsigned long py_last_us = 0;
+
+void runPython(const String& line) {
+    unsigned long t0 = micros();
+    bool ok = vm.run(line.c_str(), line.length());
+    py_last_us = micros() - t0;
+    py_last_ok = ok;
+    
+    if (!ok) {
+        addOutputLine("Error: " + String(vm.error()), TFT_RED);
+    }
+}
+
+void cmdPyStat(StrView args) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "Last statement: %s, %lu us, %lu steps",
+             py_last_ok ? "ok" : "error", py_last_us, (unsigned long)vm.lastSteps());
+    addOutputLine(String(buf), TFT_CYAN);
+    snprintf(buf, sizeof(buf), "  Code: %u bytes, arena: %u bytes",
+             (unsigned)vm.codeBytes(), (unsigned)vm.arenaBytes());
+    addOutputLine(String(buf));
+}
+
+void cmdHelp(StrView args) {
     addOutputLine("Available commands:", TFT_CYAN);
-    addOutputLine("  help     - Show this help");
-    addOutputLine("  clear    - Clear screen");
-    addOutputLine("  info     - System information");
-    addOutputLine("  test     - Test components");
-    addOutputLine("  echo     - Echo text");
-    addOutputLine("  version  - Show version");
-    addOutputLine("  print(\"text\") - Print text");
+    char buf[64];
+    for (size_t i = 0; i < commandRegistry.count(); i++) {
+        const CommandDef& def = commandRegistry.at(i);
+        snprintf(buf, sizeof(buf), "  %-8s - %s", def.name, def.help);
+        addOutputLine(String(buf));
+    }
+    addOutputLine("Python: x = 1; print(x * 2)");
+    addOutputLine("  for/while/if, battery() heap()");
     addOutputLine("Scroll: Fn+. (down) Fn+; (up)");
     if (i2cKeyboardEnabled) {
         addOutputLine("I2C Keyboard: ACTIVE", TFT_GREEN);
     }
 }
 
-void cmdClear() {
+void cmdClear(StrView args) {
     clearScreen();
 }
 
-void cmdInfo() {
+void cmdInfo(StrView args) {
     int batteryLevel = M5Cardputer.Power.getBatteryLevel();
     int batteryVoltage = M5Cardputer.Power.getBatteryVoltage();
     bool isCharging = M5Cardputer.Power.isCharging();
@@ -428,7 +559,7 @@ void cmdInfo() {
     addOutputLine(String(buf));
 }
 
-void cmdTest() {
+void cmdTest(StrView args) {
     addOutputLine("Testing components...", TFT_CYAN);
     addOutputLine("  Keyboard: OK", TFT_GREEN);
     delay(100);
@@ -455,15 +586,15 @@ void cmdTest() {
     addOutputLine("All tests passed!", TFT_GREEN);
 }
 
-void cmdEcho(const String& text) {
-    if (text.length() > 0) {
-        addOutputLine(text, TFT_CYAN);
+void cmdEcho(StrView args) {
+    if (!args.empty()) {
+        addOutputLine(args.toString(), TFT_CYAN);
     } else {
         addOutputLine("Usage: echo <text>", TFT_YELLOW);
     }
 }
 
-void cmdVersion() {
+void cmdVersion(StrView args) {
     addOutputLine("Python Terminal v1.0", TFT_CYAN);
     addOutputLine("Cardputer-Adv", TFT_YELLOW);
     addOutputLine("I2C Keyboard Support", TFT_YELLOW);
@@ -479,39 +610,127 @@ void cmdVersion() {
     }
 }
 
-void cmdPrint(const String& cmd) {
-    // Parse print("text") or print('text')
-    // Find opening parenthesis
-    int openParen = cmd.indexOf('(');
-    if (openParen == -1) {
-        addOutputLine("Error: Syntax error. Use: print(\"text\")", TFT_RED);
-        return;
+// ============================================
+// Display Benchmark
+// ============================================
+
+#define BENCH_FRAMES 10
+#define BENCH_STRIP_ROWS 8  // Rows per pushImage() strip in the LovyanGFX test
+
+// RGB565 test pattern: one strip of horizontal gradient
+static uint16_t benchStrip[480 * BENCH_STRIP_ROWS];
+
+// One result line: bytes on the wire are 3 per pixel (18-bit mode)
+static String benchResult(const char* name, unsigned long us) {
+    float seconds = us / 1000000.0f;
+    float mbps = (float)BENCH_FRAMES * lcd.width() * lcd.height() * 3 / seconds / 1048576.0f;
+    char buf[64];
+    snprintf(buf, sizeof(buf), "  %-9s %5.2f MB/s %5.1f FPS", name, mbps, BENCH_FRAMES / seconds);
+    Serial.println(buf);
+    return String(buf);
+}
+
+void cmdBench(StrView args) {
+    int w = lcd.width();
+    int h = lcd.height();
+    
+    for (int y = 0; y < BENCH_STRIP_ROWS; y++) {
+        for (int x = 0; x < w; x++) {
+            benchStrip[y * w + x] = lcd.color565(x * 255 / w, y * 32, 255 - x * 255 / w);
+        }
     }
     
-    // Find closing parenthesis
-    int closeParen = cmd.lastIndexOf(')');
-    if (closeParen == -1 || closeParen <= openParen) {
-        addOutputLine("Error: Syntax error. Use: print(\"text\")", TFT_RED);
-        return;
+    Serial.printf("Display benchmark (%dx%d, %d frames, DMA %s)\n",
+                  w, h, BENCH_FRAMES, ILI9488_USE_DMA ? "ON" : "OFF");
+    
+    // 1. Solid fill (no conversion, LovyanGFX repeats one pixel)
+    unsigned long t0 = micros();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        lcd.fillScreen((f & 1) ? TFT_NAVY : TFT_DARKGREEN);
     }
+    String fillLine = benchResult("fill", micros() - t0);
     
-    // Extract content between parentheses
-    String content = cmd.substring(openParen + 1, closeParen);
-    content.trim();
+    // 2. RGB565 image through LovyanGFX (converted per pixel by the library)
+    t0 = micros();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        lcd.startWrite();
+        for (int y = 0; y < h; y += BENCH_STRIP_ROWS) {
+            lcd.pushImage(0, y, w, BENCH_STRIP_ROWS, (const lgfx::rgb565_t*)benchStrip);
+        }
+        lcd.endWrite();
+    }
+    String imageLine = benchResult("pushImage", micros() - t0);
     
-    // Remove quotes (single or double)
-    if (content.startsWith("\"") && content.endsWith("\"")) {
-        content = content.substring(1, content.length() - 1);
-    } else if (content.startsWith("'") && content.endsWith("'")) {
-        content = content.substring(1, content.length() - 1);
+    // 3. RGB565 image through the double-buffered 565->666 pusher
+    String pusherLine = "  pusher    (no DMA buffers)";
+    if (pusher.ready()) {
+        t0 = micros();
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            pusher.pushRGB565(0, 0, w, h, benchStrip, 0);
+        }
+        pusherLine = benchResult("pusher", micros() - t0);
     }
     
-    // Output text
-    if (content.length() > 0) {
-        addOutputLine(content, TFT_CYAN);
-    } else {
-        addOutputLine("", TFT_WHITE);  // Empty string
+    // Restore the terminal: blank screen, grid in sync, full redraw
+    lcd.fillScreen(TFT_BLACK);
+    grid.reset();
+    
+    addOutputLine(ILI9488_USE_DMA ? "Display benchmark (DMA ON):" : "Display benchmark (DMA OFF):", TFT_CYAN);
+    addOutputLine(fillLine);
+    addOutputLine(imageLine);
+    addOutputLine(pusherLine);
+}
+
+// ============================================
+// I2C Keyboard Statistics
+// ============================================
+
+void cmdKbStat(StrView args) {
+    if (!keyService.running()) {
+        addOutputLine("I2C Keyboard: NOT CONNECTED", TFT_YELLOW);
+        return;
+    }
+    if (args.equalsIgnoreCase("reset")) {
+        keyService.resetStats();
+        addOutputLine("Keyboard stats cleared", TFT_GREEN);
+        return;
+    }
+    
+    I2CKeyService::Stats st = keyService.stats();
+    char buf[64];
+    addOutputLine("Keyboard reader:", TFT_CYAN);
+    snprintf(buf, sizeof(buf), "  Poll: %u ms, %lu polls, max %lu us",
+             st.pollMs, (unsigned long)st.polls, (unsigned long)st.maxPollUs);
+    addOutputLine(String(buf));
+    snprintf(buf, sizeof(buf), "  Keys: %lu  Bus errors: %lu",
+             (unsigned long)st.keys, (unsigned long)st.busErrors);
+    addOutputLine(String(buf));
+    snprintf(buf, sizeof(buf), "  Queue drops: %lu  Suspected: %lu",
+             (unsigned long)st.queueDrops, (unsigned long)st.suspectedDrops);
+    addOutputLine(String(buf));
+    
+    // Inter-key gap histogram in poll periods
+    String hist = "  Gaps:";
+    for (int i = 0; i < I2CKeyService::GAP_BUCKETS; i++) {
+        snprintf(buf, sizeof(buf), " %s:%lu", I2CKeyService::gapBucketLabel(i),
+                 (unsigned long)st.gapHist[i]);
+        hist += buf;
+    }
+    addOutputLine(hist);
+    Serial.println(hist);
+}
+
+void cmdKbPoll(StrView args) {
+    int ms = args.toInt();
+    if (ms < 1 || ms > 1000) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "Usage: kbpoll <1-1000 ms> (now %u)", keyService.pollInterval());
+        addOutputLine(String(buf), TFT_YELLOW);
+        return;
     }
+    keyService.setPollInterval(ms);
+    keyService.resetStats();
+    addOutputLine("Keyboard poll: " + String(ms) + " ms (stats cleared)", TFT_GREEN);
 }
 
 // ============================================
@@ -539,10 +758,18 @@ void initI2CKeyboard() {
     byte error = Wire.endTransmission();
     
     if (error == 0) {
-        i2cKeyboardEnabled = true;
         Serial.println("  ✓ CardKeyBoard found at 0x5F");
-        Serial.println("  ✓ I2C Keyboard initialized!");
-        addOutputLine("I2C Keyboard: Connected", TFT_GREEN);
+        
+        // Reader task on core 0 (loop() runs on core 1)
+        if (keyService.begin(&Wire, CARDKEYBOARD_I2C_ADDRESS, I2C_KEYBOARD_POLL_INTERVAL)) {
+            i2cKeyboardEnabled = true;
+            Serial.printf("  ✓ I2C Keyboard reader task started (%d ms poll)\n", I2C_KEYBOARD_POLL_INTERVAL);
+            addOutputLine("I2C Keyboard: Connected", TFT_GREEN);
+        } else {
+            i2cKeyboardEnabled = false;
+            Serial.println("  ✗ I2C Keyboard reader task could not be created");
+            addOutputLine("I2C Keyboard: TASK FAILED", TFT_RED);
+        }
     } else {
         i2cKeyboardEnabled = false;
         Serial.println("  ✗ CardKeyBoard not found at 0x5F");
@@ -551,34 +778,12 @@ void initI2CKeyboard() {
     }
 }
 
-unsigned char readI2CKeyboard() {
-    if (!i2cKeyboardEnabled) {
-        return 0;
+// Hand queued key events to the terminal (called from loop())
+void drainI2CKeyboard() {
+    KeyEvent ev;
+    while (keyService.pop(ev)) {
+        processI2CKeyboard(ev.code);
     }
-    
-    unsigned long currentTime = millis();
-    
-    // Don't read too often
-    if (currentTime - lastI2CKeyboardRead < I2C_KEYBOARD_POLL_INTERVAL) {
-        return 0;
-    }
-    lastI2CKeyboardRead = currentTime;
-    
-    // Request 1 byte from CardKeyBoard
-    uint8_t bytesReceived = Wire.requestFrom(CARDKEYBOARD_I2C_ADDRESS, 1);
-    
-    if (bytesReceived > 0 && Wire.available()) {
-        unsigned char key = Wire.read();
-        
-        // CardKeyBoard sends 0 or 255 when no key pressed
-        if (key == 0 || key == 255) {
-            return 0;
-        }
-        
-        return key;
-    }
-    
-    return 0;
 }
 
 void processI2CKeyboard(unsigned char key) {
@@ -703,6 +908,32 @@ void setup() {
         lcd.setTextSize(2);  // Larger font size for large screen
         lcd.setTextColor(TFT_WHITE, TFT_BLACK);
         
+        // Internal RAM (no PSRAM) holds output and prompt/echo: white, green
+        if (!grid.begin(&lcd, GlyphAtlas::faceBytes(2) * 2)) {
+            Serial.println("  ✗ ERROR: Glyph atlas buffer allocation FAILED!");
+            return;
+        }
+        
+        // Pre-render terminal colors (most used first; the rest fall back
+        // to mask expansion when the tile budget is exhausted)
+        const uint16_t termColors[] = {TFT_WHITE, TFT_GREEN, TFT_CYAN, TFT_YELLOW, TFT_RED};
+        const char* const termColorNames[] = {"white", "green", "cyan", "yellow", "red"};
+        String cached;
+        for (size_t i = 0; i < sizeof(termColors) / sizeof(termColors[0]); i++) {
+            if (grid.atlas().preload(2, termColors[i], TFT_BLACK)) {
+                cached += cached.length() ? ", " : "";
+                cached += termColorNames[i];
+            }
+        }
+        Serial.printf("  ✓ Glyph atlas: %u bytes of tiles (%s; others drawn from masks)\n",
+                      (unsigned)grid.atlas().tileBytesUsed(), cached.length() ? cached.c_str() : "none");
+        
+        if (pusher.begin(&lcd, lcd.width())) {
+            Serial.printf("  ✓ DMA line buffers ready (DMA %s)\n", ILI9488_USE_DMA ? "ON" : "OFF");
+        } else {
+            Serial.println("  ✗ WARNING: DMA line buffer allocation failed ('bench' limited)");
+        }
+        
         Serial.println("\nReady! Terminal initialized...");
         Serial.println("----------------------------------------\n");
         
@@ -724,6 +955,8 @@ void setup() {
     Serial.println("\nInitializing I2C Keyboard...");
     initI2CKeyboard();
     
+    initPython();
+    
     clearScreen();
     
     Serial.println("Terminal ready!");
@@ -749,15 +982,12 @@ void loop() {
     if (currentMillis - cursorBlinkTime > CURSOR_BLINK_PERIOD) {
         cursorBlinkTime = currentMillis;
         cursorVisible = !cursorVisible;
-        renderInputLine();
+        renderCursor();  // Only the cursor cell changes
     }
     
     // Handle I2C keyboard (if enabled)
     if (i2cKeyboardEnabled) {
-        unsigned char i2cKey = readI2CKeyboard();
-        if (i2cKey != 0) {
-            processI2CKeyboard(i2cKey);
-        }
+        drainI2CKeyboard();
     }
     
     // Handle built-in keyboard
@@ -0,0 +1,153 @@
+/*
+ * Character-grid terminal model for the external ILI9488 display
+ *
+ * The screen is a COLS x ROWS grid of cells (glyph + foreground color)
+ * with one dirty bit per cell. Writers only touch the grid; flush()
+ * pushes the damaged cells, merging horizontal runs of dirty cells on
+ * a row into a single pixel block. Writing the same glyph/color into a
+ * cell does not mark it dirty, so re-rendering unchanged text is free.
+ *
+ * Cell size matches setTextSize(2) of the built-in 6x8 font (12x16 glyph)
+ * inside a LINE_HEIGHT (24 px) row. Glyphs come from GlyphAtlas tiles
+ * that are already in the panel's 3-byte pixel format.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include "glyph_atlas.h"
+
+class TermGrid {
+public:
+    static constexpr int COLS    = 40;   // 480 / CELL_W
+    static constexpr int ROWS    = 13;   // 12 output rows + input row
+    static constexpr int CELL_W  = 12;
+    static constexpr int CELL_H  = 24;
+    static constexpr int GLYPH_Y = 4;    // Glyph offset inside the cell (16 px glyph)
+
+    struct Cell {
+        char ch;
+        uint16_t fg;
+    };
+
+    // Flush statistics (cells / pixel blocks pushed by the last flush)
+    struct FlushStats {
+        uint16_t cells;
+        uint16_t blocks;
+    };
+
+    TermGrid() : _lcd(nullptr), _anyDirty(false) {
+        reset();
+    }
+
+    // Attach to the display. The atlas block buffer holds one full row
+    // (480x24) so any dirty run fits in a single block. Without PSRAM
+    // the tiles get internalTileBudget bytes.
+    bool begin(lgfx::LGFX_Device* lcd, size_t internalTileBudget) {
+        _lcd = lcd;
+        return _atlas.begin(lcd, COLS * CELL_W * CELL_H, 1024 * 1024, internalTileBudget);
+    }
+
+    GlyphAtlas& atlas() { return _atlas; }
+
+    // Blank grid that matches a freshly cleared (black) screen - nothing dirty
+    void reset() {
+        for (int r = 0; r < ROWS; r++) {
+            for (int c = 0; c < COLS; c++) {
+                _cells[r][c] = {' ', TFT_WHITE};
+            }
+            _dirty[r] = 0;
+        }
+        _anyDirty = false;
+    }
+
+    // Force every cell to be pushed on the next flush
+    void invalidate() {
+        for (int r = 0; r < ROWS; r++) {
+            _dirty[r] = ALL_COLS;
+        }
+        _anyDirty = true;
+    }
+
+    void putChar(int col, int row, char ch, uint16_t fg) {
+        if (col < 0 || col >= COLS || row < 0 || row >= ROWS) return;
+        Cell& cell = _cells[row][col];
+        if (ch == ' ') fg = TFT_WHITE;  // Color of a blank cell is irrelevant
+        if (cell.ch == ch && cell.fg == fg) return;
+        cell.ch = ch;
+        cell.fg = fg;
+        _dirty[row] |= (1ULL << col);
+        _anyDirty = true;
+    }
+
+    // Write up to len characters starting at col; returns the next column
+    int putText(int col, int row, const char* text, int len, uint16_t fg) {
+        for (int i = 0; i < len && col < COLS; i++, col++) {
+            putChar(col, row, text[i], fg);
+        }
+        return col;
+    }
+
+    // Blank the row from col to the right edge
+    void clearToEol(int col, int row) {
+        for (; col < COLS; col++) {
+            putChar(col, row, ' ', TFT_WHITE);
+        }
+    }
+
+    bool isDirty() const { return _anyDirty; }
+
+    // Push damaged cells. Each horizontal run of dirty cells becomes one
+    // pixel block composed from atlas tiles.
+    FlushStats flush() {
+        FlushStats stats = {0, 0};
+        if (!_anyDirty || !_lcd) return stats;
+
+        _lcd->startWrite();
+        for (int r = 0; r < ROWS; r++) {
+            uint64_t bits = _dirty[r];
+            if (!bits) continue;
+
+            int col = 0;
+            while (col < COLS) {
+                if (!(bits & (1ULL << col))) {
+                    col++;
+                    continue;
+                }
+                int start = col;
+                while (col < COLS && (bits & (1ULL << col))) {
+                    col++;
+                }
+                pushRun(r, start, col - start);
+                stats.cells += col - start;
+                stats.blocks++;
+            }
+            _dirty[r] = 0;
+        }
+        _lcd->endWrite();
+
+        _anyDirty = false;
+        return stats;
+    }
+
+private:
+    static constexpr uint64_t ALL_COLS = (1ULL << COLS) - 1;
+
+    void pushRun(int row, int col, int count) {
+        int x = col * CELL_W;
+        int w = count * CELL_W;
+
+        if (!_atlas.beginBlock(w, CELL_H, TFT_BLACK)) return;
+        for (int i = 0; i < count; i++) {
+            const Cell& cell = _cells[row][col + i];
+            _atlas.blitGlyph(i * CELL_W, GLYPH_Y, cell.ch, 2, cell.fg, TFT_BLACK);
+        }
+        _atlas.endBlock(x, row * CELL_H);
+    }
+
+    lgfx::LGFX_Device* _lcd;
+    GlyphAtlas _atlas;
+    Cell _cells[ROWS][COLS];
+    uint64_t _dirty[ROWS];
+    bool _anyDirty;
+};
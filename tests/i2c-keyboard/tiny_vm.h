@@ -0,0 +1,1259 @@
+/*
+ * Tiny bytecode interpreter for the Python terminal
+ *
+ * One input line is tokenized and compiled into a compact stack bytecode
+ * and then executed. The language is a small Python subset:
+ *
+ *   x = 1; y = x * 2.5          assignment (=, +=, -=, *=, /=)
+ *   print("sum:", x + y)        calls into registered native functions
+ *   for i in range(10): s += i  range(stop) / (start, stop) / (start, stop, step)
+ *   while n > 1: n = n // 2     loop bodies (and if bodies) run to end of line
+ *   if x > 3: print(x)
+ *   and or not  < <= > >= == !=  + - * / // %  break continue pass
+ *
+ * Values are None, 32-bit int (wraps on overflow; True/False are 1/0),
+ * float and string (literals only; no string operators except == / !=). Variables are global and persist across lines.
+ * An expression statement at top level echoes its value like the Python REPL.
+ *
+ * Nothing is allocated on the heap. Code and string literals of one
+ * statement share a fixed arena (code grows up, strings grow down), the
+ * value stack depth is computed at compile time, and variables live in a
+ * fixed table, so a statement either fits these bounds or fails to
+ * compile with an error. Loops are bounded by a step limit.
+ *
+ * Pure C++ (no Arduino headers) so the host benchmark can include it.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+class TinyVm {
+public:
+    static constexpr int MAX_VARS = 32;      // User variables
+    static constexpr int MAX_TEMPS = 12;     // Hidden loop slots per statement (3 per loop)
+    static constexpr int NAME_LEN = 12;      // Including NUL
+    static constexpr int STR_LEN = 24;       // String stored in a variable (incl. NUL)
+    static constexpr int STACK_SIZE = 32;
+    static constexpr int ARENA_SIZE = 1024;  // Code + string literals per statement
+    static constexpr int MAX_NATIVES = 16;
+    static constexpr int MAX_ARGS = 8;
+    static constexpr int MAX_LOOPS = 4;      // Loop nesting
+    static constexpr int MAX_NESTING = 32;   // Parentheses, calls, unary operators, ifs (C recursion)
+    static constexpr int MAX_JUMPS = 8;      // break/continue per loop
+    static constexpr int LINE_LEN = 128;     // print() output line
+    static constexpr int ERROR_LEN = 64;
+
+    enum Type : uint8_t { T_UNDEF, T_NONE, T_INT, T_FLOAT, T_STR };
+
+    struct Value {
+        uint8_t type;
+        union {
+            int32_t i;
+            float f;
+            const char* s;
+        };
+    };
+
+    typedef bool (*NativeFn)(TinyVm& vm, const Value* args, int argc, Value& result);
+    typedef void (*OutputFn)(const char* line, void* ctx);
+
+    TinyVm() : _out(nullptr), _outCtx(nullptr), _nativeCount(0), _stepLimit(2000000),
+               _lastSteps(0), _codeLen(0), _strTop(ARENA_SIZE) {
+        _error[0] = '\0';
+        clearVars();
+        registerNative("print", nativePrint, 0, MAX_ARGS);
+        registerNative("abs", nativeAbs, 1, 1);
+        registerNative("int", nativeInt, 1, 1);
+        registerNative("float", nativeFloat, 1, 1);
+        registerNative("min", nativeMin, 1, MAX_ARGS);
+        registerNative("max", nativeMax, 1, MAX_ARGS);
+    }
+
+    void setOutput(OutputFn fn, void* ctx) {
+        _out = fn;
+        _outCtx = ctx;
+    }
+
+    bool registerNative(const char* name, NativeFn fn, uint8_t minArgs, uint8_t maxArgs) {
+        if (_nativeCount >= MAX_NATIVES || strlen(name) >= NAME_LEN) return false;
+        Native& n = _natives[_nativeCount++];
+        strcpy(n.name, name);
+        n.fn = fn;
+        n.minArgs = minArgs;
+        n.maxArgs = maxArgs > MAX_ARGS ? MAX_ARGS : maxArgs;
+        return true;
+    }
+
+    // Upper bound on executed instructions per statement (checked on loop jumps)
+    void setStepLimit(uint32_t steps) { _stepLimit = steps; }
+
+    void clearVars() {
+        for (int i = 0; i < MAX_VARS + MAX_TEMPS; i++) {
+            _varNames[i][0] = '\0';
+            _vars[i].type = T_UNDEF;
+        }
+    }
+
+    // Compile and execute one line. On false, error() says why.
+    bool run(const char* src, size_t len) {
+        bool ok = compile(src, len) && execute();
+        releaseUndefined();
+        return ok;
+    }
+
+    bool compile(const char* src, size_t len);
+    bool execute();
+
+    const char* error() const { return _error; }
+    uint32_t lastSteps() const { return _lastSteps; }
+    size_t codeBytes() const { return _codeLen; }
+    size_t arenaBytes() const { return _codeLen + (ARENA_SIZE - _strTop); }
+    int maxStackDepth() const { return _maxDepth; }
+
+    // Variable access (host tools, diagnostics)
+    const Value* findVar(const char* name) const {
+        for (int i = 0; i < MAX_VARS; i++) {
+            if (_vars[i].type != T_UNDEF && strcmp(_varNames[i], name) == 0) return &_vars[i];
+        }
+        return nullptr;
+    }
+
+    // --- Helpers for native functions ---
+    static Value none() { Value v; v.type = T_NONE; v.i = 0; return v; }
+    static Value fromInt(int32_t i) { Value v; v.type = T_INT; v.i = i; return v; }
+    static Value fromFloat(float f) { Value v; v.type = T_FLOAT; v.f = f; return v; }
+    static bool isNumber(const Value& v) { return v.type == T_INT || v.type == T_FLOAT; }
+    static float toFloat(const Value& v) { return v.type == T_INT ? (float)v.i : v.f; }
+
+    // Set the error message; returns false so natives can "return vm.fail(...)"
+    bool fail(const char* fmt, ...) {
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(_error, sizeof(_error), fmt, ap);
+        va_end(ap);
+        return false;
+    }
+
+    void output(const char* line) {
+        if (_out) _out(line, _outCtx);
+    }
+
+    // str() / repr() of a value into buf
+    static void format(const Value& v, char* buf, int size, bool repr) {
+        switch (v.type) {
+        case T_INT:
+            snprintf(buf, size, "%ld", (long)v.i);
+            break;
+        case T_FLOAT: {
+            snprintf(buf, size, "%g", (double)v.f);
+            // Python always shows a float as a float
+            if (!strpbrk(buf, ".eEni") && (int)strlen(buf) + 2 < size) strcat(buf, ".0");
+            break;
+        }
+        case T_STR:
+            snprintf(buf, size, repr ? "'%s'" : "%s", v.s);
+            break;
+        default:
+            snprintf(buf, size, "None");
+            break;
+        }
+    }
+
+private:
+    // ============================================
+    // Bytecode
+    // ============================================
+
+    enum Op : uint8_t {
+        OP_HALT,
+        OP_INT,       // i32
+        OP_FLOAT,     // f32
+        OP_STR,       // u16 arena offset
+        OP_NONE,
+        OP_LOAD,      // u8 slot
+        OP_STORE,     // u8 slot (pops)
+        OP_POP,
+        OP_ECHO,      // Pop and print repr (top-level expression)
+        OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_IDIV, OP_MOD,
+        OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE,
+        OP_NEG,
+        OP_NOT,
+        OP_JMP,       // u16 target
+        OP_JZ,        // u16 target, pops
+        OP_JZ_KEEP,   // u16: falsy -> jump, keep value; else pop (and)
+        OP_JNZ_KEEP,  // u16: truthy -> jump, keep value; else pop (or)
+        OP_CALL,      // u8 native, u8 argc
+        OP_FOR_TEST,  // u8 counter, u8 stop, u8 step, u8 var, u16 exit
+        OP_FOR_NEXT,  // u8 counter, u8 stop, u8 step, u16 test
+    };
+
+    // ============================================
+    // Tokenizer
+    // ============================================
+
+    enum TokKind : uint8_t {
+        TK_END, TK_INT, TK_FLOAT, TK_STR, TK_NAME,
+        TK_WHILE, TK_FOR, TK_IN, TK_IF, TK_AND, TK_OR, TK_NOT,
+        TK_BREAK, TK_CONTINUE, TK_PASS, TK_TRUE, TK_FALSE, TK_NONE,
+        TK_PLUS, TK_MINUS, TK_STAR, TK_SLASH, TK_DSLASH, TK_PERCENT,
+        TK_LPAREN, TK_RPAREN, TK_COMMA, TK_COLON, TK_SEMI,
+        TK_ASSIGN, TK_PLUSEQ, TK_MINUSEQ, TK_STAREQ, TK_SLASHEQ,
+        TK_EQ, TK_NE, TK_LT, TK_LE, TK_GT, TK_GE,
+        TK_ERROR,
+    };
+
+    struct Token {
+        uint8_t kind;
+        const char* start;
+        uint16_t len;
+        int32_t i;
+        float f;
+    };
+
+    struct Native {
+        char name[NAME_LEN];
+        NativeFn fn;
+        uint8_t minArgs;
+        uint8_t maxArgs;
+    };
+
+    struct Loop {
+        uint16_t breaks[MAX_JUMPS];
+        uint16_t conts[MAX_JUMPS];
+        uint8_t nBreaks;
+        uint8_t nConts;
+    };
+
+    static bool isNameStart(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    void nextToken() {
+        while (_pos < _end && (*_pos == ' ' || *_pos == '\t')) _pos++;
+        Token& t = _tok;
+        t.start = _pos;
+        t.len = 0;
+        if (_pos >= _end) {
+            t.kind = TK_END;
+            return;
+        }
+
+        char c = *_pos;
+        if (isNameStart(c)) {
+            while (_pos < _end && (isNameStart(*_pos) || isDigit(*_pos))) _pos++;
+            t.len = _pos - t.start;
+            t.kind = keyword(t.start, t.len);
+            return;
+        }
+
+        if (isDigit(c) || (c == '.' && _pos + 1 < _end && isDigit(_pos[1]))) {
+            int64_t iv = 0;
+            while (_pos < _end && isDigit(*_pos)) {
+                iv = iv * 10 + (*_pos++ - '0');
+                if (iv > INT32_MAX) iv = (int64_t)INT32_MAX + 1;  // Saturate, flagged below
+            }
+            if (_pos < _end && *_pos == '.') {
+                float fv = (float)iv, scale = 0.1f;
+                for (_pos++; _pos < _end && isDigit(*_pos); _pos++, scale *= 0.1f) {
+                    fv += (*_pos - '0') * scale;
+                }
+                t.kind = TK_FLOAT;
+                t.f = fv;
+            } else if (iv > INT32_MAX) {
+                t.kind = TK_ERROR;
+            } else {
+                t.kind = TK_INT;
+                t.i = (int32_t)iv;
+            }
+            t.len = _pos - t.start;
+            return;
+        }
+
+        if (c == '"' || c == '\'') {
+            const char* s = ++_pos;
+            while (_pos < _end && *_pos != c) _pos++;
+            if (_pos >= _end) {
+                t.kind = TK_ERROR;  // Unterminated string
+                t.start = s - 1;
+                return;
+            }
+            t.kind = TK_STR;
+            t.start = s;
+            t.len = _pos - s;
+            _pos++;
+            return;
+        }
+
+        // Operators; pick() takes the two-character form when the next char matches
+        char n = (_pos + 1 < _end) ? _pos[1] : '\0';
+        t.len = 1;
+        switch (c) {
+        case '+': t.kind = pick(n, '=', TK_PLUSEQ, TK_PLUS); break;
+        case '-': t.kind = pick(n, '=', TK_MINUSEQ, TK_MINUS); break;
+        case '*': t.kind = pick(n, '=', TK_STAREQ, TK_STAR); break;
+        case '/': t.kind = (n == '/') ? pick(n, '/', TK_DSLASH, TK_SLASH)
+                                      : pick(n, '=', TK_SLASHEQ, TK_SLASH); break;
+        case '=': t.kind = pick(n, '=', TK_EQ, TK_ASSIGN); break;
+        case '!': t.kind = pick(n, '=', TK_NE, TK_ERROR); break;
+        case '<': t.kind = pick(n, '=', TK_LE, TK_LT); break;
+        case '>': t.kind = pick(n, '=', TK_GE, TK_GT); break;
+        case '%': t.kind = TK_PERCENT; break;
+        case '(': t.kind = TK_LPAREN; break;
+        case ')': t.kind = TK_RPAREN; break;
+        case ',': t.kind = TK_COMMA; break;
+        case ':': t.kind = TK_COLON; break;
+        case ';': t.kind = TK_SEMI; break;
+        default: t.kind = TK_ERROR; break;
+        }
+        _pos += t.len;
+    }
+
+    uint8_t pick(char next, char want, uint8_t twoChar, uint8_t oneChar) {
+        if (next != want) return oneChar;
+        _tok.len = 2;
+        return twoChar;
+    }
+
+    static uint8_t keyword(const char* s, int len) {
+        struct Kw { const char* word; uint8_t kind; };
+        static const Kw words[] = {
+            {"while", TK_WHILE}, {"for", TK_FOR}, {"in", TK_IN}, {"if", TK_IF},
+            {"and", TK_AND}, {"or", TK_OR}, {"not", TK_NOT}, {"break", TK_BREAK},
+            {"continue", TK_CONTINUE}, {"pass", TK_PASS}, {"True", TK_TRUE},
+            {"False", TK_FALSE}, {"None", TK_NONE},
+        };
+        for (const Kw& k : words) {
+            if ((int)strlen(k.word) == len && memcmp(k.word, s, len) == 0) return k.kind;
+        }
+        return TK_NAME;
+    }
+
+    bool accept(uint8_t kind) {
+        if (_tok.kind != kind) return false;
+        nextToken();
+        return true;
+    }
+
+    bool expect(uint8_t kind, const char* what) {
+        if (accept(kind)) return true;
+        return syntaxError(what);
+    }
+
+    bool syntaxError(const char* expected) {
+        if (_failed) return false;
+        _failed = true;
+        if (_tok.kind == TK_END) {
+            return fail("SyntaxError: expected %s at end", expected);
+        }
+        return fail("SyntaxError: expected %s near '%.*s'", expected,
+                    _tok.len ? (int)_tok.len : 1, _tok.start);
+    }
+
+    bool compileError(const char* msg) {
+        if (_failed) return false;
+        _failed = true;
+        return fail("%s", msg);
+    }
+
+    // ============================================
+    // Emitter
+    // ============================================
+
+    bool reserve(int bytes) {
+        if (_codeLen + bytes > _strTop) return compileError("statement too long");
+        return true;
+    }
+
+    // The compiler recurses once per nesting level, a few C frames each;
+    // bound it separately from the value stack (loopTask has ~8 KB)
+    bool enterNested() {
+        if (++_nesting > MAX_NESTING) {
+            _nesting--;
+            return compileError("expression too deep");
+        }
+        return true;
+    }
+
+    // Track stack depth so the VM never needs overflow checks
+    void adjustDepth(int delta) {
+        _depth += delta;
+        if (_depth > _maxDepth) _maxDepth = _depth;
+        if (_depth > STACK_SIZE) compileError("expression too deep");
+    }
+
+    void emit(uint8_t op, int delta) {
+        if (!reserve(1)) return;
+        _arena[_codeLen++] = op;
+        adjustDepth(delta);
+    }
+
+    void emit8(uint8_t v) {
+        if (reserve(1)) _arena[_codeLen++] = v;
+    }
+
+    void emit16(uint16_t v) {
+        if (!reserve(2)) return;
+        _arena[_codeLen++] = v & 0xFF;
+        _arena[_codeLen++] = v >> 8;
+    }
+
+    void emit32(const void* p) {
+        if (!reserve(4)) return;
+        memcpy(_arena + _codeLen, p, 4);
+        _codeLen += 4;
+    }
+
+    // Jump with a placeholder target; returns the operand position
+    uint16_t emitJump(uint8_t op, int delta) {
+        emit(op, delta);
+        uint16_t at = _codeLen;
+        emit16(0);
+        return at;
+    }
+
+    void patch(uint16_t at, uint16_t target) {
+        if (_failed) return;
+        _arena[at] = target & 0xFF;
+        _arena[at + 1] = target >> 8;
+    }
+
+    // Copy a string literal to the top of the arena; returns its offset
+    bool internString(const char* s, int len, uint16_t& offset) {
+        if (_strTop - (len + 1) < _codeLen) return compileError("statement too long");
+        _strTop -= len + 1;
+        memcpy(_arena + _strTop, s, len);
+        _arena[_strTop + len] = '\0';
+        offset = _strTop;
+        return true;
+    }
+
+    // Variable slot for a name (created if missing)
+    int varSlot(const char* name, int len) {
+        if (len >= NAME_LEN) {
+            compileError("name too long");
+            return -1;
+        }
+        int freeSlot = -1;
+        for (int i = 0; i < MAX_VARS; i++) {
+            if (_varNames[i][0] == '\0') {
+                if (freeSlot < 0) freeSlot = i;
+            } else if ((int)strlen(_varNames[i]) == len && memcmp(_varNames[i], name, len) == 0) {
+                return i;
+            }
+        }
+        if (freeSlot < 0) {
+            compileError("too many variables");
+            return -1;
+        }
+        memcpy(_varNames[freeSlot], name, len);
+        _varNames[freeSlot][len] = '\0';
+        _vars[freeSlot].type = T_UNDEF;
+        return freeSlot;
+    }
+
+    int tempSlot() {
+        if (_tempCount >= MAX_TEMPS) {
+            compileError("loops nested too deep");
+            return -1;
+        }
+        int slot = MAX_VARS + _tempCount++;
+        _vars[slot].type = T_UNDEF;
+        return slot;
+    }
+
+    int nativeIndex(const char* name, int len) const {
+        for (int i = 0; i < _nativeCount; i++) {
+            if ((int)strlen(_natives[i].name) == len && memcmp(_natives[i].name, name, len) == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Names in slots that were never assigned are released after each run
+    void releaseUndefined() {
+        for (int i = 0; i < MAX_VARS; i++) {
+            if (_vars[i].type == T_UNDEF) _varNames[i][0] = '\0';
+        }
+    }
+
+    // ============================================
+    // Compiler (recursive descent)
+    // ============================================
+
+    void statementList(bool top) {
+        do {
+            if (_tok.kind == TK_END) break;  // Trailing ';'
+            statement(top);
+            if (_failed) return;
+        } while (accept(TK_SEMI));
+    }
+
+    void statement(bool top) {
+        switch (_tok.kind) {
+        case TK_WHILE: whileStatement(); return;
+        case TK_FOR: forStatement(); return;
+        case TK_IF: ifStatement(); return;
+        case TK_PASS: nextToken(); return;
+        case TK_BREAK:
+        case TK_CONTINUE: jumpStatement(); return;
+        case TK_NAME: {
+            // Assignment needs one token of lookahead
+            const char* savePos = _pos;
+            Token name = _tok;
+            nextToken();
+            uint8_t op = _tok.kind;
+            if (op == TK_ASSIGN || op == TK_PLUSEQ || op == TK_MINUSEQ ||
+                op == TK_STAREQ || op == TK_SLASHEQ) {
+                nextToken();
+                assignment(name, op);
+                return;
+            }
+            _pos = savePos;
+            _tok = name;
+            break;
+        }
+        default:
+            break;
+        }
+
+        expression();
+        emit(top ? OP_ECHO : OP_POP, -1);
+    }
+
+    void assignment(const Token& name, uint8_t op) {
+        int slot = varSlot(name.start, name.len);
+        if (slot < 0) return;
+        if (op != TK_ASSIGN) {
+            emit(OP_LOAD, 1);
+            emit8(slot);
+        }
+        expression();
+        switch (op) {
+        case TK_PLUSEQ: emit(OP_ADD, -1); break;
+        case TK_MINUSEQ: emit(OP_SUB, -1); break;
+        case TK_STAREQ: emit(OP_MUL, -1); break;
+        case TK_SLASHEQ: emit(OP_DIV, -1); break;
+        default: break;
+        }
+        emit(OP_STORE, -1);
+        emit8(slot);
+    }
+
+    void whileStatement() {
+        nextToken();
+        uint16_t start = _codeLen;
+        expression();
+        uint16_t exitJump = emitJump(OP_JZ, -1);
+        if (!expect(TK_COLON, "':'")) return;
+
+        if (!beginLoop()) return;
+        statementList(false);
+        emit(OP_JMP, 0);
+        emit16(start);
+        patch(exitJump, _codeLen);
+        endLoop(_codeLen, start);
+    }
+
+    // for NAME in range(...): body
+    void forStatement() {
+        nextToken();
+        if (_tok.kind != TK_NAME) {
+            syntaxError("loop variable");
+            return;
+        }
+        Token name = _tok;
+        nextToken();
+        if (!expect(TK_IN, "'in'")) return;
+        if (_tok.kind != TK_NAME || _tok.len != 5 || memcmp(_tok.start, "range", 5) != 0) {
+            syntaxError("range(...)");
+            return;
+        }
+        nextToken();
+        if (!expect(TK_LPAREN, "'('")) return;
+
+        // The counter is hidden: assigning the loop variable in the body
+        // doesn't change the iterations, as in Python
+        int var = varSlot(name.start, name.len);
+        int counter = tempSlot();
+        int stop = tempSlot();
+        int step = tempSlot();
+        if (var < 0 || counter < 0 || stop < 0 || step < 0) return;
+
+        // Arguments are evaluated before the loop variable is assigned
+        int argc = 0;
+        do {
+            expression();
+            if (_failed) return;
+            argc++;
+        } while (argc < 3 && accept(TK_COMMA));
+        if (!expect(TK_RPAREN, "')'")) return;
+
+        int32_t zero = 0, one = 1;
+        if (argc == 1) {
+            emit(OP_STORE, -1); emit8(stop);
+            emit(OP_INT, 1); emit32(&zero);
+            emit(OP_STORE, -1); emit8(counter);
+        } else {
+            if (argc == 3) {
+                emit(OP_STORE, -1); emit8(step);
+            }
+            emit(OP_STORE, -1); emit8(stop);
+            emit(OP_STORE, -1); emit8(counter);
+        }
+        if (argc < 3) {
+            emit(OP_INT, 1); emit32(&one);
+            emit(OP_STORE, -1); emit8(step);
+        }
+        if (!expect(TK_COLON, "':'")) return;
+
+        uint16_t test = _codeLen;
+        emit(OP_FOR_TEST, 0);
+        emit8(counter);
+        emit8(stop);
+        emit8(step);
+        emit8(var);
+        uint16_t exitJump = _codeLen;
+        emit16(0);
+
+        if (!beginLoop()) return;
+        statementList(false);
+        uint16_t next = _codeLen;
+        emit(OP_FOR_NEXT, 0);
+        emit8(counter);
+        emit8(stop);
+        emit8(step);
+        emit16(test);
+        patch(exitJump, _codeLen);
+        endLoop(_codeLen, next);
+    }
+
+    void ifStatement() {
+        nextToken();
+        expression();
+        uint16_t skip = emitJump(OP_JZ, -1);
+        if (!expect(TK_COLON, "':'")) return;
+        if (!enterNested()) return;
+        statementList(false);
+        _nesting--;
+        patch(skip, _codeLen);
+    }
+
+    void jumpStatement() {
+        bool isBreak = _tok.kind == TK_BREAK;
+        nextToken();
+        if (_loopDepth == 0) {
+            compileError(isBreak ? "SyntaxError: 'break' outside loop"
+                                 : "SyntaxError: 'continue' outside loop");
+            return;
+        }
+        Loop& loop = _loops[_loopDepth - 1];
+        uint8_t& count = isBreak ? loop.nBreaks : loop.nConts;
+        if (count >= MAX_JUMPS) {
+            compileError("too many break/continue");
+            return;
+        }
+        uint16_t at = emitJump(OP_JMP, 0);
+        (isBreak ? loop.breaks : loop.conts)[count++] = at;
+    }
+
+    bool beginLoop() {
+        if (_loopDepth >= MAX_LOOPS) return compileError("loops nested too deep");
+        Loop& loop = _loops[_loopDepth++];
+        loop.nBreaks = loop.nConts = 0;
+        return true;
+    }
+
+    void endLoop(uint16_t breakTarget, uint16_t continueTarget) {
+        Loop& loop = _loops[--_loopDepth];
+        for (int i = 0; i < loop.nBreaks; i++) patch(loop.breaks[i], breakTarget);
+        for (int i = 0; i < loop.nConts; i++) patch(loop.conts[i], continueTarget);
+    }
+
+    // --- Expressions, lowest precedence first ---
+
+    void expression() {
+        andExpr();
+        while (!_failed && accept(TK_OR)) {
+            uint16_t j = emitJump(OP_JNZ_KEEP, -1);
+            andExpr();
+            patch(j, _codeLen);
+        }
+    }
+
+    void andExpr() {
+        notExpr();
+        while (!_failed && accept(TK_AND)) {
+            uint16_t j = emitJump(OP_JZ_KEEP, -1);
+            notExpr();
+            patch(j, _codeLen);
+        }
+    }
+
+    void notExpr() {
+        if (accept(TK_NOT)) {
+            if (!enterNested()) return;
+            notExpr();
+            _nesting--;
+            emit(OP_NOT, 0);
+            return;
+        }
+        comparison();
+    }
+
+    void comparison() {
+        additive();
+        uint8_t op;
+        switch (_tok.kind) {
+        case TK_LT: op = OP_LT; break;
+        case TK_LE: op = OP_LE; break;
+        case TK_GT: op = OP_GT; break;
+        case TK_GE: op = OP_GE; break;
+        case TK_EQ: op = OP_EQ; break;
+        case TK_NE: op = OP_NE; break;
+        default: return;
+        }
+        nextToken();
+        additive();
+        emit(op, -1);
+        if (_tok.kind >= TK_EQ && _tok.kind <= TK_GE) {
+            compileError("SyntaxError: chained comparisons not supported");
+        }
+    }
+
+    void additive() {
+        term();
+        while (!_failed) {
+            if (accept(TK_PLUS)) { term(); emit(OP_ADD, -1); }
+            else if (accept(TK_MINUS)) { term(); emit(OP_SUB, -1); }
+            else break;
+        }
+    }
+
+    void term() {
+        unary();
+        while (!_failed) {
+            uint8_t op;
+            switch (_tok.kind) {
+            case TK_STAR: op = OP_MUL; break;
+            case TK_SLASH: op = OP_DIV; break;
+            case TK_DSLASH: op = OP_IDIV; break;
+            case TK_PERCENT: op = OP_MOD; break;
+            default: return;
+            }
+            nextToken();
+            unary();
+            emit(op, -1);
+        }
+    }
+
+    void unary() {
+        if (accept(TK_MINUS)) {
+            // Fold negative literals
+            if (_tok.kind == TK_INT) {
+                int32_t v = -_tok.i;
+                emit(OP_INT, 1); emit32(&v);
+                nextToken();
+                return;
+            }
+            if (_tok.kind == TK_FLOAT) {
+                float v = -_tok.f;
+                emit(OP_FLOAT, 1); emit32(&v);
+                nextToken();
+                return;
+            }
+            if (!enterNested()) return;
+            unary();
+            _nesting--;
+            emit(OP_NEG, 0);
+            return;
+        }
+        if (accept(TK_PLUS)) {
+            if (!enterNested()) return;
+            unary();
+            _nesting--;
+            return;
+        }
+        primary();
+    }
+
+    void primary() {
+        Token t = _tok;
+        switch (t.kind) {
+        case TK_INT:
+            nextToken();
+            emit(OP_INT, 1); emit32(&t.i);
+            return;
+        case TK_FLOAT:
+            nextToken();
+            emit(OP_FLOAT, 1); emit32(&t.f);
+            return;
+        case TK_TRUE:
+        case TK_FALSE: {
+            nextToken();
+            int32_t v = (t.kind == TK_TRUE) ? 1 : 0;
+            emit(OP_INT, 1); emit32(&v);
+            return;
+        }
+        case TK_NONE:
+            nextToken();
+            emit(OP_NONE, 1);
+            return;
+        case TK_STR: {
+            nextToken();
+            uint16_t off = 0;
+            if (!internString(t.start, t.len, off)) return;
+            emit(OP_STR, 1); emit16(off);
+            return;
+        }
+        case TK_LPAREN:
+            nextToken();
+            if (!enterNested()) return;
+            expression();
+            _nesting--;
+            expect(TK_RPAREN, "')'");
+            return;
+        case TK_NAME:
+            nextToken();
+            if (_tok.kind == TK_LPAREN) {
+                if (!enterNested()) return;
+                call(t);
+                _nesting--;
+            } else {
+                int slot = varSlot(t.start, t.len);
+                if (slot < 0) return;
+                emit(OP_LOAD, 1); emit8(slot);
+            }
+            return;
+        case TK_ERROR:
+            if (*t.start == '"' || *t.start == '\'') compileError("SyntaxError: unterminated string");
+            else syntaxError("valid token");
+            return;
+        default:
+            syntaxError("expression");
+            return;
+        }
+    }
+
+    void call(const Token& name) {
+        int idx = nativeIndex(name.start, name.len);
+        if (idx < 0) {
+            _failed = true;
+            fail("NameError: function '%.*s' is not defined", (int)name.len, name.start);
+            return;
+        }
+        nextToken();  // '('
+        int argc = 0;
+        if (_tok.kind != TK_RPAREN) {
+            do {
+                if (argc >= MAX_ARGS) {
+                    compileError("too many arguments");
+                    return;
+                }
+                expression();
+                if (_failed) return;
+                argc++;
+            } while (accept(TK_COMMA));
+        }
+        if (!expect(TK_RPAREN, "')'")) return;
+
+        const Native& n = _natives[idx];
+        if (argc < n.minArgs || argc > n.maxArgs) {
+            _failed = true;
+            fail("TypeError: %s() takes %d..%d arguments", n.name, n.minArgs, n.maxArgs);
+            return;
+        }
+        emit(OP_CALL, 1 - argc);
+        emit8(idx);
+        emit8(argc);
+    }
+
+    // ============================================
+    // Interpreter helpers
+    // ============================================
+
+    static bool truthy(const Value& v) {
+        switch (v.type) {
+        case T_INT: return v.i != 0;
+        case T_FLOAT: return v.f != 0.0f;
+        case T_STR: return v.s[0] != '\0';
+        default: return false;
+        }
+    }
+
+    static uint16_t read16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+    // Slow path for binary ops (mixed types, floats, errors); a = a op b
+    bool binary(uint8_t op, Value& a, const Value& b) {
+        if (op == OP_EQ || op == OP_NE) {
+            bool eq;
+            if (isNumber(a) && isNumber(b)) eq = toFloat(a) == toFloat(b);
+            else if (a.type == T_STR && b.type == T_STR) eq = strcmp(a.s, b.s) == 0;
+            else eq = a.type == b.type && a.type == T_NONE;
+            a = fromInt((op == OP_EQ) == eq);
+            return true;
+        }
+        if (!isNumber(a) || !isNumber(b)) return fail("TypeError: unsupported operand types");
+
+        if (a.type == T_INT && b.type == T_INT) {
+            int32_t x = a.i, y = b.i;
+            switch (op) {
+            case OP_DIV:
+                if (y == 0) return fail("ZeroDivisionError: division by zero");
+                a = fromFloat((float)x / (float)y);
+                return true;
+            case OP_IDIV:
+            case OP_MOD: {
+                if (y == 0) return fail("ZeroDivisionError: integer division or modulo by zero");
+                if (y == -1) {
+                    // INT32_MIN / -1 overflows (undefined in C)
+                    if (op == OP_MOD) a = fromInt(0);
+                    else if (x == INT32_MIN) return fail("OverflowError: integer division result too large");
+                    else a = fromInt(-x);
+                    return true;
+                }
+                int32_t q = x / y, r = x % y;
+                if (r != 0 && ((r < 0) != (y < 0))) { q--; r += y; }  // Floor semantics
+                a = fromInt(op == OP_IDIV ? q : r);
+                return true;
+            }
+            default:
+                break;  // Handled by the fast path
+            }
+        }
+
+        float x = toFloat(a), y = toFloat(b);
+        switch (op) {
+        case OP_ADD: a = fromFloat(x + y); break;
+        case OP_SUB: a = fromFloat(x - y); break;
+        case OP_MUL: a = fromFloat(x * y); break;
+        case OP_DIV:
+            if (y == 0.0f) return fail("ZeroDivisionError: float division by zero");
+            a = fromFloat(x / y);
+            break;
+        case OP_IDIV:
+            if (y == 0.0f) return fail("ZeroDivisionError: float divmod()");
+            a = fromFloat(floorf(x / y));
+            break;
+        case OP_MOD: {
+            if (y == 0.0f) return fail("ZeroDivisionError: float modulo");
+            float r = fmodf(x, y);
+            if (r != 0.0f && ((r < 0.0f) != (y < 0.0f))) r += y;
+            a = fromFloat(r);
+            break;
+        }
+        case OP_LT: a = fromInt(x < y); break;
+        case OP_LE: a = fromInt(x <= y); break;
+        case OP_GT: a = fromInt(x > y); break;
+        case OP_GE: a = fromInt(x >= y); break;
+        default: return fail("bad opcode");
+        }
+        return true;
+    }
+
+    // ============================================
+    // Built-in natives
+    // ============================================
+
+    static bool nativePrint(TinyVm& vm, const Value* args, int argc, Value& result) {
+        char line[LINE_LEN];
+        int pos = 0;
+        line[0] = '\0';
+        for (int i = 0; i < argc && pos < LINE_LEN - 1; i++) {
+            if (i > 0) line[pos++] = ' ';
+            format(args[i], line + pos, LINE_LEN - pos, false);
+            pos += strlen(line + pos);
+        }
+        line[pos] = '\0';
+        vm.output(line);
+        result = none();
+        return true;
+    }
+
+    static bool nativeAbs(TinyVm& vm, const Value* args, int, Value& result) {
+        if (args[0].type == T_INT) result = fromInt(args[0].i < 0 ? (int32_t)(0u - (uint32_t)args[0].i) : args[0].i);
+        else if (args[0].type == T_FLOAT) result = fromFloat(fabsf(args[0].f));
+        else return vm.fail("TypeError: bad operand for abs()");
+        return true;
+    }
+
+    static bool nativeInt(TinyVm& vm, const Value* args, int, Value& result) {
+        if (!isNumber(args[0])) return vm.fail("TypeError: int() needs a number");
+        result = fromInt(args[0].type == T_INT ? args[0].i : (int32_t)args[0].f);
+        return true;
+    }
+
+    static bool nativeFloat(TinyVm& vm, const Value* args, int, Value& result) {
+        if (!isNumber(args[0])) return vm.fail("TypeError: float() needs a number");
+        result = fromFloat(toFloat(args[0]));
+        return true;
+    }
+
+    static bool minMax(TinyVm& vm, const Value* args, int argc, Value& result, bool wantMax) {
+        for (int i = 0; i < argc; i++) {
+            if (!isNumber(args[i])) return vm.fail("TypeError: min()/max() need numbers");
+        }
+        result = args[0];
+        for (int i = 1; i < argc; i++) {
+            float x = toFloat(args[i]), r = toFloat(result);
+            if (wantMax ? x > r : x < r) result = args[i];
+        }
+        return true;
+    }
+
+    static bool nativeMin(TinyVm& vm, const Value* args, int argc, Value& result) {
+        return minMax(vm, args, argc, result, false);
+    }
+
+    static bool nativeMax(TinyVm& vm, const Value* args, int argc, Value& result) {
+        return minMax(vm, args, argc, result, true);
+    }
+
+    // ============================================
+    // State
+    // ============================================
+
+    OutputFn _out;
+    void* _outCtx;
+
+    Native _natives[MAX_NATIVES];
+    int _nativeCount;
+
+    char _varNames[MAX_VARS + MAX_TEMPS][NAME_LEN];
+    Value _vars[MAX_VARS + MAX_TEMPS];
+    char _strVals[MAX_VARS][STR_LEN];  // Strings assigned to variables
+
+    Value _stack[STACK_SIZE];
+    uint32_t _stepLimit;
+    uint32_t _lastSteps;
+
+    // Per-statement compile state
+    uint8_t _arena[ARENA_SIZE];
+    uint16_t _codeLen;
+    uint16_t _strTop;
+    int _depth;
+    int _maxDepth;
+    int _nesting;
+    int _tempCount;
+    Loop _loops[MAX_LOOPS];
+    int _loopDepth;
+    bool _failed;
+    const char* _pos;
+    const char* _end;
+    Token _tok;
+
+    char _error[ERROR_LEN];
+};
+
+// ============================================
+// Compile / execute
+// ============================================
+
+inline bool TinyVm::compile(const char* src, size_t len) {
+    _codeLen = 0;
+    _strTop = ARENA_SIZE;
+    _depth = _maxDepth = 0;
+    _nesting = 0;
+    _tempCount = 0;
+    _loopDepth = 0;
+    _failed = false;
+    _error[0] = '\0';
+    _pos = src;
+    _end = src + len;
+
+    nextToken();
+    statementList(true);
+    if (!_failed && _tok.kind != TK_END) {
+        syntaxError("end of statement");
+    }
+    emit(OP_HALT, 0);
+    return !_failed;
+}
+
+inline bool TinyVm::execute() {
+    const uint8_t* code = _arena;
+    uint32_t pc = 0;
+    Value* sp = _stack;  // Next free slot; depth checked at compile time
+    uint32_t steps = 0;
+    char buf[LINE_LEN];
+
+// Int fast path for arithmetic/compare, slow path otherwise
+#define TINYVM_BINARY(OPCODE, INT_EXPR)                                      \
+    case OPCODE: {                                                           \
+        Value& a = sp[-2];                                                   \
+        const Value& b = sp[-1];                                             \
+        if (a.type == T_INT && b.type == T_INT) {                            \
+            a.i = (INT_EXPR);                                                \
+        } else if (!binary(OPCODE, a, b)) {                                  \
+            goto error;                                                      \
+        }                                                                    \
+        sp--;                                                                \
+        break;                                                               \
+    }
+
+    for (;;) {
+        steps++;
+        uint8_t op = code[pc++];
+        switch (op) {
+        case OP_HALT:
+            _lastSteps = steps;
+            return true;
+
+        case OP_INT:
+            sp->type = T_INT;
+            memcpy(&sp->i, code + pc, 4);
+            sp++;
+            pc += 4;
+            break;
+        case OP_FLOAT:
+            sp->type = T_FLOAT;
+            memcpy(&sp->f, code + pc, 4);
+            sp++;
+            pc += 4;
+            break;
+        case OP_STR:
+            sp->type = T_STR;
+            sp->s = (const char*)(code + read16(code + pc));
+            sp++;
+            pc += 2;
+            break;
+        case OP_NONE:
+            *sp++ = none();
+            break;
+
+        case OP_LOAD: {
+            uint8_t slot = code[pc++];
+            if (_vars[slot].type == T_UNDEF) {
+                fail("NameError: name '%s' is not defined", _varNames[slot]);
+                goto error;
+            }
+            *sp++ = _vars[slot];
+            break;
+        }
+        case OP_STORE: {
+            uint8_t slot = code[pc++];
+            Value v = *--sp;
+            if (v.type == T_STR && slot < MAX_VARS && v.s != _strVals[slot]) {
+                // Literals die with the arena; keep a bounded copy
+                strncpy(_strVals[slot], v.s, STR_LEN - 1);
+                _strVals[slot][STR_LEN - 1] = '\0';
+                v.s = _strVals[slot];
+            }
+            _vars[slot] = v;
+            break;
+        }
+        case OP_POP:
+            sp--;
+            break;
+        case OP_ECHO:
+            sp--;
+            if (sp->type != T_NONE) {
+                format(*sp, buf, sizeof(buf), true);
+                output(buf);
+            }
+            break;
+
+        TINYVM_BINARY(OP_ADD, (int32_t)((uint32_t)a.i + (uint32_t)b.i))
+        TINYVM_BINARY(OP_SUB, (int32_t)((uint32_t)a.i - (uint32_t)b.i))
+        TINYVM_BINARY(OP_MUL, (int32_t)((uint32_t)a.i * (uint32_t)b.i))
+        TINYVM_BINARY(OP_LT, a.i < b.i)
+        TINYVM_BINARY(OP_LE, a.i <= b.i)
+        TINYVM_BINARY(OP_GT, a.i > b.i)
+        TINYVM_BINARY(OP_GE, a.i >= b.i)
+        TINYVM_BINARY(OP_EQ, a.i == b.i)
+        TINYVM_BINARY(OP_NE, a.i != b.i)
+
+        case OP_DIV:
+        case OP_IDIV:
+        case OP_MOD:
+            if (!binary(op, sp[-2], sp[-1])) goto error;
+            sp--;
+            break;
+
+        case OP_NEG: {
+            Value& a = sp[-1];
+            if (a.type == T_INT) a.i = (int32_t)(0u - (uint32_t)a.i);
+            else if (a.type == T_FLOAT) a.f = -a.f;
+            else { fail("TypeError: bad operand for unary -"); goto error; }
+            break;
+        }
+        case OP_NOT:
+            sp[-1] = fromInt(!truthy(sp[-1]));
+            break;
+
+        case OP_JMP: {
+            uint16_t target = read16(code + pc);
+            if (target < pc && steps > _stepLimit) goto stepLimit;
+            pc = target;
+            break;
+        }
+        case OP_JZ:
+            sp--;
+            pc = truthy(*sp) ? pc + 2 : read16(code + pc);
+            break;
+        case OP_JZ_KEEP:
+            if (!truthy(sp[-1])) { pc = read16(code + pc); }
+            else { sp--; pc += 2; }
+            break;
+        case OP_JNZ_KEEP:
+            if (truthy(sp[-1])) { pc = read16(code + pc); }
+            else { sp--; pc += 2; }
+            break;
+
+        case OP_CALL: {
+            const Native& n = _natives[code[pc]];
+            uint8_t argc = code[pc + 1];
+            pc += 2;
+            Value result;
+            if (!n.fn(*this, sp - argc, argc, result)) goto error;
+            sp -= argc;
+            *sp++ = result;
+            break;
+        }
+
+        case OP_FOR_TEST: {
+            const Value& v = _vars[code[pc]];
+            const Value& stop = _vars[code[pc + 1]];
+            const Value& step = _vars[code[pc + 2]];
+            if (v.type != T_INT || stop.type != T_INT || step.type != T_INT) {
+                fail("TypeError: range() needs integers");
+                goto error;
+            }
+            if (step.i == 0) {
+                fail("ValueError: range() step must not be zero");
+                goto error;
+            }
+            bool more = step.i > 0 ? v.i < stop.i : v.i > stop.i;
+            if (more) _vars[code[pc + 3]] = v;
+            pc = more ? pc + 6 : read16(code + pc + 4);
+            break;
+        }
+        case OP_FOR_NEXT: {
+            // Past the int range means past stop too: end the loop there
+            Value& v = _vars[code[pc]];
+            int64_t next = (int64_t)v.i + _vars[code[pc + 2]].i;
+            v.i = next > INT32_MAX || next < INT32_MIN ? _vars[code[pc + 1]].i : (int32_t)next;
+            if (steps > _stepLimit) goto stepLimit;
+            pc = read16(code + pc + 3);
+            break;
+        }
+
+        default:
+            fail("bad opcode %d", op);
+            goto error;
+        }
+    }
+#undef TINYVM_BINARY
+
+stepLimit:
+    fail("step limit (%lu) exceeded", (unsigned long)_stepLimit);
+error:
+    _lastSteps = steps;
+    return false;
+}
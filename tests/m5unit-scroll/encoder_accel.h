@@ -0,0 +1,128 @@
+/*
+ * Velocity-aware encoder acceleration
+ *
+ * Turns raw encoder detents into list steps. Every detent is kept (no
+ * debounce that throws increments away): slow turns move one item per
+ * detent, fast spins are multiplied by a gain that grows with the
+ * estimated angular velocity, so one flick crosses a long list.
+ *
+ * Velocity is an exponential moving average of detents per second over
+ * the intervals between movements. Fractional steps are carried to
+ * the next update, and reversing direction or pausing drops the
+ * carry and the velocity, so the first detent after a pause or a turn
+ * back always moves exactly one item.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class EncoderAccel {
+public:
+    enum Curve {
+        CURVE_OFF,        // 1 step per detent
+        CURVE_LINEAR,     // Gain grows linearly above the threshold
+        CURVE_QUADRATIC,  // Gentle at first, steep for real spins
+        CURVE_STEPPED,    // Fixed gain bands (x1 / x4 / x16 / x64)
+        CURVE_COUNT
+    };
+
+    struct Config {
+        Curve curve;
+        float threshold;  // Detents/s below which gain is 1
+        float factor;     // Linear: gain per detent/s, quadratic: per (detent/s)^2
+        float maxGain;
+        uint16_t idleMs;  // Pause that resets velocity and carry
+    };
+
+    static Config defaultConfig(Curve curve) {
+        Config c;
+        c.curve = curve;
+        c.threshold = 8.0f;
+        c.factor = (curve == CURVE_QUADRATIC) ? 0.05f : 0.5f;
+        c.maxGain = 100.0f;
+        c.idleMs = 250;
+        return c;
+    }
+
+    EncoderAccel() : _velocity(0), _gain(1), _carry(0), _lastMs(0), _lastDir(0) {
+        _cfg = defaultConfig(CURVE_QUADRATIC);
+    }
+
+    void setConfig(const Config& cfg) { _cfg = cfg; reset(); }
+    const Config& config() const { return _cfg; }
+
+    void reset() {
+        _velocity = 0;
+        _gain = 1;
+        _carry = 0;
+        _lastDir = 0;
+    }
+
+    // Feed the detents counted since the previous call; returns list steps
+    int update(int32_t detents, uint32_t nowMs) {
+        if (detents == 0) return 0;
+
+        // Time since the previous movement (polls without detents in
+        // between count as part of the interval)
+        uint32_t dt = nowMs - _lastMs;
+        _lastMs = nowMs;
+        if (dt > _cfg.idleMs) reset();
+
+        int dir = detents > 0 ? 1 : -1;
+        if (dir != _lastDir) reset();
+        bool fresh = (_lastDir == 0);
+        _lastDir = dir;
+
+        // EMA of |detents| / s; a tiny dt (two polls back to back) would
+        // give a meaningless spike, so clamp it to the poll granularity
+        float instant = (float)abs(detents) * 1000.0f / (float)max(dt, (uint32_t)10);
+        _velocity = fresh ? instant : _velocity + 0.4f * (instant - _velocity);
+
+        // The first detents of a movement always move 1:1 (dt before
+        // them is not part of the movement)
+        _gain = fresh ? 1.0f : gainFor(_velocity);
+
+        float steps = (float)detents * _gain + _carry;
+        int out = (int)steps;  // Truncate toward zero
+        _carry = steps - (float)out;
+        return out;
+    }
+
+    float velocity() const { return _velocity; }
+    float gain() const { return _gain; }
+
+    static const char* curveName(Curve c) {
+        static const char* const names[CURVE_COUNT] = {"off", "linear", "quad", "stepped"};
+        return (c >= 0 && c < CURVE_COUNT) ? names[c] : "?";
+    }
+
+private:
+    float gainFor(float v) const {
+        float over = v - _cfg.threshold;
+        if (over <= 0) return 1.0f;
+        float g;
+        switch (_cfg.curve) {
+            case CURVE_LINEAR:
+                g = 1.0f + _cfg.factor * over;
+                break;
+            case CURVE_QUADRATIC:
+                g = 1.0f + _cfg.factor * over * over;
+                break;
+            case CURVE_STEPPED:
+                g = (v < _cfg.threshold * 2) ? 4.0f : (v < _cfg.threshold * 4) ? 16.0f : 64.0f;
+                break;
+            default:
+                g = 1.0f;
+                break;
+        }
+        return min(g, _cfg.maxGain);
+    }
+
+    Config _cfg;
+    float _velocity;   // Detents per second (EMA)
+    float _gain;
+    float _carry;      // Fractional steps not yet applied
+    uint32_t _lastMs;  // Last update() with detents
+    int _lastDir;
+};
@@ -0,0 +1,308 @@
+/*
+ * Pre-rendered glyph atlas for the external ILI9488 display
+ *
+ * The ILI9488 takes 3 bytes per pixel over SPI (RGB666 in the top bits of
+ * each byte), so every LovyanGFX print() rasterizes glyphs and converts
+ * colors on the fly. The atlas renders the built-in 6x8 font once per
+ * (scale, fg, bg) face into tiles already in the panel's wire format
+ * (lgfx::bgr888_t = R,G,B bytes). Text is then composed row by row with
+ * memcpy into a block buffer and sent with a single pushImageDMA().
+ *
+ * There are two block buffers: while one is on the SPI DMA the next block
+ * is composed into the other (needs b.dma_channel = SPI_DMA_CH_AUTO on the
+ * bus; without DMA the push simply blocks).
+ *
+ * Tiles live in PSRAM when the board has it. Without PSRAM (or when the
+ * tile budget is used up) a face falls back to expanding the 1-bit glyph
+ * masks straight into the block buffer, which is still a plain byte loop.
+ *
+ * Only printable ASCII (32-126) is rendered; other bytes become spaces.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <esp_heap_caps.h>
+
+class GlyphAtlas {
+public:
+    static constexpr int FIRST_CHAR = 32;
+    static constexpr int GLYPH_COUNT = 95;  // 32..126
+    static constexpr int BASE_W = 6;        // Font0 advance (5 px + 1 spacing)
+    static constexpr int BASE_H = 8;
+    static constexpr int MAX_FACES = 12;
+
+    GlyphAtlas() : _lcd(nullptr), _buf(nullptr), _bufBytes(0), _active(0), _blockW(0), _blockH(0),
+                   _blockBg(0), _faceCount(0), _tileBytesUsed(0), _tileBudget(0), _tileCaps(0) {
+        _blockBuf[0] = _blockBuf[1] = nullptr;
+    }
+
+    // maxBlockPixels: capacity of each block buffer (e.g. 480 * 24 for one
+    // terminal row). tileBudget: bytes of pre-rendered tiles allowed in
+    // PSRAM; internal RAM gets internalBudget instead.
+    bool begin(lgfx::LGFX_Device* lcd, int maxBlockPixels,
+               size_t tileBudget = 1024 * 1024, size_t internalBudget = 64 * 1024) {
+        _lcd = lcd;
+
+        _bufBytes = (size_t)maxBlockPixels * 3;
+        for (int i = 0; i < 2; i++) {
+            _blockBuf[i] = (uint8_t*)heap_caps_malloc(_bufBytes, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+            if (!_blockBuf[i]) {
+                return false;
+            }
+        }
+        _buf = _blockBuf[0];
+
+        if (heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0) {
+            _tileCaps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+            _tileBudget = tileBudget;
+        } else {
+            _tileCaps = MALLOC_CAP_8BIT;
+            _tileBudget = internalBudget;
+        }
+
+        buildMasks();
+        return true;
+    }
+
+    // Glyph cell size for a scale
+    static int glyphWidth(uint8_t scale) { return BASE_W * scale; }
+    static int glyphHeight(uint8_t scale) { return BASE_H * scale; }
+    // Tiles of one face, for sizing the budgets (scale 2: 54,720 bytes)
+    static size_t faceBytes(uint8_t scale) { return (size_t)glyphWidth(scale) * glyphHeight(scale) * 3 * GLYPH_COUNT; }
+
+    // --- Block composition ---
+    // beginBlock() fills a w x h block with bg, blitGlyph() places glyphs at
+    // block-relative pixel positions, endBlock() pushes the block as one
+    // DMA transfer. Returns false if the block does not fit the buffer.
+    bool beginBlock(int w, int h, uint16_t bg) {
+        if (!_blockBuf[1] || w <= 0 || h <= 0 || (size_t)w * h * 3 > _bufBytes) {
+            return false;
+        }
+        // The buffer in flight is the other one. This one's transfer was
+        // finished before that one started (the bus serializes them).
+        _buf = _blockBuf[_active];
+        _blockW = w;
+        _blockH = h;
+        _blockBg = bg;
+
+        uint8_t rgb[3];
+        toNative(bg, rgb);
+        fillPixels(_buf, rgb, w * h);
+        return true;
+    }
+
+    void blitGlyph(int px, int py, char ch, uint8_t scale, uint16_t fg, uint16_t bg) {
+        int gw = glyphWidth(scale);
+        int gh = glyphHeight(scale);
+        if (px < 0 || py < 0 || px + gw > _blockW || py + gh > _blockH) return;
+        if (ch == ' ' && bg == _blockBg) return;  // Already background
+
+        int idx = glyphIndex(ch);
+        uint8_t* dst = _buf + ((size_t)py * _blockW + px) * 3;
+        size_t dstStride = (size_t)_blockW * 3;
+        size_t rowBytes = (size_t)gw * 3;
+
+        const Face* face = findOrCreateFace(scale, fg, bg);
+        if (face && face->tiles) {
+            // Fast path: copy pre-rendered rows
+            const uint8_t* src = face->tiles + (size_t)idx * face->tileBytes;
+            for (int y = 0; y < gh; y++) {
+                memcpy(dst, src, rowBytes);
+                dst += dstStride;
+                src += rowBytes;
+            }
+        } else {
+            expandGlyph(dst, dstStride, idx, scale, fg, bg);
+        }
+    }
+
+    void endBlock(int x, int y) {
+        if (!_blockW) return;
+        _lcd->pushImageDMA(x, y, _blockW, _blockH, (const lgfx::bgr888_t*)_buf);
+        _active ^= 1;
+        _blockW = _blockH = 0;
+    }
+
+    // Block until the last pushed block has left the buffer
+    void waitIdle() {
+        if (_lcd) _lcd->waitDMA();
+    }
+
+    // --- Convenience: one line of text ---
+    // Draws text at (x, y) in a box of boxW x boxH pixels (0 = fit text),
+    // glyph row at glyphY inside the box, everything else filled with bg.
+    // Long boxes are split into several blocks if the buffer is too small.
+    // Wrap several calls in startWrite()/endWrite() to keep the overlap
+    // across lines; endWrite() waits for the last transfer.
+    void drawText(int x, int y, const char* text, int len, uint8_t scale,
+                  uint16_t fg, uint16_t bg, int boxW = 0, int boxH = 0, int glyphY = 0) {
+        int gw = glyphWidth(scale);
+        int gh = glyphHeight(scale);
+        if (boxW <= 0) boxW = len * gw;
+        if (boxH < gh + glyphY) boxH = gh + glyphY;
+        if (boxW <= 0) return;
+
+        // Widest chunk (whole glyphs) that fits the buffer
+        int chunkGlyphs = (int)(_bufBytes / ((size_t)gw * boxH * 3));
+        if (chunkGlyphs <= 0) return;
+        int chunkW = chunkGlyphs * gw;
+
+        // One SPI transaction so chunk N+1 is composed while chunk N is sent
+        _lcd->startWrite();
+        for (int cx = 0; cx < boxW; cx += chunkW) {
+            int w = min(chunkW, boxW - cx);
+            if (!beginBlock(w, boxH, bg)) break;
+            int first = cx / gw;
+            for (int i = 0; i * gw < w && first + i < len; i++) {
+                blitGlyph(i * gw, glyphY, text[first + i], scale, fg, bg);
+            }
+            endBlock(x + cx, y);
+        }
+        _lcd->endWrite();
+    }
+
+    // Pre-render a face ahead of time (e.g. in setup())
+    bool preload(uint8_t scale, uint16_t fg, uint16_t bg) {
+        const Face* face = findOrCreateFace(scale, fg, bg);
+        return face && face->tiles;
+    }
+
+    size_t tileBytesUsed() const { return _tileBytesUsed; }
+    int faceCount() const { return _faceCount; }
+
+private:
+    struct Face {
+        uint8_t scale;
+        uint16_t fg;
+        uint16_t bg;
+        size_t tileBytes;  // Bytes per glyph tile
+        uint8_t* tiles;    // nullptr = mask expansion (over budget)
+    };
+
+    static int glyphIndex(char ch) {
+        int c = (uint8_t)ch;
+        if (c < FIRST_CHAR || c >= FIRST_CHAR + GLYPH_COUNT) return 0;  // Space
+        return c - FIRST_CHAR;
+    }
+
+    static void toNative(uint16_t c, uint8_t* rgb) {
+        uint8_t r = (c >> 11) & 0x1F;
+        uint8_t g = (c >> 5) & 0x3F;
+        uint8_t b = c & 0x1F;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // Fill count pixels with one color by doubling memcpy
+    static void fillPixels(uint8_t* dst, const uint8_t* rgb, int count) {
+        if (count <= 0) return;
+        dst[0] = rgb[0];
+        dst[1] = rgb[1];
+        dst[2] = rgb[2];
+        size_t done = 3;
+        size_t total = (size_t)count * 3;
+        while (done < total) {
+            size_t n = min(done, total - done);
+            memcpy(dst + done, dst, n);
+            done += n;
+        }
+    }
+
+    // Rasterize each glyph once at scale 1 through LovyanGFX so the atlas
+    // matches print() output exactly.
+    void buildMasks() {
+        LGFX_Sprite probe;
+        probe.setColorDepth(16);
+        probe.createSprite(BASE_W, BASE_H);
+        for (int i = 0; i < GLYPH_COUNT; i++) {
+            probe.fillSprite(TFT_BLACK);
+            probe.drawChar(0, 0, (uint16_t)(FIRST_CHAR + i), (uint16_t)TFT_WHITE, (uint16_t)TFT_BLACK, 1);
+            for (int y = 0; y < BASE_H; y++) {
+                uint8_t bits = 0;
+                for (int x = 0; x < BASE_W; x++) {
+                    if (probe.readPixel(x, y) != 0) {
+                        bits |= (1 << x);
+                    }
+                }
+                _masks[i][y] = bits;
+            }
+        }
+        probe.deleteSprite();
+    }
+
+    void expandGlyph(uint8_t* dst, size_t dstStride, int idx, uint8_t scale,
+                     uint16_t fg, uint16_t bg) {
+        uint8_t fgRgb[3], bgRgb[3];
+        toNative(fg, fgRgb);
+        toNative(bg, bgRgb);
+        for (int y = 0; y < BASE_H; y++) {
+            uint8_t bits = _masks[idx][y];
+            uint8_t* row = dst;
+            for (int x = 0; x < BASE_W; x++) {
+                const uint8_t* c = (bits & (1 << x)) ? fgRgb : bgRgb;
+                for (int s = 0; s < scale; s++) {
+                    row[0] = c[0];
+                    row[1] = c[1];
+                    row[2] = c[2];
+                    row += 3;
+                }
+            }
+            // Repeat the expanded row for the vertical scale
+            for (int s = 1; s < scale; s++) {
+                memcpy(dst + s * dstStride, dst, (size_t)BASE_W * scale * 3);
+            }
+            dst += dstStride * scale;
+        }
+    }
+
+    const Face* findFace(uint8_t scale, uint16_t fg, uint16_t bg) const {
+        for (int i = 0; i < _faceCount; i++) {
+            const Face& f = _faces[i];
+            if (f.scale == scale && f.fg == fg && f.bg == bg) return &f;
+        }
+        return nullptr;
+    }
+
+    const Face* findOrCreateFace(uint8_t scale, uint16_t fg, uint16_t bg) {
+        const Face* existing = findFace(scale, fg, bg);
+        if (existing || _faceCount >= MAX_FACES) return existing;
+
+        Face& f = _faces[_faceCount++];
+        f.scale = scale;
+        f.fg = fg;
+        f.bg = bg;
+        f.tileBytes = (size_t)glyphWidth(scale) * glyphHeight(scale) * 3;
+        f.tiles = nullptr;
+
+        size_t total = faceBytes(scale);
+        if (_tileBytesUsed + total <= _tileBudget) {
+            f.tiles = (uint8_t*)heap_caps_malloc(total, _tileCaps);
+        }
+        if (f.tiles) {
+            _tileBytesUsed += total;
+            size_t stride = (size_t)glyphWidth(scale) * 3;
+            for (int i = 0; i < GLYPH_COUNT; i++) {
+                expandGlyph(f.tiles + i * f.tileBytes, stride, i, scale, fg, bg);
+            }
+        }
+        return &f;
+    }
+
+    lgfx::LGFX_Device* _lcd;
+    uint8_t* _blockBuf[2];
+    uint8_t* _buf;         // Block being composed
+    size_t _bufBytes;      // Capacity of each block buffer
+    int _active;
+    int _blockW;
+    int _blockH;
+    uint16_t _blockBg;
+
+    uint8_t _masks[GLYPH_COUNT][BASE_H];
+    Face _faces[MAX_FACES];
+    int _faceCount;
+    size_t _tileBytesUsed;
+    size_t _tileBudget;
+    uint32_t _tileCaps;
+};
@@ -0,0 +1,167 @@
+/*
+ * I2C bus health controller
+ *
+ * Tracks every transaction outcome of one device (OK / NACK / timeout /
+ * bus error), its bus time, and an error window over the last 64
+ * transactions. From that it decides what the engine should do next:
+ *
+ * - RESET_BUS: several failures in a row - clock the bus free
+ *   (i2c_master_bus_reset(), no sleep) and carry on.
+ * - SPEED_DOWN: the window error rate is over the limit, or resets did
+ *   not help - go one step down the 400/100/50 kHz ladder.
+ * - SPEED_UP: enough transactions at the current speed and a clean error
+ *   window - try the next step. If that step then fails, the wait before
+ *   trying it again doubles (per step), so a device that cannot do
+ *   400 kHz is not re-tested every few seconds.
+ *
+ * Pure bookkeeping: no bus access, so the engine decides when to act.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class I2CBusHealth {
+public:
+    enum Outcome { TXN_OK, TXN_NACK, TXN_TIMEOUT, TXN_BUS_ERROR };
+    enum Action { ACT_NONE, ACT_RESET_BUS, ACT_SPEED_DOWN, ACT_SPEED_UP };
+
+    static constexpr int SPEED_STEPS = 3;
+    static constexpr int WINDOW = 64;               // Transactions in the error window
+    static constexpr int DOWN_ERRORS = 4;           // Window errors that force a step down (~6%)
+    static constexpr int RESET_AFTER = 4;           // Consecutive failures before a bus reset
+    static constexpr int RESETS_BEFORE_DOWN = 2;    // Resets without success before a step down
+    static constexpr uint32_t PROMOTE_AFTER = 500;  // Transactions at a speed before a step up
+    static constexpr uint8_t MAX_BACKOFF = 6;       // Promotion wait doubles up to 64x
+
+    struct Stats {
+        uint8_t address;
+        uint8_t speedIdx;
+        uint32_t txns;
+        uint32_t errors;
+        uint32_t nacks;
+        uint32_t timeouts;
+        uint32_t busErrors;
+        uint32_t resets;
+        uint32_t speedUps;
+        uint32_t speedDowns;
+        uint32_t latencyAvgUs;  // Bus time per transaction (EMA)
+        uint32_t latencyMaxUs;
+        uint8_t windowErrors;   // Errors in the last WINDOW transactions
+    };
+
+    static uint32_t speedHz(int idx) {
+        static const uint32_t speeds[SPEED_STEPS] = {50000, 100000, 400000};
+        return speeds[constrain(idx, 0, SPEED_STEPS - 1)];
+    }
+
+    // Ladder step for a configured speed (highest step not above hz)
+    static int speedIndexFor(uint32_t hz) {
+        int idx = 0;
+        while (idx + 1 < SPEED_STEPS && speedHz(idx + 1) <= hz) idx++;
+        return idx;
+    }
+
+    I2CBusHealth() { begin(0, 0); }
+
+    void begin(uint8_t address, int speedIdx) {
+        memset(&_stats, 0, sizeof(_stats));
+        _stats.address = address;
+        _stats.speedIdx = (uint8_t)constrain(speedIdx, 0, SPEED_STEPS - 1);
+        _window = 0;
+        _consecutive = 0;
+        _resetsSinceOk = 0;
+        _txnsAtSpeed = 0;
+        memset(_backoff, 0, sizeof(_backoff));
+        _probing = false;
+    }
+
+    uint32_t currentHz() const { return speedHz(_stats.speedIdx); }
+
+    // Record one transaction and return what to do about it
+    Action record(Outcome outcome, uint32_t latencyUs) {
+        bool failed = (outcome != TXN_OK);
+        _stats.txns++;
+        _stats.latencyAvgUs = _stats.txns == 1 ? latencyUs
+                            : _stats.latencyAvgUs + ((int32_t)(latencyUs - _stats.latencyAvgUs) >> 3);
+        if (latencyUs > _stats.latencyMaxUs) _stats.latencyMaxUs = latencyUs;
+
+        if (_window & (1ULL << (WINDOW - 1))) _stats.windowErrors--;
+        _window = (_window << 1) | (failed ? 1 : 0);
+
+        _txnsAtSpeed++;
+        // A new speed that survived a full window is trusted
+        if (_probing && _txnsAtSpeed >= (uint32_t)WINDOW) {
+            _probing = false;
+            _backoff[_stats.speedIdx] = 0;
+        }
+
+        if (!failed) {
+            _consecutive = 0;
+            _resetsSinceOk = 0;
+            int next = _stats.speedIdx + 1;
+            if (next < SPEED_STEPS && _stats.windowErrors == 0 &&
+                _txnsAtSpeed >= (PROMOTE_AFTER << _backoff[next])) {
+                return changeSpeed(+1);
+            }
+            return ACT_NONE;
+        }
+
+        _stats.errors++;
+        _stats.windowErrors++;
+        if (outcome == TXN_NACK) _stats.nacks++;
+        else if (outcome == TXN_TIMEOUT) _stats.timeouts++;
+        else _stats.busErrors++;
+
+        if (_stats.windowErrors >= DOWN_ERRORS && _stats.speedIdx > 0) {
+            return changeSpeed(-1);
+        }
+        if (++_consecutive >= RESET_AFTER) {
+            _consecutive = 0;
+            if (++_resetsSinceOk > RESETS_BEFORE_DOWN && _stats.speedIdx > 0) {
+                return changeSpeed(-1);
+            }
+            _stats.resets++;
+            return ACT_RESET_BUS;
+        }
+        return ACT_NONE;
+    }
+
+    const Stats& stats() const { return _stats; }
+
+    static const char* actionName(Action a) {
+        static const char* const names[] = {"none", "bus reset", "speed down", "speed up"};
+        return names[a];
+    }
+
+private:
+    Action changeSpeed(int dir) {
+        if (dir < 0) {
+            // Step down while probing a higher speed = that speed failed
+            uint8_t& b = _backoff[_stats.speedIdx];
+            if (_probing && b < MAX_BACKOFF) b++;
+            _probing = false;
+            _stats.speedIdx--;
+            _stats.speedDowns++;
+        } else {
+            _probing = true;
+            _stats.speedIdx++;
+            _stats.speedUps++;
+        }
+        // Fresh window for the new speed
+        _window = 0;
+        _stats.windowErrors = 0;
+        _consecutive = 0;
+        _resetsSinceOk = 0;
+        _txnsAtSpeed = 0;
+        return dir < 0 ? ACT_SPEED_DOWN : ACT_SPEED_UP;
+    }
+
+    Stats _stats;
+    uint64_t _window;        // Bit i = transaction i ago failed
+    int _consecutive;        // Failures in a row
+    int _resetsSinceOk;      // Bus resets without a success in between
+    uint32_t _txnsAtSpeed;   // Transactions since the last speed change
+    uint8_t _backoff[SPEED_STEPS];  // Wait before stepping up to i = PROMOTE_AFTER << _backoff[i]
+    bool _probing;           // Current speed was reached by a step up and is not trusted yet
+};
@@ -0,0 +1,310 @@
+/*
+ * Non-blocking I2C transaction engine for M5Unit-Scroll (STM32F030)
+ *
+ * The Unit-Scroll firmware needs a pause between the register-address
+ * write and the data read (~500 us) and a short settle time after the
+ * read (~300 us). Spinning in delayMicroseconds() for that costs close
+ * to a millisecond of dead CPU per register on the UI thread.
+ *
+ * Here every register access is a ScrollTxn posted to a queue. A worker
+ * task runs each phase through the ESP-IDF i2c_master driver in async
+ * mode (trans_queue_depth > 0, on_trans_done callback), and the
+ * inter-phase pauses are one-shot esp_timer waits, so the worker sleeps
+ * instead of spinning. When a transaction finishes, its completion
+ * callback runs in the worker task with the received bytes.
+ *
+ * submit() never blocks: the UI loop posts transactions and picks up
+ * results from state written by the callbacks.
+ *
+ * Every outcome goes to an I2CBusHealth controller, which asks for a
+ * bus reset or a speed change; the worker applies those between
+ * transactions (the device is re-added at the new speed).
+ *
+ * Requires Arduino-ESP32 3.x (ESP-IDF 5.x, driver/i2c_master.h). The bus
+ * port must not be used by Wire at the same time - call Wire.end() first.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <driver/i2c_master.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "i2c_bus_health.h"
+
+struct ScrollTxn;
+typedef void (*ScrollTxnDone)(const ScrollTxn& txn, bool ok, const uint8_t* rx, void* ctx);
+
+struct ScrollTxn {
+    uint8_t reg;            // Register address (first byte written)
+    uint8_t writeLen;       // Payload bytes after reg (0-4)
+    uint8_t write[4];
+    uint8_t readLen;        // Bytes to read after the write (0 = write only)
+    uint16_t gapUs;         // Pause between write and read phases
+    uint16_t settleUs;      // Pause after the read before the next transaction
+    ScrollTxnDone done;     // Optional, runs in the worker task
+    void* ctx;
+};
+
+class ScrollI2C {
+public:
+    static constexpr int QUEUE_DEPTH = 8;       // Pending transactions
+    static constexpr int PHASE_TIMEOUT_MS = 20; // Per write/read phase
+
+    struct Stats {
+        uint32_t completed;
+        uint32_t errors;
+        uint32_t queueFull;      // submit() rejected
+        uint32_t lastLatencyUs;  // Queue entry to completion
+        uint32_t maxLatencyUs;
+    };
+
+    ScrollI2C() : _bus(nullptr), _dev(nullptr), _queue(nullptr), _task(nullptr),
+                  _timer(nullptr), _phaseEvent(I2C_EVENT_DONE) {
+        memset(&_stats, 0, sizeof(_stats));
+        memset(&_devCfg, 0, sizeof(_devCfg));
+    }
+
+    bool begin(i2c_port_num_t port, int sda, int scl, uint8_t address, uint32_t hz) {
+        i2c_master_bus_config_t busCfg = {};
+        busCfg.i2c_port = port;
+        busCfg.sda_io_num = (gpio_num_t)sda;
+        busCfg.scl_io_num = (gpio_num_t)scl;
+        busCfg.clk_source = I2C_CLK_SRC_DEFAULT;
+        busCfg.glitch_ignore_cnt = 7;
+        busCfg.trans_queue_depth = QUEUE_DEPTH;  // Non-zero = async transfers
+        busCfg.flags.enable_internal_pullup = 1;
+        if (i2c_new_master_bus(&busCfg, &_bus) != ESP_OK) {
+            return false;
+        }
+
+        _devCfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+        _devCfg.device_address = address;
+        _devCfg.scl_speed_hz = hz;
+        if (!addDevice()) {
+            return false;
+        }
+        _health.begin(address, I2CBusHealth::speedIndexFor(hz));
+
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = onTimer;
+        timerArgs.arg = this;
+        timerArgs.name = "scroll_gap";
+        if (esp_timer_create(&timerArgs, &_timer) != ESP_OK) {
+            return false;
+        }
+
+        _queue = xQueueCreate(QUEUE_DEPTH, sizeof(Pending));
+        if (!_queue) {
+            return false;
+        }
+        return xTaskCreatePinnedToCore(taskEntry, "scroll_i2c", 4096, this, 3, &_task, 0) == pdPASS;
+    }
+
+    // Post a transaction; false if the queue is full. Never blocks.
+    bool submit(const ScrollTxn& txn) {
+        Pending p = {txn, (uint32_t)esp_timer_get_time()};
+        if (!_queue || xQueueSend(_queue, &p, 0) != pdTRUE) {
+            _stats.queueFull++;
+            return false;
+        }
+        return true;
+    }
+
+    // Convenience: read len bytes from reg
+    bool submitRead(uint8_t reg, uint8_t len, ScrollTxnDone done, void* ctx = nullptr,
+                    uint16_t gapUs = 500, uint16_t settleUs = 300) {
+        ScrollTxn t = {};
+        t.reg = reg;
+        t.readLen = len;
+        t.gapUs = gapUs;
+        t.settleUs = settleUs;
+        t.done = done;
+        t.ctx = ctx;
+        return submit(t);
+    }
+
+    // Convenience: write up to 4 bytes starting at reg
+    bool submitWrite(uint8_t reg, const uint8_t* data, uint8_t len,
+                     ScrollTxnDone done = nullptr, void* ctx = nullptr) {
+        ScrollTxn t = {};
+        t.reg = reg;
+        t.writeLen = len > 4 ? 4 : len;
+        memcpy(t.write, data, t.writeLen);
+        t.done = done;
+        t.ctx = ctx;
+        return submit(t);
+    }
+
+    int pending() const { return _queue ? (int)uxQueueMessagesWaiting(_queue) : 0; }
+
+    // Snapshots for display (written by the worker task)
+    Stats stats() const { return _stats; }
+    I2CBusHealth::Stats health() const { return _health.stats(); }
+    uint32_t speedHz() const { return _devCfg.scl_speed_hz; }
+
+    void printTelemetry() const {
+        I2CBusHealth::Stats h = _health.stats();
+        Serial.printf("I2C 0x%02X @ %u kHz: %u txns, %u err (%u nack, %u timeout, %u bus), "
+                      "window %u/%d\n",
+                      h.address, (unsigned)(_devCfg.scl_speed_hz / 1000), (unsigned)h.txns,
+                      (unsigned)h.errors, (unsigned)h.nacks, (unsigned)h.timeouts,
+                      (unsigned)h.busErrors, h.windowErrors, I2CBusHealth::WINDOW);
+        Serial.printf("  bus time %u us avg / %u us max, queue latency %u us max, "
+                      "%u resets, %u up / %u down, %u queue full\n",
+                      (unsigned)h.latencyAvgUs, (unsigned)h.latencyMaxUs,
+                      (unsigned)_stats.maxLatencyUs, (unsigned)h.resets,
+                      (unsigned)h.speedUps, (unsigned)h.speedDowns, (unsigned)_stats.queueFull);
+    }
+
+private:
+    struct Pending {
+        ScrollTxn txn;
+        uint32_t queuedUs;
+    };
+
+    // i2c_master ISR callback: phase finished
+    static bool IRAM_ATTR onTransDone(i2c_master_dev_handle_t dev,
+                                      const i2c_master_event_data_t* evt, void* arg) {
+        ScrollI2C* self = static_cast<ScrollI2C*>(arg);
+        self->_phaseEvent = evt->event;
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(self->_task, &woken);
+        return woken == pdTRUE;
+    }
+
+    // esp_timer callback: inter-phase pause elapsed
+    static void onTimer(void* arg) {
+        xTaskNotifyGive(static_cast<ScrollI2C*>(arg)->_task);
+    }
+
+    bool addDevice() {
+        if (i2c_master_bus_add_device(_bus, &_devCfg, &_dev) != ESP_OK) {
+            _dev = nullptr;
+            return false;
+        }
+        i2c_master_event_callbacks_t cbs = {};
+        cbs.on_trans_done = onTransDone;
+        return i2c_master_register_event_callbacks(_dev, &cbs, this) == ESP_OK;
+    }
+
+    // Re-add the device at a new SCL speed (worker task, between transactions)
+    void setSpeed(uint32_t hz) {
+        if (_dev) i2c_master_bus_rm_device(_dev);
+        _devCfg.scl_speed_hz = hz;
+        if (!addDevice()) {
+            Serial.printf(">>> I2C 0x%02X: re-adding device at %u kHz failed\n",
+                          _devCfg.device_address, (unsigned)(hz / 1000));
+        }
+    }
+
+    static void taskEntry(void* arg) {
+        static_cast<ScrollI2C*>(arg)->run();
+    }
+
+    // Sleep for us microseconds without spinning
+    void pause(uint16_t us) {
+        if (us == 0) return;
+        ulTaskNotifyTake(pdTRUE, 0);
+        esp_timer_start_once(_timer, us);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    // Wait for the on_trans_done notification of a queued phase
+    I2CBusHealth::Outcome finishPhase(esp_err_t queued) {
+        if (queued == ESP_ERR_TIMEOUT) return I2CBusHealth::TXN_TIMEOUT;
+        if (queued != ESP_OK) return I2CBusHealth::TXN_BUS_ERROR;
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PHASE_TIMEOUT_MS)) == 0) {
+            // The driver may still be working on _tx/_rx: let it finish
+            // before the next transaction reuses them
+            i2c_master_bus_wait_all_done(_bus, PHASE_TIMEOUT_MS);
+            return I2CBusHealth::TXN_TIMEOUT;
+        }
+        switch (_phaseEvent) {
+            case I2C_EVENT_DONE: return I2CBusHealth::TXN_OK;
+            case I2C_EVENT_NACK: return I2CBusHealth::TXN_NACK;
+            default:             return I2CBusHealth::TXN_BUS_ERROR;
+        }
+    }
+
+    // Async phases use _tx/_rx, which outlive a timed-out transfer
+    I2CBusHealth::Outcome execute(const ScrollTxn& t) {
+        if (!_dev) return I2CBusHealth::TXN_BUS_ERROR;
+
+        _tx[0] = t.reg;
+        memcpy(_tx + 1, t.write, t.writeLen);
+
+        ulTaskNotifyTake(pdTRUE, 0);  // Drop stale notifications
+        I2CBusHealth::Outcome r = finishPhase(i2c_master_transmit(_dev, _tx, 1 + t.writeLen, -1));
+        if (r != I2CBusHealth::TXN_OK || t.readLen == 0) return r;
+
+        pause(t.gapUs);
+        r = finishPhase(i2c_master_receive(_dev, _rx, t.readLen, -1));
+        if (r != I2CBusHealth::TXN_OK) return r;
+        pause(t.settleUs);
+        return r;
+    }
+
+    void applyHealthAction(I2CBusHealth::Action action) {
+        if (action == I2CBusHealth::ACT_NONE) return;
+
+        const I2CBusHealth::Stats& h = _health.stats();
+        if (action == I2CBusHealth::ACT_RESET_BUS) {
+            // Clocks out a stuck slave; no settling sleep needed
+            i2c_master_bus_reset(_bus);
+            Serial.printf(">>> I2C 0x%02X: bus reset (%u errors)\n", h.address, (unsigned)h.errors);
+            return;
+        }
+
+        uint32_t hz = I2CBusHealth::speedHz(h.speedIdx);
+        if (hz == _devCfg.scl_speed_hz) return;
+        Serial.printf(">>> I2C 0x%02X: %s %u -> %u kHz\n", h.address,
+                      I2CBusHealth::actionName(action),
+                      (unsigned)(_devCfg.scl_speed_hz / 1000), (unsigned)(hz / 1000));
+        if (action == I2CBusHealth::ACT_SPEED_DOWN) {
+            i2c_master_bus_reset(_bus);  // The failed speed may have left the bus stuck
+        }
+        setSpeed(hz);
+    }
+
+    void run() {
+        Pending p;
+        for (;;) {
+            if (xQueueReceive(_queue, &p, portMAX_DELAY) != pdTRUE) continue;
+
+            uint8_t len = p.txn.readLen > sizeof(_rx) ? sizeof(_rx) : p.txn.readLen;
+            p.txn.readLen = len;
+            uint32_t start = (uint32_t)esp_timer_get_time();
+            I2CBusHealth::Outcome outcome = execute(p.txn);
+            uint32_t end = (uint32_t)esp_timer_get_time();
+            bool ok = (outcome == I2CBusHealth::TXN_OK);
+
+            uint32_t latency = end - p.queuedUs;
+            _stats.lastLatencyUs = latency;
+            if (latency > _stats.maxLatencyUs) _stats.maxLatencyUs = latency;
+            if (ok) {
+                _stats.completed++;
+            } else {
+                _stats.errors++;
+            }
+
+            applyHealthAction(_health.record(outcome, end - start));
+
+            if (p.txn.done) p.txn.done(p.txn, ok, _rx, p.txn.ctx);
+        }
+    }
+
+    i2c_master_bus_handle_t _bus;
+    i2c_master_dev_handle_t _dev;
+    QueueHandle_t _queue;
+    TaskHandle_t _task;
+    esp_timer_handle_t _timer;
+    i2c_device_config_t _devCfg;
+    volatile i2c_master_event_t _phaseEvent;
+    uint8_t _tx[5];   // Worker task only
+    uint8_t _rx[16];
+    Stats _stats;
+    I2CBusHealth _health;  // Written only by the worker task
+};
@@ -41,7 +41,12 @@
 #include <M5Cardputer.h>
 #include <M5GFX.h>
 #include <Wire.h>
+#include <atomic>
 #include "lgfx/v1/panel/Panel_LCD.hpp"
+#include "glyph_atlas.h"
+#include "scroll_i2c_async.h"
+#include "virtual_list.h"
+#include "encoder_accel.h"
 
 // ============================================
 // Local Panel_ILI9488 Definition
@@ -110,8 +115,8 @@ public:
         b.freq_write = 20000000;    // 20 MHz
         b.freq_read  = 16000000;
         b.spi_3wire  = true;        // 3-wire SPI
-        b.use_lock   = false;       // No SPI lock
-        b.dma_channel = 0;          // No DMA
+        b.use_lock   = true;        // Hold the bus while DMA transfers run
+        b.dma_channel = SPI_DMA_CH_AUTO;  // DMA for glyph atlas block pushes
 
         b.pin_sclk = 40;            // SCK  -> PIN 7
         b.pin_mosi = 14;            // MOSI -> PIN 9
@@ -146,6 +151,7 @@ public:
 };
 
 LGFX_ILI9488 lcd;  // External ILI9488 display
+GlyphAtlas atlas;  // Pre-rendered font tiles in panel pixel format
 
 // ============================================
 // I2C Settings
@@ -176,58 +182,66 @@ uint8_t foundAddress = 0;
 bool showScrollTest = false;  // Flag to show scroll test screen
 unsigned long screenSwitchTime = 0;  // Last screen switch time
 const int SCREEN_SWITCH_DELAY = 500;  // Delay after screen switch before I2C read (ms)
-const int MAX_LIST_ITEMS = 20;  // Maximum items in list
-String listItems[MAX_LIST_ITEMS] = {
-    "Item 1", "Item 2", "Item 3", "Item 4", "Item 5",
-    "Item 6", "Item 7", "Item 8", "Item 9", "Item 10",
-    "Item 11", "Item 12", "Item 13", "Item 14", "Item 15",
-    "Item 16", "Item 17", "Item 18", "Item 19", "Item 20"
-};
-bool listItemsChecked[MAX_LIST_ITEMS] = {false};  // Check flags
-int listItemCount = MAX_LIST_ITEMS;  // Number of items
-int selectedListItem = 0;  // Selected item (0-based)
-int lastScrollNavTime = 0;  // Last navigation time (debounce)
-const int SCROLL_NAV_DEBOUNCE = 150;  // Navigation debounce (ms)
+const int LIST_ITEM_COUNT = 10000;  // Items in list (names generated on demand)
+uint8_t listItemsChecked[(LIST_ITEM_COUNT + 7) / 8] = {0};  // Check flags, 1 bit per item
 unsigned long lastScrollReadTime = 0;  // Last encoder read time
-const int SCROLL_READ_INTERVAL = 50;  // Encoder read interval (ms) - don't read too often
-int i2cErrorCount = 0;  // I2C error counter
-const int MAX_I2C_ERRORS = 10;  // Maximum consecutive errors before skipping reads (increased)
+const int SCROLL_READ_INTERVAL = 20;  // Encoder read interval (ms); the I2C engine spaces the transactions
+unsigned long ledOffTime = 0;  // Scheduled LED off after a check (0 = none)
 
 // ============================================
-// State for scroll rendering optimization
+// Async I2C engine
+// ============================================
+// Wire is only used for probing in setup(); after that the engine owns
+// PORT.A. Its completion callbacks run in the I2C worker task and publish
+// results here, loop() only reads them.
+ScrollI2C scrollBus;
+uint32_t scrollBusSpeed = 50000;  // Speed the module answered at in setup()
+std::atomic<int32_t> pendingIncrement(0);  // Sum of 0x50 reads not yet consumed
+std::atomic<int32_t> absoluteEncoder(0);   // Last 0x10 value
+std::atomic<bool> buttonDown(false);       // Last 0x20 value
+std::atomic<bool> pollInFlight(false);     // Poll batch queued, not finished yet
+std::atomic<bool> pollReady(false);        // Finished batch not yet handled by loop()
+
 // ============================================
+// Scroll list (virtualized, see virtual_list.h)
+// ============================================
+// Inside the frame at (20, 40, 440, 190): 7 rows of 26 px
+#define LIST_X      22
+#define LIST_Y      45
+#define LIST_W      436
+#define LIST_H      182
+#define LIST_ROW_H  26
+
+VirtualList scrollList;
 bool scrollScreenInitialized = false;  // First screen initialization flag
-int lastFirstVisible = -1;  // Last first visible item (for optimization)
 
 // ============================================
-// Soft I2C Bus Reset
+// Encoder → list navigation
 // ============================================
-void i2cBusReset() {
-    Serial.println(">>> I2C Bus Reset: Recovering from errors...");
-    
-    // Stop shared I2C
-    Wire.end();
-    delay(50);
-    
-    // Toggle SCL 9 times to release stuck slave
-    pinMode(I2C_SCL_PIN, OUTPUT);
-    for (int i = 0; i < 9; i++) {
-        digitalWrite(I2C_SCL_PIN, HIGH);
-        delayMicroseconds(5);
-        digitalWrite(I2C_SCL_PIN, LOW);
-        delayMicroseconds(5);
-    }
-    
-    // Return pins to "I2C mode"
-    pinMode(I2C_SCL_PIN, INPUT_PULLUP);
-    pinMode(I2C_SDA_PIN, INPUT_PULLUP);
-    delay(50);
-    
-    // Reinitialize Wire on port A
-    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, 50000);  // 50 kHz for STM32F030
-    Wire.setTimeOut(100);
-    
-    Serial.println(">>> I2C Bus Reset: Complete");
+// Every detent is fed to the acceleration model; the resulting steps move
+// navTarget, and the list is redrawn at most once per frame, so a fast
+// spin between two frames costs one redraw.
+EncoderAccel scrollAccel;
+int navTarget = 0;                // Item the encoder points at (may be ahead of the screen)
+unsigned long lastListFrame = 0;  // Last list redraw
+const int LIST_FRAME_MS = 30;     // Minimum time between list redraws (~33 FPS)
+uint32_t navLedColor = 0xFFFFFFFF;  // Last color written by navigation (avoid repeat writes)
+
+bool isItemChecked(int index) {
+    return listItemsChecked[index >> 3] & (1 << (index & 7));
+}
+
+void toggleItemChecked(int index) {
+    listItemsChecked[index >> 3] ^= (1 << (index & 7));
+}
+
+// Data source for scrollList
+void listItemSource(int index, bool selected, ListRow& row, void* ctx) {
+    bool checked = isItemChecked(index);
+    // Show [x] mark before name if item is checked
+    row.len = snprintf(row.text, sizeof(row.text), "%sItem %d", checked ? "[x] " : "", index + 1);
+    // Large yellow font for selected, small for others
+    row.color = selected ? TFT_YELLOW : (checked ? TFT_GREEN : TFT_WHITE);
 }
 
 void setup() {
@@ -258,6 +272,24 @@ void setup() {
         lcd.setTextSize(2);  // Larger font size for large screen
         lcd.setTextColor(TFT_WHITE, TFT_BLACK);
         
+        // Block buffer: one 480x24 strip (taller text is split into chunks)
+        // Without PSRAM the internal budget holds the two list faces; the
+        // selected row (one row at a time) is drawn by mask expansion
+        if (!atlas.begin(&lcd, 480 * 24, 1024 * 1024, GlyphAtlas::faceBytes(2) * 2)) {
+            Serial.println("  ✗ ERROR: Glyph atlas allocation FAILED!");
+            return;
+        }
+        bool white = atlas.preload(2, TFT_WHITE, TFT_BLACK);    // List items
+        bool green = atlas.preload(2, TFT_GREEN, TFT_BLACK);    // Checked items
+        bool selected = atlas.preload(3, TFT_YELLOW, TFT_BLACK); // Selected item
+        Serial.printf("  ✓ Glyph atlas: %u bytes of tiles (items %s, checked %s, selected %s)\n",
+                      (unsigned)atlas.tileBytesUsed(), white ? "tiles" : "masks",
+                      green ? "tiles" : "masks", selected ? "tiles" : "masks");
+        
+        scrollList.begin(&lcd, &atlas, LIST_X, LIST_Y, LIST_W, LIST_H, LIST_ROW_H, listItemSource);
+        scrollList.setScales(2, 3);  // Selected row is bigger but keeps the row pitch
+        scrollList.setCount(LIST_ITEM_COUNT);
+        
         Serial.println("\nReady! Display initialized...");
         Serial.println("----------------------------------------\n");
         
@@ -309,7 +341,6 @@ void setup() {
     
     uint8_t addresses[] = {0x40, 0x5E, 0x5F, 0x41, 0x42};
     bool found = false;
-    uint8_t foundAddress = 0;
     
     // Method 1: Standard scan
     Serial.println("\nMethod 1: Standard I2C scan");
@@ -375,6 +406,7 @@ void setup() {
                 Serial.printf("  ✓ Device found at 0x%02X with %d kHz!\n", UNIT_SCROLL_I2C_ADDRESS, speeds[s] / 1000);
                 found = true;
                 foundAddress = UNIT_SCROLL_I2C_ADDRESS;
+                scrollBusSpeed = speeds[s];
                 moduleFound = true;
                 break;
             }
@@ -466,6 +498,15 @@ void setup() {
             }
         }
         
+        // Hand PORT.A over to the async engine
+        Wire.end();
+        if (scrollBus.begin(I2C_NUM_0, I2C_SDA_PIN, I2C_SCL_PIN, foundAddress, scrollBusSpeed)) {
+            Serial.printf("  ✓ Async I2C engine running (%d kHz)\n", (int)(scrollBusSpeed / 1000));
+        } else {
+            Serial.println("  ✗ Async I2C engine failed to start");
+            moduleFound = false;
+        }
+        
         // Display successful connection
         lcd.fillScreen(TFT_BLACK);
         lcd.setCursor(10, 10);
@@ -494,74 +535,52 @@ void setup() {
     Serial.println();
 }
 
-// Improved register read function with error handling
-bool readScrollRegister(uint8_t reg, uint8_t length, uint8_t* data) {
-    // Check if module is found
-    if (!moduleFound) {
-        return false;
+// ============================================
+// Completion callbacks (run in the I2C worker task)
+// ============================================
+void onIncEncoderRead(const ScrollTxn& txn, bool ok, const uint8_t* rx, void* ctx) {
+    if (ok) {
+        pendingIncrement += (int16_t)(rx[0] | (rx[1] << 8));  // little-endian
     }
-    
-    // Use found address if set, otherwise constant
-    uint8_t address = (foundAddress != 0) ? foundAddress : UNIT_SCROLL_I2C_ADDRESS;
-    
-    // Send register address
-    Wire.beginTransmission(address);
-    Wire.write(reg);
-    byte error = Wire.endTransmission(false);  // false = не останавливать шину (repeated start)
-    
-    if (error != 0) {
-        i2cErrorCount++;
-        return false;
+}
+
+void onEncoderRead(const ScrollTxn& txn, bool ok, const uint8_t* rx, void* ctx) {
+    if (ok) {
+        absoluteEncoder = (int16_t)(rx[0] | (rx[1] << 8));
     }
-    
-    // Delay for STM32F030 before read (reduced for stability)
-    delayMicroseconds(500);  // Optimal delay for STM32F030
-    
-    // Request data
-    uint8_t bytesReceived = Wire.requestFrom(address, length, true);
-    
-    if (bytesReceived == 0) {
-        i2cErrorCount++;
-        return false;
+}
+
+// Last transaction of a poll batch
+void onButtonRead(const ScrollTxn& txn, bool ok, const uint8_t* rx, void* ctx) {
+    if (ok) {
+        buttonDown = (rx[0] != 0);
     }
-    
-    // Small delay after requestFrom for STM32F030
-    delayMicroseconds(300);
-    
-    // Read data (max 16 bytes for info register)
-    for (int i = 0; i < length && i < 16; i++) {
-        if (Wire.available()) {
-            data[i] = Wire.read();
-        } else {
-            i2cErrorCount++;
-            return false;
-        }
+    pollReady = true;
+    pollInFlight = false;
+}
+
+void onWriteDone(const ScrollTxn& txn, bool ok, const uint8_t* rx, void* ctx) {
+    if (!ok) {
+        Serial.printf(">>> I2C write error: reg 0x%02X\n", txn.reg);
     }
-    
-    // Successful read - reset error counter
-    i2cErrorCount = 0;
-    return true;
 }
 
-// Wrapper for backward compatibility
-int readScrollRegisterValue(uint8_t reg, uint8_t length) {
-    uint8_t data[4] = {0};
-    
-    if (!readScrollRegister(reg, length, data)) {
-        // Read error - return last known value
-        if (length == 2) {
-            return lastEncoderValue;
-        } else {
-            return lastButtonState ? 1 : 0;
-        }
+// Queue one poll batch (incremental encoder, absolute encoder on the main
+// screen, button). The STM32F030 read delays are handled by the engine,
+// so this returns immediately.
+void pollScrollUnit(unsigned long currentTime) {
+    if (pollInFlight || currentTime - lastScrollReadTime < SCROLL_READ_INTERVAL) {
+        return;
     }
+    lastScrollReadTime = currentTime;
+    pollInFlight = true;
     
-    if (length == 2) {
-        // 16-bit value (encoder)
-        return (int16_t)(data[0] | (data[1] << 8));
-    } else {
-        // 8-bit value (button)
-        return data[0];
+    scrollBus.submitRead(SCROLL_INC_ENCODER_REG, 2, onIncEncoderRead);
+    if (!showScrollTest) {
+        scrollBus.submitRead(SCROLL_ENCODER_REG, 2, onEncoderRead);
+    }
+    if (!scrollBus.submitRead(SCROLL_BUTTON_REG, 1, onButtonRead)) {
+        pollInFlight = false;  // Queue full - try again next interval
     }
 }
 
@@ -576,46 +595,38 @@ void setScrollLEDFast(uint32_t color) {
         return;
     }
     
-    // Use found address if set, otherwise constant
-    uint8_t address = (foundAddress != 0) ? foundAddress : UNIT_SCROLL_I2C_ADDRESS;
-    
     // Extract RGB from 0xRRGGBB format
-    uint8_t r = (color >> 16) & 0xFF;  // Red
-    uint8_t g = (color >> 8) & 0xFF;   // Green
-    uint8_t b = color & 0xFF;          // Blue
+    uint8_t rgb[3] = {
+        (uint8_t)((color >> 16) & 0xFF),  // Red
+        (uint8_t)((color >> 8) & 0xFF),   // Green
+        (uint8_t)(color & 0xFF)           // Blue
+    };
     
     // Write R, G, B to registers 0x31, 0x32, 0x33
     // neopixel_set_color() ожидает: байт 8-15 = R, байт 16-23 = G, байт 24-31 = B
-    Wire.beginTransmission(address);
-    Wire.write(0x31);  // Start register for R
-    Wire.write(r);     // R → байт 8-15 буфера
-    Wire.write(g);     // G → байт 16-23 буфера
-    Wire.write(b);     // B → байт 24-31 буфера
-    byte error = Wire.endTransmission();
-    
-    if (error == 0) {
-        Serial.printf(">>> LED set to RGB(%d, %d, %d) = 0x%06X\n", r, g, b, color);
+    if (scrollBus.submitWrite(0x31, rgb, 3, onWriteDone)) {
+        Serial.printf(">>> LED set to RGB(%d, %d, %d) = 0x%06X\n", rgb[0], rgb[1], rgb[2], color);
     } else {
-        Serial.printf(">>> LED write error: %d\n", error);
-        i2cErrorCount++;
+        Serial.println(">>> LED write dropped: I2C queue full");
     }
 }
 
 // ============================================
-// Scroll test screen rendering function (OPTIMIZED)
+// Scroll test screen rendering
 // ============================================
 // Style like ZX Spectrum emulator
-// Uses partial updates to eliminate flickering
+// Static parts are drawn once; the list only redraws the rows that changed
+void drawScrollCounter() {
+    char buf[16];
+    int len = snprintf(buf, sizeof(buf), "%d/%d", scrollList.selected() + 1, scrollList.count());
+    atlas.drawText(340, 10, buf, len, 2, TFT_CYAN, TFT_BLACK, 140);
+}
+
 void drawScrollTest() {
-    // Calculate first visible item (scrolling)
-    int firstVisible = selectedListItem - 3;
-    if (firstVisible < 0) firstVisible = 0;
-    
-    // Group all SPI operations to eliminate flickering
-    lcd.startWrite();
-    
     // Redraw static elements only on first initialization
     if (!scrollScreenInitialized) {
+        lcd.startWrite();
+        
         // ═══ ЗАГОЛОВОК ═══
         lcd.setTextSize(2);
         lcd.setTextColor(TFT_CYAN, TFT_BLACK);
@@ -627,73 +638,172 @@ void drawScrollTest() {
         lcd.setTextColor(TFT_CYAN, TFT_BLACK);
         lcd.setCursor(10, 240);
         lcd.print("Scroll=Nav Button=Check Space=Back");
+        lcd.setCursor(10, 264);
+        lcd.print("B=Benchmark A=Accel:");
         
+        lcd.drawRect(20, 40, 440, 190, TFT_WHITE);
+        lcd.endWrite();
+        
+        scrollList.invalidate();
         scrollScreenInitialized = true;
     }
     
-    // Update counter (right) - always
-    lcd.fillRect(360, 10, 120, 20, TFT_BLACK);  // Clear counter area
-    lcd.setTextSize(2);
-    lcd.setTextColor(TFT_CYAN, TFT_BLACK);
-    lcd.setCursor(360, 10);
-    lcd.printf("%d/%d", selectedListItem + 1, listItemCount);
-    
-    // Redraw frame ALWAYS (so it doesn't disappear)
-    lcd.drawRect(20, 40, 440, 190, TFT_WHITE);
+    scrollList.draw();
+    drawScrollCounter();
+    drawAccelLabel();
+}
+
+// Apply all steps accumulated since the last frame in one redraw
+void renderListNav(unsigned long currentTime) {
+    int before = scrollList.selected();
+    scrollList.select(navTarget);
+    lastListFrame = currentTime;
     
-    // Clear list area with margin to eliminate artifacts
-    // Clear entire inner frame area (with 2px margin from frame edges)
-    // This ensures removal of all artifacts from previous renders
-    lcd.fillRect(22, 42, 436, 186, TFT_BLACK);  // Inside frame with 2px margin
+    int moved = scrollList.selected() - before;
+    if (moved == 0) {
+        return;
+    }
+    drawScrollCounter();
+    Serial.printf(">>> Scroll %s %+d → Item %d/%d (%.0f det/s, x%.1f)\n",
+                  moved > 0 ? "DOWN" : "UP", moved, scrollList.selected() + 1, scrollList.count(),
+                  scrollAccel.velocity(), scrollAccel.gain());
     
-    // Update lastFirstVisible to track changes
-    if (firstVisible != lastFirstVisible) {
-        lastFirstVisible = firstVisible;
+    uint32_t color = moved > 0 ? 0x00FF00 : 0xFF0000;  // Green down, red up
+    if (color != navLedColor) {
+        setScrollLEDFast(color);
+        navLedColor = color;
     }
+}
+
+void drawAccelLabel() {
+    const char* name = EncoderAccel::curveName(scrollAccel.config().curve);
+    atlas.drawText(250, 264, name, strlen(name), 2, TFT_YELLOW, TFT_BLACK, 100);
+}
+
+// A key on the scroll screen: next acceleration curve
+void cycleAccelCurve() {
+    int next = (scrollAccel.config().curve + 1) % EncoderAccel::CURVE_COUNT;
+    scrollAccel.setConfig(EncoderAccel::defaultConfig((EncoderAccel::Curve)next));
+    drawAccelLabel();
+    Serial.printf(">>> Encoder acceleration: %s\n", EncoderAccel::curveName((EncoderAccel::Curve)next));
+}
+
+// ============================================
+// Redraw benchmark (B key on the scroll screen)
+// ============================================
+// Steps through the list with each redraw strategy and prints the
+// average cost per step. "old" is the drawing code from before the glyph
+// atlas, "full" the atlas redrawing the whole frame on every step.
+void printListStats(const char* label) {
+    Serial.printf("  %-8s", label);
+    for (int k = 0; k < VirtualList::STEP_KINDS; k++) {
+        const VirtualList::StepStats& st = scrollList.stats((VirtualList::StepKind)k);
+        if (st.count == 0) continue;
+        Serial.printf("  %s: %u x %lu us avg (max %lu, %.1f rows)",
+                      VirtualList::stepKindName(k), (unsigned)st.count,
+                      (unsigned long)(st.totalUs / st.count), (unsigned long)st.maxUs,
+                      (float)st.rows / st.count);
+    }
+    Serial.println();
+}
+
+// The list as drawn before the atlas and VirtualList: clear the frame,
+// then lcd.print() every visible row (the counter is left out, as in
+// the other strategies)
+void drawListOld(int sel) {
+    int firstVisible = sel - 3;
+    if (firstVisible < 0) firstVisible = 0;
     
-    int y = 50;  // Initial Y position
+    lcd.startWrite();
+    lcd.drawRect(20, 40, 440, 190, TFT_WHITE);
+    lcd.fillRect(22, 42, 436, 186, TFT_BLACK);
     
+    int y = 50;
     for (int i = 0; i < 8; i++) {
         int itemIdx = firstVisible + i;
+        if (itemIdx >= LIST_ITEM_COUNT) break;
         
-        // Check bounds
-        if (itemIdx >= listItemCount) break;
-        
-        bool isSelected = (itemIdx == selectedListItem);
-        bool isChecked = listItemsChecked[itemIdx];
-        
-        // Set size and color
+        bool isSelected = (itemIdx == sel);
+        bool isChecked = isItemChecked(itemIdx);
         if (isSelected) {
-            lcd.setTextSize(4);  // Large font for selected
+            lcd.setTextSize(4);
             lcd.setTextColor(TFT_YELLOW, TFT_BLACK);
         } else {
-            lcd.setTextSize(2);  // Small font for others
+            lcd.setTextSize(2);
             lcd.setTextColor(isChecked ? TFT_GREEN : TFT_WHITE, TFT_BLACK);
         }
-        
         lcd.setCursor(30, y);
         
-        // Get item name
-        String name = listItems[itemIdx];
-        
-        // Truncate long names
+        String name = "Item " + String(itemIdx + 1);
         int maxLen = isSelected ? 20 : 35;
         if (name.length() > maxLen) {
             name = name.substring(0, maxLen - 3) + "...";
         }
-        
-        // Show [✓] mark before name if item is checked
         if (isChecked) {
-            lcd.print("[✓] ");
+            lcd.print("[x] ");
         }
-        
         lcd.print(name);
         
-        // Next line
         y += isSelected ? 32 : 22;
     }
+    lcd.endWrite();
+}
+
+uint32_t benchOldSteps(int steps) {
+    drawListOld(0);
+    uint32_t t0 = micros();
+    for (int i = 1; i <= steps; i++) drawListOld(i);      // Down
+    for (int i = steps - 1; i >= 0; i--) drawListOld(i);  // Back up
+    return (micros() - t0) / (2 * steps);
+}
+
+uint32_t benchListSteps(int steps) {
+    scrollList.select(0);
+    scrollList.resetStats();
+    uint32_t t0 = micros();
+    for (int i = 1; i <= steps; i++) scrollList.select(i);      // Down
+    for (int i = steps - 1; i >= 0; i--) scrollList.select(i);  // Back up
+    return (micros() - t0) / (2 * steps);
+}
+
+void benchScrollList() {
+    const int steps = 40;
+    int restore = scrollList.selected();
+    
+    Serial.println("\n>>> List redraw benchmark (per encoder step)");
+    
+    uint32_t oldUs = benchOldSteps(steps);
+    Serial.printf("  %-8s  fillRect + print(): %lu us avg\n", "old", (unsigned long)oldUs);
+    
+    scrollList.setLegacyRedraw(true);
+    uint32_t fullUs = benchListSteps(steps);
+    printListStats("full");
+    scrollList.setLegacyRedraw(false);
+    
+    scrollList.setShiftMode(VirtualList::SHIFT_REDRAW);
+    scrollList.invalidate();
+    uint32_t redrawUs = benchListSteps(steps);
+    printListStats("redraw");
     
-    lcd.endWrite();  // End SPI operation group
+    scrollList.setShiftMode(VirtualList::SHIFT_COPY);
+    scrollList.invalidate();
+    uint32_t copyUs = benchListSteps(steps);
+    printListStats("copy");
+    
+    // Keep whichever shift strategy is faster on this panel
+    scrollList.setShiftMode(copyUs < redrawUs ? VirtualList::SHIFT_COPY : VirtualList::SHIFT_REDRAW);
+    Serial.printf("  Average: old %lu us, full %lu us, redraw %lu us, copy %lu us -> using %s\n",
+                  (unsigned long)oldUs, (unsigned long)fullUs, (unsigned long)redrawUs, (unsigned long)copyUs,
+                  copyUs < redrawUs ? "copy" : "redraw");
+    
+    char buf[48];
+    int len = snprintf(buf, sizeof(buf), "Step: %lu -> %lu us",
+                       (unsigned long)oldUs, (unsigned long)min(redrawUs, copyUs));
+    atlas.drawText(10, 290, buf, len, 2, TFT_GREEN, TFT_BLACK, 460);
+    
+    scrollList.invalidate();
+    scrollList.select(restore);
+    drawScrollCounter();
 }
 
 // ============================================
@@ -701,7 +811,6 @@ void drawScrollTest() {
 // ============================================
 void resetScrollScreenState() {
     scrollScreenInitialized = false;
-    lastFirstVisible = -1;
 }
 
 void loop() {
@@ -711,6 +820,28 @@ void loop() {
     if (M5Cardputer.Keyboard.isChange() && M5Cardputer.Keyboard.isPressed()) {
         auto keys = M5Cardputer.Keyboard.keysState();
         
+        // T on either screen - I2C bus health telemetry on Serial
+        for (auto c : keys.word) {
+            if ((c == 't' || c == 'T') && moduleFound) {
+                scrollBus.printTelemetry();
+                return;
+            }
+        }
+        
+        // B / A on the scroll screen - redraw benchmark / acceleration curve
+        if (showScrollTest) {
+            for (auto c : keys.word) {
+                if (c == 'b' || c == 'B') {
+                    benchScrollList();
+                    return;
+                }
+                if (c == 'a' || c == 'A') {
+                    cycleAccelCurve();
+                    return;
+                }
+            }
+        }
+        
         // Space - switch between screens
         if (keys.space) {
             showScrollTest = !showScrollTest;
@@ -719,10 +850,11 @@ void loop() {
             // Remember screen switch time
             screenSwitchTime = millis();
             
-            // Reset error counter and state when switching screens
-            i2cErrorCount = 0;
+            // Reset state when switching screens (drop rotation from the old screen)
+            pendingIncrement = 0;
             lastScrollReadTime = 0;
-            lastScrollNavTime = 0;
+            scrollAccel.reset();
+            navTarget = scrollList.selected();
             lastButtonState = false;  // Reset button state
             
             if (showScrollTest) {
@@ -763,10 +895,16 @@ void loop() {
         return;
     }
     
+    unsigned long currentTime = millis();
+    
+    // Scheduled LED off (replaces delay() between LED writes)
+    if (ledOffTime != 0 && (long)(currentTime - ledOffTime) >= 0) {
+        setScrollLEDFast(0x000000);
+        ledOffTime = 0;
+    }
+    
     // ═══ ЕСЛИ ЭКРАН СКРОЛЛА АКТИВЕН ═══
     if (showScrollTest) {
-        unsigned long currentTime = millis();
-        
         // IMPORTANT: Don't read I2C immediately after screen switch!
         // Give module time to recover after switch
         if (screenSwitchTime > 0 && (currentTime - screenSwitchTime) < SCREEN_SWITCH_DELAY) {
@@ -774,79 +912,37 @@ void loop() {
             return;
         }
         
-        // Check read interval - don't read too often
-        if (currentTime - lastScrollReadTime < SCROLL_READ_INTERVAL) {
-            delay(10);
-            return;
-        }
-        lastScrollReadTime = currentTime;
-        
-        // If too many errors in a row - do soft bus reset
-        if (i2cErrorCount >= MAX_I2C_ERRORS) {
-            i2cBusReset();  // Soft bus reset
-            i2cErrorCount = 0;
-            delay(200);
-            return;  // Skip read after errors
-        }
-        
-        // Read incremental encoder value for navigation
-        uint8_t incData[2] = {0};
-        if (readScrollRegister(SCROLL_INC_ENCODER_REG, 2, incData)) {
-            i2cErrorCount = 0;  // Successful read - reset error counter
-            int16_t incValue = (int16_t)(incData[0] | (incData[1] << 8));
+        // Handle the last finished poll batch, then queue the next one
+        if (pollReady.exchange(false)) {
+            // Navigate list: rotate right → list down, left → list up
+            int steps = scrollAccel.update(pendingIncrement.exchange(0), currentTime);
+            if (steps != 0) {
+                navTarget = constrain(navTarget + steps, 0, scrollList.count() - 1);
+            }
             
-            if (incValue != 0 && (currentTime - lastScrollNavTime > SCROLL_NAV_DEBOUNCE)) {
-                // Navigate list
-                if (incValue > 0) {
-                    // Rotate right → list down
-                    if (selectedListItem < listItemCount - 1) {
-                        selectedListItem++;
-                        drawScrollTest();
-                        Serial.printf(">>> Scroll DOWN → Item %d/%d\n", selectedListItem + 1, listItemCount);
-                        setScrollLEDFast(0x00FF00);  // Green when scrolling down
-                    }
-                } else {
-                    // Rotate left → list up
-                    if (selectedListItem > 0) {
-                        selectedListItem--;
-                        drawScrollTest();
-                        Serial.printf(">>> Scroll UP → Item %d/%d\n", selectedListItem + 1, listItemCount);
-                        setScrollLEDFast(0xFF0000);  // Red when scrolling up
-                    }
+            // Button for check/uncheck
+            bool buttonState = buttonDown;
+            if (buttonState && !lastButtonState) {
+                // Button pressed - toggle check (on the item the encoder points at)
+                if (navTarget != scrollList.selected()) {
+                    renderListNav(currentTime);
                 }
-                lastScrollNavTime = currentTime;
-            }
-        } else {
-            // Read error - increment counter (but don't block completely)
-            i2cErrorCount++;
-            // Log only every 5th error to avoid cluttering Serial
-            if (i2cErrorCount % 5 == 0) {
-                Serial.printf(">>> I2C read errors: %d\n", i2cErrorCount);
+                int item = scrollList.selected();
+                toggleItemChecked(item);
+                scrollList.refreshItem(item);
+                Serial.printf(">>> Item %d %s\n", item + 1, 
+                             isItemChecked(item) ? "CHECKED" : "UNCHECKED");
+                setScrollLEDFast(0x0000FF);  // Blue when checking
+                navLedColor = 0x000000;  // Off after the flash
+                ledOffTime = currentTime + 100;  // Turn off LED in 100 ms
             }
+            lastButtonState = buttonState;
         }
+        pollScrollUnit(currentTime);
         
-        // Read button state for check/uncheck (less often than encoder)
-        static unsigned long lastButtonReadTime = 0;
-        if (currentTime - lastButtonReadTime > 100) {  // Read button once per 100ms
-            uint8_t buttonData[1] = {0};
-            if (readScrollRegister(SCROLL_BUTTON_REG, 1, buttonData)) {
-                i2cErrorCount = 0;  // Successful read - reset counter
-                bool buttonState = (buttonData[0] != 0);
-                
-                if (buttonState && !lastButtonState) {
-                    // Button pressed - toggle check
-                    listItemsChecked[selectedListItem] = !listItemsChecked[selectedListItem];
-                    drawScrollTest();
-                    Serial.printf(">>> Item %d %s\n", selectedListItem + 1, 
-                                 listItemsChecked[selectedListItem] ? "CHECKED" : "UNCHECKED");
-                    setScrollLEDFast(0x0000FF);  // Blue when checking
-                    delay(100);
-                    setScrollLEDFast(0x000000);  // Turn off LED
-                }
-                
-                lastButtonState = buttonState;
-            }
-            lastButtonReadTime = currentTime;
+        // Coalesced redraw: everything since the last frame is one select()
+        if (navTarget != scrollList.selected() && currentTime - lastListFrame >= LIST_FRAME_MS) {
+            renderListNav(currentTime);
         }
         
         delay(10);
@@ -854,15 +950,10 @@ void loop() {
     }
     
     // ═══ ГЛАВНЫЙ ЭКРАН (оригинальный тест) ═══
-    // Reset error counter when returning to main screen
-    i2cErrorCount = 0;
-    
-    // Read incremental encoder value (0x50) - this is what we need!
-    // This register shows change since last read and automatically resets
-    uint8_t incData[2] = {0};
-    if (readScrollRegister(SCROLL_INC_ENCODER_REG, 2, incData)) {
-        i2cErrorCount = 0;  // Successful read - reset error counter
-        int16_t incValue = (int16_t)(incData[0] | (incData[1] << 8));  // little-endian
+    if (pollReady.exchange(false)) {
+        // Incremental encoder (0x50) - this is what we need!
+        // This register shows change since last read and automatically resets
+        int32_t incValue = pendingIncrement.exchange(0);
         
         if (incValue != 0) {
             // Rotation detected!
@@ -878,31 +969,23 @@ void loop() {
                 setScrollLEDFast(0xFF0000);  // Red
             }
             
-            // Display on external screen
-            lcd.fillRect(0, 130, 480, 100, TFT_BLACK);
-            lcd.setCursor(10, 140);
-            lcd.setTextColor(TFT_GREEN, TFT_BLACK);
-            lcd.setTextSize(3);
-            lcd.printf("Encoder: %d\n", lastEncoderValue);
-            lcd.setTextSize(2);
-            lcd.setCursor(10, 200);
-            lcd.setTextColor(TFT_CYAN, TFT_BLACK);
-            lcd.printf("Increment: %+d", incValue);
+            // Display on external screen (padded boxes overwrite old values)
+            char buf[32];
+            int len = snprintf(buf, sizeof(buf), "Encoder: %d", lastEncoderValue);
+            atlas.drawText(10, 140, buf, len, 3, TFT_GREEN, TFT_BLACK, 470);
+            len = snprintf(buf, sizeof(buf), "Increment: %+d", incValue);
+            atlas.drawText(10, 200, buf, len, 2, TFT_CYAN, TFT_BLACK, 470);
+        }
+        
+        // Absolute encoder value (0x10) for synchronization
+        int encoderValue = absoluteEncoder;
+        if (encoderValue != lastEncoderValue) {
+            // Update if changed (in case we missed increment)
+            lastEncoderValue = encoderValue;
         }
-    }
-    
-    // Also read absolute encoder value (0x10) for synchronization
-    int encoderValue = readScrollRegisterValue(SCROLL_ENCODER_REG, 2);
-    if (encoderValue != lastEncoderValue) {
-        // Update if changed (in case we missed increment)
-        lastEncoderValue = encoderValue;
-    }
-    
-    // Read button state (0x20)
-    uint8_t buttonData[1] = {0};
-    if (readScrollRegister(SCROLL_BUTTON_REG, 1, buttonData)) {
-        bool buttonState = (buttonData[0] != 0);
         
+        // Button state (0x20)
+        bool buttonState = buttonDown;
         if (buttonState != lastButtonState) {
             Serial.printf(">>> Button: %s\n", buttonState ? "PRESSED" : "RELEASED");
             
@@ -916,36 +999,27 @@ void loop() {
             }
             
             // Display on external screen
-            lcd.fillRect(0, 240, 480, 80, TFT_BLACK);
-            lcd.setCursor(10, 250);
-            lcd.setTextSize(2);
-            lcd.setTextColor(buttonState ? TFT_RED : TFT_WHITE, TFT_BLACK);
-            lcd.printf("Button: %s", buttonState ? "PRESSED" : "RELEASED");
+            const char* buttonText = buttonState ? "Button: PRESSED" : "Button: RELEASED";
+            atlas.drawText(10, 250, buttonText, strlen(buttonText), 2,
+                           buttonState ? TFT_RED : TFT_WHITE, TFT_BLACK, 470);
             
-            // On button press - reset encoder (like MicroPython example)
+            // On button press - reset encoder (like MicroPython example).
+            // Queued ahead of the next poll, so that poll already reads 0.
             if (buttonState) {
-                if (moduleFound) {
-                    uint8_t address = (foundAddress != 0) ? foundAddress : UNIT_SCROLL_I2C_ADDRESS;
-                    Wire.beginTransmission(address);
-                    Wire.write(SCROLL_RESET_REG);
-                    Wire.write(1);  // Write 1 to reset encoder
-                    Wire.endTransmission();
-                }
+                uint8_t one = 1;  // Write 1 to reset encoder
+                scrollBus.submitWrite(SCROLL_RESET_REG, &one, 1, onWriteDone);
                 lastEncoderValue = 0;
                 Serial.println(">>> Encoder reset!");
                 
-                // Update display
-                lcd.fillRect(0, 130, 480, 100, TFT_BLACK);
-                lcd.setCursor(10, 140);
-                lcd.setTextColor(TFT_GREEN, TFT_BLACK);
-                lcd.setTextSize(3);
-                lcd.printf("Encoder: 0\n");
+                // Update display (clear the increment line too)
+                atlas.drawText(10, 140, "Encoder: 0", 10, 3, TFT_GREEN, TFT_BLACK, 470);
+                atlas.drawText(10, 200, "", 0, 2, TFT_BLACK, TFT_BLACK, 470);
             }
             
             lastButtonState = buttonState;
         }
     }
+    pollScrollUnit(currentTime);
     
-    delay(50);  // Small delay for stability
+    delay(10);  // Keyboard polling pace; I2C runs in its own task
 }
-
@@ -0,0 +1,289 @@
+/*
+ * Virtualized list widget for the external ILI9488 display
+ *
+ * Items are never stored: a callback fills the text and color of one
+ * item on demand, so the list can hold any count (the scroll test uses
+ * 10,000). Only the visible window of fixed-height rows is drawn.
+ *
+ * Each visible row slot remembers how wide its last text was. A row is
+ * redrawn as one atlas block covering the new text plus whatever is left
+ * of the old one, instead of clearing the whole frame.
+ *
+ * Per step:
+ * - Selection moves inside the window: redraw the old and new selected rows.
+ * - Window shifts by d < rows: either block-copy the remaining rows with
+ *   copyRect() and draw the d new ones (SHIFT_COPY), or redraw every row
+ *   (SHIFT_REDRAW). On this panel copyRect() reads pixels back over SPI,
+ *   so which one is faster depends on how wide the rows are - the stats
+ *   below are there to measure it.
+ * - Larger jumps redraw the window.
+ *
+ * The ILI9488 only scrolls in hardware along its 480 px axis, which is
+ * horizontal in the landscape rotation used here, so there is no
+ * hardware scroll option.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include "glyph_atlas.h"
+
+struct ListRow {
+    char text[48];
+    int len;          // Characters in text (longer text is truncated with "...")
+    uint16_t color;
+};
+
+// Fill row for item index; selected = item is the current selection
+typedef void (*VirtualListSource)(int index, bool selected, ListRow& row, void* ctx);
+
+class VirtualList {
+public:
+    static constexpr int MAX_ROWS = 16;
+    static constexpr int TEXT_PAD_X = 6;  // Text inset from the list's left edge
+
+    enum ShiftMode { SHIFT_REDRAW, SHIFT_COPY };
+    enum StepKind { STEP_SELECT, STEP_SHIFT, STEP_FULL, STEP_KINDS };
+
+    struct StepStats {
+        uint32_t count;
+        uint32_t rows;     // Rows drawn
+        uint32_t totalUs;
+        uint32_t maxUs;
+    };
+
+    VirtualList() : _lcd(nullptr), _atlas(nullptr), _src(nullptr), _ctx(nullptr),
+                    _x(0), _y(0), _w(0), _rowH(0), _rows(0), _count(0),
+                    _first(0), _sel(0), _scale(2), _selScale(3), _bg(0),
+                    _mode(SHIFT_REDRAW), _legacy(false), _dirty(true), _rowsDrawn(0) {
+        memset(_slotW, 0, sizeof(_slotW));
+        resetStats();
+    }
+
+    void begin(lgfx::LGFX_Device* lcd, GlyphAtlas* atlas, int x, int y, int w, int h,
+               int rowH, VirtualListSource src, void* ctx = nullptr) {
+        _lcd = lcd;
+        _atlas = atlas;
+        _x = x;
+        _y = y;
+        _w = w;
+        _rowH = rowH;
+        _rows = h / rowH;
+        if (_rows > MAX_ROWS) _rows = MAX_ROWS;
+        _src = src;
+        _ctx = ctx;
+        _dirty = true;
+    }
+
+    void setCount(int count) {
+        _count = max(0, count);
+        _sel = constrain(_sel, 0, max(0, _count - 1));
+        _dirty = true;
+    }
+
+    // Text scale for normal / selected rows
+    void setScales(uint8_t normal, uint8_t selected) {
+        _scale = normal;
+        _selScale = selected;
+        _dirty = true;
+    }
+
+    void setColors(uint16_t bg) { _bg = bg; _dirty = true; }
+    void setShiftMode(ShiftMode mode) { _mode = mode; }
+    ShiftMode shiftMode() const { return _mode; }
+
+    // Full-frame redraw (clear the area, draw every row through the atlas
+    // on each step) - a baseline for measurements
+    void setLegacyRedraw(bool on) { _legacy = on; _dirty = true; }
+
+    int count() const { return _count; }
+    int selected() const { return _sel; }
+    int firstVisible() const { return _first; }
+    int visibleRows() const { return _rows; }
+
+    // Next select() or draw() repaints the whole window (clears the area)
+    void invalidate() { _dirty = true; }
+
+    void draw() { select(_sel); }
+
+    // Move the selection (clamped) and redraw as little as possible
+    void select(int index) {
+        if (!_lcd || _rows == 0) return;
+        index = constrain(index, 0, max(0, _count - 1));
+        if (index == _sel && !_dirty && !_legacy) return;
+
+        uint32_t t0 = micros();
+        _rowsDrawn = 0;
+        StepKind kind;
+
+        int oldSel = _sel;
+        _sel = index;
+        int newFirst = windowFor(index);
+        int d = newFirst - _first;
+
+        _lcd->startWrite();
+        if (_dirty || _legacy) {
+            _first = newFirst;
+            clearAll();
+            drawRows(0, _rows);
+            _dirty = false;
+            kind = STEP_FULL;
+        } else if (d == 0) {
+            drawSlot(oldSel - _first);
+            if (index != oldSel) drawSlot(index - _first);
+            kind = STEP_SELECT;
+        } else if (_mode == SHIFT_COPY && abs(d) < _rows) {
+            shiftRows(d);
+            _first = newFirst;
+            uint32_t done;
+            if (d > 0) {
+                drawRows(_rows - d, _rows);
+                done = ((1u << d) - 1) << (_rows - d);
+            } else {
+                drawRows(0, -d);
+                done = (1u << -d) - 1;
+            }
+            // Old and new selection, unless already drawn as new rows
+            int s = oldSel - _first;
+            if (s >= 0 && s < _rows && !(done & (1u << s))) drawSlot(s);
+            s = index - _first;
+            if (s != oldSel - _first && !(done & (1u << s))) drawSlot(s);
+            kind = STEP_SHIFT;
+        } else {
+            _first = newFirst;
+            drawRows(0, _rows);
+            kind = abs(d) < _rows ? STEP_SHIFT : STEP_FULL;
+        }
+        _lcd->endWrite();  // Waits for the last DMA block
+
+        uint32_t us = micros() - t0;
+        StepStats& st = _stats[kind];
+        st.count++;
+        st.rows += _rowsDrawn;
+        st.totalUs += us;
+        if (us > st.maxUs) st.maxUs = us;
+    }
+
+    void moveBy(int delta) { select(_sel + delta); }
+
+    // Item data changed (e.g. checked): redraw it if visible
+    void refreshItem(int index) {
+        int slot = index - _first;
+        if (!_lcd || _dirty || slot < 0 || slot >= _rows) return;
+        _lcd->startWrite();
+        drawSlot(slot);
+        _lcd->endWrite();
+    }
+
+    const StepStats& stats(StepKind kind) const { return _stats[kind]; }
+    void resetStats() { memset(_stats, 0, sizeof(_stats)); }
+
+    static const char* stepKindName(int kind) {
+        static const char* const names[STEP_KINDS] = {"select", "shift", "full"};
+        return (kind >= 0 && kind < STEP_KINDS) ? names[kind] : "?";
+    }
+
+private:
+    // First visible item that keeps index one row away from the window
+    // edges (except at the ends of the list)
+    int windowFor(int index) const {
+        const int margin = _rows > 2 ? 1 : 0;
+        int first = _first;
+        if (index < first + margin) first = index - margin;
+        if (index > first + _rows - 1 - margin) first = index - (_rows - 1 - margin);
+        return constrain(first, 0, max(0, _count - _rows));
+    }
+
+    int textWidth() const { return _w - TEXT_PAD_X; }
+
+    void clearAll() {
+        _lcd->fillRect(_x, _y, _w, _rows * _rowH, _bg);
+        memset(_slotW, 0, sizeof(_slotW));
+    }
+
+    void drawRows(int from, int to) {
+        for (int s = from; s < to; s++) drawSlot(s);
+    }
+
+    // Draw item _first + slot into its row; the block covers the new
+    // text and the rest of the previous text in that slot
+    void drawSlot(int slot) {
+        if (slot < 0 || slot >= _rows) return;
+        int index = _first + slot;
+        int x = _x + TEXT_PAD_X;
+        int y = _y + slot * _rowH;
+
+        if (index >= _count) {
+            if (_slotW[slot] > 0) {
+                _lcd->fillRect(x, y, _slotW[slot], _rowH, _bg);
+                _slotW[slot] = 0;
+            }
+            return;
+        }
+
+        bool isSel = (index == _sel);
+        uint8_t scale = isSel ? _selScale : _scale;
+        int gw = GlyphAtlas::glyphWidth(scale);
+        int gh = GlyphAtlas::glyphHeight(scale);
+
+        ListRow row;
+        row.len = 0;
+        row.color = TFT_WHITE;
+        _src(index, isSel, row, _ctx);
+        int len = constrain(row.len, 0, (int)sizeof(row.text) - 1);
+
+        // Truncate long names
+        int maxLen = textWidth() / gw;
+        if (len > maxLen) {
+            len = maxLen;
+            for (int i = max(0, len - 3); i < len; i++) row.text[i] = '.';
+        }
+
+        int w = len * gw;
+        int boxW = max(w, (int)_slotW[slot]);
+        if (boxW > 0) {
+            _atlas->drawText(x, y, row.text, len, scale, row.color, _bg,
+                             boxW, _rowH, max(0, (_rowH - gh) / 2));
+        }
+        _slotW[slot] = w;
+        _rowsDrawn++;
+    }
+
+    // Move rows d slots up (d > 0) or down (d < 0) on the panel
+    void shiftRows(int d) {
+        int n = _rows - abs(d);
+        int srcSlot = d > 0 ? d : 0;
+        int dstSlot = d > 0 ? 0 : -d;
+
+        // As wide as the widest text in the window, so the copy also
+        // covers everything that was in the destination rows
+        int copyW = 0;
+        for (int i = 0; i < _rows; i++) copyW = max(copyW, (int)_slotW[i]);
+        if (copyW > 0) {
+            int x = _x + TEXT_PAD_X;
+            _lcd->copyRect(x, _y + dstSlot * _rowH, copyW, n * _rowH,
+                           x, _y + srcSlot * _rowH);
+        }
+
+        // Recycle slot widths with the pixels. Exposed slots still hold
+        // their old contents, so their widths stay as they are.
+        memmove(_slotW + dstSlot, _slotW + srcSlot, n * sizeof(_slotW[0]));
+    }
+
+    lgfx::LGFX_Device* _lcd;
+    GlyphAtlas* _atlas;
+    VirtualListSource _src;
+    void* _ctx;
+    int _x, _y, _w, _rowH, _rows;
+    int _count;
+    int _first;
+    int _sel;
+    uint8_t _scale, _selScale;
+    uint16_t _bg;
+    ShiftMode _mode;
+    bool _legacy;
+    bool _dirty;
+    int _rowsDrawn;
+    uint16_t _slotW[MAX_ROWS];  // Width of the text last drawn in each slot
+    StepStats _stats[STEP_KINDS];
+};
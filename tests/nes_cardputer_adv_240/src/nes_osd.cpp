@@ -13,6 +13,7 @@
 #include <Arduino.h>
 #include <string.h>
 #include <Wire.h>  // For Joystick2 I2C
+#include <CardputerI2C.h>  // Shared Joystick2 driver (repo lib/CardputerI2C)
 #include <esp_timer.h>  // For audio timer (60 Hz independent from video)
 #include "external_display/LGFX_ILI9341.h"
 
@@ -109,10 +110,9 @@ static void init_scale_luts(void) {
 #define JOYSTICK2_ADDR 0x63
 static bool joystick2_available = false;
 
-// Joystick2 registers (from official documentation)
-#define REG_ADC_X_8   0x10  // X ADC 8-bit (0-255)
-#define REG_ADC_Y_8   0x11  // Y ADC 8-bit (0-255)
-#define REG_BUTTON    0x20  // Button (1=no press, 0=press)
+// Joystick2 on Wire; X/Y come in one 2-byte burst (see joystick2.h)
+static WireBus joystick2_bus(Wire);
+static Joystick2 joystick2(joystick2_bus, JOYSTICK2_ADDR);
 
 // Joystick2 data structure
 struct Joystick2Data {
@@ -125,44 +125,11 @@ struct Joystick2Data {
 static bool readJoystick2(Joystick2Data* data) {
     if (!joystick2_available) return false;
     
-    // Read X
-    Wire.beginTransmission(JOYSTICK2_ADDR);
-    Wire.write(REG_ADC_X_8);
-    if (Wire.endTransmission(false) != 0) return false;
-    
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-        data->x = Wire.read();
-    } else {
-        return false;
-    }
-    
-    // Read Y
-    Wire.beginTransmission(JOYSTICK2_ADDR);
-    Wire.write(REG_ADC_Y_8);
-    if (Wire.endTransmission(false) != 0) return false;
-    
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-        data->y = Wire.read();
-    } else {
-        return false;
-    }
-    
-    // Read button
-    Wire.beginTransmission(JOYSTICK2_ADDR);
-    Wire.write(REG_BUTTON);
-    if (Wire.endTransmission(false) != 0) return false;
-    
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-        uint8_t btn = Wire.read();
-        // Invert: in joystick 0=pressed, 1=not pressed
-        data->button = (btn == 0) ? 1 : 0;
-    } else {
-        return false;
-    }
-    
+    Joystick2State js;
+    if (!joystick2.read(&js)) return false;
+    data->x = js.x;
+    data->y = js.y;
+    data->button = js.pressed ? 1 : 0;
     return true;
 }
 
@@ -522,15 +489,12 @@ static void osd_initinput(void) {
     Serial.println("[INPUT] I2C: SDA=G2, SCL=G1");
     Serial.printf("[INPUT] Looking for device at 0x%02X...\n", JOYSTICK2_ADDR);
     
-    Wire.beginTransmission(JOYSTICK2_ADDR);
-    byte error = Wire.endTransmission();
-    
-    if (error == 0) {
+    if (joystick2.begin()) {
         joystick2_available = true;
         Serial.printf("[INPUT] ✅ Joystick2 detected at 0x%02X!\n", JOYSTICK2_ADDR);
     } else {
         joystick2_available = false;
-        Serial.printf("[INPUT] ❌ Joystick2 not found (error: %d)\n", error);
+        Serial.printf("[INPUT] ❌ Joystick2 not found\n");
         Serial.println("[INPUT] Using keyboard only");
     }
 }
@@ -0,0 +1,160 @@
+/*
+ * Host decoder for the binary Serial log (LOG_BINARY_KEY)
+ *
+ * Build and run on a PC:
+ *   g++ -O2 -std=c++11 -pthread -I../src -o log_decode log_decode.cpp
+ *   ./log_decode [-t] < capture.bin        (or a serial port: -t < /dev/ttyACM0)
+ *   ./log_decode --selftest
+ *
+ * Records start with LOG_SYNC and are formatted with the same
+ * LOG_FORMATS table as the firmware (src/log_formats.h). Bytes outside
+ * records - the [SCHED]/[VIEW] reports, which are still plain text -
+ * are passed through. -t prefixes each record with its millis().
+ *
+ * --selftest pushes records from several threads into a LogRing while
+ * one thread drains it to a binary stream, then decodes the stream and
+ * checks that every record arrived in order or was counted as dropped.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log_ring.h"
+
+static bool validHeader(const LogRecord& h) {
+    return h.state == LOG_SYNC && h.fmt < LOG_FMT_COUNT && h.nargs <= LOG_MAX_ARGS &&
+           h.textLen <= LOG_MAX_TEXT;
+}
+
+// Decode one buffered stream; fn(rec, args, text) per record, other
+// bytes to passthrough(byte). Returns the bytes consumed (a partial
+// record at the end is left for the next call).
+template <typename RecFn, typename ByteFn>
+static size_t decode(const uint8_t* data, size_t len, RecFn fn, ByteFn passthrough) {
+    size_t i = 0;
+    while (i < len) {
+        if (data[i] != LOG_SYNC) {
+            passthrough(data[i++]);
+            continue;
+        }
+        if (len - i < sizeof(LogRecord)) break;
+        LogRecord h;
+        memcpy(&h, data + i, sizeof(h));
+        if (!validHeader(h)) {
+            passthrough(data[i++]);
+            continue;
+        }
+        size_t size = logRecordSize(h.nargs, h.textLen);
+        if (len - i < size) break;
+        int32_t args[LOG_MAX_ARGS];
+        memcpy(args, data + i + sizeof(h), h.nargs * 4u);
+        fn(h, args, (const char*)data + i + sizeof(h) + h.nargs * 4u);
+        i += size;
+    }
+    return i;
+}
+
+static int selftest() {
+    const int producers = 4;
+    const int perProducer = 20000;
+    LogRing ring;
+    std::vector<uint8_t> stream;
+    bool done = false;
+
+    std::thread drain([&] {
+        for (;;) {
+            bool last = __atomic_load_n(&done, __ATOMIC_ACQUIRE);
+            ring.drain([&](const LogRecord& rec, const int32_t* args, const char* text) {
+                size_t size = logRecordSize(rec.nargs, rec.textLen);
+                size_t at = stream.size();
+                stream.resize(at + size);
+                LogRecord h = rec;
+                h.state = LOG_SYNC;
+                memcpy(&stream[at], &h, sizeof(h));
+                memcpy(&stream[at + sizeof(h)], args, size - sizeof(h));
+                (void)text;
+            });
+            if (last) break;
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&ring, p] {
+            char text[16];
+            for (int i = 0; i < perProducer; i++) {
+                if (i % 3 == 0) {
+                    int n = snprintf(text, sizeof(text), "p%d #%d", p, i);
+                    ring.push(LOG_TEXT, (uint32_t)i, nullptr, 0, text, (uint8_t)n);
+                } else {
+                    int32_t args[3] = {'A' + p, i, p};
+                    ring.push(LOG_ENC, (uint32_t)i, args, 3);
+                }
+                if (i % 16 == 0) std::this_thread::yield();  // Let the drain keep up, mostly
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    __atomic_store_n(&done, true, __ATOMIC_RELEASE);
+    drain.join();
+
+    int received = 0, errors = 0, passthrough = 0;
+    int last[producers];
+    for (int p = 0; p < producers; p++) last[p] = -1;
+    size_t used = decode(stream.data(), stream.size(),
+        [&](const LogRecord& rec, const int32_t* args, const char* text) {
+            int p, i;
+            if (rec.fmt == LOG_TEXT) {
+                if (sscanf(std::string(text, rec.textLen).c_str(), "p%d #%d", &p, &i) != 2) {
+                    errors++;
+                    return;
+                }
+            } else {
+                p = args[2];
+                i = args[1];
+                if (args[0] != 'A' + p) errors++;
+            }
+            if (p < 0 || p >= producers || i <= last[p] || (uint32_t)i != rec.ms) errors++;
+            else last[p] = i;
+            received++;
+        },
+        [&](uint8_t) { passthrough++; });
+
+    uint32_t dropped = ring.dropped();
+    printf("selftest: %d records, %d received, %u dropped, %d errors, %d stray bytes\n",
+           producers * perProducer, received, (unsigned)dropped, errors, passthrough);
+    bool ok = errors == 0 && passthrough == 0 && used == stream.size() &&
+              received + (int)dropped == producers * perProducer;
+    printf(ok ? "selftest passed\n" : "selftest FAILED\n");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    bool timestamps = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--selftest")) return selftest();
+        if (!strcmp(argv[i], "-t")) timestamps = true;
+    }
+
+    std::vector<uint8_t> buf;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+        buf.insert(buf.end(), chunk, chunk + n);
+        size_t used = decode(buf.data(), buf.size(),
+            [&](const LogRecord& rec, const int32_t* args, const char* text) {
+                char line[LOG_MAX_TEXT + 64];
+                LogRing::format(line, sizeof(line), rec, args, text);
+                if (timestamps) printf("%10u ", (unsigned)rec.ms);
+                printf("[APP] %s\n", line);
+            },
+            [](uint8_t b) { putchar(b); });
+        buf.erase(buf.begin(), buf.begin() + used);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Log record formats, shared by the firmware and host/log_decode.cpp
+ *
+ * A record carries the index into LOG_FORMATS instead of the formatted
+ * text: up to LOG_MAX_ARGS int32 arguments and, for formats that start
+ * with %s, one text argument. Formatting happens later, in the drain
+ * task - or on the host, for the binary mode.
+ *
+ * Append new formats at the end: the host decoder must be rebuilt with
+ * the same table, and old captures keep their meaning.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+enum LogFmt : uint8_t {
+    LOG_TEXT,             // Any pre-formatted line
+    LOG_KEY,
+    LOG_JOY,
+    LOG_SCROLL_PRESSED,
+    LOG_SCROLL_RELEASED,
+    LOG_ENC,
+    LOG_DROPPED,          // Emitted by the drain: records lost since the last one
+    LOG_FMT_COUNT,
+
+    LOG_PAD = 0xFF        // Ring only: skip to the start of the buffer
+};
+
+// Text argument first (if the record has one), then the int32 arguments
+static const char* const LOG_FORMATS[LOG_FMT_COUNT] = {
+    "%s",
+    "KB: 0x%02X",
+    "Joy: X=%3d Y=%3d Btn=%d",
+    "Scroll %c button: PRESSED",
+    "Scroll %c button: RELEASED",
+    "Enc %c: %+d (Total: %d)",
+    "LOG: %u records dropped",
+};
+
+#define LOG_MAX_ARGS 4
+#define LOG_MAX_TEXT 120
+#define LOG_SYNC     0xA5  // First byte of a record in the binary stream
+
+// Record header. In the ring 'state' is the commit flag, on the wire it
+// is LOG_SYNC. Arguments and text follow, padded to 4 bytes.
+struct LogRecord {
+    uint8_t state;
+    uint8_t fmt;       // LogFmt
+    uint8_t nargs;     // int32 arguments after the header
+    uint8_t textLen;   // Text bytes after the arguments (not terminated)
+    uint32_t ms;       // millis() when logged
+};
+
+static inline uint32_t logRecordSize(uint8_t nargs, uint8_t textLen) {
+    return (sizeof(LogRecord) + nargs * 4u + textLen + 3u) & ~3u;
+}
@@ -0,0 +1,125 @@
+/*
+ * Lock-free log ring: many producers, one drain
+ *
+ * push() is all the logging a poll task does: reserve space with one
+ * compare-and-swap, copy the format index, arguments and text in, then
+ * set the record's commit flag. No formatting, no Serial, no locks, so
+ * it can be called from any task or core (and from an ISR if the ring
+ * and the caller sit in IRAM/DRAM).
+ *
+ * The drain (one task) takes committed records in order and stops at
+ * the first one still being written. A record never wraps: when it
+ * doesn't fit before the end of the buffer, a LOG_PAD marker fills the
+ * rest. When the ring is full, push() drops the record and counts it.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include "log_formats.h"
+
+class LogRing {
+public:
+    static constexpr uint32_t SIZE = 8192;  // Bytes, power of two
+    static constexpr uint32_t MASK = SIZE - 1;
+
+    LogRing() : _reserve(0), _tail(0), _dropped(0) { memset(_buf, 0, sizeof(_buf)); }
+
+    // false = ring full, record dropped
+    bool push(uint8_t fmt, uint32_t ms, const int32_t* args, uint8_t nargs,
+              const char* text = nullptr, uint8_t textLen = 0) {
+        if (nargs > LOG_MAX_ARGS) nargs = LOG_MAX_ARGS;
+        if (textLen > LOG_MAX_TEXT) textLen = LOG_MAX_TEXT;
+        uint32_t size = logRecordSize(nargs, textLen);
+
+        uint32_t r, pad;
+        do {
+            r = _reserve.load(std::memory_order_relaxed);
+            uint32_t off = r & MASK;
+            pad = (off + size > SIZE) ? SIZE - off : 0;
+            if (r + pad + size - _tail.load(std::memory_order_acquire) > SIZE) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!_reserve.compare_exchange_weak(r, r + pad + size, std::memory_order_relaxed));
+
+        if (pad) {
+            // Only the first word: pad may be as small as 4 bytes
+            at(r)->fmt = LOG_PAD;
+            commit(at(r));
+            r += pad;
+        }
+        LogRecord* rec = at(r);
+        rec->fmt = fmt;
+        rec->nargs = nargs;
+        rec->textLen = textLen;
+        rec->ms = ms;
+        uint8_t* p = (uint8_t*)(rec + 1);
+        memcpy(p, args, nargs * 4u);
+        if (textLen) memcpy(p + nargs * 4u, text, textLen);
+        commit(rec);
+        return true;
+    }
+
+    // Calls fn(const LogRecord&, const int32_t* args, const char* text)
+    // for up to max committed records, oldest first; returns how many
+    template <typename Fn>
+    int drain(Fn fn, int max = 1 << 30) {
+        int n = 0;
+        uint32_t t = _tail.load(std::memory_order_relaxed);
+        while (n < max && t != _reserve.load(std::memory_order_relaxed)) {
+            LogRecord* rec = at(t);
+            if (!__atomic_load_n(&rec->state, __ATOMIC_ACQUIRE)) break;  // Still being written
+            uint32_t size;
+            if (rec->fmt == LOG_PAD) {
+                size = SIZE - (t & MASK);
+            } else {
+                const int32_t* args = (const int32_t*)(rec + 1);
+                fn(*rec, args, (const char*)(args + rec->nargs));
+                size = logRecordSize(rec->nargs, rec->textLen);
+                n++;
+            }
+            // Any word may be a header on the next lap: clear the whole
+            // record so no stale byte reads as a commit flag
+            memset(rec, 0, size);
+            t += size;
+            _tail.store(t, std::memory_order_release);
+        }
+        return n;
+    }
+
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    uint32_t used() const { return _reserve.load(std::memory_order_relaxed) - _tail.load(std::memory_order_relaxed); }
+
+    // Format a record as text (no newline); returns the length
+    static int format(char* out, size_t n, const LogRecord& rec, const int32_t* args,
+                      const char* text) {
+        if (rec.fmt >= LOG_FMT_COUNT) return snprintf(out, n, "LOG: bad format %u", (unsigned)rec.fmt);
+        // Unused arguments are ignored by snprintf
+        int32_t a[LOG_MAX_ARGS] = {0, 0, 0, 0};
+        memcpy(a, args, rec.nargs * 4u);
+        int len;
+        if (rec.textLen || rec.fmt == LOG_TEXT) {
+            char t[LOG_MAX_TEXT + 1];
+            memcpy(t, text, rec.textLen);
+            t[rec.textLen] = '\0';
+            len = snprintf(out, n, LOG_FORMATS[rec.fmt], t, a[0], a[1], a[2], a[3]);
+        } else {
+            len = snprintf(out, n, LOG_FORMATS[rec.fmt], a[0], a[1], a[2], a[3]);
+        }
+        if (len < 0) return 0;
+        return len < (int)n ? len : (int)n - 1;
+    }
+
+private:
+    static void commit(LogRecord* rec) { __atomic_store_n(&rec->state, 1, __ATOMIC_RELEASE); }
+
+    LogRecord* at(uint32_t pos) { return (LogRecord*)&_buf[pos & MASK]; }
+
+    alignas(4) uint8_t _buf[SIZE];
+    std::atomic<uint32_t> _reserve;  // Free-running: end of the reserved bytes
+    std::atomic<uint32_t> _tail;     // Free-running: oldest byte not yet drained
+    std::atomic<uint32_t> _dropped;
+};
@@ -0,0 +1,240 @@
+/*
+ * Log model + partial-redraw view for the external ILI9488 display
+ *
+ * The model is a ring of fixed-size lines. Color and a 32-bit hash
+ * (FNV-1a over text and color) are computed once when a line is added;
+ * nothing is copied or reclassified at redraw time.
+ *
+ * The view remembers, per visible slot, the hash and text width it last
+ * drew. draw() compares hashes and redraws only the slots that changed,
+ * each as one atlas block covering the new text plus what is left of
+ * the old one.
+ *
+ * When new lines scroll the window by d < rows, every slot would change.
+ * The shift path moves the remaining rows up with copyRect() (only as
+ * wide as the widest text) and draws just the d new rows. On this panel
+ * copyRect() reads the pixels back over SPI, so it is not always faster
+ * than redrawing: SHIFT_AUTO times both on the first shifts and keeps
+ * the faster one.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include "glyph_atlas.h"
+
+struct LogLine {
+    char text[48];   // Longer text is cut (40 glyphs fit at scale 2)
+    uint8_t len;
+    uint16_t color;
+    uint32_t hash;   // Never 0 (0 = empty slot)
+};
+
+class LogView {
+public:
+    static constexpr int MAX_LINES = 50;
+    static constexpr int MAX_ROWS = 16;
+    static constexpr int AUTO_SAMPLES = 4;  // Shifts timed per mode before choosing
+
+    enum ShiftMode { SHIFT_REDRAW, SHIFT_COPY, SHIFT_AUTO };
+
+    struct Stats {
+        uint32_t draws;
+        uint32_t rowsDrawn;
+        uint32_t rowsSkipped;  // Hash unchanged
+        uint32_t shifts[2];    // Per mode (SHIFT_REDRAW, SHIFT_COPY)
+        uint32_t shiftUs[2];
+        uint32_t fullRedraws;
+    };
+
+    LogView() : _lcd(nullptr), _atlas(nullptr), _x(0), _y(0), _w(0), _rowH(0), _rows(0),
+                _scale(2), _bg(0), _head(0), _count(0), _seq(0),
+                _valid(false), _drawnTop(0), _mode(SHIFT_AUTO), _active(SHIFT_REDRAW) {
+        memset(_slotHash, 0, sizeof(_slotHash));
+        memset(_slotW, 0, sizeof(_slotW));
+        resetStats();
+    }
+
+    void begin(lgfx::LGFX_Device* lcd, GlyphAtlas* atlas, int x, int y, int w,
+               int rowH, int rows, uint8_t scale, uint16_t bg) {
+        _lcd = lcd;
+        _atlas = atlas;
+        _x = x;
+        _y = y;
+        _w = w;
+        _rowH = rowH;
+        _rows = rows > MAX_ROWS ? MAX_ROWS : rows;
+        _scale = scale;
+        _bg = bg;
+        _valid = false;
+    }
+
+    // --- Model ---
+
+    void add(const char* text, int len, uint16_t color) {
+        LogLine& line = _lines[(_head + _count) % MAX_LINES];
+        if (_count < MAX_LINES) _count++;
+        else _head = (_head + 1) % MAX_LINES;
+        _seq++;
+
+        len = constrain(len, 0, (int)sizeof(line.text));
+        memcpy(line.text, text, len);
+        line.len = (uint8_t)len;
+        line.color = color;
+
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < len; i++) h = (h ^ (uint8_t)text[i]) * 16777619u;
+        h = (h ^ (color & 0xFF)) * 16777619u;
+        h = (h ^ (color >> 8)) * 16777619u;
+        line.hash = h ? h : 1;
+    }
+
+    void clear() {
+        _head = 0;
+        _count = 0;
+        _valid = false;
+    }
+
+    int count() const { return _count; }
+    const LogLine& line(int i) const { return _lines[(_head + i) % MAX_LINES]; }  // 0 = oldest
+
+    // --- View ---
+
+    void setShiftMode(ShiftMode mode) {
+        _mode = mode;
+        if (mode != SHIFT_AUTO) _active = mode;
+        resetStats();
+    }
+    ShiftMode shiftMode() const { return _mode; }
+    ShiftMode activeShiftMode() const { return _active; }
+
+    // Next draw() repaints every slot
+    void invalidate() { _valid = false; }
+
+    void draw() {
+        if (!_lcd || _rows == 0) return;
+        _stats.draws++;
+
+        // Window shows the newest lines; top = sequence number of slot 0
+        int first = max(0, _count - _rows);
+        uint32_t top = _seq - _count + first;
+
+        _lcd->startWrite();
+        if (!_valid) {
+            _lcd->fillRect(_x, _y, _w, _rows * _rowH, _bg);
+            memset(_slotHash, 0, sizeof(_slotHash));
+            memset(_slotW, 0, sizeof(_slotW));
+            _valid = true;
+            _stats.fullRedraws++;
+        } else if (top != _drawnTop) {
+            uint32_t d = top - _drawnTop;
+            if (d < (uint32_t)_rows) {
+                shift((int)d, first);  // Ends the write
+                _drawnTop = top;
+                return;
+            }
+        }
+        _drawnTop = top;
+        drawChanged(first, 0, _rows);
+        _lcd->endWrite();
+    }
+
+    const Stats& stats() const { return _stats; }
+    void resetStats() {
+        memset(&_stats, 0, sizeof(_stats));
+        if (_mode == SHIFT_AUTO) _active = SHIFT_REDRAW;
+    }
+
+    // Average µs per shift for a mode, 0 = not measured
+    uint32_t avgShiftUs(ShiftMode mode) const {
+        return _stats.shifts[mode] ? _stats.shiftUs[mode] / _stats.shifts[mode] : 0;
+    }
+
+private:
+    // Window moved down by d rows (d < _rows)
+    void shift(int d, int first) {
+        uint32_t t0 = micros();
+        ShiftMode mode = _active;
+
+        if (mode == SHIFT_COPY) {
+            // Move the rows that stay, as wide as the widest text in the
+            // window so the copy also covers what was in the target rows
+            int n = _rows - d;
+            int copyW = 0;
+            for (int s = 0; s < _rows; s++) copyW = max(copyW, (int)_slotW[s]);
+            if (copyW > 0) {
+                _lcd->copyRect(_x, _y, copyW, n * _rowH, _x, _y + d * _rowH);
+            }
+            memmove(_slotHash, _slotHash + d, n * sizeof(_slotHash[0]));
+            memmove(_slotW, _slotW + d, n * sizeof(_slotW[0]));
+            // Exposed rows keep their old pixels: widths stay, hashes
+            // are unknown so they are drawn
+            for (int s = n; s < _rows; s++) _slotHash[s] = 0;
+            drawChanged(first, n, _rows);
+        } else {
+            drawChanged(first, 0, _rows);
+        }
+        _lcd->endWrite();  // Count the wait for the last DMA block
+
+        _stats.shifts[mode]++;
+        _stats.shiftUs[mode] += micros() - t0;
+        if (_mode == SHIFT_AUTO) chooseShiftMode();
+    }
+
+    // Time AUTO_SAMPLES shifts with each mode, then keep the faster one
+    void chooseShiftMode() {
+        if (_stats.shifts[SHIFT_REDRAW] < (uint32_t)AUTO_SAMPLES) _active = SHIFT_REDRAW;
+        else if (_stats.shifts[SHIFT_COPY] < (uint32_t)AUTO_SAMPLES) _active = SHIFT_COPY;
+        else _active = avgShiftUs(SHIFT_COPY) < avgShiftUs(SHIFT_REDRAW) ? SHIFT_COPY : SHIFT_REDRAW;
+    }
+
+    void drawChanged(int first, int from, int to) {
+        int gw = GlyphAtlas::glyphWidth(_scale);
+        for (int s = from; s < to; s++) {
+            int i = first + s;
+            int y = _y + s * _rowH;
+            if (i >= _count) {
+                if (_slotHash[s] != 0 || _slotW[s] > 0) {
+                    if (_slotW[s] > 0) _lcd->fillRect(_x, y, _slotW[s], _rowH, _bg);
+                    _slotHash[s] = 0;
+                    _slotW[s] = 0;
+                    _stats.rowsDrawn++;
+                }
+                continue;
+            }
+            const LogLine& l = line(i);
+            if (l.hash == _slotHash[s]) {
+                _stats.rowsSkipped++;
+                continue;
+            }
+            int len = min((int)l.len, _w / gw);
+            int w = len * gw;
+            int boxW = max(w, (int)_slotW[s]);
+            if (boxW > 0) {
+                _atlas->drawText(_x, y, l.text, len, _scale, l.color, _bg, boxW, _rowH);
+            }
+            _slotHash[s] = l.hash;
+            _slotW[s] = w;
+            _stats.rowsDrawn++;
+        }
+    }
+
+    lgfx::LGFX_Device* _lcd;
+    GlyphAtlas* _atlas;
+    int _x, _y, _w, _rowH, _rows;
+    uint8_t _scale;
+    uint16_t _bg;
+
+    LogLine _lines[MAX_LINES];
+    int _head;       // Oldest line
+    int _count;
+    uint32_t _seq;   // Lines added so far
+
+    bool _valid;
+    uint32_t _drawnTop;           // Sequence number drawn in slot 0
+    uint32_t _slotHash[MAX_ROWS];  // Hash drawn in each slot, 0 = empty
+    uint16_t _slotW[MAX_ROWS];     // Text width drawn in each slot
+    ShiftMode _mode;
+    ShiftMode _active;             // Mode used for the next shift
+    Stats _stats;
+};
@@ -30,7 +30,12 @@
 #include <M5Cardputer.h>
 #include <M5GFX.h>
 #include <Wire.h>
+#include <CardputerI2C.h>
 #include "lgfx/v1/panel/Panel_LCD.hpp"
+#include "glyph_atlas.h"
+#include "poll_scheduler.h"
+#include "log_view.h"
+#include "log_ring.h"
 
 // ============================================
 // Local Panel_ILI9488 Definition
@@ -99,8 +104,8 @@ public:
         b.freq_write = 20000000;    // 20 MHz
         b.freq_read  = 16000000;
         b.spi_3wire  = true;        // 3-wire SPI
-        b.use_lock   = false;       // No SPI locking
-        b.dma_channel = 0;          // No DMA
+        b.use_lock   = true;        // Hold the bus while DMA transfers run
+        b.dma_channel = SPI_DMA_CH_AUTO;  // DMA for glyph atlas block pushes
 
         b.pin_sclk = 40;            // SCK  -> PIN 7
         b.pin_mosi = 14;            // MOSI -> PIN 9
@@ -135,6 +140,7 @@ public:
 };
 
 LGFX_ILI9488 lcd;  // External ILI9488 display
+GlyphAtlas atlas;  // Pre-rendered font tiles in panel pixel format
 
 // ============================================
 // PA Hub and Device Constants
@@ -145,17 +151,11 @@ LGFX_ILI9488 lcd;  // External ILI9488 display
 #define PAHUB_CH_SCROLL_A    1
 #define PAHUB_CH_SCROLL_B    2
 #define PAHUB_CH_KEYBOARD    3
+#define PAHUB_SETTLE_US      500   // Delay after writing a new channel mask
 
+// Registers and timing quirks live in the CardputerI2C drivers
 #define JOYSTICK2_ADDR       0x63
-#define JOYSTICK2_REG_ADC_X_8   0x10
-#define JOYSTICK2_REG_ADC_Y_8   0x11
-#define JOYSTICK2_REG_BUTTON    0x20
-
 #define SCROLL_ADDR          0x40
-#define SCROLL_ENCODER_REG   0x10  // Absolute encoder (16-bit)
-#define SCROLL_INC_ENCODER_REG 0x50  // Incremental encoder (16-bit, resets after read)
-#define SCROLL_BUTTON_REG    0x20
-
 #define CARDKEYBOARD_ADDR    0x5F
 
 #define DEBOUNCE_DELAY_MS    50
@@ -164,6 +164,27 @@ LGFX_ILI9488 lcd;  // External ILI9488 display
 #define POLL_INTERVAL_BTN    10   // Button polling interval (ms)
 #define POLL_INTERVAL_ENC    50   // Encoder polling interval (ms) - not too frequent!
 
+// Scheduler specs: deadline = lateness before a poll counts as missed,
+// early = how soon a poll may run with others on an already selected channel
+#define POLL_DEADLINE_KB     10
+#define POLL_DEADLINE_JOY    5
+#define POLL_DEADLINE_BTN    5
+#define POLL_DEADLINE_ENC    25
+#define POLL_EARLY_KB        5
+#define POLL_EARLY_JOY       3
+#define POLL_EARLY_BTN       3
+#define POLL_EARLY_ENC       10   // One button period: encoders ride along with button reads
+
+#define SCHED_REPORT_INTERVAL_MS 10000  // Rates/jitter report on Serial
+#define SCHED_TOGGLE_KEY     'b'  // CardKeyBoard: batched <-> unbatched polling (comparison)
+#define PAHUB_MAP_TOGGLE_KEY 'm'  // CardKeyBoard: multi-channel masks <-> one channel at a time
+#define LOG_SHIFT_KEY        'v'  // CardKeyBoard: log scroll auto -> redraw -> copyRect
+#define LOG_BINARY_KEY       'l'  // CardKeyBoard: Serial log text <-> binary (host/log_decode.cpp)
+
+#define LOG_DRAIN_INTERVAL_MS 5    // Drain task wakes this often
+#define LOG_DRAIN_CHUNK       512  // Bytes per Serial.write()
+#define LOG_DRAIN_CORE        0    // loop() and the polling run on core 1
+
 // ============================================
 // Global Variables
 // ============================================
@@ -174,7 +195,19 @@ bool scroll_a_available = false;
 bool scroll_b_available = false;
 bool keyboard_available = false;
 
-uint8_t pahub_current_channel = 0xFF;
+// I2C buses and devices (CardputerI2C); the hub keeps the address map
+// built by initDevices()
+WireBus i2c_bus(Wire1);
+PaHub pahub(i2c_bus, PAHUB_ADDR, PAHUB_SETTLE_US);
+PaHubChannel joystick_bus(pahub, PAHUB_CH_JOYSTICK2);
+PaHubChannel scroll_a_bus(pahub, PAHUB_CH_SCROLL_A);
+PaHubChannel scroll_b_bus(pahub, PAHUB_CH_SCROLL_B);
+PaHubChannel keyboard_bus(pahub, PAHUB_CH_KEYBOARD);
+
+Joystick2 joystick(joystick_bus, JOYSTICK2_ADDR);
+UnitScroll scroll_a_unit(scroll_a_bus, SCROLL_ADDR);
+UnitScroll scroll_b_unit(scroll_b_bus, SCROLL_ADDR);
+CardKeyBoard keyboard(keyboard_bus, CARDKEYBOARD_ADDR);
 
 // Button state with debounce
 struct ButtonState {
@@ -188,52 +221,48 @@ struct ButtonState {
 ButtonState scroll_a_state = {false, false, 0, false, false};
 ButtonState scroll_b_state = {false, false, 0, false, false};
 
-unsigned long last_kb_poll = 0;
-unsigned long last_joy_poll = 0;
-unsigned long last_btn_poll = 0;
-unsigned long last_enc_poll = 0;
+// Device polling
+PollScheduler scheduler;
+unsigned long last_sched_report = 0;
+
+// One Scroll unit (button + encoder on its own PA Hub channel)
+struct ScrollUnit {
+    char name;
+    uint8_t channel;
+    UnitScroll* dev;
+    ButtonState* state;
+    int16_t* encoder_value;
+};
 
 // Encoder values
 int16_t scroll_a_encoder_value = 0;
 int16_t scroll_b_encoder_value = 0;
 
-// Screen output buffer
-#define MAX_OUTPUT_LINES 50
-String outputLines[MAX_OUTPUT_LINES];
-int outputLineCount = 0;
-int scrollOffset = 0;
+// Screen output: LogView keeps the last LogView::MAX_LINES lines
 #define LINE_HEIGHT 24  // Increased for font size 2
 #define VISIBLE_LINES 13  // Decreased due to larger font
-
-// Display state for partial updates
-struct DisplayState {
-    bool initialized = false;
-    String lastLines[VISIBLE_LINES];
-    int lastScrollOffset = -1;
-};
-
-static DisplayState displayState;
+LogView logView;
 bool needRedraw = false;  // Flag for batching (deferred redraw)
 
+// Serial log: records wait in logRing until logDrainTask() writes them
+LogRing logRing;
+volatile bool log_binary = false;  // LOG_BINARY_KEY
+
 // ============================================
 // PA Hub Functions
 // ============================================
 
+// Scheduler select callback. Every mask the hub writes is collision-free,
+// so a channel that is already enabled needs no write.
 bool selectPaHubChannel(uint8_t channel) {
-    if (channel > 5) return false;
-    if (pahub_current_channel == channel) return true;
-    
-    Wire1.beginTransmission(PAHUB_ADDR);
-    Wire1.write(1 << channel);
-    byte error = Wire1.endTransmission();
-    
-    if (error == 0) {
-        pahub_current_channel = channel;
-        delayMicroseconds(500);  // Small delay for channel switching
-        return true;
-    }
-    
-    return false;
+    return pahub.select(channel);
+}
+
+// Scheduler group for a channel: channels in the hub's shared set are
+// always enabled and need no switch of their own
+uint8_t pahubGroupFor(uint8_t channel) {
+    uint8_t group = pahub.groupFor(channel);
+    return group == PaHub::ANY ? PollScheduler::NO_CHANNEL : group;
 }
 
 // ============================================
@@ -243,100 +272,18 @@ bool selectPaHubChannel(uint8_t channel) {
 bool readJoystick2(uint8_t* x, uint8_t* y, uint8_t* button) {
     if (!joystick2_available || !pahub_available) return false;
     
-    if (!selectPaHubChannel(PAHUB_CH_JOYSTICK2)) return false;
-    
-    // Read X
-    Wire1.beginTransmission(JOYSTICK2_ADDR);
-    Wire1.write(JOYSTICK2_REG_ADC_X_8);
-    if (Wire1.endTransmission(false) != 0) return false;
-    
-    Wire1.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire1.available() >= 1) {
-        *x = Wire1.read();
-    } else {
-        return false;
-    }
-    
-    // Read Y
-    Wire1.beginTransmission(JOYSTICK2_ADDR);
-    Wire1.write(JOYSTICK2_REG_ADC_Y_8);
-    if (Wire1.endTransmission(false) != 0) return false;
-    
-    Wire1.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire1.available() >= 1) {
-        *y = Wire1.read();
-    } else {
-        return false;
-    }
-    
-    // Read button
-    Wire1.beginTransmission(JOYSTICK2_ADDR);
-    Wire1.write(JOYSTICK2_REG_BUTTON);
-    if (Wire1.endTransmission(false) != 0) return false;
-    
-    Wire1.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire1.available() >= 1) {
-        uint8_t btn = Wire1.read();
-        *button = (btn == 0) ? 1 : 0;  // Invert
-    } else {
-        return false;
-    }
-    
+    Joystick2State js;
+    if (!joystick.read(&js)) return false;
+    *x = js.x;
+    *y = js.y;
+    *button = js.pressed ? 1 : 0;
     return true;
 }
 
-bool readScrollButton(uint8_t channel, bool* pressed) {
-    if (!pahub_available) return false;
-    
-    if (!selectPaHubChannel(channel)) return false;
-    
-    Wire1.beginTransmission(SCROLL_ADDR);
-    Wire1.write(SCROLL_BUTTON_REG);
-    if (Wire1.endTransmission(false) != 0) return false;
-    
-    delayMicroseconds(500);  // Delay for STM32F030
-    
-    Wire1.requestFrom(SCROLL_ADDR, 1, true);
-    delayMicroseconds(300);
-    
-    if (Wire1.available() >= 1) {
-        uint8_t btn = Wire1.read();
-        *pressed = (btn == 0);
-        return true;
-    }
-    
-    return false;
-}
-
-// Read incremental encoder value (register 0x50)
-bool readScrollEncoder(uint8_t channel, int16_t* increment) {
-    if (!pahub_available) return false;
-    
-    if (!selectPaHubChannel(channel)) return false;
-    
-    Wire1.beginTransmission(SCROLL_ADDR);
-    Wire1.write(SCROLL_INC_ENCODER_REG);
-    if (Wire1.endTransmission(false) != 0) return false;
-    
-    delayMicroseconds(500);  // Delay for STM32F030
-    
-    Wire1.requestFrom(SCROLL_ADDR, 2, true);  // 16-bit value
-    delayMicroseconds(300);
-    
-    if (Wire1.available() >= 2) {
-        uint8_t low = Wire1.read();
-        uint8_t high = Wire1.read();
-        *increment = (int16_t)(low | (high << 8));  // little-endian
-        return true;
-    }
-    
-    return false;
-}
-
-void updateButtonState(ButtonState* state, uint8_t channel) {
+bool updateButtonState(ButtonState* state, UnitScroll& unit) {
     bool current_raw = false;
-    if (!readScrollButton(channel, &current_raw)) {
-        return;
+    if (!pahub_available || !unit.readButton(&current_raw)) {
+        return false;
     }
     
     state->current_state = current_raw;
@@ -352,188 +299,149 @@ void updateButtonState(ButtonState* state, uint8_t channel) {
     if ((now - state->last_change_time) >= DEBOUNCE_DELAY_MS) {
         state->debounced_state = state->current_state;
     }
+    return true;
 }
 
-uint8_t readKeyboardKey() {
+bool readKeyboardKey(uint8_t* key) {
     if (!keyboard_available || !pahub_available) {
-        return 0;
-    }
-    
-    if (!selectPaHubChannel(PAHUB_CH_KEYBOARD)) {
-        return 0;
-    }
-    
-    Wire1.requestFrom(CARDKEYBOARD_ADDR, 1);
-    delayMicroseconds(500);  // Delay for Slave response
-    
-    if (Wire1.available() > 0) {
-        uint8_t key = Wire1.read();
-        return key;
+        return false;
     }
-    
-    return 0;
+    return keyboard.readKey(key);
 }
 
 // ============================================
 // Display Functions
 // ============================================
 
-// Forward declaration
-void redrawScreen();
+static bool startsWith(const char* text, const char* prefix) {
+    return strncmp(text, prefix, strlen(prefix)) == 0;
+}
 
-void addOutputLine(const String& text, uint16_t color = TFT_WHITE, bool logToSerial = true) {
-    if (outputLineCount < MAX_OUTPUT_LINES) {
-        outputLines[outputLineCount] = text;
-        outputLineCount++;
-    } else {
-        // Shift buffer up
-        for (int i = 0; i < MAX_OUTPUT_LINES - 1; i++) {
-            outputLines[i] = outputLines[i + 1];
-        }
-        outputLines[MAX_OUTPUT_LINES - 1] = text;
+// Log color, decided once when the line is added
+uint16_t logLineColor(const char* text) {
+    if (startsWith(text, "OK") || strstr(text, ": OK")) {
+        return TFT_GREEN;
+    } else if (startsWith(text, "ERR") || strstr(text, "NOT FOUND")) {
+        return TFT_RED;
+    } else if (startsWith(text, "KB:") || startsWith(text, "Keyboard")) {
+        return TFT_CYAN;
+    } else if (startsWith(text, "Joy:") || startsWith(text, "Joystick")) {
+        return TFT_YELLOW;
+    } else if (startsWith(text, "Scroll") && strstr(text, "button")) {
+        return TFT_MAGENTA;
+    } else if (startsWith(text, "Enc")) {
+        return TFT_BLUE;
     }
+    return TFT_WHITE;
+}
+
+void showLine(const char* text, int len) {
+    logView.add(text, len, logLineColor(text));
+    // Set flag for deferred redraw (batching)
+    needRedraw = true;
+}
+
+// color is kept for the callers; the screen colors come from the text
+// as they always have
+void addOutputLine(const String& text, uint16_t color = TFT_WHITE, bool logToSerial = true) {
+    (void)color;
+    showLine(text.c_str(), text.length());
     
-    // === 2. Serial Logging ===
+    // Serial: queued, written by logDrainTask()
     if (logToSerial) {
-        // Using c_str(), no String magic
-        Serial.print("[APP] ");
-        Serial.println(text.c_str());
-        // Flush is almost not needed on ESP32, but we'll keep it:
-        Serial.flush();
+        int len = min((int)text.length(), LOG_MAX_TEXT);
+        logRing.push(LOG_TEXT, millis(), nullptr, 0, text.c_str(), (uint8_t)len);
     }
-    
-    // Recalculate scrollOffset
-    int newScrollOffset = max(0, outputLineCount - VISIBLE_LINES);
-    if (newScrollOffset != scrollOffset) {
-        scrollOffset = newScrollOffset;
-        // Scroll change requires full redraw
-        displayState.lastScrollOffset = -1;
+}
+
+// Event line from a poll task: shown now, and only the format index and
+// arguments are queued for Serial
+template <typename... Args>
+void logEvent(LogFmt fmt, Args... args) {
+    int32_t a[] = {(int32_t)args...};
+    uint8_t n = sizeof...(args);
+    LogRecord rec = {0, (uint8_t)fmt, n, 0, 0};
+    char buf[64];
+    int len = LogRing::format(buf, sizeof(buf), rec, a, nullptr);
+    showLine(buf, len);
+    logRing.push(fmt, millis(), a, n);
+}
+
+// ============================================
+// Log Drain (low-priority task)
+// ============================================
+
+static uint8_t log_out[LOG_DRAIN_CHUNK];
+static size_t log_out_used = 0;
+
+static void logFlush() {
+    if (log_out_used) {
+        Serial.write(log_out, log_out_used);
+        log_out_used = 0;
     }
-    
-    // Set flag for deferred redraw (batching)
-    needRedraw = true;
 }
 
-void redrawScreen() {
-    lcd.startWrite();
-    
-    int startLine = scrollOffset;
-    int endLine = min(startLine + VISIBLE_LINES, outputLineCount);
-    
-    // First initialization or scroll change - full redraw
-    if (!displayState.initialized || scrollOffset != displayState.lastScrollOffset) {
-        // Clear entire text output area (always all VISIBLE_LINES)
-        lcd.fillRect(0, 0, 480, VISIBLE_LINES * LINE_HEIGHT, TFT_BLACK);
-        
-        lcd.setTextSize(2);  // Larger font for better readability
-        
-        // Redraw all visible lines (always VISIBLE_LINES)
-        for (int displayIndex = 0; displayIndex < VISIBLE_LINES; displayIndex++) {
-            int i = startLine + displayIndex;
-            int y = displayIndex * LINE_HEIGHT;  // Explicit coordinates for each line
-            
-            if (i < outputLineCount) {
-                // Data available for this line
-                uint16_t color = TFT_WHITE;
-                if (outputLines[i].startsWith("OK") || outputLines[i].indexOf(": OK") >= 0) {
-                    color = TFT_GREEN;
-                } else if (outputLines[i].startsWith("ERR") || outputLines[i].startsWith("ERROR") || outputLines[i].indexOf("NOT FOUND") >= 0) {
-                    color = TFT_RED;
-                } else if (outputLines[i].startsWith("KB:") || outputLines[i].startsWith("Keyboard")) {
-                    color = TFT_CYAN;
-                } else if (outputLines[i].startsWith("Joy:") || outputLines[i].startsWith("Joystick")) {
-                    color = TFT_YELLOW;
-                } else if (outputLines[i].startsWith("Scroll") && outputLines[i].indexOf("button") >= 0) {
-                    color = TFT_MAGENTA;
-                } else if (outputLines[i].startsWith("Enc") || outputLines[i].startsWith("Encoder")) {
-                    color = TFT_BLUE;
-                }
-                
-                lcd.setTextColor(color, TFT_BLACK);
-                lcd.setCursor(0, y);  // Explicitly set cursor position
-                lcd.println(outputLines[i]);
-                
-                // Save line state
-                displayState.lastLines[displayIndex] = outputLines[i];
-            } else {
-                // No data - fill with empty string (black on black = clear)
-                lcd.fillRect(0, y, 480, LINE_HEIGHT, TFT_BLACK);
-                displayState.lastLines[displayIndex] = "";
-            }
-        }
-        
-        displayState.initialized = true;
-        displayState.lastScrollOffset = scrollOffset;
+static void logEmit(const LogRecord& rec, const int32_t* args, const char* text) {
+    if (log_binary) {
+        // Same layout as in the ring, LOG_SYNC in place of the commit flag
+        size_t size = logRecordSize(rec.nargs, rec.textLen);
+        if (log_out_used + size > sizeof(log_out)) logFlush();
+        LogRecord h = rec;
+        h.state = LOG_SYNC;
+        // memcpy: after text lines the buffer position is not aligned
+        memcpy(&log_out[log_out_used], &h, sizeof(h));
+        memcpy(&log_out[log_out_used + sizeof(h)], args, size - sizeof(h));
+        log_out_used += size;
     } else {
-        // Partial update - only changed lines
-        lcd.setTextSize(2);
-        
-        for (int displayIndex = 0; displayIndex < VISIBLE_LINES; displayIndex++) {
-            int i = startLine + displayIndex;
-            
-            if (i < outputLineCount) {
-                // Data available for this line
-                String currentLine = outputLines[i];
-                
-                // Check if line changed
-                if (currentLine != displayState.lastLines[displayIndex]) {
-                    // Line changed - update only this one
-                    int y = displayIndex * LINE_HEIGHT;
-                    
-                    // Clear only this line
-                    lcd.fillRect(0, y, 480, LINE_HEIGHT, TFT_BLACK);
-                    
-                    // Determine color
-                    uint16_t color = TFT_WHITE;
-                    if (currentLine.startsWith("OK") || currentLine.indexOf(": OK") >= 0) {
-                        color = TFT_GREEN;
-                    } else if (currentLine.startsWith("ERR") || currentLine.startsWith("ERROR") || currentLine.indexOf("NOT FOUND") >= 0) {
-                        color = TFT_RED;
-                    } else if (currentLine.startsWith("KB:") || currentLine.startsWith("Keyboard")) {
-                        color = TFT_CYAN;
-                    } else if (currentLine.startsWith("Joy:") || currentLine.startsWith("Joystick")) {
-                        color = TFT_YELLOW;
-                    } else if (currentLine.startsWith("Scroll") && currentLine.indexOf("button") >= 0) {
-                        color = TFT_MAGENTA;
-                    } else if (currentLine.startsWith("Enc") || currentLine.startsWith("Encoder")) {
-                        color = TFT_BLUE;
-                    }
-                    
-                    // Draw new line
-                    lcd.setTextColor(color, TFT_BLACK);
-                    lcd.setCursor(0, y);
-                    lcd.println(currentLine);
-                    
-                    // Save new state
-                    displayState.lastLines[displayIndex] = currentLine;
-                }
-            } else {
-                // No data for this line - check if need to clear
-                if (displayState.lastLines[displayIndex] != "") {
-                    // Had line, now empty - clear
-                    int y = displayIndex * LINE_HEIGHT;
-                    lcd.fillRect(0, y, 480, LINE_HEIGHT, TFT_BLACK);
-                    displayState.lastLines[displayIndex] = "";
-                }
-            }
+        // Longest line: prefix + formatted record + newline
+        if (log_out_used + 8 + LOG_MAX_TEXT + 64 > sizeof(log_out)) logFlush();
+        char* out = (char*)&log_out[log_out_used];
+        memcpy(out, "[APP] ", 6);
+        int len = LogRing::format(out + 6, LOG_MAX_TEXT + 64, rec, args, text);
+        out[6 + len] = '\n';
+        log_out_used += 6 + len + 1;
+    }
+}
+
+// Formats and writes queued records in LOG_DRAIN_CHUNK writes; the
+// poll loop never waits for USB CDC
+void logDrainTask(void*) {
+    uint32_t reported_dropped = 0;
+    for (;;) {
+        logRing.drain(logEmit);
+        uint32_t dropped = logRing.dropped();
+        if (dropped != reported_dropped) {
+            int32_t lost = (int32_t)(dropped - reported_dropped);
+            LogRecord rec = {0, LOG_DROPPED, 1, 0, (uint32_t)millis()};
+            logEmit(rec, &lost, nullptr);
+            reported_dropped = dropped;
         }
+        logFlush();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
     }
-    
-    lcd.endWrite();
+}
+
+// Only slots whose line hash changed are drawn; a scroll by a few lines
+// moves the rest (see log_view.h)
+void redrawScreen() {
+    logView.draw();
+}
+
+void printLogViewReport() {
+    static const char* const names[] = {"redraw", "copyRect", "auto"};
+    const LogView::Stats& st = logView.stats();
+    Serial.printf("[VIEW] draws=%u rows drawn=%u skipped=%u full=%u\n",
+                  (unsigned)st.draws, (unsigned)st.rowsDrawn, (unsigned)st.rowsSkipped,
+                  (unsigned)st.fullRedraws);
+    Serial.printf("[VIEW] shift mode=%s (using %s) redraw=%uus x%u copyRect=%uus x%u\n",
+                  names[logView.shiftMode()], names[logView.activeShiftMode()],
+                  (unsigned)logView.avgShiftUs(LogView::SHIFT_REDRAW), (unsigned)st.shifts[0],
+                  (unsigned)logView.avgShiftUs(LogView::SHIFT_COPY), (unsigned)st.shifts[1]);
 }
 
 void clearScreen() {
-    outputLineCount = 0;
-    scrollOffset = 0;
-    displayState.initialized = false;
-    displayState.lastScrollOffset = -1;
+    logView.clear();
     needRedraw = false;  // Reset flag
-    for (int i = 0; i < MAX_OUTPUT_LINES; i++) {
-        outputLines[i] = "";
-    }
-    for (int i = 0; i < VISIBLE_LINES; i++) {
-        displayState.lastLines[i] = "";
-    }
     addOutputLine("PA Hub Test v1.0", TFT_CYAN);
     addOutputLine("Cardputer-Adv", TFT_YELLOW);
     addOutputLine("External Display: ILI9488", TFT_YELLOW);
@@ -551,30 +459,23 @@ void initDevices() {
     // Wire1 already initialized in setup() after M5Cardputer.begin()
     
     // Detect PA Hub
-    Wire1.beginTransmission(PAHUB_ADDR);
-    byte error = Wire1.endTransmission();
-    
-    if (error == 0) {
+    if (pahub.probe()) {
         pahub_available = true;
         char buf[64];
         snprintf(buf, sizeof(buf), "OK PA Hub detected at 0x%02X", PAHUB_ADDR);
         addOutputLine(String(buf), TFT_GREEN);
         addOutputLine("OK PA Hub: OK", TFT_GREEN);
         
-        // Deselect all channels
-        Wire1.beginTransmission(PAHUB_ADDR);
-        Wire1.write(0x00);
-        Wire1.endTransmission();
-        pahub_current_channel = 0xFF;
+        // Deselect all channels and forget the address map
+        pahub.reset();
         delay(10);
         
         // Detect Joystick2 on Channel 0
         addOutputLine("Checking Joystick2...", TFT_CYAN);
         if (selectPaHubChannel(PAHUB_CH_JOYSTICK2)) {
-            Wire1.beginTransmission(JOYSTICK2_ADDR);
-            error = Wire1.endTransmission();
-            if (error == 0) {
+            if (joystick.begin()) {
                 joystick2_available = true;
+                pahub.setChannelAddress(PAHUB_CH_JOYSTICK2, JOYSTICK2_ADDR);
                 snprintf(buf, sizeof(buf), "OK Joystick2 found at 0x%02X (Channel 0)", JOYSTICK2_ADDR);
                 addOutputLine(String(buf), TFT_GREEN);
                 addOutputLine("OK Joystick2: OK", TFT_GREEN);
@@ -587,10 +488,9 @@ void initDevices() {
         // Detect Scroll A on Channel 1
         addOutputLine("Checking Scroll A...", TFT_CYAN);
         if (selectPaHubChannel(PAHUB_CH_SCROLL_A)) {
-            Wire1.beginTransmission(SCROLL_ADDR);
-            error = Wire1.endTransmission();
-            if (error == 0) {
+            if (scroll_a_unit.begin()) {
                 scroll_a_available = true;
+                pahub.setChannelAddress(PAHUB_CH_SCROLL_A, SCROLL_ADDR);
                 snprintf(buf, sizeof(buf), "OK Scroll A found at 0x%02X (Channel 1)", SCROLL_ADDR);
                 addOutputLine(String(buf), TFT_GREEN);
                 addOutputLine("OK Scroll A: OK", TFT_GREEN);
@@ -603,10 +503,9 @@ void initDevices() {
         // Detect Scroll B on Channel 2
         addOutputLine("Checking Scroll B...", TFT_CYAN);
         if (selectPaHubChannel(PAHUB_CH_SCROLL_B)) {
-            Wire1.beginTransmission(SCROLL_ADDR);
-            error = Wire1.endTransmission();
-            if (error == 0) {
+            if (scroll_b_unit.begin()) {
                 scroll_b_available = true;
+                pahub.setChannelAddress(PAHUB_CH_SCROLL_B, SCROLL_ADDR);
                 snprintf(buf, sizeof(buf), "OK Scroll B found at 0x%02X (Channel 2)", SCROLL_ADDR);
                 addOutputLine(String(buf), TFT_GREEN);
                 addOutputLine("OK Scroll B: OK", TFT_GREEN);
@@ -620,12 +519,10 @@ void initDevices() {
         addOutputLine("Checking Keyboard...", TFT_CYAN);
         if (selectPaHubChannel(PAHUB_CH_KEYBOARD)) {
             delay(50);
-            Wire1.requestFrom(CARDKEYBOARD_ADDR, 1);
-            delay(10);
             
-            if (Wire1.available() > 0) {
-                uint8_t testKey = Wire1.read();
+            if (keyboard.begin()) {
                 keyboard_available = true;
+                pahub.setChannelAddress(PAHUB_CH_KEYBOARD, CARDKEYBOARD_ADDR);
                 snprintf(buf, sizeof(buf), "OK CardKeyBoard found at 0x%02X (Channel 3)", CARDKEYBOARD_ADDR);
                 addOutputLine(String(buf), TFT_GREEN);
                 addOutputLine("OK Keyboard: OK", TFT_GREEN);
@@ -641,6 +538,12 @@ void initDevices() {
                  keyboard_available, joystick2_available, scroll_a_available, scroll_b_available);
         addOutputLine(String(buf), TFT_WHITE);
         // Removed duplicate Serial.printf - now only through addOutputLine
+        
+        pahub.buildMap();
+        snprintf(buf, sizeof(buf), "Hub map: shared 0x%02X, A 0x%02X, B 0x%02X",
+                 pahub.sharedMask(), pahub.maskFor(PAHUB_CH_SCROLL_A),
+                 pahub.maskFor(PAHUB_CH_SCROLL_B));
+        addOutputLine(String(buf), TFT_WHITE);
         addOutputLine("");
         addOutputLine("Polling devices...", TFT_CYAN);
         addOutputLine("Press keys/buttons to test", TFT_YELLOW);
@@ -654,6 +557,124 @@ void initDevices() {
     }
 }
 
+// ============================================
+// Poll Tasks (run by the scheduler)
+// ============================================
+
+ScrollUnit scroll_a = {'A', PAHUB_CH_SCROLL_A, &scroll_a_unit, &scroll_a_state, &scroll_a_encoder_value};
+ScrollUnit scroll_b = {'B', PAHUB_CH_SCROLL_B, &scroll_b_unit, &scroll_b_state, &scroll_b_encoder_value};
+
+bool pahub_map_toggle = false;  // PAHUB_MAP_TOGGLE_KEY pressed
+
+bool pollKeyboard(void*) {
+    uint8_t key = 0;
+    if (!readKeyboardKey(&key)) return false;
+
+    if (key != 0 && key != 0xFF) {
+        logEvent(LOG_KEY, key);
+
+        if (key == SCHED_TOGGLE_KEY) {
+            scheduler.setBatching(!scheduler.batching());
+            scheduler.resetStats();
+            last_sched_report = millis();
+            addOutputLine(scheduler.batching() ? "Polling: batched by channel"
+                                               : "Polling: unbatched (timers)", TFT_GREEN);
+        } else if (key == PAHUB_MAP_TOGGLE_KEY) {
+            pahub_map_toggle = true;  // Handled in loop(), not while tasks run
+        } else if (key == LOG_BINARY_KEY) {
+            log_binary = !log_binary;
+            addOutputLine(log_binary ? "Serial log: binary (host/log_decode)"
+                                     : "Serial log: text", TFT_GREEN);
+        } else if (key == LOG_SHIFT_KEY) {
+            static const LogView::ShiftMode next[] = {LogView::SHIFT_COPY, LogView::SHIFT_AUTO,
+                                                      LogView::SHIFT_REDRAW};
+            logView.setShiftMode(next[logView.shiftMode()]);
+            addOutputLine(logView.shiftMode() == LogView::SHIFT_AUTO ? "Log scroll: auto"
+                          : logView.shiftMode() == LogView::SHIFT_COPY ? "Log scroll: copyRect"
+                                                                       : "Log scroll: redraw", TFT_GREEN);
+        }
+    }
+    return true;
+}
+
+bool pollJoystick(void*) {
+    uint8_t joy_x = 0, joy_y = 0, joy_button = 0;
+    if (!readJoystick2(&joy_x, &joy_y, &joy_button)) return false;
+
+    // Output only if changed (not centered or button pressed)
+    const uint8_t threshold = 40;
+    const uint8_t center = 127;
+
+    bool changed = (joy_y > (center + threshold)) || (joy_y < (center - threshold)) ||
+                  (joy_x > (center + threshold)) || (joy_x < (center - threshold)) ||
+                  joy_button;
+
+    if (changed) {
+        logEvent(LOG_JOY, joy_x, joy_y, joy_button);
+    }
+    return true;
+}
+
+bool pollScrollButton(void* ctx) {
+    ScrollUnit* unit = (ScrollUnit*)ctx;
+    ButtonState* state = unit->state;
+    if (!updateButtonState(state, *unit->dev)) return false;
+
+    // Edge detection: transition from false to true (press)
+    if (state->debounced_state && !state->last_debounced_state) {
+        logEvent(LOG_SCROLL_PRESSED, unit->name);
+    }
+    // Edge detection: transition from true to false (release)
+    else if (!state->debounced_state && state->last_debounced_state) {
+        logEvent(LOG_SCROLL_RELEASED, unit->name);
+    }
+    return true;
+}
+
+bool pollScrollEncoder(void* ctx) {
+    ScrollUnit* unit = (ScrollUnit*)ctx;
+    int16_t increment = 0;
+    if (!pahub_available || !unit->dev->readIncrement(&increment)) return false;
+
+    if (increment != 0) {
+        *unit->encoder_value += increment;
+        logEvent(LOG_ENC, unit->name, increment, *unit->encoder_value);
+    }
+    return true;
+}
+
+// Register a task for every device found by initDevices(); tasks are
+// grouped by the hub selection they need (see pahubGroupFor())
+void initPollScheduler() {
+    scheduler.begin(selectPaHubChannel);
+    if (!pahub_available) return;
+
+    if (keyboard_available) {
+        scheduler.add({"kb", pahubGroupFor(PAHUB_CH_KEYBOARD), POLL_INTERVAL_KB, POLL_DEADLINE_KB, POLL_EARLY_KB,
+                       pollKeyboard, nullptr});
+    }
+    if (joystick2_available) {
+        scheduler.add({"joy", pahubGroupFor(PAHUB_CH_JOYSTICK2), POLL_INTERVAL_JOY, POLL_DEADLINE_JOY, POLL_EARLY_JOY,
+                       pollJoystick, nullptr});
+    }
+    if (scroll_a_available) {
+        scheduler.add({"btn A", pahubGroupFor(PAHUB_CH_SCROLL_A), POLL_INTERVAL_BTN, POLL_DEADLINE_BTN, POLL_EARLY_BTN,
+                       pollScrollButton, &scroll_a});
+        scheduler.add({"enc A", pahubGroupFor(PAHUB_CH_SCROLL_A), POLL_INTERVAL_ENC, POLL_DEADLINE_ENC, POLL_EARLY_ENC,
+                       pollScrollEncoder, &scroll_a});
+    }
+    if (scroll_b_available) {
+        scheduler.add({"btn B", pahubGroupFor(PAHUB_CH_SCROLL_B), POLL_INTERVAL_BTN, POLL_DEADLINE_BTN, POLL_EARLY_BTN,
+                       pollScrollButton, &scroll_b});
+        scheduler.add({"enc B", pahubGroupFor(PAHUB_CH_SCROLL_B), POLL_INTERVAL_ENC, POLL_DEADLINE_ENC, POLL_EARLY_ENC,
+                       pollScrollEncoder, &scroll_b});
+    }
+    // initDevices() left some channel selected
+    scheduler.invalidateChannel();
+    scheduler.resetStats();
+    last_sched_report = millis();
+}
+
 // ============================================
 // Setup
 // ============================================
@@ -665,6 +686,9 @@ void setup() {
     Serial.println("\n=== Serial test from setup() ===");
     Serial.flush();
     
+    xTaskCreatePinnedToCore(logDrainTask, "log_drain", 4096, nullptr, tskIDLE_PRIORITY + 1,
+                            nullptr, LOG_DRAIN_CORE);
+    
     addOutputLine("========================================", TFT_CYAN);
     addOutputLine("PA Hub Test - Cardputer-Adv", TFT_CYAN);
     addOutputLine("External Display: ILI9488", TFT_CYAN);
@@ -680,6 +704,28 @@ void setup() {
         lcd.fillScreen(TFT_BLACK);
         lcd.setTextSize(1);
         lcd.setTextColor(TFT_WHITE, TFT_BLACK);
+        
+        // One full text line (480 x LINE_HEIGHT) per block transfer. Without
+        // PSRAM the internal budget holds two faces: plain text and the
+        // joystick lines, which stream while a stick is moved
+        if (!atlas.begin(&lcd, 480 * LINE_HEIGHT, 1024 * 1024, GlyphAtlas::faceBytes(2) * 2)) {
+            addOutputLine("ERR Glyph atlas allocation FAILED!", TFT_RED);
+            return;
+        }
+        logView.begin(&lcd, &atlas, 0, 0, 480, LINE_HEIGHT, VISIBLE_LINES, 2, TFT_BLACK);
+        // Log colors from logLineColor(), most used first
+        const uint16_t logColors[] = {TFT_WHITE, TFT_YELLOW, TFT_GREEN, TFT_CYAN,
+                                      TFT_BLUE, TFT_MAGENTA, TFT_RED};
+        const char* const logColorNames[] = {"white", "yellow", "green", "cyan", "blue", "magenta", "red"};
+        String cached;
+        for (size_t i = 0; i < sizeof(logColors) / sizeof(logColors[0]); i++) {
+            if (atlas.preload(2, logColors[i], TFT_BLACK)) {
+                cached += cached.length() ? ", " : "";
+                cached += logColorNames[i];
+            }
+        }
+        addOutputLine("OK Glyph atlas tiles: " + (cached.length() ? cached : String("none")) + " (" +
+                      String((unsigned)atlas.tileBytesUsed()) + " bytes)");
     } else {
         addOutputLine("ERR ILI9488 initialization FAILED!", TFT_RED);
         return;
@@ -706,6 +752,7 @@ void setup() {
     
     // Initialize devices
     initDevices();
+    initPollScheduler();
     
     // Immediate screen redraw after initialization
     if (needRedraw) {
@@ -722,94 +769,26 @@ void setup() {
 // ============================================
 
 void loop() {
-    unsigned long now = millis();
-    
-    // Keyboard polling (every 20ms)
-    if (keyboard_available && (now - last_kb_poll) >= POLL_INTERVAL_KB) {
-        uint8_t key = readKeyboardKey();
-        if (key != 0 && key != 0xFF) {
-            char buf[64];
-            snprintf(buf, sizeof(buf), "KB: 0x%02X", key);
-                addOutputLine(String(buf), TFT_CYAN);  // Only addOutputLine
-        }
-        last_kb_poll = now;
+    // Device polling: due reads grouped by PA Hub channel
+    scheduler.service();
+    
+    if (pahub_map_toggle) {
+        // Task groups depend on the map: register them again
+        pahub_map_toggle = false;
+        pahub.setMultiChannel(!pahub.multiChannel());
+        bool batching = scheduler.batching();
+        initPollScheduler();
+        scheduler.setBatching(batching);
+        addOutputLine(pahub.multiChannel() ? "PA Hub: multi-channel masks"
+                                          : "PA Hub: one channel at a time", TFT_GREEN);
     }
     
-    // Joystick polling (every 10ms)
-    if (joystick2_available && (now - last_joy_poll) >= POLL_INTERVAL_JOY) {
-        uint8_t joy_x = 0, joy_y = 0, joy_button = 0;
-        if (readJoystick2(&joy_x, &joy_y, &joy_button)) {
-            // Output only if changed (not centered or button pressed)
-            const uint8_t threshold = 40;
-            const uint8_t center = 127;
-            
-            bool changed = (joy_y > (center + threshold)) || (joy_y < (center - threshold)) ||
-                          (joy_x > (center + threshold)) || (joy_x < (center - threshold)) ||
-                          joy_button;
-            
-            if (changed) {
-                char buf[128];
-                snprintf(buf, sizeof(buf), "Joy: X=%3d Y=%3d Btn=%d", joy_x, joy_y, joy_button);
-                addOutputLine(String(buf), TFT_YELLOW);  // Only addOutputLine
-            }
-        }
-        last_joy_poll = now;
-    }
-    
-    // Scroll buttons polling (every 10ms)
-    if ((now - last_btn_poll) >= POLL_INTERVAL_BTN) {
-        if (scroll_a_available) {
-            updateButtonState(&scroll_a_state, PAHUB_CH_SCROLL_A);
-            // Edge detection: transition from false to true (press)
-            if (scroll_a_state.debounced_state && !scroll_a_state.last_debounced_state) {
-                addOutputLine("Scroll A button: PRESSED", TFT_MAGENTA);  // Only addOutputLine
-            }
-            // Edge detection: transition from true to false (release)
-            else if (!scroll_a_state.debounced_state && scroll_a_state.last_debounced_state) {
-                addOutputLine("Scroll A button: RELEASED", TFT_MAGENTA);  // Only addOutputLine
-            }
-        }
-        
-        if (scroll_b_available) {
-            updateButtonState(&scroll_b_state, PAHUB_CH_SCROLL_B);
-            // Edge detection: transition from false to true (press)
-            if (scroll_b_state.debounced_state && !scroll_b_state.last_debounced_state) {
-                addOutputLine("Scroll B button: PRESSED", TFT_MAGENTA);  // Only addOutputLine
-            }
-            // Edge detection: transition from true to false (release)
-            else if (!scroll_b_state.debounced_state && scroll_b_state.last_debounced_state) {
-                addOutputLine("Scroll B button: RELEASED", TFT_MAGENTA);  // Only addOutputLine
-            }
-        }
-        last_btn_poll = now;
-    }
-    
-    // Scroll encoder polling (every 50ms)
-    if ((now - last_enc_poll) >= POLL_INTERVAL_ENC) {
-        if (scroll_a_available) {
-            int16_t increment = 0;
-            if (readScrollEncoder(PAHUB_CH_SCROLL_A, &increment)) {
-                if (increment != 0) {
-                    scroll_a_encoder_value += increment;
-                    char buf[128];
-                    snprintf(buf, sizeof(buf), "Enc A: %+d (Total: %d)", increment, scroll_a_encoder_value);
-                    addOutputLine(String(buf), TFT_BLUE);  // Only addOutputLine
-                }
-            }
-        }
-        
-        if (scroll_b_available) {
-            int16_t increment = 0;
-            if (readScrollEncoder(PAHUB_CH_SCROLL_B, &increment)) {
-                if (increment != 0) {
-                    scroll_b_encoder_value += increment;
-                    char buf[128];
-                    snprintf(buf, sizeof(buf), "Enc B: %+d (Total: %d)", increment, scroll_b_encoder_value);
-                    addOutputLine(String(buf), TFT_BLUE);  // Only addOutputLine
-                }
-            }
-        }
-        last_enc_poll = now;
+    if (millis() - last_sched_report >= SCHED_REPORT_INTERVAL_MS) {
+        scheduler.printReport();
+        scheduler.resetStats();
+        printLogViewReport();
+        logView.resetStats();
+        last_sched_report = millis();
     }
     
     // Batching: screen redraw once per cycle (if needed)
@@ -820,4 +799,3 @@ void loop() {
     
     delay(1);
 }
-
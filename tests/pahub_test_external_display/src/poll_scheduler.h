@@ -0,0 +1,252 @@
+/*
+ * Deadline-based poll scheduler for devices behind a PA Hub (PCA9548A)
+ *
+ * Each device read is a task with a period, a deadline (how late it may
+ * run before it counts as missed), an early window (how soon before its
+ * due time it may run) and the hub channel it lives on.
+ *
+ * service() collects the due tasks and works through them channel by
+ * channel:
+ * - stay on the current channel while it has due work (no switch),
+ * - otherwise switch to the channel of the most urgent task
+ *   (earliest due + deadline),
+ * - on that channel run everything due, plus tasks whose early window
+ *   has opened, so they don't need a switch of their own a few ms later.
+ *
+ * Without batching (setBatching(false)) tasks run in registration order
+ * as soon as they are due, like independent timers - kept to compare
+ * bus time and channel switches against.
+ *
+ * The channel is only a grouping key: tasks with the same key share one
+ * hub selection, NO_CHANNEL tasks are reachable under any selection.
+ *
+ * Per task it records achieved rate, interval jitter, worst lateness,
+ * missed deadlines and bus time; for the hub, switches and the time
+ * spent switching.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+typedef bool (*PollFn)(void* ctx);                // false = bus error
+typedef bool (*ChannelSelectFn)(uint8_t channel);
+
+struct PollTaskSpec {
+    const char* name;
+    uint8_t channel;      // PollScheduler::NO_CHANNEL = no hub channel needed
+    uint16_t periodMs;
+    uint16_t deadlineMs;  // Lateness before a run counts as missed
+    uint16_t earlyMs;     // May run this much before its due time when batching
+    PollFn fn;
+    void* ctx;
+};
+
+class PollScheduler {
+public:
+    static constexpr int MAX_TASKS = 12;
+    static constexpr uint8_t NO_CHANNEL = 0xFF;
+
+    struct TaskStats {
+        uint32_t runs;
+        uint32_t errors;
+        uint32_t missed;
+        uint32_t busUs;
+        uint32_t jitterSumUs;   // Sum of |interval - period|
+        uint32_t maxJitterUs;
+        uint32_t maxLateUs;
+    };
+
+    PollScheduler() : _select(nullptr), _count(0), _current(NO_CHANNEL), _batching(true),
+                      _switches(0), _switchUs(0), _windowStart(0) {}
+
+    // Also drops all tasks, so begin() + add() can re-register them
+    void begin(ChannelSelectFn select) {
+        _select = select;
+        _count = 0;
+        _current = NO_CHANNEL;
+        resetStats();
+    }
+
+    // Returns task id, -1 if the table is full
+    int add(const PollTaskSpec& spec) {
+        if (_count >= MAX_TASKS) return -1;
+        Task& t = _tasks[_count];
+        t.spec = spec;
+        t.enabled = true;
+        t.next = micros();
+        t.lastRun = 0;
+        memset(&t.stats, 0, sizeof(t.stats));
+        return _count++;
+    }
+
+    void setEnabled(int id, bool on) {
+        if (id >= 0 && id < _count) _tasks[id].enabled = on;
+    }
+
+    void setBatching(bool on) { _batching = on; }
+    bool batching() const { return _batching; }
+
+    // Something else selected a channel (or the hub was reset)
+    void invalidateChannel() { _current = NO_CHANNEL; }
+
+    // Run due work; call from loop()
+    void service() {
+        uint32_t now = micros();
+
+        if (!_batching) {
+            for (int i = 0; i < _count; i++) {
+                if (_tasks[i].enabled && isDue(_tasks[i], now, 0)) {
+                    if (selectChannel(_tasks[i].spec.channel)) runTask(_tasks[i]);
+                }
+            }
+            return;
+        }
+
+        uint32_t pending = 0;
+        for (int i = 0; i < _count; i++) {
+            if (_tasks[i].enabled && isDue(_tasks[i], now, 0)) pending |= 1u << i;
+        }
+
+        while (pending) {
+            uint8_t ch = pickChannel(pending);
+            if (!selectChannel(ch)) {
+                // Channel unreachable: drop its work until the next round
+                for (int i = 0; i < _count; i++) {
+                    if (_tasks[i].spec.channel == ch) pending &= ~(1u << i);
+                }
+                continue;
+            }
+            now = micros();
+            for (int i = 0; i < _count; i++) {
+                Task& t = _tasks[i];
+                if (!t.enabled || t.spec.channel != ch) continue;
+                if ((pending & (1u << i)) || isDue(t, now, t.spec.earlyMs)) {
+                    runTask(t);
+                    pending &= ~(1u << i);
+                }
+            }
+        }
+    }
+
+    int taskCount() const { return _count; }
+    const char* taskName(int id) const { return _tasks[id].spec.name; }
+    const TaskStats& taskStats(int id) const { return _tasks[id].stats; }
+
+    // Serial report for the window since the last resetStats()
+    void printReport() const {
+        uint32_t windowUs = micros() - _windowStart;
+        float secs = windowUs / 1e6f;
+        if (secs <= 0) return;
+
+        uint32_t busUs = _switchUs;
+        Serial.printf("[SCHED] %s, %.1f s window\n", _batching ? "batched" : "unbatched", secs);
+        for (int i = 0; i < _count; i++) {
+            const Task& t = _tasks[i];
+            const TaskStats& s = t.stats;
+            busUs += s.busUs;
+            if (!t.enabled) continue;
+            uint32_t intervals = s.runs > 1 ? s.runs - 1 : 1;
+            char ch[8];
+            if (t.spec.channel == NO_CHANNEL) snprintf(ch, sizeof(ch), "any");
+            else snprintf(ch, sizeof(ch), "ch%u", t.spec.channel);
+            Serial.printf("  %-6s %-4s %3u ms: %5.1f Hz (target %5.1f), jitter %.2f ms avg / %.2f max, "
+                          "late %.2f ms max, %u missed, %u err, %u us/run\n",
+                          t.spec.name, ch,
+                          (unsigned)t.spec.periodMs, s.runs / secs, 1000.0f / t.spec.periodMs,
+                          s.jitterSumUs / 1000.0f / intervals, s.maxJitterUs / 1000.0f,
+                          s.maxLateUs / 1000.0f, (unsigned)s.missed, (unsigned)s.errors,
+                          (unsigned)(s.runs ? s.busUs / s.runs : 0));
+        }
+        Serial.printf("  hub: %.1f switches/s (%.1f ms/s), total bus time %.1f ms/s\n",
+                      _switches / secs, _switchUs / 1000.0f / secs, busUs / 1000.0f / secs);
+    }
+
+    void resetStats() {
+        for (int i = 0; i < _count; i++) {
+            memset(&_tasks[i].stats, 0, sizeof(TaskStats));
+            _tasks[i].lastRun = 0;
+        }
+        _switches = 0;
+        _switchUs = 0;
+        _windowStart = micros();
+    }
+
+private:
+    struct Task {
+        PollTaskSpec spec;
+        bool enabled;
+        uint32_t next;     // Due time (micros)
+        uint32_t lastRun;  // 0 = not run in this window
+        TaskStats stats;
+    };
+
+    static bool isDue(const Task& t, uint32_t now, uint16_t earlyMs) {
+        return (int32_t)(now + (uint32_t)earlyMs * 1000 - t.next) >= 0;
+    }
+
+    // Current channel if it has due work, else the most urgent task's channel
+    uint8_t pickChannel(uint32_t pending) const {
+        int best = -1;
+        uint32_t now = micros();
+        int32_t bestSlack = 0;
+        for (int i = 0; i < _count; i++) {
+            if (!(pending & (1u << i))) continue;
+            if (_tasks[i].spec.channel == _current) return _current;
+            // Time left until the deadline passes
+            int32_t slack = (int32_t)(_tasks[i].next + _tasks[i].spec.deadlineMs * 1000u - now);
+            if (best < 0 || slack < bestSlack) {
+                best = i;
+                bestSlack = slack;
+            }
+        }
+        return _tasks[best].spec.channel;
+    }
+
+    bool selectChannel(uint8_t ch) {
+        if (ch == NO_CHANNEL || ch == _current) return true;
+        uint32_t t0 = micros();
+        bool ok = _select && _select(ch);
+        _switchUs += micros() - t0;
+        _switches++;
+        _current = ok ? ch : NO_CHANNEL;
+        return ok;
+    }
+
+    void runTask(Task& t) {
+        uint32_t t0 = micros();
+        bool ok = t.spec.fn(t.spec.ctx);
+        uint32_t t1 = micros();
+
+        TaskStats& s = t.stats;
+        uint32_t periodUs = (uint32_t)t.spec.periodMs * 1000;
+        int32_t late = (int32_t)(t0 - t.next);
+        if (late > 0) {
+            if ((uint32_t)late > s.maxLateUs) s.maxLateUs = late;
+            if ((uint32_t)late > (uint32_t)t.spec.deadlineMs * 1000) s.missed++;
+        }
+        if (t.lastRun != 0) {
+            int32_t dev = (int32_t)(t0 - t.lastRun) - (int32_t)periodUs;
+            uint32_t jitter = dev < 0 ? -dev : dev;
+            s.jitterSumUs += jitter;
+            if (jitter > s.maxJitterUs) s.maxJitterUs = jitter;
+        }
+        s.runs++;
+        s.busUs += t1 - t0;
+        if (!ok) s.errors++;
+        t.lastRun = t0;
+
+        // Keep the phase; if a whole period was lost, restart from now
+        t.next += periodUs;
+        if ((int32_t)(t0 - t.next) >= 0) t.next = t0 + periodUs;
+    }
+
+    ChannelSelectFn _select;
+    Task _tasks[MAX_TASKS];
+    int _count;
+    uint8_t _current;
+    bool _batching;
+    uint32_t _switches;
+    uint32_t _switchUs;
+    uint32_t _windowStart;
+};
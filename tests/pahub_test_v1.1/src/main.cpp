@@ -25,6 +25,7 @@
 
 #include <M5Cardputer.h>
 #include <Wire.h>
+#include <CardputerI2C.h>
 
 // ============================================
 // PA Hub and Device Constants
@@ -36,16 +37,9 @@
 #define PAHUB_CH_SCROLL_B    2
 #define PAHUB_CH_KEYBOARD    3
 
+// Registers and timing quirks live in the CardputerI2C drivers
 #define JOYSTICK2_ADDR       0x63
-#define JOYSTICK2_REG_ADC_X_8   0x10
-#define JOYSTICK2_REG_ADC_Y_8   0x11
-#define JOYSTICK2_REG_BUTTON    0x20
-
 #define SCROLL_ADDR          0x40
-#define SCROLL_ENCODER_REG   0x10  // Absolute encoder (16-bit)
-#define SCROLL_INC_ENCODER_REG 0x50  // Incremental encoder (16-bit, resets after read)
-#define SCROLL_BUTTON_REG    0x20
-
 #define CARDKEYBOARD_ADDR    0x5F
 
 #define DEBOUNCE_DELAY_MS    50
@@ -64,7 +58,18 @@ bool scroll_a_available = false;
 bool scroll_b_available = false;
 bool keyboard_available = false;
 
-uint8_t pahub_current_channel = 0xFF;
+// I2C buses and devices (CardputerI2C)
+WireBus i2c_bus(Wire);
+PaHub pahub(i2c_bus, PAHUB_ADDR);
+PaHubChannel joystick_bus(pahub, PAHUB_CH_JOYSTICK2);
+PaHubChannel scroll_a_bus(pahub, PAHUB_CH_SCROLL_A);
+PaHubChannel scroll_b_bus(pahub, PAHUB_CH_SCROLL_B);
+PaHubChannel keyboard_bus(pahub, PAHUB_CH_KEYBOARD);
+
+Joystick2 joystick(joystick_bus, JOYSTICK2_ADDR);
+UnitScroll scroll_a_unit(scroll_a_bus, SCROLL_ADDR);
+UnitScroll scroll_b_unit(scroll_b_bus, SCROLL_ADDR);
+CardKeyBoard keyboard(keyboard_bus, CARDKEYBOARD_ADDR);
 
 // Button state with debounce
 struct ButtonState {
@@ -96,20 +101,7 @@ unsigned long lastEventTime = 0;
 // ============================================
 
 bool selectPaHubChannel(uint8_t channel) {
-    if (channel > 5) return false;
-    if (pahub_current_channel == channel) return true;
-    
-    Wire.beginTransmission(PAHUB_ADDR);
-    Wire.write(1 << channel);
-    byte error = Wire.endTransmission();
-    
-    if (error == 0) {
-        pahub_current_channel = channel;
-        delayMicroseconds(500);  // Small delay for channel switching
-        return true;
-    }
-    
-    return false;
+    return pahub.select(channel);
 }
 
 // ============================================
@@ -119,94 +111,27 @@ bool selectPaHubChannel(uint8_t channel) {
 bool readJoystick2(uint8_t* x, uint8_t* y, uint8_t* button) {
     if (!joystick2_available || !pahub_available) return false;
     
-    if (!selectPaHubChannel(PAHUB_CH_JOYSTICK2)) return false;
-    
-    // Read X
-    Wire.beginTransmission(JOYSTICK2_ADDR);
-    Wire.write(JOYSTICK2_REG_ADC_X_8);
-    if (Wire.endTransmission(false) != 0) return false;
-    
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-        *x = Wire.read();
-    } else {
-        return false;
-    }
-    
-    // Read Y
-    Wire.beginTransmission(JOYSTICK2_ADDR);
-    Wire.write(JOYSTICK2_REG_ADC_Y_8);
-    if (Wire.endTransmission(false) != 0) return false;
-    
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-        *y = Wire.read();
-    } else {
-        return false;
-    }
-    
-    // Read button
-    Wire.beginTransmission(JOYSTICK2_ADDR);
-    Wire.write(JOYSTICK2_REG_BUTTON);
-    if (Wire.endTransmission(false) != 0) return false;
-    
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-        uint8_t btn = Wire.read();
-        *button = (btn == 0) ? 1 : 0;  // Invert
-    } else {
-        return false;
-    }
-    
+    Joystick2State js;
+    if (!joystick.read(&js)) return false;
+    *x = js.x;
+    *y = js.y;
+    *button = js.pressed ? 1 : 0;
     return true;
 }
 
+UnitScroll& scrollUnitFor(uint8_t channel) {
+    return channel == PAHUB_CH_SCROLL_A ? scroll_a_unit : scroll_b_unit;
+}
+
 bool readScrollButton(uint8_t channel, bool* pressed) {
     if (!pahub_available) return false;
-    
-    if (!selectPaHubChannel(channel)) return false;
-    
-    Wire.beginTransmission(SCROLL_ADDR);
-    Wire.write(SCROLL_BUTTON_REG);
-    if (Wire.endTransmission(false) != 0) return false;
-    
-    delayMicroseconds(500);  // Delay for STM32F030
-    
-    Wire.requestFrom(SCROLL_ADDR, 1, true);
-    delayMicroseconds(300);
-    
-    if (Wire.available() >= 1) {
-        uint8_t btn = Wire.read();
-        *pressed = (btn == 0);
-        return true;
-    }
-    
-    return false;
+    return scrollUnitFor(channel).readButton(pressed);
 }
 
 // Read incremental encoder value (register 0x50)
 bool readScrollEncoder(uint8_t channel, int16_t* increment) {
     if (!pahub_available) return false;
-    
-    if (!selectPaHubChannel(channel)) return false;
-    
-    Wire.beginTransmission(SCROLL_ADDR);
-    Wire.write(SCROLL_INC_ENCODER_REG);
-    if (Wire.endTransmission(false) != 0) return false;
-    
-    delayMicroseconds(500);  // Delay for STM32F030
-    
-    Wire.requestFrom(SCROLL_ADDR, 2, true);  // 16-bit value
-    delayMicroseconds(300);
-    
-    if (Wire.available() >= 2) {
-        uint8_t low = Wire.read();
-        uint8_t high = Wire.read();
-        *increment = (int16_t)(low | (high << 8));  // little-endian
-        return true;
-    }
-    
-    return false;
+    return scrollUnitFor(channel).readIncrement(increment);
 }
 
 void updateButtonState(ButtonState* state, uint8_t channel) {
@@ -235,19 +160,9 @@ uint8_t readKeyboardKey() {
         return 0;
     }
     
-    if (!selectPaHubChannel(PAHUB_CH_KEYBOARD)) {
-        return 0;
-    }
-    
-    Wire.requestFrom(CARDKEYBOARD_ADDR, 1);
-    delayMicroseconds(500);  // Delay for Slave response
-    
-    if (Wire.available() > 0) {
-        uint8_t key = Wire.read();
-        return key;
-    }
-    
-    return 0;
+    uint8_t key = 0;
+    keyboard.readKey(&key);
+    return key;
 }
 
 // ============================================
@@ -314,10 +229,7 @@ void initDevices() {
     // Wire already initialized in setup() after M5Cardputer.begin()
     
     // Detect PA Hub
-    Wire.beginTransmission(PAHUB_ADDR);
-    byte error = Wire.endTransmission();
-    
-    if (error == 0) {
+    if (pahub.probe()) {
         pahub_available = true;
         char buf[64];
         snprintf(buf, sizeof(buf), "OK PA Hub detected at 0x%02X", PAHUB_ADDR);
@@ -325,18 +237,13 @@ void initDevices() {
         Serial.println(buf);
         
         // Deselect all channels
-        Wire.beginTransmission(PAHUB_ADDR);
-        Wire.write(0x00);
-        Wire.endTransmission();
-        pahub_current_channel = 0xFF;
+        pahub.reset();
         delay(10);
         
         // Detect Joystick2 on Channel 0
         Serial.println("Checking Joystick2...");
         if (selectPaHubChannel(PAHUB_CH_JOYSTICK2)) {
-            Wire.beginTransmission(JOYSTICK2_ADDR);
-            error = Wire.endTransmission();
-            if (error == 0) {
+            if (joystick.begin()) {
                 joystick2_available = true;
                 snprintf(buf, sizeof(buf), "OK Joystick2 found at 0x%02X (Channel 0)", JOYSTICK2_ADDR);
                 Serial.print("[APP] ");
@@ -349,9 +256,7 @@ void initDevices() {
         // Detect Scroll A on Channel 1
         Serial.println("Checking Scroll A...");
         if (selectPaHubChannel(PAHUB_CH_SCROLL_A)) {
-            Wire.beginTransmission(SCROLL_ADDR);
-            error = Wire.endTransmission();
-            if (error == 0) {
+            if (scroll_a_unit.begin()) {
                 scroll_a_available = true;
                 snprintf(buf, sizeof(buf), "OK Scroll A found at 0x%02X (Channel 1)", SCROLL_ADDR);
                 Serial.print("[APP] ");
@@ -364,9 +269,7 @@ void initDevices() {
         // Detect Scroll B on Channel 2
         Serial.println("Checking Scroll B...");
         if (selectPaHubChannel(PAHUB_CH_SCROLL_B)) {
-            Wire.beginTransmission(SCROLL_ADDR);
-            error = Wire.endTransmission();
-            if (error == 0) {
+            if (scroll_b_unit.begin()) {
                 scroll_b_available = true;
                 snprintf(buf, sizeof(buf), "OK Scroll B found at 0x%02X (Channel 2)", SCROLL_ADDR);
                 Serial.print("[APP] ");
@@ -380,11 +283,8 @@ void initDevices() {
         Serial.println("Checking Keyboard...");
         if (selectPaHubChannel(PAHUB_CH_KEYBOARD)) {
             delay(50);
-            Wire.requestFrom(CARDKEYBOARD_ADDR, 1);
-            delay(10);
             
-            if (Wire.available() > 0) {
-                uint8_t testKey = Wire.read();
+            if (keyboard.begin()) {
                 keyboard_available = true;
                 snprintf(buf, sizeof(buf), "OK CardKeyBoard found at 0x%02X (Channel 3)", CARDKEYBOARD_ADDR);
                 Serial.print("[APP] ");
@@ -1,6 +1,11 @@
 /*
  * Battery Monitor for M5Stack Tab5
  * Uses INA226 power monitor IC
+ *
+ * A background task samples the INA226 (bus voltage, shunt voltage and
+ * current in one pass, once a conversion is ready) and publishes the
+ * result as a snapshot. All getters read that snapshot: they cause no
+ * I2C traffic and return values from the same pass.
  */
 
 #pragma once
@@ -18,6 +23,22 @@ extern "C" {
 // Device at 0x41 (CONFIG: 41 27) is INA226
 #define INA226_ADDRESS 0x41
 
+// Sampling period of the background task
+#ifndef BATTERY_MONITOR_SAMPLE_MS
+#define BATTERY_MONITOR_SAMPLE_MS 100
+#endif
+
+// GPIO wired to the INA226 ALERT pin, or -1 to poll the conversion-ready
+// flag instead (the Tab5 BSP defines no GPIO for ALERT)
+#ifndef BATTERY_MONITOR_ALERT_GPIO
+#define BATTERY_MONITOR_ALERT_GPIO -1
+#endif
+
+// A snapshot older than this is reported as ESP_ERR_TIMEOUT
+#ifndef BATTERY_MONITOR_STALE_MS
+#define BATTERY_MONITOR_STALE_MS 1000
+#endif
+
 // Battery status structure
 typedef struct {
     int level;          // Battery level 0-100%
@@ -25,8 +46,69 @@ typedef struct {
     bool is_charging;   // True if charging
     bool battery_present; // True if battery is detected
     bool initialized;   // True if battery monitor initialized
+    float current_ma;   // Current from the shunt (negative = charging)
+    int shunt_uv;       // Shunt voltage in µV (negative = charging)
+    int64_t timestamp_us; // esp_timer time of the sample all fields come from
 } battery_status_t;
 
+// One INA226 sampling pass
+typedef struct {
+    int bus_mv;           // Bus voltage in mV
+    int shunt_uv;         // Shunt voltage in µV (negative = charging)
+    float current_ma;     // From the shunt voltage (negative = charging)
+    float current_reg_ma; // From the CURRENT register (calibrated)
+    int64_t timestamp_us; // esp_timer time of the pass
+    uint32_t count;       // Samples published so far
+    uint32_t not_ready;   // Passes skipped so far: no new conversion yet
+    uint32_t errors;      // Passes skipped so far: I2C error
+} battery_sample_t;
+
+// Power profiling (battery_monitor_profile_start()): the INA226 runs at its
+// fastest conversion time, a task reads the shunt voltage continuously and
+// reduces it to min/max/mean buckets, sent as binary records:
+//
+//   offset  size
+//   0       2     magic 'B' 'P'
+//   2       1     version (1)
+//   3       1     bucket count n
+//   4       2     sequence number (gaps = dropped records)
+//   6       2     bucket length (µs)
+//   8       4     esp_timer time of the first bucket (µs, low 32 bits)
+//   12      2     bus voltage (mV, read once per record)
+//   14      2     current per shunt LSB (µA)
+//   16      8*n   buckets: min, max, mean (int16, shunt LSBs), samples (u8), mark (u8)
+//   16+8n   2     CRC-16/CCITT of everything before it
+//
+// Multi-byte fields are little-endian. host/profile_decode.cpp turns the
+// records back into a CSV timeline with energy per marked segment.
+#define BATTERY_PROFILE_VERSION     1
+#define BATTERY_PROFILE_MAX_BUCKETS 32
+#define BATTERY_PROFILE_RECORD_MAX  (16 + 8 * BATTERY_PROFILE_MAX_BUCKETS + 2)
+
+// Called from the profiler's writer task for each record
+typedef void (*battery_profile_sink_t)(const uint8_t *record, size_t len, void *ctx);
+
+typedef struct {
+    uint32_t bucket_us;          // Bucket length in µs (>= 200)
+    uint8_t buckets_per_record;  // 1..BATTERY_PROFILE_MAX_BUCKETS
+    battery_profile_sink_t sink;
+    void *sink_ctx;
+} battery_profile_config_t;
+
+#define BATTERY_PROFILE_CONFIG_DEFAULT() { \
+    .bucket_us = 1000,                   \
+    .buckets_per_record = 32,            \
+    .sink = NULL,                        \
+    .sink_ctx = NULL,                    \
+}
+
+typedef struct {
+    uint32_t samples;         // Shunt readings
+    uint32_t records;         // Records queued for the sink
+    uint32_t records_dropped; // Sink too slow: queue full
+    uint32_t errors;          // I2C errors
+} battery_profile_stats_t;
+
 /**
  * @brief Initialize battery monitor (INA226)
  * 
@@ -43,6 +125,51 @@ esp_err_t battery_monitor_init(i2c_master_bus_handle_t i2c_bus_handle);
  */
 esp_err_t battery_monitor_read(battery_status_t *status);
 
+/**
+ * @brief Get the latest INA226 sample (no I2C traffic)
+ * 
+ * @param out Pointer to battery_sample_t structure to fill
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before the first sample,
+ *         ESP_ERR_TIMEOUT if the sample is older than BATTERY_MONITOR_STALE_MS
+ */
+esp_err_t battery_monitor_get_sample(battery_sample_t *out);
+
+/**
+ * @brief Start power profiling
+ * 
+ * Reconfigures the INA226 (140 µs conversions, no averaging) and starts
+ * the profiler tasks. The regular sampler pauses; the getters keep
+ * working from one snapshot per record.
+ * 
+ * @param config Profiling configuration (sink required)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already running
+ */
+esp_err_t battery_monitor_profile_start(const battery_profile_config_t *config);
+
+/**
+ * @brief Stop power profiling and restore the normal INA226 configuration
+ * 
+ * @return ESP_OK on success
+ */
+esp_err_t battery_monitor_profile_stop(void);
+
+/**
+ * @brief Mark the current bucket (e.g. "display refresh starts")
+ * 
+ * Any task; does nothing while not profiling.
+ * 
+ * @param mark Event id 1-255, shown by the host decoder; one per bucket,
+ *             the first one wins
+ */
+void battery_monitor_profile_mark(uint8_t mark);
+
+/**
+ * @brief Get profiling counters
+ * 
+ * @param out Pointer to battery_profile_stats_t structure to fill
+ */
+void battery_monitor_profile_get_stats(battery_profile_stats_t *out);
+
 /**
  * @brief Get battery level (0-100%)
  * 
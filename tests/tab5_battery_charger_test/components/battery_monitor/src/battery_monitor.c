@@ -1,6 +1,23 @@
 /*
  * Battery Monitor for M5Stack Tab5
  * Uses INA226 power monitor IC
+ *
+ * Sampling: a task wakes every BATTERY_MONITOR_SAMPLE_MS, checks that the
+ * INA226 has finished a conversion (CVRF in MASK/ENABLE, or the ALERT pin
+ * with BATTERY_MONITOR_ALERT_GPIO) and reads shunt voltage, bus voltage
+ * and current back to back. The sample goes into the free one of two
+ * slots; a generation counter then publishes it. Readers copy the slot
+ * the counter points at and retry if it moved during the copy, so a
+ * reader never sees half of one pass and half of another.
+ *
+ * Profiling: battery_monitor_profile_start() takes the INA226 away from
+ * the sampler (ina226_lock) for the whole run, switches to 140 µs
+ * conversions and reads the shunt register as fast as the bus allows.
+ * The register pointer stays on SHUNTVOLTAGE, so each reading is a single
+ * 2-byte receive. Readings are reduced to min/max/mean buckets; full
+ * records go through a queue to a writer task that calls the sink, so a
+ * slow sink drops records (visible as sequence gaps) instead of stalling
+ * the sampling.
  */
 
 #include "battery_monitor.h"
@@ -8,9 +25,15 @@
 #include "driver/i2c_master.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include <stdatomic.h>
 #include "nvs_flash.h"
 #include "nvs.h"
 #include <math.h>
+#include <string.h>
 
 // Forward declaration for USB-C detection (to avoid including full BSP header)
 // Function is implemented in m5stack_tab5 component
@@ -36,17 +59,59 @@ static uint32_t last_save_time_ms = 0;
 #define INA226_REG_MANUF_ID     0xFE  // Manufacturer ID (Texas Instruments: 0x5449)
 
 // INA226 configuration values
+#define INA226_AVERAGES_1       0b000
 #define INA226_AVERAGES_16      0b010
+#define INA226_CONV_TIME_140US  0b000
 #define INA226_BUS_CONV_TIME_1100US  0b100
 #define INA226_SHUNT_CONV_TIME_1100US 0b100
 #define INA226_MODE_SHUNT_BUS_CONT   0b111
 
+// MASK/ENABLE bits
+#define INA226_MASK_CNVR        (1 << 10)  // ALERT pin on conversion ready
+#define INA226_MASK_CVRF        (1 << 3)   // Conversion ready (cleared by reading MASK/ENABLE)
+
+// One shunt + bus conversion cycle with the configuration above
+#define INA226_CYCLE_MS  ((16 * (1100 + 1100) + 999) / 1000)
+
+#define SAMPLER_STACK_SIZE 3072
+#define SAMPLER_PRIORITY   5
+
+#define PROFILE_STACK_SIZE     4096
+#define PROFILE_PRIORITY       10   // Above the sampler and the UI
+#define PROFILE_CORE           1
+#define PROFILE_WRITER_STACK   3072
+#define PROFILE_WRITER_PRIORITY 4
+#define PROFILE_QUEUE_LEN      8
+#define PROFILE_UA_PER_LSB     500  // 2.5 µV shunt LSB / 5 mOhm
+
 #define I2C_MASTER_TIMEOUT_MS 50
 
 static i2c_master_dev_handle_t ina226_dev_handle = NULL;
 static bool initialized = false;
 static float current_lsb = 0.0f;  // Current LSB for reading current from INA226
 
+// Published samples: slot (generation & 1) is the current one
+static battery_sample_t sample_slots[2];
+static atomic_uint sample_generation = 0;  // 0 = nothing published yet
+static uint32_t samples_not_ready = 0;     // Passes skipped: no new conversion
+static uint32_t sample_errors = 0;         // Passes skipped: I2C error
+static TaskHandle_t sampler_task_handle = NULL;
+static uint16_t ina226_config = 0;                // Normal CONFIG, restored after profiling
+static SemaphoreHandle_t ina226_lock = NULL;      // Sampler or profiler
+
+// Profiling
+typedef struct {
+    uint16_t len;  // 0 = stop the writer
+    uint8_t data[BATTERY_PROFILE_RECORD_MAX];
+} profile_record_t;
+
+static battery_profile_config_t profile_cfg;
+static QueueHandle_t profile_queue = NULL;
+static SemaphoreHandle_t profile_done = NULL;     // Given by the writer when it exits
+static atomic_bool profile_running = false;
+static atomic_uint profile_pending_mark = 0;
+static battery_profile_stats_t profile_stats;
+
 // Helper functions
 // Read unsigned 16-bit register
 static esp_err_t ina226_read_u16(uint8_t reg, uint16_t *out)
@@ -157,16 +222,10 @@ static float read_current(void)
     return current;
 }
 
-// Read current from shunt voltage directly (more reliable than CURRENT register)
+// Current from the shunt voltage (more reliable than CURRENT register)
 // Returns current in mA (signed: negative = charging, positive = discharging)
-static float read_current_from_shunt_ma_internal(void)
+static float shunt_raw_to_ma(int16_t shunt_raw)
 {
-    int16_t shunt_raw = 0;
-    esp_err_t err = ina226_read_s16(INA226_REG_SHUNTVOLTAGE, &shunt_raw);
-    if (err != ESP_OK) {
-        return 0.0f; // I2C error
-    }
-    
     // Shunt voltage LSB = 2.5µV = 0.0000025V
     float shunt_voltage_v = (float)shunt_raw * 0.0000025f;
     
@@ -177,6 +236,287 @@ static float read_current_from_shunt_ma_internal(void)
     return current_a * 1000.0f;  // Convert to mA (signed: negative = charging)
 }
 
+// Sampler task only
+static void publish_sample(battery_sample_t *sample)
+{
+    unsigned gen = atomic_load_explicit(&sample_generation, memory_order_relaxed);
+    sample->count = gen + 1;
+    sample_slots[(gen + 1) & 1] = *sample;  // The slot readers are not using
+    atomic_store_explicit(&sample_generation, gen + 1, memory_order_release);
+}
+
+// Any task; false before the first sample
+static bool copy_sample(battery_sample_t *out)
+{
+    for (;;) {
+        unsigned gen = atomic_load_explicit(&sample_generation, memory_order_acquire);
+        if (gen == 0) {
+            return false;
+        }
+        *out = sample_slots[gen & 1];
+        atomic_thread_fence(memory_order_acquire);
+        // Unchanged: the writer was filling the other slot the whole time
+        if (atomic_load_explicit(&sample_generation, memory_order_relaxed) == gen) {
+            return true;
+        }
+    }
+}
+
+// One pass: skipped unless a conversion finished since the last one, so
+// every sample is a new measurement
+static esp_err_t sample_once(void)
+{
+    uint16_t mask = 0;
+    esp_err_t err = ina226_read_u16(INA226_REG_MASKENABLE, &mask);  // Clears CVRF (and ALERT)
+    if (err == ESP_OK && !(mask & INA226_MASK_CVRF)) {
+        samples_not_ready++;
+        return ESP_ERR_NOT_FINISHED;
+    }
+    
+    int16_t shunt_raw = 0;
+    uint16_t bus_raw = 0;
+    int16_t current_raw = 0;
+    if (err == ESP_OK) err = ina226_read_s16(INA226_REG_SHUNTVOLTAGE, &shunt_raw);
+    if (err == ESP_OK) err = ina226_read_u16(INA226_REG_BUSVOLTAGE, &bus_raw);
+    if (err == ESP_OK) err = ina226_read_s16(INA226_REG_CURRENT, &current_raw);
+    if (err != ESP_OK) {
+        sample_errors++;
+        return err;
+    }
+    
+    battery_sample_t sample = {
+        .bus_mv = (int)(bus_raw * 1.25f),  // LSB = 1.25 mV, no shift (see read_bus_voltage)
+        .shunt_uv = (int)(shunt_raw * 2.5f),
+        .current_ma = shunt_raw_to_ma(shunt_raw),
+        .current_reg_ma = (float)current_raw * current_lsb * 1000.0f,
+        .timestamp_us = esp_timer_get_time(),
+        .not_ready = samples_not_ready,
+        .errors = sample_errors,
+    };
+    publish_sample(&sample);
+    return ESP_OK;
+}
+
+#if BATTERY_MONITOR_ALERT_GPIO >= 0
+static void IRAM_ATTR alert_isr(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(sampler_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// ALERT (active low) signals conversion ready
+static esp_err_t setup_alert_gpio(void)
+{
+    gpio_config_t io = {
+        .pin_bit_mask = 1ULL << BATTERY_MONITOR_ALERT_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    esp_err_t err = gpio_config(&io);
+    if (err != ESP_OK) return err;
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;  // Already installed is fine
+    err = gpio_isr_handler_add(BATTERY_MONITOR_ALERT_GPIO, alert_isr, NULL);
+    if (err != ESP_OK) return err;
+    return write_register16(INA226_REG_MASKENABLE, INA226_MASK_CNVR);
+}
+#endif
+
+static void sampler_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(BATTERY_MONITOR_SAMPLE_MS));
+        if (xSemaphoreTake(ina226_lock, 0) != pdTRUE) {
+            continue;  // Profiling
+        }
+#if BATTERY_MONITOR_ALERT_GPIO >= 0
+        // Drop the conversion that finished while sleeping, wait for the
+        // next one: the registers are then read right after an update
+        uint16_t mask = 0;
+        ulTaskNotifyTake(pdTRUE, 0);
+        ina226_read_u16(INA226_REG_MASKENABLE, &mask);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2 * INA226_CYCLE_MS));
+#endif
+        sample_once();
+        xSemaphoreGive(ina226_lock);
+    }
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, v & 0xFFFF);
+    put_u16(p + 2, v >> 16);
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+static uint16_t profile_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// Point the INA226 at SHUNTVOLTAGE for the receive-only reads
+static esp_err_t profile_select_shunt(void)
+{
+    uint8_t reg = INA226_REG_SHUNTVOLTAGE;
+    return i2c_master_transmit(ina226_dev_handle, &reg, 1, I2C_MASTER_TIMEOUT_MS);
+}
+
+// Header and CRC around the buckets already in rec->data; returns false if
+// the queue was full
+static bool profile_send(profile_record_t *rec, uint8_t n, uint16_t seq, uint32_t t_us, uint16_t bus_mv)
+{
+    uint8_t *d = rec->data;
+    d[0] = 'B';
+    d[1] = 'P';
+    d[2] = BATTERY_PROFILE_VERSION;
+    d[3] = n;
+    put_u16(d + 4, seq);
+    put_u16(d + 6, (uint16_t)profile_cfg.bucket_us);
+    put_u32(d + 8, t_us);
+    put_u16(d + 12, bus_mv);
+    put_u16(d + 14, PROFILE_UA_PER_LSB);
+    size_t len = 16 + 8 * (size_t)n;
+    put_u16(d + len, profile_crc16(d, len));
+    rec->len = len + 2;
+    return xQueueSend(profile_queue, rec, 0) == pdTRUE;
+}
+
+static void profile_task(void *arg)
+{
+    // Waits out a sampler pass in progress; held until profiling stops
+    xSemaphoreTake(ina226_lock, portMAX_DELAY);
+    
+    uint16_t fast = (INA226_AVERAGES_1 << 9) | (INA226_CONV_TIME_140US << 6) |
+                    (INA226_CONV_TIME_140US << 3) | INA226_MODE_SHUNT_BUS_CONT;
+    if (write_register16(INA226_REG_CONFIG, fast) != ESP_OK) {
+        profile_stats.errors++;
+    }
+    
+    static profile_record_t rec;  // Only this task
+    const uint8_t n_max = profile_cfg.buckets_per_record;
+    const int64_t bucket_us = profile_cfg.bucket_us;
+    uint16_t seq = 0;
+    uint16_t bus_mv = 0;
+    uint8_t n = 0;
+    int16_t b_min = INT16_MAX, b_max = INT16_MIN;
+    int32_t b_sum = 0;
+    uint32_t b_count = 0;
+    int64_t bucket_start = esp_timer_get_time();
+    uint32_t record_t_us = (uint32_t)bucket_start;
+    bool pointer_ok = profile_select_shunt() == ESP_OK;
+    
+    while (atomic_load(&profile_running)) {
+        uint8_t r[2];
+        if (!pointer_ok) {
+            pointer_ok = profile_select_shunt() == ESP_OK;
+        }
+        if (pointer_ok && i2c_master_receive(ina226_dev_handle, r, 2, I2C_MASTER_TIMEOUT_MS) == ESP_OK) {
+            int16_t raw = (int16_t)(((uint16_t)r[0] << 8) | r[1]);
+            if (raw < b_min) b_min = raw;
+            if (raw > b_max) b_max = raw;
+            b_sum += raw;
+            b_count++;
+            profile_stats.samples++;
+        } else {
+            profile_stats.errors++;
+            pointer_ok = false;
+            vTaskDelay(1);  // Don't spin on a stuck bus
+        }
+        
+        int64_t now = esp_timer_get_time();
+        if (now - bucket_start < bucket_us) {
+            continue;
+        }
+        
+        // Close the bucket; one with no readings has count 0
+        uint8_t *b = rec.data + 16 + 8 * n;
+        put_u16(b, (uint16_t)(b_count ? b_min : 0));
+        put_u16(b + 2, (uint16_t)(b_count ? b_max : 0));
+        put_u16(b + 4, (uint16_t)(b_count ? (int16_t)(b_sum / (int32_t)b_count) : 0));
+        b[6] = b_count > 255 ? 255 : b_count;
+        b[7] = (uint8_t)atomic_exchange(&profile_pending_mark, 0);
+        n++;
+        b_min = INT16_MAX;
+        b_max = INT16_MIN;
+        b_sum = 0;
+        b_count = 0;
+        bucket_start += bucket_us;
+        if (now - bucket_start >= bucket_us) {
+            bucket_start = now;  // Preempted for longer than a bucket: resync
+        }
+        
+        if (n < n_max) {
+            continue;
+        }
+        
+        // Bus voltage once per record, then back to the shunt register
+        uint16_t bus_raw = 0;
+        if (ina226_read_u16(INA226_REG_BUSVOLTAGE, &bus_raw) != ESP_OK) {
+            profile_stats.errors++;
+        }
+        pointer_ok = profile_select_shunt() == ESP_OK;
+        bus_mv = (uint16_t)(bus_raw * 1.25f);
+        
+        // The getters keep working: publish the last bucket
+        int16_t mean = (int16_t)(rec.data[16 + 8 * (n - 1) + 4] | (rec.data[16 + 8 * (n - 1) + 5] << 8));
+        battery_sample_t sample = {
+            .bus_mv = bus_mv,
+            .shunt_uv = (int)(mean * 2.5f),
+            .current_ma = shunt_raw_to_ma(mean),
+            .current_reg_ma = shunt_raw_to_ma(mean),  // CURRENT is not read while profiling
+            .timestamp_us = now,
+            .not_ready = samples_not_ready,
+            .errors = sample_errors,
+        };
+        publish_sample(&sample);
+        
+        if (profile_send(&rec, n, seq++, record_t_us, bus_mv)) {
+            profile_stats.records++;
+        } else {
+            profile_stats.records_dropped++;
+        }
+        n = 0;
+        record_t_us = (uint32_t)bucket_start;
+    }
+    
+    // Partial record, then the writer's stop marker
+    if (n > 0 && profile_send(&rec, n, seq, record_t_us, bus_mv)) {
+        profile_stats.records++;
+    }
+    if (write_register16(INA226_REG_CONFIG, ina226_config) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to restore INA226 configuration");
+    }
+    xSemaphoreGive(ina226_lock);
+    rec.len = 0;
+    xQueueSend(profile_queue, &rec, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+static void profile_writer_task(void *arg)
+{
+    static profile_record_t rec;
+    while (xQueueReceive(profile_queue, &rec, portMAX_DELAY) == pdTRUE && rec.len > 0) {
+        profile_cfg.sink(rec.data, rec.len, profile_cfg.sink_ctx);
+    }
+    xSemaphoreGive(profile_done);
+    vTaskDelete(NULL);
+}
 
 // I2C scan function
 static void scan_i2c_bus(i2c_master_bus_handle_t bus_handle) {
@@ -367,6 +707,7 @@ esp_err_t battery_monitor_init(i2c_master_bus_handle_t i2c_bus_handle)
     config |= (INA226_BUS_CONV_TIME_1100US << 6);
     config |= (INA226_SHUNT_CONV_TIME_1100US << 3);
     config |= INA226_MODE_SHUNT_BUS_CONT;
+    ina226_config = config;
     
     ret = write_register16(INA226_REG_CONFIG, config);
     if (ret != ESP_OK) {
@@ -418,6 +759,12 @@ esp_err_t battery_monitor_init(i2c_master_bus_handle_t i2c_bus_handle)
     
     initialized = true;
     
+    // First sample before returning: the getters work right away
+    esp_err_t sample_err = sample_once();
+    if (sample_err != ESP_OK) {
+        ESP_LOGW(TAG, "First sample failed: %s", esp_err_to_name(sample_err));
+    }
+    
     // Test read voltage
     float test_voltage = read_bus_voltage();
     if (test_voltage > 0) {
@@ -444,6 +791,25 @@ esp_err_t battery_monitor_init(i2c_master_bus_handle_t i2c_bus_handle)
     ESP_LOGI(TAG, "Dumping INA226 registers after initialization:");
     dump_ina226_registers();
     
+    // Start the sampler
+    ina226_lock = xSemaphoreCreateMutex();
+    if (!ina226_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(sampler_task, "battery_mon", SAMPLER_STACK_SIZE, NULL, SAMPLER_PRIORITY,
+                    &sampler_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sampler task");
+        return ESP_ERR_NO_MEM;
+    }
+#if BATTERY_MONITOR_ALERT_GPIO >= 0
+    ret = setup_alert_gpio();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "ALERT GPIO %d setup failed: %s", BATTERY_MONITOR_ALERT_GPIO, esp_err_to_name(ret));
+    }
+#endif
+    ESP_LOGI(TAG, "Sampling every %d ms (%s)", BATTERY_MONITOR_SAMPLE_MS,
+             BATTERY_MONITOR_ALERT_GPIO >= 0 ? "ALERT pin" : "conversion-ready flag");
+    
     return ESP_OK;
 }
 
@@ -465,21 +831,22 @@ esp_err_t battery_monitor_read(battery_status_t *status)
     
     status->initialized = true;
     
-    // Read bus voltage
-    float bus_voltage = read_bus_voltage();
-    if (bus_voltage < 0) {
+    // Latest sample: voltage and current from the same INA226 pass
+    battery_sample_t sample;
+    esp_err_t err = battery_monitor_get_sample(&sample);
+    if (err != ESP_OK) {
         status->level = -1;
         status->voltage_mv = -1;
         status->is_charging = false;
         status->battery_present = false;
-        return ESP_FAIL;
+        return err;
     }
     
-    // Convert to mV
-    int raw_voltage_mv = (int)(bus_voltage * 1000.0f);
-    
-    // Read current
-    float current_ma = read_current_from_shunt_ma_internal();
+    int raw_voltage_mv = sample.bus_mv;
+    float current_ma = sample.current_ma;
+    status->current_ma = sample.current_ma;
+    status->shunt_uv = sample.shunt_uv;
+    status->timestamp_us = sample.timestamp_us;
     
     // Determine charging status (negative = charging)
     status->is_charging = (current_ma < -10.0f);
@@ -592,26 +959,33 @@ bool battery_monitor_is_charging(void)
     return false;
 }
 
+esp_err_t battery_monitor_get_sample(battery_sample_t *out)
+{
+    if (!out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!initialized || !copy_sample(out)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (esp_timer_get_time() - out->timestamp_us > (int64_t)BATTERY_MONITOR_STALE_MS * 1000) {
+        return ESP_ERR_TIMEOUT;  // Sampler not getting through (I2C errors)
+    }
+    return ESP_OK;
+}
+
 esp_err_t battery_monitor_get_current_ma(float *out_ma)
 {
     if (!initialized || !out_ma) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    int16_t shunt_raw = 0;
-    esp_err_t err = ina226_read_s16(INA226_REG_SHUNTVOLTAGE, &shunt_raw);
+    battery_sample_t sample;
+    esp_err_t err = battery_monitor_get_sample(&sample);
     if (err != ESP_OK) {
         return err;
     }
     
-    // Shunt voltage LSB = 2.5µV = 0.0000025V
-    float shunt_voltage_v = (float)shunt_raw * 0.0000025f;
-    
-    // Current = Shunt Voltage / R_shunt
-    // R_shunt = 0.005 ohm (5 mOhm)
-    float current_a = shunt_voltage_v / 0.005f;
-    
-    *out_ma = current_a * 1000.0f; // Convert to mA (signed: negative = charging)
+    *out_ma = sample.current_ma; // Signed: negative = charging
     return ESP_OK;
 }
 
@@ -621,14 +995,92 @@ esp_err_t battery_monitor_get_shunt_voltage_uv(int *out_uv)
         return ESP_ERR_INVALID_STATE;
     }
     
-    int16_t shunt_raw = 0;
-    esp_err_t err = ina226_read_s16(INA226_REG_SHUNTVOLTAGE, &shunt_raw);
+    battery_sample_t sample;
+    esp_err_t err = battery_monitor_get_sample(&sample);
     if (err != ESP_OK) {
         return err;
     }
     
     // Shunt voltage LSB = 2.5µV, can be negative (charging)
-    *out_uv = (int)(shunt_raw * 2.5f);
+    *out_uv = sample.shunt_uv;
     return ESP_OK;
 }
 
+esp_err_t battery_monitor_profile_start(const battery_profile_config_t *config)
+{
+    if (!config || !config->sink || config->bucket_us < 200 || config->bucket_us > UINT16_MAX ||
+        config->buckets_per_record == 0 || config->buckets_per_record > BATTERY_PROFILE_MAX_BUCKETS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (atomic_load(&profile_running)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (!profile_queue) {
+        profile_queue = xQueueCreate(PROFILE_QUEUE_LEN, sizeof(profile_record_t));
+        profile_done = xSemaphoreCreateBinary();
+        if (!profile_queue || !profile_done) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    xQueueReset(profile_queue);
+    
+    profile_cfg = *config;
+    memset(&profile_stats, 0, sizeof(profile_stats));
+    atomic_store(&profile_pending_mark, 0);
+    atomic_store(&profile_running, true);
+    
+    if (xTaskCreate(profile_writer_task, "battery_prof_out", PROFILE_WRITER_STACK, NULL,
+                    PROFILE_WRITER_PRIORITY, NULL) != pdPASS) {
+        atomic_store(&profile_running, false);
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(profile_task, "battery_prof", PROFILE_STACK_SIZE, NULL,
+                                PROFILE_PRIORITY, NULL, PROFILE_CORE) != pdPASS) {
+        atomic_store(&profile_running, false);
+        static profile_record_t stop;  // Too big for the caller's stack
+        stop.len = 0;
+        xQueueSend(profile_queue, &stop, portMAX_DELAY);
+        xSemaphoreTake(profile_done, portMAX_DELAY);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Profiling: %lu us buckets, %u per record",
+             (unsigned long)config->bucket_us, config->buckets_per_record);
+    return ESP_OK;
+}
+
+esp_err_t battery_monitor_profile_stop(void)
+{
+    if (!atomic_exchange(&profile_running, false)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // The profiler restores CONFIG and stops the writer after the last record
+    if (xSemaphoreTake(profile_done, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGW(TAG, "Profiler did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    ESP_LOGI(TAG, "Profiling stopped: %lu samples, %lu records, %lu dropped, %lu errors",
+             (unsigned long)profile_stats.samples, (unsigned long)profile_stats.records,
+             (unsigned long)profile_stats.records_dropped, (unsigned long)profile_stats.errors);
+    return ESP_OK;
+}
+
+void battery_monitor_profile_mark(uint8_t mark)
+{
+    // One mark per bucket: the first one wins
+    unsigned none = 0;
+    if (atomic_load(&profile_running)) {
+        atomic_compare_exchange_strong(&profile_pending_mark, &none, mark);
+    }
+}
+
+void battery_monitor_profile_get_stats(battery_profile_stats_t *out)
+{
+    if (out) {
+        *out = profile_stats;
+    }
+}
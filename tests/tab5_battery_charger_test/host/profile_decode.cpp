@@ -0,0 +1,541 @@
+/*
+ * Host side of the battery monitor's power profiling (POWER_PROFILE 1)
+ *
+ * Build and run on a PC:
+ *   g++ -O2 -std=c++11 -o profile_decode profile_decode.cpp
+ *   stty -F /dev/ttyACM0 raw && ./profile_decode < /dev/ttyACM0 > profile.csv
+ *   ./profile_decode --segments < capture.bin > /dev/null
+ *   ./profile_decode --selftest
+ *
+ * Picks the binary records (layout in battery_monitor.h) out of the
+ * console stream and writes one CSV row per bucket to stdout:
+ *
+ *   t_ms,min_ma,mean_ma,max_ma,bus_mv,samples,mark
+ *
+ * Time is relative to the first record; the 32-bit stamps are extended
+ * across their wrap. The log text around the records goes to stderr as
+ * it arrives. At the end (EOF or Ctrl-C) stderr gets the summary: charge
+ * and energy, peak current, records lost to sequence gaps or bad CRCs,
+ * and per mark id the segments from that mark to the next one (count,
+ * mean duration, current and energy). --segments lists every segment.
+ *
+ * Energy uses the bus voltage of each record, read once per record: on
+ * battery that is the pack, with only USB power it is VSYS.
+ */
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// As in battery_monitor.h
+static const int HEADER = 16;
+static const int BUCKET = 8;
+static const int MAX_BUCKETS = 32;
+static const int VERSION = 1;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void onSignal(int) { stop_requested = 1; }
+
+static uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t get32(const uint8_t* p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+// CRC-16/CCITT-FALSE, as profile_crc16()
+static uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+struct Bucket {
+    uint64_t t_us;  // Extended, relative to the first record
+    double min_ma, max_ma, mean_ma;
+    int bus_mv;
+    int samples;
+    int mark;
+    double us;  // Length
+};
+
+// Splits the stream into records and text: bucket(b) for each bucket,
+// text(p, len) for everything else
+template <typename OnBucket, typename OnText>
+class ProfileDecoder {
+public:
+    ProfileDecoder(OnBucket bucket, OnText text)
+        : _bucket(bucket), _text(text), _records(0), _dropped(0), _bad(0), _crlfRecords(0), _started(false), _seq(0), _last(0),
+          _now(0), _base(0) {}
+
+    void feed(const uint8_t* data, size_t len) {
+        _buf.insert(_buf.end(), data, data + len);
+        size_t i = 0;
+        while (i < _buf.size()) {
+            const uint8_t* p = _buf.data() + i;
+            size_t avail = _buf.size() - i;
+            if (p[0] != 'B') {
+                size_t k = 1;
+                while (k < avail && p[k] != 'B') k++;
+                _text(p, k);
+                i += k;
+                continue;
+            }
+            if (avail < 4) break;  // Need the header
+            size_t n = p[3];
+            if (p[1] != 'P' || p[2] != VERSION || n == 0 || n > (size_t)MAX_BUCKETS) {
+                _text(p, 1);
+                i++;
+                continue;
+            }
+            size_t total = HEADER + BUCKET * n + 2;
+            if (avail < total) break;
+            if (crc16(p, total - 2) != get16(p + total - 2)) {
+                // A console that turns "\n" into "\r\n" (old firmware, or
+                // another sink) stretched the record
+                size_t used = undoCrlf(p, avail);
+                if (used == SIZE_MAX) break;  // Need more input
+                if (used > 0) {
+                    onRecord(_crlf.data(), _crlf[3]);
+                    _crlfRecords++;
+                    i += used;
+                    continue;
+                }
+                // Text that happens to start with "BP", or a damaged record
+                if (looksBinary(p, total - 2)) _bad++;
+                _text(p, 1);
+                i++;
+                continue;
+            }
+            onRecord(p, n);
+            i += total;
+        }
+        _buf.erase(_buf.begin(), _buf.begin() + i);
+    }
+
+    // Whatever is left can't be a record
+    void finish() {
+        if (!_buf.empty()) _text(_buf.data(), _buf.size());
+        _buf.clear();
+    }
+
+    uint32_t records() const { return _records; }
+    uint32_t dropped() const { return _dropped; }  // Sequence gaps
+    uint32_t bad() const { return _bad; }
+    uint32_t crlfRecords() const { return _crlfRecords; }  // Recovered from "\r\n" expansion
+
+private:
+    // The record at p with each "\r\n" taken back to "\n", into _crlf:
+    // the input bytes it used, 0 if the CRC still fails, SIZE_MAX if
+    // the input ends first
+    size_t undoCrlf(const uint8_t* p, size_t avail) {
+        _crlf.clear();
+        size_t i = 0, total = HEADER;
+        while (_crlf.size() < total) {
+            if (i >= avail || (p[i] == '\r' && i + 1 >= avail)) return SIZE_MAX;
+            if (p[i] == '\r' && p[i + 1] == '\n') i++;
+            _crlf.push_back(p[i++]);
+            if (_crlf.size() == 4) {
+                size_t n = _crlf[3];
+                if (n == 0 || n > (size_t)MAX_BUCKETS) return 0;
+                total = HEADER + BUCKET * n + 2;
+            }
+        }
+        return crc16(_crlf.data(), total - 2) == get16(_crlf.data() + total - 2) ? i : 0;
+    }
+
+    static bool looksBinary(const uint8_t* p, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            if ((p[i] < 0x20 || p[i] >= 0x7F) && p[i] != '\r' && p[i] != '\n' && p[i] != '\t' && p[i] != 0x1B) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void onRecord(const uint8_t* p, size_t n) {
+        uint16_t seq = get16(p + 4);
+        if (_records > 0) _dropped += (uint16_t)(seq - _seq - 1);
+        _seq = seq;
+        _records++;
+
+        uint16_t bucket_us = get16(p + 6);
+        uint64_t t = extend(get32(p + 8)) - _base;
+        int bus_mv = get16(p + 12);
+        double ma_per_lsb = get16(p + 14) / 1000.0;
+        for (size_t i = 0; i < n; i++) {
+            const uint8_t* b = p + HEADER + BUCKET * i;
+            Bucket out;
+            out.t_us = t + (uint64_t)bucket_us * i;
+            out.min_ma = (int16_t)get16(b) * ma_per_lsb;
+            out.max_ma = (int16_t)get16(b + 2) * ma_per_lsb;
+            out.mean_ma = (int16_t)get16(b + 4) * ma_per_lsb;
+            out.bus_mv = bus_mv;
+            out.samples = b[6];
+            out.mark = b[7];
+            out.us = bucket_us;
+            _bucket(out);
+        }
+    }
+
+    // 64-bit time from the 32-bit stamp
+    uint64_t extend(uint32_t t) {
+        if (!_started) {
+            _started = true;
+            _last = t;
+            _now = _base = (uint64_t)t;
+            return _now;
+        }
+        _now += (uint32_t)(t - _last);
+        _last = t;
+        return _now;
+    }
+
+    OnBucket _bucket;
+    OnText _text;
+    std::vector<uint8_t> _buf;
+    std::vector<uint8_t> _crlf;
+    uint32_t _records;
+    uint32_t _dropped;
+    uint32_t _bad;
+    uint32_t _crlfRecords;
+    bool _started;
+    uint16_t _seq;
+    uint32_t _last;
+    uint64_t _now;
+    uint64_t _base;
+};
+
+template <typename OnBucket, typename OnText>
+static ProfileDecoder<OnBucket, OnText> makeDecoder(OnBucket bucket, OnText text) {
+    return ProfileDecoder<OnBucket, OnText>(bucket, text);
+}
+
+// Totals over the buckets, and the segments between marks
+class Summary {
+public:
+    struct Segment {
+        int mark;
+        double start_ms, ms;
+        double charge_mc;  // mA * s
+        double energy_mj;
+        double peak_ma;
+        bool gap;  // Spans lost records: left out of the per-mark figures
+    };
+
+    Summary() : _buckets(0), _samples(0), _empty(0), _ms(0), _covered_ms(0), _charge(0), _energy(0), _peak(0), _next_us(0) {}
+
+    void add(const Bucket& b) {
+        if (_buckets > 0 && b.t_us != _next_us && !_segments.empty() && _segments.back().ms == 0) {
+            _segments.back().gap = true;
+        }
+        _buckets++;
+        _next_us = b.t_us + (uint64_t)b.us;
+        _ms = _next_us / 1000.0;
+        if (b.mark) {
+            closeSegment(b.t_us / 1000.0);
+            Segment s = {b.mark, b.t_us / 1000.0, 0, 0, 0, 0, false};
+            _segments.push_back(s);
+        }
+        if (b.samples == 0) {
+            _empty++;  // I2C errors for a whole bucket
+            return;
+        }
+        double s = b.us / 1e6;
+        _covered_ms += b.us / 1000.0;
+        double charge = b.mean_ma * s;
+        double energy = b.mean_ma * b.bus_mv * s / 1000.0;
+        _samples += b.samples;
+        _charge += charge;
+        _energy += energy;
+        if (b.max_ma > _peak) _peak = b.max_ma;
+        if (!_segments.empty() && _segments.back().ms == 0) {
+            Segment& seg = _segments.back();
+            seg.charge_mc += charge;
+            seg.energy_mj += energy;
+            if (b.max_ma > seg.peak_ma) seg.peak_ma = b.max_ma;
+        }
+    }
+
+    void finish() { closeSegment(_ms); }
+
+    void print(FILE* f, bool all) const {
+        fprintf(f, "[profile] %.3f s, %u buckets, %u samples (%u buckets empty)\n", _ms / 1000.0, (unsigned)_buckets,
+                (unsigned)_samples, (unsigned)_empty);
+        if (_covered_ms > 0) {
+            // Means over the time covered by buckets, lost records excluded
+            fprintf(f, "[profile] mean %.1f mA, peak %.1f mA, %.3f C, %.3f J (%.1f mW mean)\n",
+                    _charge / (_covered_ms / 1000.0), _peak, _charge / 1000.0, _energy / 1000.0,
+                    _energy / (_covered_ms / 1000.0));
+        }
+        for (int mark = 1; mark < 256; mark++) {
+            int count = 0, incomplete = 0;
+            double ms = 0, charge = 0, energy = 0, peak = 0;
+            for (size_t i = 0; i < _segments.size(); i++) {
+                const Segment& s = _segments[i];
+                if (s.mark != mark) continue;
+                if (s.gap) {
+                    incomplete++;
+                    continue;
+                }
+                count++;
+                ms += s.ms;
+                charge += s.charge_mc;
+                energy += s.energy_mj;
+                if (s.peak_ma > peak) peak = s.peak_ma;
+            }
+            if (count > 0) {
+                fprintf(f, "[profile] mark %3d: %5d x %9.1f ms, %7.1f mA mean, %7.1f mA peak, %9.3f mJ each\n", mark,
+                        count, ms / count, ms > 0 ? charge / (ms / 1000.0) : 0, peak, energy / count);
+            }
+            if (incomplete > 0) {
+                fprintf(f, "[profile] mark %3d: %5d segments incomplete (lost records)\n", mark, incomplete);
+            }
+        }
+        if (!all) return;
+        for (size_t i = 0; i < _segments.size(); i++) {
+            const Segment& s = _segments[i];
+            fprintf(f, "[profile]   %10.3f ms mark %3d: %9.1f ms, %7.1f mA peak, %9.3f mJ%s\n", s.start_ms, s.mark,
+                    s.ms, s.peak_ma, s.energy_mj, s.gap ? " (incomplete)" : "");
+        }
+    }
+
+    double energyMj() const { return _energy; }
+    double chargeMc() const { return _charge; }
+    double peakMa() const { return _peak; }
+    const std::vector<Segment>& segments() const { return _segments; }
+
+private:
+    void closeSegment(double end_ms) {
+        if (_segments.empty() || _segments.back().ms != 0) return;
+        Segment& s = _segments.back();
+        s.ms = end_ms - s.start_ms;
+        if (s.ms <= 0) s.ms = 1e-9;  // Closed
+    }
+
+    uint32_t _buckets;
+    uint32_t _samples;
+    uint32_t _empty;
+    double _ms;
+    double _covered_ms;
+    double _charge;
+    double _energy;
+    double _peak;
+    uint64_t _next_us;  // Where the next bucket should start
+    std::vector<Segment> _segments;
+};
+
+// As profile_task(): n buckets of constant current raw (shunt LSBs)
+static void makeRecord(uint16_t seq, uint32_t t_us, uint16_t bus_mv, const int16_t* raw, const uint8_t* marks, int n,
+                       std::vector<uint8_t>& wire) {
+    uint8_t r[HEADER + BUCKET * MAX_BUCKETS + 2];
+    r[0] = 'B';
+    r[1] = 'P';
+    r[2] = VERSION;
+    r[3] = (uint8_t)n;
+    r[4] = (uint8_t)seq;
+    r[5] = (uint8_t)(seq >> 8);
+    r[6] = 1000 & 0xFF;
+    r[7] = 1000 >> 8;
+    for (int i = 0; i < 4; i++) r[8 + i] = (uint8_t)(t_us >> (8 * i));
+    r[12] = (uint8_t)bus_mv;
+    r[13] = (uint8_t)(bus_mv >> 8);
+    r[14] = 500 & 0xFF;
+    r[15] = 500 >> 8;
+    for (int i = 0; i < n; i++) {
+        uint8_t* b = r + HEADER + BUCKET * i;
+        int16_t lo = raw[i] - 4, hi = raw[i] + 4;
+        b[0] = (uint8_t)lo;
+        b[1] = (uint8_t)((uint16_t)lo >> 8);
+        b[2] = (uint8_t)hi;
+        b[3] = (uint8_t)((uint16_t)hi >> 8);
+        b[4] = (uint8_t)raw[i];
+        b[5] = (uint8_t)((uint16_t)raw[i] >> 8);
+        b[6] = 6;
+        b[7] = marks[i];
+    }
+    size_t len = HEADER + BUCKET * n;
+    uint16_t crc = crc16(r, len);
+    r[len] = (uint8_t)crc;
+    r[len + 1] = (uint8_t)(crc >> 8);
+    wire.insert(wire.end(), r, r + len + 2);
+}
+
+static bool near(double a, double b) { return a - b < 1e-6 && b - a < 1e-6; }
+
+static int selftest() {
+    int errors = 0;
+
+    // 20 records of 32 x 1 ms starting just before the 32-bit wrap:
+    // 100 mA (raw 200), with a 10 ms burst of 500 mA marked 4 every
+    // 64 ms; log text between records, record 7 damaged, record 12
+    // missing
+    static const char log[] = "I (1234) BatteryTest: usb=1 bus_mv=7400 BP 1 current_ma=100.0\n";
+    std::vector<uint8_t> wire;
+    std::string expectText;
+    uint32_t t = 0xFFFFFFFFu - 100000u;
+    int64_t expectBuckets = 0;
+    double expectCharge = 0;
+    for (int rec = 0; rec < 20; rec++) {
+        int16_t raw[MAX_BUCKETS];
+        uint8_t marks[MAX_BUCKETS];
+        for (int i = 0; i < MAX_BUCKETS; i++) {
+            int ms = rec * MAX_BUCKETS + i;
+            raw[i] = ms % 64 < 10 ? 1000 : 200;
+            marks[i] = ms % 64 == 0 ? 4 : 0;
+        }
+        std::vector<uint8_t> r;
+        makeRecord((uint16_t)(0xFFF8 + rec), t + rec * MAX_BUCKETS * 1000u, 7400, raw, marks, MAX_BUCKETS, r);
+        if (rec == 7) r[HEADER + 20] ^= 0x01;
+        if (rec != 12) wire.insert(wire.end(), r.begin(), r.end());
+        if (rec != 7 && rec != 12) {
+            expectBuckets += MAX_BUCKETS;
+            for (int i = 0; i < MAX_BUCKETS; i++) expectCharge += raw[i] * 0.5 / 1000.0;
+        }
+        wire.insert(wire.end(), log, log + sizeof(log) - 1);
+        expectText += log;
+        if (rec == 7) {
+            // The damaged record's bytes come out as text; skip them
+            expectText.insert(expectText.size() - (sizeof(log) - 1), (const char*)r.data(), r.size());
+        }
+    }
+
+    std::vector<Bucket> buckets;
+    std::string text;
+    Summary summary;
+    auto decoder = makeDecoder(
+        [&](const Bucket& b) {
+            buckets.push_back(b);
+            summary.add(b);
+        },
+        [&](const uint8_t* p, size_t len) { text.append((const char*)p, len); });
+    // Fed in odd-sized pieces: records split across reads
+    for (size_t i = 0; i < wire.size(); i += 37) {
+        decoder.feed(wire.data() + i, wire.size() - i < 37 ? wire.size() - i : 37);
+    }
+    decoder.finish();
+    summary.finish();
+
+    printf("selftest: %u records, %u dropped, %u bad, %u buckets\n", (unsigned)decoder.records(),
+           (unsigned)decoder.dropped(), (unsigned)decoder.bad(), (unsigned)buckets.size());
+    if (decoder.records() != 18 || decoder.dropped() != 2 || decoder.bad() != 1 ||
+        (int64_t)buckets.size() != expectBuckets) {
+        errors++;
+    }
+    if (text != expectText) {
+        printf("selftest: text around the records differs\n");
+        errors++;
+    }
+
+    // Across the wrap: record 19 starts 19 * 32 ms after the first
+    double lastMs = buckets.empty() ? 0 : buckets.back().t_us / 1000.0;
+    printf("selftest: last bucket at %.3f ms, %.6f C, %.6f J, peak %.1f mA\n", lastMs, summary.chargeMc() / 1000.0,
+           summary.energyMj() / 1000.0, summary.peakMa());
+    if (!near(lastMs, 19 * 32 + 31) || !near(summary.chargeMc(), expectCharge) ||
+        !near(summary.energyMj(), expectCharge * 7.4) || !near(summary.peakMa(), 502.0)) {
+        errors++;
+    }
+
+    // Segments from each mark to the next: 64 ms, 10 ms of 500 mA and
+    // 54 ms of 100 mA. Record 12 took the mark at 384 ms with it; the
+    // segments at 192 and 320 ms span the lost records
+    const std::vector<Summary::Segment>& segs = summary.segments();
+    int full = 0, gaps = 0;
+    for (size_t i = 0; i < segs.size(); i++) {
+        if (segs[i].gap) gaps++;
+        else if (near(segs[i].ms, 64) && near(segs[i].charge_mc, 10 * 0.5 + 54 * 0.1)) full++;
+    }
+    printf("selftest: %u segments, %d of 64 ms with %.1f mC, %d incomplete\n", (unsigned)segs.size(), full,
+           10 * 0.5 + 54 * 0.1, gaps);
+    if (segs.size() != 9 || full != 7 || gaps != 2) errors++;
+
+    // The same kind of stream through a console that sends "\n" as
+    // "\r\n": 10 buckets (n = 0x0A) of raw 10 (0x000A), a 0x0A in each
+    // stamp and sequence number, a genuine "\r\n" in record 2
+    std::vector<uint8_t> sent, crlfWire;
+    std::string crlfText;
+    for (int rec = 0; rec < 4; rec++) {
+        int16_t raw[10];
+        uint8_t marks[10] = {};
+        for (int i = 0; i < 10; i++) raw[i] = 10;
+        if (rec == 2) raw[3] = 0x0A0D;
+        makeRecord((uint16_t)(0x0A0A + rec), 0x0A0A0A00u + rec * 10000u, 3850, raw, marks, 10, sent);
+        static const char line[] = "I (99) BatteryTest: frame\n";
+        sent.insert(sent.end(), line, line + sizeof(line) - 1);
+        crlfText += "I (99) BatteryTest: frame\r\n";
+    }
+    for (size_t i = 0; i < sent.size(); i++) {
+        if (sent[i] == '\n') crlfWire.push_back('\r');
+        crlfWire.push_back(sent[i]);
+    }
+    std::vector<Bucket> crlfBuckets;
+    text.clear();
+    auto crlfDecoder = makeDecoder([&](const Bucket& b) { crlfBuckets.push_back(b); },
+                                   [&](const uint8_t* p, size_t len) { text.append((const char*)p, len); });
+    for (size_t i = 0; i < crlfWire.size(); i += 5) {
+        crlfDecoder.feed(crlfWire.data() + i, crlfWire.size() - i < 5 ? crlfWire.size() - i : 5);
+    }
+    crlfDecoder.finish();
+    printf("selftest: CRLF console, %u records (%u expanded), %u bad, %u buckets\n", (unsigned)crlfDecoder.records(),
+           (unsigned)crlfDecoder.crlfRecords(), (unsigned)crlfDecoder.bad(), (unsigned)crlfBuckets.size());
+    if (crlfDecoder.records() != 4 || crlfDecoder.crlfRecords() != 4 || crlfDecoder.dropped() != 0 ||
+        crlfDecoder.bad() != 0 || crlfBuckets.size() != 40 || !near(crlfBuckets[0].mean_ma, 5.0) ||
+        !near(crlfBuckets[23].mean_ma, 0x0A0D * 0.5) || !near(crlfBuckets.back().t_us / 1000.0, 3 * 10 + 9)) {
+        errors++;
+    }
+    if (text != crlfText) {
+        printf("selftest: text around the CRLF records differs\n");
+        errors++;
+    }
+
+    printf(errors ? "selftest FAILED\n" : "selftest passed\n");
+    return errors ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    bool all = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--selftest")) return selftest();
+        if (!strcmp(argv[i], "--segments")) all = true;
+    }
+
+    // No SA_RESTART: Ctrl-C ends the blocking read and prints the summary
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    Summary summary;
+    printf("t_ms,min_ma,mean_ma,max_ma,bus_mv,samples,mark\n");
+    auto decoder = makeDecoder(
+        [&](const Bucket& b) {
+            printf("%.3f,%.1f,%.1f,%.1f,%d,%d,%d\n", b.t_us / 1000.0, b.min_ma, b.mean_ma, b.max_ma, b.bus_mv,
+                   b.samples, b.mark);
+            summary.add(b);
+        },
+        [&](const uint8_t* p, size_t len) { fwrite(p, 1, len, stderr); });
+    uint8_t chunk[4096];
+    size_t n;
+    while (!stop_requested && (n = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+        decoder.feed(chunk, n);
+        fflush(stdout);
+    }
+    decoder.finish();
+    summary.finish();
+
+    fflush(stdout);
+    summary.print(stderr, all);
+    fprintf(stderr, "[profile] %u records, %u dropped, %u bad\n", (unsigned)decoder.records(),
+            (unsigned)decoder.dropped(), (unsigned)decoder.bad());
+    if (decoder.crlfRecords() > 0) {
+        fprintf(stderr, "[profile] %u records had \"\\n\" sent as \"\\r\\n\" by the console\n",
+                (unsigned)decoder.crlfRecords());
+    }
+    return 0;
+}
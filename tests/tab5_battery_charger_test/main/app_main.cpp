@@ -10,6 +10,9 @@
 #include "esp_lcd_panel_ops.h"
 #include "esp_heap_caps.h"
 #include "battery_monitor.h"
+#include "sdkconfig.h"
+#include "driver/uart_vfs.h"
+#include "driver/usb_serial_jtag_vfs.h"
 
 static const char *TAG = "BatteryTest";
 
@@ -17,6 +20,17 @@ static const char *TAG = "BatteryTest";
 static bsp_lcd_handles_t lcd_handles;
 static esp_lcd_panel_handle_t panel_handle = NULL;
 
+// Power profiling: stream INA226 records (1 ms buckets) to the console for
+// host/profile_decode.cpp. Marks tag the events below in the timeline.
+#define POWER_PROFILE 0
+
+#define MARK_DISPLAY_INIT 1
+#define MARK_DISPLAY_ON   2
+#define MARK_BACKLIGHT    3
+#define MARK_FRAME        4  // update_display() starts drawing
+#define MARK_USB_CHANGE   5
+#define MARK_CHARGE_CHANGE 6
+
 // Tab5 display dimensions (portrait: 720×1280, rotated to landscape: 1280×720)
 #define DISPLAY_PHYSICAL_WIDTH   720
 #define DISPLAY_PHYSICAL_HEIGHT  1280
@@ -369,6 +383,28 @@ static void update_display(battery_status_t* status, float current_ma, bool usb_
                               DISPLAY_PHYSICAL_WIDTH, DISPLAY_PHYSICAL_HEIGHT, framebuffer);
 }
 
+#if POWER_PROFILE
+// Profiler writer task: binary records interleaved with the log text
+static void profile_to_console(const uint8_t *record, size_t len, void *ctx)
+{
+    fwrite(record, 1, len, stdout);
+    fflush(stdout);
+}
+
+// The console VFS sends "\n" as "\r\n" by default, which would also
+// rewrite every 0x0A inside a record. Log lines end in "\n" alone while
+// profiling.
+static void profile_console_raw(void)
+{
+#if CONFIG_ESP_CONSOLE_UART
+    uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+#endif
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG || CONFIG_ESP_CONSOLE_SECONDARY_USB_SERIAL_JTAG
+    usb_serial_jtag_vfs_set_tx_line_endings(ESP_LINE_ENDINGS_LF);
+#endif
+}
+#endif
+
 extern "C" void app_main(void)
 {
     ESP_LOGI(TAG, "========================================");
@@ -420,8 +456,19 @@ extern "C" void app_main(void)
     }
     ESP_LOGI(TAG, "Battery monitor initialized");
     
+#if POWER_PROFILE
+    battery_profile_config_t profile_config = BATTERY_PROFILE_CONFIG_DEFAULT();
+    profile_config.sink = profile_to_console;
+    profile_console_raw();
+    ret = battery_monitor_profile_start(&profile_config);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Power profiling not started: %s", esp_err_to_name(ret));
+    }
+#endif
+    
     // Initialize display
     ESP_LOGI(TAG, "Initializing display...");
+    battery_monitor_profile_mark(MARK_DISPLAY_INIT);
     bsp_display_config_t display_config = {};
     ret = bsp_display_new_with_handles_to_st7123(&display_config, &lcd_handles);
     
@@ -451,6 +498,7 @@ extern "C" void app_main(void)
     
     // Turn on display
     ESP_LOGI(TAG, "Turning on display...");
+    battery_monitor_profile_mark(MARK_DISPLAY_ON);
     ret = esp_lcd_panel_disp_on_off(panel_handle, true);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to turn on display: %s", esp_err_to_name(ret));
@@ -465,6 +513,7 @@ extern "C" void app_main(void)
         ESP_LOGW(TAG, "Brightness init failed: %s", esp_err_to_name(ret));
     } else {
         ESP_LOGI(TAG, "Brightness initialized");
+        battery_monitor_profile_mark(MARK_BACKLIGHT);
         bsp_display_brightness_set(80);  // 80% brightness
         ESP_LOGI(TAG, "Brightness set to 80%%");
     }
@@ -485,6 +534,8 @@ extern "C" void app_main(void)
     ESP_LOGI(TAG, "Starting battery test loop...");
     
     uint32_t update_count = 0;
+    bool last_usb_present = false;
+    bool last_is_charging = false;
     while (1) {
         update_count++;
         
@@ -497,18 +548,10 @@ extern "C" void app_main(void)
         ret = battery_monitor_read(&status);
         
         if (ret == ESP_OK) {
-            // Read current directly from shunt (more reliable)
-            float current_ma = 0.0f;
-            int shunt_uv = 0;
-            esp_err_t current_err = battery_monitor_get_current_ma(&current_ma);
-            esp_err_t shunt_err = battery_monitor_get_shunt_voltage_uv(&shunt_uv);
-            
-            if (current_err != ESP_OK || shunt_err != ESP_OK) {
-                ESP_LOGW(TAG, "Failed to read shunt/current: shunt=%s current=%s", 
-                         esp_err_to_name(shunt_err), esp_err_to_name(current_err));
-                current_ma = 0.0f;
-                shunt_uv = 0;
-            }
+            // Current and shunt voltage come from the same INA226 sample as
+            // the voltage (the monitor's sampling task; no I2C here)
+            float current_ma = status.current_ma;
+            int shunt_uv = status.shunt_uv;
             
             // Check USB-C presence (using charging status - simpler and more reliable)
             bool usb_present = detect_usb_present(status.voltage_mv, current_ma, status.is_charging);
@@ -516,7 +559,17 @@ extern "C" void app_main(void)
             // Use battery_present from status (determined by voltage classification voting in battery_monitor)
             bool battery_present = status.battery_present;
             
+            if (update_count > 1 && usb_present != last_usb_present) {
+                battery_monitor_profile_mark(MARK_USB_CHANGE);
+            }
+            if (update_count > 1 && status.is_charging != last_is_charging) {
+                battery_monitor_profile_mark(MARK_CHARGE_CHANGE);
+            }
+            last_usb_present = usb_present;
+            last_is_charging = status.is_charging;
+            
             // Update display
+            battery_monitor_profile_mark(MARK_FRAME);
             update_display(&status, current_ma, usb_present, battery_present);
             
             // Log in simple format: usb=0/1 bus_mv=... shunt_uv=... current_ma=...
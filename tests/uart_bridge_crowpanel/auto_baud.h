@@ -0,0 +1,149 @@
+/*
+ * Baud rate search for the CrowPanel link
+ *
+ * The ESP32-S3 UART has no auto-baud support in the Arduino core, so the
+ * bridge tries candidate rates instead. While searching, received bytes
+ * go to a tap (not to USB) and each candidate is judged on a sample:
+ * - any framing errors, or mostly non-text bytes -> next candidate
+ * - SAMPLE_BYTES of clean text (ESP_LOG output is printable ASCII plus
+ *   CR/LF and ANSI color escapes) -> locked; the sample is forwarded
+ * A silent line keeps the current candidate: there is nothing to judge.
+ *
+ * Once locked, a burst of framing errors (the target rebooted into its
+ * bootloader, or changed speed) starts a new search. A rate set with
+ * fix() - from the host's CDC line coding - is never searched away from.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "uart_bridge.h"
+
+class AutoBaud {
+public:
+    enum State { FIXED, SEARCHING, LOCKED };
+
+    static constexpr int SAMPLE_BYTES = 64;
+    static constexpr int BAD_ERRORS = 2;         // Framing errors that reject a candidate
+    static constexpr uint8_t MIN_TEXT_PCT = 90;  // Text bytes in a good sample
+    static constexpr uint32_t SETTLE_MS = 5;     // Ignore bytes right after a rate change
+    static constexpr uint32_t RELOCK_ERRORS = 8; // Framing errors per check while locked
+    static constexpr uint32_t RELOCK_CHECK_MS = 1000;
+
+    AutoBaud(UartBridge& bridge)
+        : _bridge(bridge), _state(FIXED), _index(0), _tried(0), _switchMs(0),
+          _checkMs(0), _checkErrors(0), _errorBase(0), _count(0), _text(0), _searches(0) {}
+
+    // Try the current rate first, then the rest of the list
+    void search() {
+        _bridge.setRxTap(tapEntry, this);
+        _state = SEARCHING;
+        _tried = 0;
+        _searches++;
+        _index = indexOf(_bridge.baud());
+        tryCandidate();
+    }
+
+    // Host-chosen rate: stop searching and stay on it
+    void fix(uint32_t baud) {
+        _bridge.setBaud(baud);
+        _bridge.setRxTap(nullptr, nullptr);
+        _state = FIXED;
+    }
+
+    // Call from loop()
+    void service(uint32_t nowMs) {
+        if (_state == SEARCHING) {
+            uint32_t errors = _bridge.stats().frameErrors - _errorBase;
+            if ((int)errors >= BAD_ERRORS) {
+                next();
+            } else if (_count >= SAMPLE_BYTES) {
+                if (_text * 100 >= (uint32_t)_count * MIN_TEXT_PCT) lock();
+                else next();
+            }
+        } else if (_state == LOCKED && nowMs - _checkMs >= RELOCK_CHECK_MS) {
+            uint32_t errors = _bridge.stats().frameErrors;
+            if (errors - _checkErrors >= RELOCK_ERRORS) search();
+            _checkErrors = errors;
+            _checkMs = nowMs;
+        }
+    }
+
+    State state() const { return _state; }
+    uint32_t searches() const { return _searches; }
+    // Rates tried in the current search (a full pass starts over)
+    int tried() const { return _tried; }
+
+private:
+    static const uint32_t* candidates(int* count) {
+        // Most likely first: ESP-IDF default, then the usual fast rates
+        static const uint32_t list[] = {115200, 921600, 2000000, 1500000, 460800,
+                                        230400, 3000000, 57600, 1000000, 500000,
+                                        250000, 38400, 19200, 9600};
+        *count = sizeof(list) / sizeof(list[0]);
+        return list;
+    }
+
+    static int indexOf(uint32_t baud) {
+        int n;
+        const uint32_t* list = candidates(&n);
+        for (int i = 0; i < n; i++) {
+            if (list[i] == baud) return i;
+        }
+        return 0;
+    }
+
+    void next() {
+        int n;
+        candidates(&n);
+        _index = (_index + 1) % n;
+        _tried++;
+        tryCandidate();
+    }
+
+    void tryCandidate() {
+        int n;
+        const uint32_t* list = candidates(&n);
+        _switchMs = millis();  // First: the tap ignores bytes from here on
+        _count = 0;
+        _text = 0;
+        _bridge.setBaud(list[_index]);
+        _errorBase = _bridge.stats().frameErrors;
+    }
+
+    void lock() {
+        _bridge.injectRx(_sample, _count);  // Before the tap goes: one processor caller
+        _bridge.setRxTap(nullptr, nullptr);
+        _state = LOCKED;
+        _checkMs = millis();
+        _checkErrors = _bridge.stats().frameErrors;
+    }
+
+    static bool isText(uint8_t c) {
+        return (c >= 0x20 && c < 0x7F) || c == '\r' || c == '\n' || c == '\t' || c == 0x1B;
+    }
+
+    // UART event task
+    static void tapEntry(const uint8_t* data, size_t len, void* ctx) {
+        AutoBaud* self = (AutoBaud*)ctx;
+        if (millis() - self->_switchMs < SETTLE_MS) return;
+        for (size_t i = 0; i < len && self->_count < SAMPLE_BYTES; i++) {
+            self->_sample[self->_count] = data[i];
+            if (isText(data[i])) self->_text++;
+            self->_count++;
+        }
+    }
+
+    UartBridge& _bridge;
+    volatile State _state;
+    int _index;
+    int _tried;
+    volatile uint32_t _switchMs;
+    uint32_t _checkMs;
+    uint32_t _checkErrors;
+    uint32_t _errorBase;
+    volatile int _count;         // Sample bytes so far
+    volatile uint32_t _text;     // Of which text
+    uint8_t _sample[SAMPLE_BYTES];
+    uint32_t _searches;
+};
@@ -0,0 +1,106 @@
+/*
+ * Single-producer/single-consumer byte ring with block access
+ *
+ * Producer and consumer work on contiguous spans instead of single
+ * bytes: writeSpan() returns where the next bytes can go (up to the end
+ * of the buffer), commit() publishes them; readSpan()/consume() do the
+ * same on the other side. A driver read or a USB write can then go
+ * straight to/from the ring without a bounce buffer.
+ *
+ * One task may produce and one may consume concurrently. The buffer is
+ * allocated in begin() (size rounded down to a power of two).
+ * Arduino-free, so host tools can use it too.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+class ByteRing {
+public:
+    ByteRing() : _buf(nullptr), _size(0), _mask(0), _head(0), _tail(0), _dropped(0), _peak(0) {}
+
+    bool begin(uint32_t size) {
+        while (size & (size - 1)) size &= size - 1;  // Round down to a power of two
+        _buf = (uint8_t*)malloc(size);
+        if (!_buf) return false;
+        _size = size;
+        _mask = size - 1;
+        return true;
+    }
+
+    uint32_t capacity() const { return _size; }
+    uint32_t used() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+    uint32_t space() const { return _size - used(); }
+
+    // --- Producer ---
+
+    // Contiguous free space; *len = 0 when full
+    uint8_t* writeSpan(uint32_t* len) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t free = _size - (head - _tail.load(std::memory_order_acquire));
+        uint32_t toEnd = _size - (head & _mask);
+        *len = free < toEnd ? free : toEnd;
+        return _buf + (head & _mask);
+    }
+
+    void commit(uint32_t len) {
+        uint32_t head = _head.load(std::memory_order_relaxed) + len;
+        _head.store(head, std::memory_order_release);
+        uint32_t fill = head - _tail.load(std::memory_order_relaxed);
+        if (fill > _peak) _peak = fill;
+    }
+
+    // Copy in as much as fits; the rest is counted as dropped
+    uint32_t write(const uint8_t* data, uint32_t len) {
+        uint32_t done = 0;
+        while (done < len) {
+            uint32_t span;
+            uint8_t* p = writeSpan(&span);
+            if (span == 0) break;
+            if (span > len - done) span = len - done;
+            memcpy(p, data + done, span);
+            commit(span);
+            done += span;
+        }
+        drop(len - done);
+        return done;
+    }
+
+    void drop(uint32_t len) { _dropped += len; }
+
+    // --- Consumer ---
+
+    // Contiguous readable bytes; *len = 0 when empty
+    const uint8_t* readSpan(uint32_t* len) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t avail = _head.load(std::memory_order_acquire) - tail;
+        uint32_t toEnd = _size - (tail & _mask);
+        *len = avail < toEnd ? avail : toEnd;
+        return _buf + (tail & _mask);
+    }
+
+    void consume(uint32_t len) {
+        _tail.store(_tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+    // --- Stats (producer side) ---
+
+    uint32_t dropped() const { return _dropped; }  // Bytes lost, ring full
+    uint32_t peak() const { return _peak; }        // Highest fill seen
+    void resetPeak() { _peak = used(); }
+
+private:
+    uint8_t* _buf;
+    uint32_t _size;
+    uint32_t _mask;
+    std::atomic<uint32_t> _head;  // Free-running
+    std::atomic<uint32_t> _tail;  // Free-running
+    volatile uint32_t _dropped;
+    volatile uint32_t _peak;
+};
@@ -0,0 +1,49 @@
+/*
+ * Byte-stream interfaces between the bridge core and its ports
+ *
+ * UartBridge only moves bytes between a UartStream (the target's UART)
+ * and a ByteStream (USB), so the same forwarding code runs on the
+ * Cardputer (serial_streams.h: HardwareSerial and the USB Serial) and on
+ * a PC (host/bridge_harness.cpp: Linux pseudo-terminals).
+ *
+ * Arduino-free, like log_codec.h.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class ByteStream {
+public:
+    virtual ~ByteStream() {}
+
+    // Never block: return what can be done now
+    virtual int available() = 0;
+    virtual size_t read(uint8_t* buf, size_t len) = 0;
+    virtual int availableForWrite() = 0;
+    virtual size_t write(const uint8_t* data, size_t len) = 0;
+};
+
+// What the UART driver reports besides data
+enum LineError { LINE_FIFO_OVERFLOW, LINE_BUFFER_FULL, LINE_FRAME_ERROR, LINE_PARITY_ERROR, LINE_BREAK, LINE_OTHER };
+
+class UartStream : public ByteStream {
+public:
+    struct Setup {
+        uint32_t baud;
+        int8_t rxPin;
+        int8_t txPin;
+        uint32_t rxBuffer;  // Driver buffers (bytes)
+        uint32_t txBuffer;
+        uint8_t fifoFull;   // RX event thresholds: bytes in the FIFO, idle symbols
+        uint8_t rxTimeout;
+    };
+    typedef void (*DataFn)(void* ctx);
+    typedef void (*ErrorFn)(LineError err, void* ctx);
+
+    // onData is called from the driver's event task when bytes arrive,
+    // onError for driver and line errors
+    virtual void begin(const Setup& setup, DataFn onData, ErrorFn onError, void* ctx) = 0;
+    virtual void setBaud(uint32_t baud) = 0;
+};
@@ -0,0 +1,145 @@
+/*
+ * Channel-tagged frames for bridging several UARTs into one USB stream
+ *
+ * Each port has its own UartBridge (ring, stats). Its processor hands
+ * the bytes it keeps to a ChannelFramer in the UART event task, which
+ * cuts them into frames stamped with the port number and the RX time:
+ *
+ *   COBS(port | t_us (u32 LE, esp_timer) | data (<= CHUNK_MAX) | CRC-16) 0x00
+ *
+ * A frame goes into the port's ring whole or not at all. ChannelMux
+ * empties the rings to USB from loop() (UartBridge::setRxDrain()). Once
+ * it has started writing a frame it finishes that frame before it
+ * serves another port, so frames never interleave.
+ *
+ * host/demux.cpp splits the stream back into one file per port, with
+ * timestamps on a common time base. COBS, CRC and the "text outside
+ * frames" convention are shared with the compressed transport
+ * (log_codec.h).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "byte_ring.h"
+#include "byte_stream.h"
+#include "log_codec.h"
+
+namespace channel {
+static constexpr int CHUNK_MAX = 240;  // Data bytes per frame
+static constexpr int HEADER = 5;       // port, t_us
+static constexpr int FRAME_BYTES = HEADER + CHUNK_MAX + 2;
+static constexpr int WIRE_MAX = FRAME_BYTES + FRAME_BYTES / 254 + 2;
+}  // namespace channel
+
+class ChannelFramer {
+public:
+    static constexpr uint32_t STAGE_SIZE = 2048;
+
+    explicit ChannelFramer(uint8_t port) : _port(port), _frames(0), _dropped(0) {}
+
+    bool begin() { return _stage.begin(STAGE_SIZE); }
+
+    // --- UART event task ---
+
+    // For a processor that writes to a ByteRing (the log filter)
+    ByteRing& input() { return _stage; }
+
+    // Frame everything staged
+    void flush(ByteRing& out) {
+        for (;;) {
+            uint32_t span;
+            const uint8_t* p = _stage.readSpan(&span);
+            if (span == 0) return;
+            frame(p, span, out);
+            _stage.consume(span);
+        }
+    }
+
+    // Frame data stamped with the current time
+    void frame(const uint8_t* data, size_t len, ByteRing& out) {
+        uint32_t t = (uint32_t)esp_timer_get_time();
+        while (len > 0) {
+            size_t n = len < (size_t)channel::CHUNK_MAX ? len : (size_t)channel::CHUNK_MAX;
+            uint8_t raw[channel::FRAME_BYTES];
+            raw[0] = _port;
+            memcpy(raw + 1, &t, 4);  // Little-endian on the ESP32
+            memcpy(raw + channel::HEADER, data, n);
+            uint16_t crc = logcodec::crc16(raw, channel::HEADER + n);
+            raw[channel::HEADER + n] = (uint8_t)crc;
+            raw[channel::HEADER + n + 1] = (uint8_t)(crc >> 8);
+
+            uint8_t wire[channel::WIRE_MAX];
+            size_t w = logcodec::cobsEncode(raw, channel::HEADER + n + 2, wire);
+            wire[w++] = 0;
+            if (out.space() >= w) {
+                out.write(wire, w);
+                _frames++;
+            } else {
+                out.drop(n);  // Whole frame or nothing: counted as ring loss
+                _dropped++;
+            }
+            data += n;
+            len -= n;
+        }
+    }
+
+    uint32_t frames() const { return _frames; }
+    uint32_t droppedFrames() const { return _dropped; }
+
+private:
+    uint8_t _port;
+    ByteRing _stage;
+    volatile uint32_t _frames;
+    volatile uint32_t _dropped;
+};
+
+class ChannelMux {
+public:
+    static constexpr int NO_PORT = -1;
+
+    ChannelMux(ByteStream& usb, uint16_t chunk) : _usb(usb), _chunk(chunk), _owner(NO_PORT), _stalls(0) {}
+
+    // Ends any text already sent, so the first frame stands alone
+    void begin() {
+        uint8_t delimiter = 0;
+        _usb.write(&delimiter, 1);
+    }
+
+    // Loop task, for each port's UartBridge::setRxDrain(); returns the
+    // bytes written to USB
+    size_t drain(ByteRing& ring, int port) {
+        if (_owner != NO_PORT && _owner != port) return 0;  // Another port is mid-frame
+        size_t total = 0;
+        for (;;) {
+            uint32_t span;
+            const uint8_t* p = ring.readSpan(&span);
+            if (span == 0) break;
+            int room = _usb.availableForWrite();
+            if (room <= 0) {
+                _stalls++;
+                break;
+            }
+            uint32_t n = min(span, (uint32_t)min(room, (int)_chunk));
+            size_t written = _usb.write(p, n);
+            ring.consume(written);
+            total += written;
+            if (written == 0) break;
+            // Mid-frame until a delimiter is the last byte written
+            _owner = p[written - 1] == 0 ? NO_PORT : port;
+            if (written < n) break;
+        }
+        return total;
+    }
+
+    // Between frames: safe to write text (bridge replies) to USB
+    bool idle() const { return _owner == NO_PORT; }
+    uint32_t stalls() const { return _stalls; }
+
+private:
+    ByteStream& _usb;
+    uint16_t _chunk;
+    int _owner;  // Port whose frame is partly written
+    uint32_t _stalls;
+};
@@ -0,0 +1,404 @@
+/*
+ * Loopback and throughput harness for the bridge core (uart_bridge.h)
+ *
+ * Build and run on Linux:
+ *   g++ -O2 -std=c++11 -pthread -I.. -o bridge_harness bridge_harness.cpp
+ *   ./bridge_harness                              # synthetic log, 921600 baud
+ *   ./bridge_harness --log crowpanel.log --baud 2000000 --burst 8192,20
+ *   ./bridge_harness --usb-rate 50000             # host reads slower than the line
+ *
+ * The firmware's UartBridge runs unchanged between two pseudo-terminals:
+ *
+ *   replay -> pty A -> [event thread] UartBridge [loop thread] -> pty B -> reader
+ *
+ * The replay thread writes the log into pty A at the line rate of the
+ * chosen baud (10 bits per byte), optionally in bursts of BYTES followed
+ * by GAP_MS of silence. An event thread plays the UART driver's event
+ * task (onReceive) and the main thread plays loop(), calling service().
+ * The reader drains pty B, at most --usb-rate bytes/s if given.
+ *
+ * At the end the received stream is aligned with what was sent:
+ * - lost: sent bytes that never arrived (should equal the bridge's own
+ *   ring-full count, Drop)
+ * - reordered: bytes that arrived after later ones
+ * - corrupt: bytes that match nothing that was sent
+ * plus throughput and the latency of each line (replay write of its
+ * '\n' to the reader's read of it) as percentiles.
+ *
+ * Exits 1 on reordered or corrupt bytes, or losses the bridge did not
+ * count; with --no-loss, on any loss.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "uart_bridge.h"
+
+static uint64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Pseudo-terminal pair: the bridge uses the master, a harness thread the
+// slave; both raw, so no byte is translated
+struct Pty {
+    int master = -1;
+    int slave = -1;
+
+    bool open() {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) || unlockpt(master)) return false;
+        slave = ::open(ptsname(master), O_RDWR | O_NOCTTY);
+        if (slave < 0) return false;
+        struct termios t;
+        tcgetattr(slave, &t);
+        cfmakeraw(&t);
+        tcsetattr(slave, TCSANOW, &t);
+        fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+        return true;
+    }
+};
+
+static int ptyAvailable(int fd) {
+    int n = 0;
+    return ioctl(fd, FIONREAD, &n) == 0 ? n : 0;
+}
+
+static size_t ptyRead(int fd, uint8_t* buf, size_t len) {
+    ssize_t n = ::read(fd, buf, len);
+    return n > 0 ? (size_t)n : 0;
+}
+
+// Like the CDC TX buffer: availableForWrite() offers a fixed amount, the
+// kernel takes what fits and write() says how much
+static const int PTY_WRITE_ROOM = 4096;
+
+static size_t ptyWrite(int fd, const uint8_t* data, size_t len) {
+    ssize_t n = ::write(fd, data, len);
+    return n > 0 ? (size_t)n : 0;
+}
+
+// The USB side: a non-blocking pty master
+class PtyPort : public ByteStream {
+public:
+    explicit PtyPort(int fd) : _fd(fd) {}
+
+    int available() override { return ptyAvailable(_fd); }
+    size_t read(uint8_t* buf, size_t len) override { return ptyRead(_fd, buf, len); }
+    int availableForWrite() override { return PTY_WRITE_ROOM; }
+    size_t write(const uint8_t* data, size_t len) override { return ptyWrite(_fd, data, len); }
+
+private:
+    int _fd;
+};
+
+// The UART side: an event thread calls onData when bytes are waiting,
+// as the driver's event task does after a FIFO threshold or line idle
+class PtyUart : public UartStream {
+public:
+    explicit PtyUart(int fd) : _fd(fd), _running(false) {}
+    ~PtyUart() { stop(); }
+
+    void begin(const Setup&, DataFn onData, ErrorFn, void* ctx) override {
+        _running = true;
+        _thread = std::thread([this, onData, ctx]() {
+            struct pollfd p = {_fd, POLLIN, 0};
+            while (_running) {
+                if (poll(&p, 1, 10) > 0 && (p.revents & POLLIN)) onData(ctx);
+            }
+        });
+    }
+    void setBaud(uint32_t) override {}  // The replay thread sets the pace
+
+    void stop() {
+        _running = false;
+        if (_thread.joinable()) _thread.join();
+    }
+
+    int available() override { return ptyAvailable(_fd); }
+    size_t read(uint8_t* buf, size_t len) override { return ptyRead(_fd, buf, len); }
+    int availableForWrite() override { return PTY_WRITE_ROOM; }
+    size_t write(const uint8_t* data, size_t len) override { return ptyWrite(_fd, data, len); }
+
+private:
+    int _fd;
+    std::atomic<bool> _running;
+    std::thread _thread;
+};
+
+// Offset reached at a time: one entry per write (replay) or read (reader)
+struct Mark {
+    uint64_t end;
+    uint64_t us;
+};
+
+static uint64_t timeOf(const std::vector<Mark>& marks, uint64_t offset) {
+    auto it = std::upper_bound(marks.begin(), marks.end(), offset,
+                               [](uint64_t off, const Mark& m) { return off < m.end; });
+    return it == marks.end() ? marks.back().us : it->us;
+}
+
+struct Options {
+    const char* log = nullptr;
+    int repeat = 1;
+    uint32_t baud = 921600;
+    uint32_t burstBytes = 0;  // 0: continuous
+    uint32_t burstGapMs = 0;
+    uint32_t usbRate = 0;     // Reader bytes/s, 0: as fast as it can
+    uint32_t rxRing = 0;      // 0: the firmware default
+    uint32_t loopUs = 100;
+    bool noLoss = false;
+};
+
+static std::string syntheticLog(size_t bytes) {
+    static const char* const tags[] = {"wifi", "esp_netif", "lvgl", "app_main", "heap", "touch"};
+    static const char* const colors[] = {"\033[0;31mE", "\033[0;33mW", "\033[0;32mI", "D"};
+    std::string log;
+    uint32_t ticks = 1000;
+    srand(1);
+    while (log.size() < bytes) {
+        char line[160];
+        int l = rand() % 100 < 70 ? 2 : rand() % 4;
+        ticks += rand() % 50;
+        snprintf(line, sizeof(line), "%s (%u) %s: event %d, value %d%s\n", colors[l], (unsigned)ticks,
+                 tags[rand() % 6], rand() % 1000, rand(), l < 3 ? "\033[0m" : "");
+        log += line;
+    }
+    return log;
+}
+
+static bool loadLog(const Options& o, std::string* log) {
+    if (!o.log) {
+        *log = syntheticLog(1 << 20);
+    } else {
+        FILE* f = fopen(o.log, "rb");
+        if (!f) {
+            perror(o.log);
+            return false;
+        }
+        char buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) log->append(buf, n);
+        fclose(f);
+    }
+    std::string one = *log;
+    for (int i = 1; i < o.repeat; i++) *log += one;
+    return !log->empty();
+}
+
+// Line-rate writer with an optional burst/gap profile
+static void replay(int fd, const std::string& log, const Options& o, std::vector<Mark>* marks) {
+    const double bytesPerUs = o.baud / 10.0 / 1e6;
+    size_t sent = 0;
+    uint64_t burstStart = nowUs(), burstSent = 0;
+    while (sent < log.size()) {
+        uint64_t now = nowUs();
+        size_t due = (size_t)((now - burstStart) * bytesPerUs) - burstSent;
+        if (o.burstBytes) due = std::min(due, (size_t)(o.burstBytes - burstSent));
+        due = std::min(due, log.size() - sent);
+        if (due > 0) {
+            uint64_t t = nowUs();  // Before the reader can see the bytes
+            ssize_t n = ::write(fd, log.data() + sent, due);  // Blocks while the pty is full
+            if (n <= 0) break;
+            sent += n;
+            burstSent += n;
+            marks->push_back({sent, t});
+        }
+        if (o.burstBytes && burstSent >= o.burstBytes) {
+            usleep(o.burstGapMs * 1000);
+            burstStart = nowUs();
+            burstSent = 0;
+            continue;
+        }
+        usleep(1000);
+    }
+}
+
+// Drains pty B, paced to usbRate if set; stops once told and idle
+static void reader(int fd, const Options& o, const std::atomic<bool>& done, std::vector<uint8_t>* got,
+                   std::vector<Mark>* marks) {
+    uint8_t buf[4096];
+    uint64_t t0 = nowUs(), idleSince = t0;
+    for (;;) {
+        size_t want = sizeof(buf);
+        if (o.usbRate) {
+            uint64_t allowed = (nowUs() - t0) * o.usbRate / 1000000;
+            if (allowed <= got->size()) {
+                usleep(1000);
+                continue;
+            }
+            want = std::min(want, (size_t)(allowed - got->size()));
+        }
+        struct pollfd p = {fd, POLLIN, 0};
+        if (poll(&p, 1, 20) > 0) {
+            ssize_t n = ::read(fd, buf, want);
+            if (n > 0) {
+                got->insert(got->end(), buf, buf + n);
+                marks->push_back({got->size(), nowUs()});
+                idleSince = nowUs();
+                continue;
+            }
+        }
+        if (done && nowUs() - idleSince > 500000) return;
+    }
+}
+
+struct Alignment {
+    uint64_t lost = 0;
+    uint64_t reordered = 0;
+    uint64_t corrupt = 0;
+    std::vector<uint64_t> lineLatencyUs;
+};
+
+// Walks the received bytes along the sent ones. A mismatch is resolved
+// by finding the next received bytes further on (a gap: lost), earlier
+// (reordered), or nowhere (corrupt).
+static Alignment align(const std::string& sent, const std::vector<uint8_t>& got, const std::vector<Mark>& sendMarks,
+                       const std::vector<Mark>& recvMarks) {
+    static const size_t PROBE = 16;
+    Alignment a;
+    size_t s = 0;
+    for (size_t i = 0; i < got.size();) {
+        if (s < sent.size() && got[i] == (uint8_t)sent[s]) {
+            if (got[i] == '\n') {
+                uint64_t sentUs = timeOf(sendMarks, s), recvUs = timeOf(recvMarks, i);
+                a.lineLatencyUs.push_back(recvUs > sentUs ? recvUs - sentUs : 0);
+            }
+            i++;
+            s++;
+            continue;
+        }
+        size_t k = std::min(PROBE, got.size() - i);
+        const char* probe = (const char*)&got[i];
+        const char* ahead =
+            s < sent.size() ? (const char*)memmem(sent.data() + s, sent.size() - s, probe, k) : nullptr;
+        if (ahead) {
+            a.lost += ahead - (sent.data() + s);
+            s = ahead - sent.data();
+            continue;
+        }
+        const char* behind = (const char*)memmem(sent.data(), s, probe, k);
+        if (behind) {
+            a.reordered += k;
+            i += k;
+        } else {
+            a.corrupt++;
+            i++;
+        }
+    }
+    a.lost += sent.size() - std::min(s, sent.size());
+    return a;
+}
+
+static uint64_t percentile(std::vector<uint64_t>& v, double p) {
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, (size_t)(p / 100.0 * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static bool parseArgs(int argc, char** argv, Options* o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--no-loss")) {
+            o->noLoss = true;
+            continue;
+        }
+        if (!v) return false;
+        i++;
+        if (!strcmp(a, "--log")) o->log = v;
+        else if (!strcmp(a, "--repeat")) o->repeat = atoi(v);
+        else if (!strcmp(a, "--baud")) o->baud = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--usb-rate")) o->usbRate = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--ring")) o->rxRing = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--loop-us")) o->loopUs = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--burst")) {
+            if (sscanf(v, "%u,%u", &o->burstBytes, &o->burstGapMs) != 2) return false;
+        } else {
+            return false;
+        }
+    }
+    return o->baud >= 300 && o->repeat >= 1;
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parseArgs(argc, argv, &o)) {
+        fprintf(stderr,
+                "usage: %s [--log FILE] [--repeat N] [--baud N] [--burst BYTES,GAP_MS] [--usb-rate B/s]\n"
+                "          [--ring BYTES] [--loop-us N] [--no-loss]\n",
+                argv[0]);
+        return 2;
+    }
+    std::string log;
+    if (!loadLog(o, &log)) return 2;
+
+    Pty uart, usb;
+    if (!uart.open() || !usb.open()) {
+        perror("pty");
+        return 2;
+    }
+    PtyUart uartPort(uart.master);
+    PtyPort usbPort(usb.master);
+    UartBridge bridge(uartPort, usbPort);
+    UartBridge::Config cfg = UartBridge::defaultConfig(o.baud, -1, -1);
+    if (o.rxRing) cfg.rxRing = o.rxRing;
+    if (!bridge.begin(cfg)) return 2;
+
+    std::vector<Mark> sendMarks, recvMarks;
+    std::vector<uint8_t> got;
+    got.reserve(log.size());
+    std::atomic<bool> sendDone(false), stop(false);
+    uint64_t t0 = nowUs();
+    std::thread readThread(reader, usb.slave, std::cref(o), std::cref(sendDone), &got, &recvMarks);
+    std::thread loopThread([&]() {
+        while (!stop) {
+            bridge.service();
+            if (o.loopUs) usleep(o.loopUs);
+        }
+    });
+    replay(uart.slave, log, o, &sendMarks);
+    uint64_t sendUs = nowUs() - t0;
+    sendDone = true;
+    readThread.join();
+    stop = true;
+    loopThread.join();
+    uartPort.stop();
+
+    UartBridge::Stats s = bridge.stats();
+    Alignment a = align(log, got, sendMarks, recvMarks);
+    uint64_t recvUs = recvMarks.empty() ? 1 : recvMarks.back().us - t0;
+    printf("sent     %zu B in %.2f s (%.0f B/s, line rate %u B/s)\n", log.size(), sendUs / 1e6,
+           log.size() * 1e6 / sendUs, (unsigned)(o.baud / 10));
+    printf("received %zu B in %.2f s (%.0f B/s)\n", got.size(), recvUs / 1e6, got.size() * 1e6 / recvUs);
+    printf("latency  %zu lines: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n", a.lineLatencyUs.size(),
+           percentile(a.lineLatencyUs, 50) / 1e3, percentile(a.lineLatencyUs, 90) / 1e3,
+           percentile(a.lineLatencyUs, 99) / 1e3, percentile(a.lineLatencyUs, 100) / 1e3);
+    printf("errors   lost %llu B, reordered %llu B, corrupt %llu B\n", (unsigned long long)a.lost,
+           (unsigned long long)a.reordered, (unsigned long long)a.corrupt);
+    printf("bridge   %lu RX events, ring peak %lu/%lu B, Drop %lu B, %lu USB stalls\n", (unsigned long)s.rxEvents,
+           (unsigned long)s.ringPeak, (unsigned long)bridge.rxRingSize(), (unsigned long)s.ringDropped,
+           (unsigned long)s.usbStalls);
+
+    bool fail = a.reordered || a.corrupt || a.lost != s.ringDropped || (o.noLoss && a.lost);
+    if (a.lost != s.ringDropped) {
+        printf("FAIL: %llu B lost, the bridge counted %lu\n", (unsigned long long)a.lost,
+               (unsigned long)s.ringDropped);
+    }
+    printf(fail ? "FAILED\n" : "passed\n");
+    return fail ? 1 : 0;
+}
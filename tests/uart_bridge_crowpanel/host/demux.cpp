@@ -0,0 +1,347 @@
+/*
+ * Host side of the bridge's multi-port mode (MULTI_PORT 1)
+ *
+ * Build and run on a PC:
+ *   g++ -O2 -std=c++11 -I.. -o demux demux.cpp
+ *   stty -F /dev/ttyACM0 raw && ./demux < /dev/ttyACM0
+ *   ./demux -d logs < capture.bin
+ *   ./demux --selftest
+ *
+ * Splits the stream of channel-tagged frames (channel_mux.h) on 0x00
+ * and appends each port's data to portN.log, every line prefixed with
+ * the bridge time its first byte arrived, relative to the first frame:
+ *
+ *   [    12.345678] I (1234) wifi: connected
+ *
+ * All ports share the bridge's clock, so the files can be merged by
+ * that prefix. The 32-bit microsecond stamps wrap every 71 minutes;
+ * they are extended from the last stamp seen, so a port whose frames
+ * arrive a little late does not count as a wrap.
+ * Text outside frames (the bridge's "[bridge] ..." replies and the boot
+ * banner) goes to stdout. The report - frames, bytes and lines per port,
+ * bad frames - goes to stderr at the end (EOF or Ctrl-C).
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "log_codec.h"
+
+// Frame layout, as in channel_mux.h (which needs Arduino.h):
+// port | t_us (u32 LE) | data | CRC-16
+static const int HEADER = 5;
+static const int CHUNK_MAX = 240;
+static const int FRAME_BYTES = HEADER + CHUNK_MAX + 2;
+static const int WIRE_MAX = FRAME_BYTES + FRAME_BYTES / 254 + 2;
+static const int PORTS = 256;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void onSignal(int) { stop_requested = 1; }
+
+static bool printable(const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if ((p[i] < 0x20 || p[i] >= 0x7F) && p[i] != '\r' && p[i] != '\n' && p[i] != '\t' && p[i] != 0x1B) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// COBS and CRC check; the decoded frame in frame, its length or 0
+static size_t decodeFrame(const uint8_t* wire, size_t len, uint8_t* frame) {
+    if (len == 0 || len > (size_t)WIRE_MAX) return 0;
+    size_t n = logcodec::cobsDecode(wire, len, frame);
+    if (n < (size_t)HEADER + 2) return 0;
+    if (logcodec::crc16(frame, n - 2) != (uint16_t)(frame[n - 2] | (frame[n - 1] << 8))) return 0;
+    return n;
+}
+
+// Splits the stream on 0x00 and hands out timestamped lines:
+// out(port, text, len), port -1 for text outside frames
+template <typename Out>
+class Demux {
+public:
+    struct PortStats {
+        uint32_t frames;
+        uint32_t bytes;
+        uint32_t lines;
+    };
+
+    explicit Demux(Out out) : _out(out), _badFrames(0), _textBlobs(0), _started(false), _last(0), _now(0), _base(0) {
+        memset(_ports, 0, sizeof(_ports));
+        memset(_stats, 0, sizeof(_stats));
+    }
+
+    void feed(const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            if (data[i] != 0) {
+                if (_blob.size() < 4096) _blob.push_back(data[i]);
+                continue;
+            }
+            if (_blob.empty()) continue;
+            const uint8_t* p = _blob.data();
+            size_t n = _blob.size();
+            uint8_t frame[WIRE_MAX];
+            size_t k = 0;
+            // Text, or text followed by a frame without a 0x00 in between
+            while (k < n && !decodeFrame(p + k, n - k, frame)) k++;
+            if (k > 0 && printable(p, k)) {
+                _out(-1, p, k);
+                _textBlobs++;
+            } else if (k > 0) {
+                _badFrames++;
+            }
+            if (k < n) onFrame(frame, decodeFrame(p + k, n - k, frame));
+            _blob.clear();
+        }
+    }
+
+    // Text at the end of a stream that never got its delimiter
+    void finish() {
+        if (!_blob.empty() && printable(_blob.data(), _blob.size())) {
+            _out(-1, _blob.data(), _blob.size());
+            _textBlobs++;
+        }
+        _blob.clear();
+    }
+
+    const PortStats& stats(int port) const { return _stats[port]; }
+    uint32_t badFrames() const { return _badFrames; }
+    uint32_t textBlobs() const { return _textBlobs; }
+
+private:
+    void onFrame(const uint8_t* frame, size_t n) {
+        int port = frame[0];
+        uint32_t t = frame[1] | (frame[2] << 8) | (frame[3] << 16) | ((uint32_t)frame[4] << 24);
+        uint64_t us = extend(t) - _base;
+        PortStats& s = _stats[port];
+        s.frames++;
+        s.bytes += n - HEADER - 2;
+
+        // Prefix each line whose first byte is in this frame
+        const uint8_t* p = frame + HEADER;
+        const uint8_t* end = frame + n - 2;
+        while (p < end) {
+            if (!_ports[port]) {
+                char ts[32];
+                int len = snprintf(ts, sizeof(ts), "[%6llu.%06llu] ", (unsigned long long)(us / 1000000),
+                                   (unsigned long long)(us % 1000000));
+                _out(port, (const uint8_t*)ts, len);
+                _ports[port] = true;
+                s.lines++;
+            }
+            const uint8_t* nl = (const uint8_t*)memchr(p, '\n', end - p);
+            const uint8_t* stop = nl ? nl + 1 : end;
+            _out(port, p, stop - p);
+            if (nl) _ports[port] = false;
+            p = stop;
+        }
+    }
+
+    // 64-bit time from the 32-bit stamp, relative to the last one seen
+    uint64_t extend(uint32_t t) {
+        if (!_started) {
+            _started = true;
+            _last = t;
+            _now = _base = (uint64_t)t;
+            return _now;
+        }
+        int32_t diff = (int32_t)(t - _last);
+        if (diff < 0) return _now + diff;  // Earlier than the newest: a late port
+        _last = t;
+        _now += (uint32_t)diff;
+        return _now;
+    }
+
+    Out _out;
+    std::vector<uint8_t> _blob;
+    bool _ports[PORTS];  // Mid-line
+    PortStats _stats[PORTS];
+    uint32_t _badFrames;
+    uint32_t _textBlobs;
+    bool _started;
+    uint32_t _last;  // Newest stamp
+    uint64_t _now;   // Newest stamp, extended
+    uint64_t _base;  // First stamp, extended
+};
+
+template <typename Out>
+static Demux<Out> makeDemux(Out out) {
+    return Demux<Out>(out);
+}
+
+// As ChannelFramer::frame()
+static void frameChunk(int port, uint32_t t, const uint8_t* data, size_t len, std::vector<uint8_t>& wire) {
+    uint8_t raw[FRAME_BYTES];
+    raw[0] = (uint8_t)port;
+    for (int i = 0; i < 4; i++) raw[1 + i] = (uint8_t)(t >> (8 * i));
+    memcpy(raw + HEADER, data, len);
+    uint16_t crc = logcodec::crc16(raw, HEADER + len);
+    raw[HEADER + len] = (uint8_t)crc;
+    raw[HEADER + len + 1] = (uint8_t)(crc >> 8);
+    uint8_t out[WIRE_MAX];
+    size_t w = logcodec::cobsEncode(raw, HEADER + len + 2, out);
+    wire.insert(wire.end(), out, out + w);
+    wire.push_back(0);
+}
+
+// Drops the "[  s.us] " prefixes; false if one goes back in time
+static bool stripPrefixes(const std::string& in, std::string* text) {
+    double last = -1;
+    size_t i = 0;
+    while (i < in.size()) {
+        size_t close = in.find("] ", i);
+        if (in[i] != '[' || close == std::string::npos) return false;
+        double ts = atof(in.c_str() + i + 1);
+        if (ts < last) return false;
+        last = ts;
+        size_t nl = in.find('\n', close);
+        size_t end = nl == std::string::npos ? in.size() : nl + 1;
+        text->append(in, close + 2, end - close - 2);
+        i = end;
+    }
+    return true;
+}
+
+static int selftest() {
+    int errors = 0;
+    srand(1);
+
+    // Two ports, lines of random length cut into frames of random size,
+    // interleaved; the clock starts just before the 32-bit wrap
+    std::string logs[3];
+    std::vector<uint8_t> wire;
+    static const char note[] = "[bridge] port 2 at 115200 baud\n";
+    uint32_t t = 0xFFFFFFFFu - 3000000u;
+    for (int port = 1; port <= 2; port++) {
+        for (int i = 0; i < 2000; i++) {
+            char line[200];
+            int len = snprintf(line, sizeof(line), "I (%d) port%d: line %d %.*s\n", i * 10, port, i,
+                               rand() % 120, "................................................................"
+                                             "........................................................");
+            logs[port].append(line, len);
+        }
+    }
+    size_t pos[3] = {0, 0, 0};
+    uint32_t stamps[3] = {t, t, t};
+    int notes = 0;
+    while (pos[1] < logs[1].size() || pos[2] < logs[2].size()) {
+        int port = 1 + rand() % 2;
+        if (pos[port] >= logs[port].size()) port = 3 - port;
+        size_t n = 1 + rand() % CHUNK_MAX;
+        if (n > logs[port].size() - pos[port]) n = logs[port].size() - pos[port];
+        t += rand() % 5000;
+        // Port 2's frames sometimes wait in its ring while port 1 drains
+        uint32_t stamp = port == 2 && rand() % 4 == 0 ? t - 2000 : t;
+        if ((int32_t)(stamp - stamps[port]) < 0) stamp = stamps[port];
+        stamps[port] = stamp;
+        frameChunk(port, stamp, (const uint8_t*)logs[port].data() + pos[port], n, wire);
+        pos[port] += n;
+        if (rand() % 500 == 0) {
+            wire.insert(wire.end(), note, note + sizeof(note) - 1);
+            wire.push_back(0);
+            notes++;
+        }
+    }
+
+    std::string out[3], text;
+    auto demux = makeDemux([&](int port, const uint8_t* p, size_t len) {
+        if (port < 0) text.append((const char*)p, len);
+        else if (port <= 2) out[port].append((const char*)p, len);
+    });
+    demux.feed(wire.data(), wire.size());
+    for (int port = 1; port <= 2; port++) {
+        std::string stripped;
+        bool ordered = stripPrefixes(out[port], &stripped);
+        printf("selftest: port %d: %u frames, %u bytes, %u lines%s\n", port, (unsigned)demux.stats(port).frames,
+               (unsigned)demux.stats(port).bytes, (unsigned)demux.stats(port).lines,
+               ordered ? "" : ", timestamps out of order");
+        if (!ordered || stripped != logs[port]) errors++;
+    }
+    // The clock wraps 3 s in; the last line comes after about 2800
+    // frames * 2.5 ms
+    size_t last = out[1].rfind("\n[");
+    double lastTs = last == std::string::npos ? 0 : atof(out[1].c_str() + last + 2);
+    printf("selftest: %d notes -> %u text blobs, %u bad frames, last line at %.3f s\n", notes,
+           (unsigned)demux.textBlobs(), (unsigned)demux.badFrames(), lastTs);
+    if (demux.textBlobs() != (uint32_t)notes || demux.badFrames() || lastTs < 5.0) errors++;
+
+    // A damaged frame is counted and skipped; the other port is unaffected
+    std::vector<uint8_t> damaged;
+    frameChunk(1, 100, (const uint8_t*)"first\n", 6, damaged);
+    size_t mid = damaged.size();
+    frameChunk(2, 200, (const uint8_t*)"lost\n", 5, damaged);
+    damaged[mid + 3] ^= 0x40;
+    frameChunk(2, 300, (const uint8_t*)"kept\n", 5, damaged);
+    std::string d[3];
+    auto check = makeDemux([&](int port, const uint8_t* p, size_t len) {
+        if (port >= 0 && port <= 2) d[port].append((const char*)p, len);
+    });
+    check.feed(damaged.data(), damaged.size());
+    printf("selftest: damaged frame -> %u bad, port 2 \"%s\"\n", (unsigned)check.badFrames(),
+           d[2].substr(0, d[2].size() - 1).c_str());
+    if (check.badFrames() != 1 || d[1] != "[     0.000000] first\n" || d[2] != "[     0.000200] kept\n") errors++;
+
+    printf(errors ? "selftest FAILED\n" : "selftest passed\n");
+    return errors ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = ".";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--selftest")) return selftest();
+        if (!strcmp(argv[i], "-d") && i + 1 < argc) dir = argv[++i];
+    }
+
+    // No SA_RESTART: Ctrl-C ends the blocking read and prints the report
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    static FILE* files[PORTS];
+    auto demux = makeDemux([&](int port, const uint8_t* p, size_t len) {
+        if (port < 0) {
+            fwrite(p, 1, len, stdout);
+            fflush(stdout);
+            return;
+        }
+        if (!files[port]) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/port%d.log", dir.c_str(), port);
+            files[port] = fopen(path, "a");
+            if (!files[port]) {
+                perror(path);
+                exit(1);
+            }
+            fprintf(stderr, "[demux] port %d -> %s\n", port, path);
+        }
+        fwrite(p, 1, len, files[port]);
+    });
+    uint8_t chunk[4096];
+    size_t n;
+    while (!stop_requested && (n = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+        demux.feed(chunk, n);
+        for (int port = 0; port < PORTS; port++) {
+            if (files[port]) fflush(files[port]);
+        }
+    }
+    demux.finish();
+
+    for (int port = 0; port < PORTS; port++) {
+        if (!files[port]) continue;
+        fclose(files[port]);
+        const auto& s = demux.stats(port);
+        fprintf(stderr, "[demux] port %d: %u frames, %u bytes, %u lines\n", port, (unsigned)s.frames,
+                (unsigned)s.bytes, (unsigned)s.lines);
+    }
+    fprintf(stderr, "[demux] %u bad frames, %u text blobs\n", (unsigned)demux.badFrames(),
+            (unsigned)demux.textBlobs());
+    return 0;
+}
@@ -0,0 +1,268 @@
+/*
+ * Host decoder for the bridge's compressed transport (~~transport on)
+ *
+ * Build and run on a PC:
+ *   g++ -O2 -std=c++11 -I.. -o log_decode log_decode.cpp
+ *   stty -F /dev/ttyACM0 raw && ./log_decode < /dev/ttyACM0
+ *   ./log_decode < capture.bin
+ *   ./log_decode --selftest
+ *
+ * Frames are split on 0x00 and decoded with the firmware's log_codec.h;
+ * the text goes to stdout. Printable text that is not a frame (the
+ * bridge's own "[bridge] ..." replies, output from before the transport
+ * was switched on) is passed through. The report - frames,
+ * compression ratio, lost and bad frames - goes to stderr at the end
+ * (EOF or Ctrl-C) and every REPORT_FRAMES frames with -v.
+ *
+ * --selftest encodes a synthetic ESP_LOG stream, decodes it back, then
+ * again with frames dropped, cut short or preceded by text, and checks
+ * the text.
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "log_codec.h"
+
+static const uint32_t REPORT_FRAMES = 10000;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void onSignal(int) { stop_requested = 1; }
+
+static void report(const logcodec::Decoder::Stats& s, uint32_t textBlobs) {
+    fprintf(stderr,
+            "[decode] %u frames, %u -> %u bytes, ratio %.2fx, %u lost, %u bad, %u skipped, %u text blobs\n",
+            (unsigned)s.frames, (unsigned)s.wireBytes, (unsigned)s.rawBytes,
+            s.wireBytes ? (double)s.rawBytes / s.wireBytes : 0.0, (unsigned)s.lostFrames,
+            (unsigned)s.badFrames, (unsigned)s.skipped, (unsigned)textBlobs);
+}
+
+static bool printable(const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if ((p[i] < 0x20 || p[i] >= 0x7F) && p[i] != '\r' && p[i] != '\n' && p[i] != '\t' && p[i] != 0x1B) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Splits a byte stream on 0x00 and decodes each blob
+template <typename Out>
+class Splitter {
+public:
+    explicit Splitter(Out out) : _out(out), _textBlobs(0) {}
+
+    void feed(const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            if (data[i] != 0) {
+                if (_blob.size() < 4096) _blob.push_back(data[i]);
+                continue;
+            }
+            if (_blob.empty()) continue;
+            const uint8_t* p = _blob.data();
+            size_t n = _blob.size();
+            // Text or a damaged frame, followed by a frame without a 0x00
+            // in between (bytes injected mid-stream, a frame cut short):
+            // the valid suffix is still decoded
+            size_t k = 0;
+            while (k < n && !logcodec::validFrame(p + k, n - k)) k++;
+            if (k > 0 && printable(p, k)) {
+                _out(p, k);
+                _textBlobs++;
+            } else if (k > 0) {
+                _decoder.decodeFrame(p, k, _out);  // Counted as bad
+            }
+            if (k < n) _decoder.decodeFrame(p + k, n - k, _out);
+            _blob.clear();
+        }
+    }
+
+    // Text at the end of a stream that never got its delimiter
+    void finish() {
+        if (!_blob.empty() && printable(_blob.data(), _blob.size())) {
+            _out(_blob.data(), _blob.size());
+            _textBlobs++;
+        }
+        _blob.clear();
+    }
+
+    const logcodec::Decoder::Stats& stats() const { return _decoder.stats(); }
+    uint32_t textBlobs() const { return _textBlobs; }
+
+private:
+    Out _out;
+    logcodec::Decoder _decoder;
+    std::vector<uint8_t> _blob;
+    uint32_t _textBlobs;
+};
+
+template <typename Out>
+static Splitter<Out> makeSplitter(Out out) {
+    return Splitter<Out>(out);
+}
+
+// ESP_LOG-like lines with the repetition of a real boot/run log
+static std::string syntheticLog(int lines) {
+    static const char* const tags[] = {"wifi", "esp_netif", "lvgl", "app_main", "heap", "touch"};
+    static const char* const colors[] = {"\033[0;31m", "\033[0;33m", "\033[0;32m", ""};
+    static const char levels[] = "EWID";
+    std::string log;
+    uint32_t ticks = 1000;
+    srand(1);
+    for (int i = 0; i < lines; i++) {
+        int l = rand() % 100 < 70 ? 2 : rand() % 4;
+        const char* tag = tags[rand() % 6];
+        ticks += rand() % 50;
+        char line[160];
+        switch (rand() % 4) {
+            case 0:
+                snprintf(line, sizeof(line), "%s%c (%u) %s: free heap %u, min %u\033[0m\n", colors[l],
+                         levels[l], (unsigned)ticks, tag, 200000 + rand() % 5000, 180000 + rand() % 100);
+                break;
+            case 1:
+                snprintf(line, sizeof(line), "%s%c (%u) %s: frame %d rendered in %d ms\033[0m\n",
+                         colors[l], levels[l], (unsigned)ticks, tag, i, rand() % 40);
+                break;
+            case 2:
+                snprintf(line, sizeof(line), "%s%c (%u) %s: touch x=%d y=%d pressed\033[0m\n", colors[l],
+                         levels[l], (unsigned)ticks, tag, rand() % 800, rand() % 480);
+                break;
+            default:
+                snprintf(line, sizeof(line), "%s%c (%u) %s: event %d on queue %d\033[0m\n", colors[l],
+                         levels[l], (unsigned)ticks, tag, rand() % 16, rand() % 4);
+                break;
+        }
+        log += line;
+    }
+    return log;
+}
+
+static int selftest() {
+    std::string log = syntheticLog(20000);
+    int errors = 0;
+
+    // Bursts of random length, framed as LogTransport does: whole frames,
+    // then the rest when the burst ends
+    logcodec::Encoder* enc = new logcodec::Encoder();
+    std::vector<uint8_t> wire;
+    std::vector<size_t> frameEnds;
+    for (size_t i = 0; i < log.size(); ) {
+        size_t n = 1 + rand() % 1024;
+        if (n > log.size() - i) n = log.size() - i;
+        enc->encode((const uint8_t*)log.data() + i, n, [&](const uint8_t* f, size_t len) {
+            wire.insert(wire.end(), f, f + len);
+            frameEnds.push_back(wire.size());
+        });
+        i += n;
+    }
+
+    std::string out;
+    auto clean = makeSplitter([&](const uint8_t* p, size_t len) { out.append((const char*)p, len); });
+    clean.feed(wire.data(), wire.size());
+    if (out != log) errors++;
+    if (clean.stats().lostFrames || clean.stats().badFrames) errors++;
+    printf("selftest: %u bytes in %u frames -> %u bytes on the wire, ratio %.2fx\n",
+           (unsigned)log.size(), (unsigned)enc->stats().frames, (unsigned)wire.size(),
+           (double)log.size() / wire.size());
+    delete enc;
+
+    // Drop frames, cut frames short and put text in front of frames: the
+    // decoder must count the losses, skip to the next key frame, pass the
+    // text through and never output anything that was not sent
+    static const char note[] = "[bridge] transport on\n";
+    std::vector<uint8_t> lossy;
+    size_t start = 0;
+    int cut = 0, dropped = 0, notes = 0;
+    for (size_t f = 0; f < frameEnds.size(); f++) {
+        size_t end = frameEnds[f];
+        if (f % 97 == 5) {
+            dropped++;
+        } else if (f % 89 == 7) {
+            lossy.insert(lossy.end(), wire.begin() + start, wire.begin() + start + (end - start) / 2);
+            cut++;
+        } else {
+            if (f % 83 == 11) {
+                lossy.insert(lossy.end(), note, note + sizeof(note) - 1);
+                notes++;
+            }
+            lossy.insert(lossy.end(), wire.begin() + start, wire.begin() + end);
+        }
+        start = end;
+    }
+    size_t wrong = 0;
+    auto damaged = makeSplitter([&](const uint8_t* p, size_t len) {
+        std::string piece((const char*)p, len);
+        if (piece != note && log.find(piece) == std::string::npos) wrong++;
+    });
+    damaged.feed(lossy.data(), lossy.size());
+    const logcodec::Decoder::Stats& s = damaged.stats();
+    printf("selftest: %d frames dropped, %d cut, %d notes -> %u lost, %u bad, %u skipped, %u text, %u wrong\n",
+           dropped, cut, notes, (unsigned)s.lostFrames, (unsigned)s.badFrames, (unsigned)s.skipped,
+           (unsigned)damaged.textBlobs(), (unsigned)wrong);
+    if (wrong) errors++;
+    // A cut frame shares its blob with the next frame: it is counted bad
+    // and the next one decoded, so its sequence number reports the cut
+    // frame as lost too
+    if (s.lostFrames < (uint32_t)(dropped + cut)) errors++;
+    if (s.badFrames != (uint32_t)cut) errors++;
+    if (damaged.textBlobs() < (uint32_t)notes / 2) errors++;  // Some follow a cut frame
+
+    // A frame cut short, then the key frame LogTransport sends after a
+    // loss: the key frame decodes right away
+    static const char* const lines[] = {"I (1) a: first\n", "I (2) b: second, cut\n", "I (3) c: third\n"};
+    logcodec::Encoder* keyEnc = new logcodec::Encoder();
+    std::vector<uint8_t> keyWire;
+    for (int i = 0; i < 3; i++) {
+        if (i == 2) keyEnc->forceKey();
+        keyEnc->encode((const uint8_t*)lines[i], strlen(lines[i]), [&](const uint8_t* f, size_t len) {
+            keyWire.insert(keyWire.end(), f, f + (i == 1 ? len / 2 : len));
+        });
+    }
+    delete keyEnc;
+    std::string recovered;
+    auto afterCut = makeSplitter([&](const uint8_t* p, size_t len) { recovered.append((const char*)p, len); });
+    afterCut.feed(keyWire.data(), keyWire.size());
+    printf("selftest: cut frame before a key frame -> %u bad, \"%.*s\"\n", (unsigned)afterCut.stats().badFrames,
+           (int)recovered.size() - 1, recovered.c_str());
+    if (recovered != std::string(lines[0]) + lines[2] || afterCut.stats().badFrames != 1) errors++;
+
+    printf(errors ? "selftest FAILED\n" : "selftest passed\n");
+    return errors ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--selftest")) return selftest();
+        if (!strcmp(argv[i], "-v")) verbose = true;
+    }
+
+    // No SA_RESTART: Ctrl-C ends the blocking read and prints the report
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    auto splitter = makeSplitter([](const uint8_t* p, size_t len) { fwrite(p, 1, len, stdout); });
+    uint32_t nextReport = REPORT_FRAMES;
+    uint8_t chunk[4096];
+    size_t n;
+    while (!stop_requested && (n = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+        splitter.feed(chunk, n);
+        fflush(stdout);
+        if (verbose && splitter.stats().frames >= nextReport) {
+            report(splitter.stats(), splitter.textBlobs());
+            nextReport += REPORT_FRAMES;
+        }
+    }
+    splitter.finish();
+    fflush(stdout);
+    report(splitter.stats(), splitter.textBlobs());
+    return 0;
+}
@@ -0,0 +1,492 @@
+/*
+ * Trigger-based capture of the raw UART stream
+ *
+ * The UART event task only copies each received chunk into a capture
+ * ring (append(): one memcpy, no parsing), so the forward path does not
+ * slow down. Everything else runs from loop() in bounded steps:
+ *
+ * - service() scans the new bytes line by line and matches each line
+ *   against the triggers: plain text (strstr) or a small regex
+ *   (. [] \d \w \s * + ? ^ $). The backtracking matcher gets
+ *   MATCH_STEPS per line and trigger; a line that needs more counts as
+ *   no match.
+ * - On a match it waits for POST bytes after the trigger line (or
+ *   POST_TIMEOUT_MS of silence: a hung target prints nothing more).
+ * - It then saves PRE bytes before the trigger line through POST bytes
+ *   after it to <dir>/NNNN.log, SAVE_CHUNK bytes per call. A line is
+ *   added to <dir>/index.txt.
+ *
+ * The ring is never locked. Readers copy a span out and then check that
+ * the producer has not lapped it; if it has, the bytes are skipped and
+ * counted (scan) or the capture is marked truncated (save).
+ *
+ * The ring goes to PSRAM when there is any. The Cardputer v1.1 has none,
+ * so it comes from internal RAM and is sized for that.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <esp_heap_caps.h>
+#include <atomic>
+
+// Every scanned line, CR LF removed (loop task)
+typedef void (*LineFn)(const char* line, size_t len, void* ctx);
+
+class LogCapture {
+public:
+    static constexpr int MAX_TRIGGERS = 8;
+    static constexpr int PATTERN_LEN = 48;
+    static constexpr int LINE_MAX = 256;          // Longer lines are matched on their start
+    static constexpr uint32_t SCAN_BUDGET = 8192; // Bytes scanned per service()
+    static constexpr uint32_t SAVE_CHUNK = 4096;  // Bytes written per service()
+    static constexpr uint32_t POST_TIMEOUT_MS = 2000;
+    static constexpr uint32_t MATCH_STEPS = 16384;  // Regex work per line and trigger
+
+    enum State { IDLE, POST, SAVING };
+
+    struct Stats {
+        uint32_t lines;      // Scanned
+        uint32_t triggers;   // Matches that started a capture
+        uint32_t busy;       // Matches while a capture was pending or saving
+        uint32_t saved;      // Captures written
+        uint32_t truncated;  // Captures partly overwritten before saving
+        uint32_t lagBytes;   // Lapped by the producer before they were scanned
+        uint32_t errors;     // File errors
+        uint32_t gaveUp;     // Regex matches cut off at MATCH_STEPS
+    };
+
+    LogCapture()
+        : _buf(nullptr), _size(0), _mask(0), _pre(0), _post(0), _psram(false), _head(0), _claim(0),
+          _fs(nullptr), _dir(""), _nextId(1), _triggerCount(0), _lineFn(nullptr), _lineCtx(nullptr),
+          _scan(0), _lineLen(0), _lineStart(0), _state(IDLE), _trigStart(0), _trigEnd(0), _trigMs(0),
+          _trigIndex(-1), _savePos(0), _saveEnd(0), _saveTruncated(false) {
+        memset(&_stats, 0, sizeof(_stats));
+        memset(_triggers, 0, sizeof(_triggers));
+        _lastFile[0] = '\0';
+    }
+
+    // size: ring bytes (power of two); pre + post must leave room for
+    // the producer while a capture is saved
+    bool begin(uint32_t size, uint32_t pre, uint32_t post) {
+        while (size & (size - 1)) size &= size - 1;
+        if (pre + post > size / 2) return false;
+        _psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0;
+        _buf = (uint8_t*)heap_caps_malloc(size, _psram ? MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT : MALLOC_CAP_8BIT);
+        if (!_buf) return false;
+        _size = size;
+        _mask = size - 1;
+        _pre = pre;
+        _post = post;
+        return true;
+    }
+
+    // Where captures go; nullptr = keep triggering, save nothing
+    void setStorage(fs::FS* fs, const char* dir) {
+        _fs = fs;
+        _dir = dir;
+        if (!_fs) return;
+        if (!_fs->exists(_dir)) _fs->mkdir(_dir);
+        // Continue numbering after the last indexed capture
+        char path[48];
+        snprintf(path, sizeof(path), "%s/index.txt", _dir);
+        File index = _fs->open(path, FILE_READ);
+        if (index) {
+            while (index.available()) {
+                String line = index.readStringUntil('\n');
+                uint32_t id = (uint32_t)line.toInt();
+                if (id >= _nextId) _nextId = id + 1;
+            }
+            index.close();
+        }
+    }
+
+    // --- Triggers (loop task) ---
+
+    bool addTrigger(const char* pattern, bool regex) {
+        if (_triggerCount >= MAX_TRIGGERS || !*pattern) return false;
+        Trigger& t = _triggers[_triggerCount++];
+        strncpy(t.pattern, pattern, PATTERN_LEN - 1);
+        t.pattern[PATTERN_LEN - 1] = '\0';
+        t.regex = regex;
+        t.hits = 0;
+        return true;
+    }
+    void clearTriggers() { _triggerCount = 0; }
+
+    // Also hand each scanned line to fn (log_tail.h)
+    void setLineHandler(LineFn fn, void* ctx) {
+        _lineFn = fn;
+        _lineCtx = ctx;
+    }
+
+    // Capture from here, as if a trigger line just ended; false if a
+    // capture is already pending or being saved
+    bool triggerNow() { return startCapture(-1, _head.load(std::memory_order_acquire)); }
+
+    // Handle a bridge command (without "~~"); false if not ours
+    //   trigger <text>        add a text trigger
+    //   trigger re <regex>    add a regex trigger
+    //   trigger clear         remove all triggers
+    //   trigger               list triggers
+    //   capture               capture now
+    //   capture stats         counters
+    bool command(const char* line, Print& out) {
+        if (!strncmp(line, "trigger", 7) && (line[7] == ' ' || line[7] == '\0')) {
+            const char* arg = line[7] ? line + 8 : "";
+            bool ok = true;
+            if (!strcmp(arg, "clear")) clearTriggers();
+            else if (!strncmp(arg, "re ", 3)) ok = addTrigger(arg + 3, true);
+            else if (*arg) ok = addTrigger(arg, false);
+            if (!ok) out.println("[bridge] too many triggers");
+            printTriggers(out);
+            return true;
+        }
+        if (!strcmp(line, "capture")) {
+            out.println(triggerNow() ? "[bridge] capture started" : "[bridge] capture busy");
+            return true;
+        }
+        if (!strcmp(line, "capture stats")) {
+            printStats(out);
+            return true;
+        }
+        return false;
+    }
+
+    void printTriggers(Print& out) {
+        for (int i = 0; i < _triggerCount; i++) {
+            out.printf("[bridge] trigger %d: %s\"%s\" (%lu hits)\n", i, _triggers[i].regex ? "re " : "",
+                       _triggers[i].pattern, (unsigned long)_triggers[i].hits);
+        }
+        if (_triggerCount == 0) out.println("[bridge] no triggers");
+    }
+
+    void printStats(Print& out) {
+        out.printf("[bridge] capture: %s, %lu KB ring (%s), pre %lu post %lu\n",
+                   _fs ? _dir : "no storage", (unsigned long)(_size / 1024),
+                   _psram ? "PSRAM" : "RAM",
+                   (unsigned long)_pre, (unsigned long)_post);
+        out.printf("[bridge] %lu lines, %lu triggers, %lu busy, %lu saved, %lu truncated, %lu lag bytes, %lu errors, %lu regex gave up\n",
+                   (unsigned long)_stats.lines, (unsigned long)_stats.triggers, (unsigned long)_stats.busy,
+                   (unsigned long)_stats.saved, (unsigned long)_stats.truncated,
+                   (unsigned long)_stats.lagBytes, (unsigned long)_stats.errors, (unsigned long)_stats.gaveUp);
+        if (_lastFile[0]) out.printf("[bridge] last: %s\n", _lastFile);
+    }
+
+    State state() const { return _state; }
+    const Stats& stats() const { return _stats; }
+    const char* lastFile() const { return _lastFile; }
+
+    // --- Producer (UART event task) ---
+
+    void append(const uint8_t* data, size_t len) {
+        if (!_buf || len == 0) return;
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (len > _size) {
+            data += len - _size;
+            head += len - _size;
+            len = _size;
+        }
+        // Claim first: a reader that copied these bytes sees the claim
+        _claim.store(head + len, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        uint32_t at = head & _mask;
+        uint32_t first = len < _size - at ? len : _size - at;
+        memcpy(_buf + at, data, first);
+        memcpy(_buf, data + first, len - first);
+        _head.store(head + len, std::memory_order_release);
+    }
+
+    // --- Matching and saving (loop task) ---
+
+    void service(uint32_t nowMs) {
+        if (!_buf) return;
+        scan();
+        if (_state == POST) {
+            uint32_t head = _head.load(std::memory_order_acquire);
+            if (head - _trigEnd >= _post || nowMs - _trigMs >= POST_TIMEOUT_MS) {
+                beginSave(head - _trigEnd >= _post ? _trigEnd + _post : head);
+            }
+        } else if (_state == SAVING) {
+            saveStep();
+        }
+    }
+
+    // Regex subset: literals, . [abc] [a-z] [^x] \d \w \s \<char>,
+    // * + ? after any of those, ^ and $ anchors. Finds a match anywhere.
+    // Gives up (no match, *gaveUp set) after MATCH_STEPS: patterns like
+    // .*.*.*x backtrack exponentially.
+    static bool regexSearch(const char* re, const char* text, bool* gaveUp = nullptr) {
+        uint32_t steps = MATCH_STEPS;
+        bool hit = false;
+        if (*re == '^') {
+            hit = matchHere(re + 1, text, steps);
+        } else if (re[0] == '.' && re[1] == '*') {
+            hit = matchHere(re, text, steps);  // Matches anywhere iff from the start
+        } else {
+            do {
+                hit = matchHere(re, text, steps);
+            } while (!hit && steps > 0 && *text++);
+        }
+        if (gaveUp) *gaveUp = !hit && steps == 0;
+        return hit;
+    }
+
+private:
+    struct Trigger {
+        char pattern[PATTERN_LEN];
+        bool regex;
+        uint32_t hits;
+    };
+
+    // Copy n bytes at pos out of the ring; false if the producer has
+    // lapped them meanwhile
+    bool copyOut(uint32_t pos, uint8_t* dst, uint32_t n) const {
+        uint32_t at = pos & _mask;
+        uint32_t first = n < _size - at ? n : _size - at;
+        memcpy(dst, _buf + at, first);
+        memcpy(dst + first, _buf, n - first);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return _claim.load(std::memory_order_relaxed) - pos <= _size;
+    }
+
+    void scan() {
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (head - _scan > _size) {
+            // Lapped: skip ahead, with room for the producer to go on
+            _stats.lagBytes += head - _scan - _size / 2;
+            _scan = head - _size / 2;
+            _lineLen = 0;
+            _lineStart = _scan;
+        }
+        uint32_t budget = SCAN_BUDGET;
+        uint8_t chunk[256];
+        while (_scan != head && budget > 0) {
+            uint32_t n = head - _scan;
+            if (n > sizeof(chunk)) n = sizeof(chunk);
+            if (n > budget) n = budget;
+            if (!copyOut(_scan, chunk, n)) return;  // Lapped: handled on the next call
+            for (uint32_t i = 0; i < n; i++) {
+                uint8_t c = chunk[i];
+                if (c == '\n') {
+                    endLine(_scan + i + 1);
+                } else if (_lineLen < LINE_MAX - 1) {
+                    _line[_lineLen++] = (char)c;
+                }
+            }
+            _scan += n;
+            budget -= n;
+        }
+    }
+
+    void endLine(uint32_t end) {
+        _stats.lines++;
+        if (_lineLen > 0 && _line[_lineLen - 1] == '\r') _lineLen--;
+        _line[_lineLen] = '\0';
+        if (_lineFn) _lineFn(_line, _lineLen, _lineCtx);
+        for (int i = 0; i < _triggerCount; i++) {
+            Trigger& t = _triggers[i];
+            bool gaveUp = false;
+            bool hit = t.regex ? regexSearch(t.pattern, _line, &gaveUp) : strstr(_line, t.pattern) != nullptr;
+            if (gaveUp) _stats.gaveUp++;
+            if (hit) {
+                t.hits++;
+                startCapture(i, end);
+                break;
+            }
+        }
+        _lineLen = 0;
+        _lineStart = end;
+    }
+
+    bool startCapture(int trigger, uint32_t lineEnd) {
+        if (_state != IDLE) {
+            _stats.busy++;
+            return false;
+        }
+        _stats.triggers++;
+        _trigIndex = trigger;
+        _trigEnd = lineEnd;
+        _trigStart = trigger >= 0 ? _lineStart : lineEnd;
+        _trigMs = millis();
+        _state = POST;
+        return true;
+    }
+
+    void beginSave(uint32_t end) {
+        uint32_t head = _head.load(std::memory_order_acquire);
+        uint32_t start = _trigStart - _pre;
+        if (_trigStart < _pre) start = 0;             // Less than PRE received so far
+        if (head - start > _size / 2 + _pre + _post) start = head - _size / 2;  // Lagged far behind
+        _savePos = start;
+        _saveEnd = end;
+        _saveTruncated = false;
+        _state = SAVING;
+
+        if (!_fs) {
+            finishSave();
+            return;
+        }
+        snprintf(_lastFile, sizeof(_lastFile), "%s/%04lu.log", _dir, (unsigned long)_nextId);
+        _file = _fs->open(_lastFile, FILE_WRITE);
+        if (!_file) {
+            _stats.errors++;
+            finishSave();
+            return;
+        }
+        _file.printf("# capture %lu at %lu ms, trigger %s%s%s\n", (unsigned long)_nextId,
+                     (unsigned long)_trigMs, _trigIndex >= 0 ? "\"" : "",
+                     _trigIndex >= 0 ? _triggers[_trigIndex].pattern : "manual", _trigIndex >= 0 ? "\"" : "");
+    }
+
+    void saveStep() {
+        if (!_file) return;
+        uint32_t n = _saveEnd - _savePos;
+        if (n > SAVE_CHUNK) n = SAVE_CHUNK;
+        if (n > 0) {
+            if (!copyOut(_savePos, _chunk, n)) {
+                _saveTruncated = true;
+                _saveEnd = _savePos;  // The rest is gone too
+            } else if (_file.write(_chunk, n) != n) {
+                _stats.errors++;
+                _saveEnd = _savePos;
+            } else {
+                _savePos += n;
+            }
+        }
+        if (_savePos == _saveEnd) finishSave();
+    }
+
+    void finishSave() {
+        if (_file) {
+            if (_saveTruncated) _file.println("\n# truncated: overwritten before it was saved");
+            uint32_t bytes = _file.size();
+            _file.close();
+            char path[48];
+            snprintf(path, sizeof(path), "%s/index.txt", _dir);
+            File index = _fs->open(path, FILE_APPEND);
+            if (index) {
+                index.printf("%lu\t%lu\t%s\t%lu\t%s\n", (unsigned long)_nextId, (unsigned long)_trigMs,
+                             _trigIndex >= 0 ? _triggers[_trigIndex].pattern : "manual",
+                             (unsigned long)bytes, _lastFile);
+                index.close();
+            } else {
+                _stats.errors++;
+            }
+            _nextId++;
+            _stats.saved++;
+            if (_saveTruncated) _stats.truncated++;
+        }
+        _state = IDLE;
+    }
+
+    // steps: remaining budget, one per character looked at
+    static bool matchHere(const char* re, const char* text, uint32_t& steps) {
+        for (;;) {
+            if (*re == '\0') return true;
+            if (re[0] == '$' && re[1] == '\0') return *text == '\0';
+            if (steps == 0) return false;
+            steps--;
+            const char* next = atomEnd(re);
+            char q = *next;
+            if (q == '*' || q == '+' || q == '?') {
+                // Greedy: take as many as possible, then back off
+                const char* t = text;
+                while (*t && matchAtom(re, *t) && (q != '?' || t == text)) t++;
+                uint32_t taken = (uint32_t)(t - text);
+                steps = steps > taken ? steps - taken : 0;
+                const char* min = q == '+' ? text + 1 : text;
+                for (; t >= min && steps > 0; t--) {
+                    if (matchHere(next + 1, t, steps)) return true;
+                }
+                return false;
+            }
+            if (*text == '\0' || !matchAtom(re, *text)) return false;
+            re = next;
+            text++;
+        }
+    }
+
+    static const char* atomEnd(const char* re) {
+        if (*re == '\\' && re[1]) return re + 2;
+        if (*re == '[') {
+            const char* p = re + 1;
+            if (*p == '^') p++;
+            if (*p == ']') p++;
+            while (*p && *p != ']') p++;
+            return *p ? p + 1 : p;
+        }
+        return re + 1;
+    }
+
+    static bool matchAtom(const char* re, char c) {
+        if (*re == '.') return true;
+        if (*re == '\\') {
+            switch (re[1]) {
+                case 'd': return c >= '0' && c <= '9';
+                case 'w': return isalnum((unsigned char)c) || c == '_';
+                case 's': return c == ' ' || c == '\t';
+                default: return c == re[1];
+            }
+        }
+        if (*re == '[') {
+            const char* p = re + 1;
+            bool negate = *p == '^';
+            if (negate) p++;
+            bool hit = false;
+            const char* first = p;
+            while (*p && (*p != ']' || p == first)) {
+                if (p[1] == '-' && p[2] && p[2] != ']') {
+                    if (c >= p[0] && c <= p[2]) hit = true;
+                    p += 3;
+                } else {
+                    if (c == *p) hit = true;
+                    p++;
+                }
+            }
+            return hit != negate;
+        }
+        return c == *re;
+    }
+
+    // Ring (written by the event task)
+    uint8_t* _buf;
+    uint32_t _size;
+    uint32_t _mask;
+    uint32_t _pre;
+    uint32_t _post;
+    bool _psram;
+    std::atomic<uint32_t> _head;   // Free-running: bytes written
+    std::atomic<uint32_t> _claim;  // Free-running: bytes being written
+
+    // Storage and triggers (loop task)
+    fs::FS* _fs;
+    const char* _dir;
+    uint32_t _nextId;
+    Trigger _triggers[MAX_TRIGGERS];
+    int _triggerCount;
+    LineFn _lineFn;
+    void* _lineCtx;
+
+    // Scanner
+    uint32_t _scan;       // Next byte to scan
+    char _line[LINE_MAX];
+    int _lineLen;
+    uint32_t _lineStart;  // Ring position of the current line
+
+    // Current capture
+    State _state;
+    uint32_t _trigStart;  // Trigger line
+    uint32_t _trigEnd;
+    uint32_t _trigMs;
+    int _trigIndex;       // -1 = manual
+    uint32_t _savePos;
+    uint32_t _saveEnd;
+    bool _saveTruncated;
+    File _file;
+    uint8_t _chunk[SAVE_CHUNK];
+    char _lastFile[48];
+
+    Stats _stats;
+};
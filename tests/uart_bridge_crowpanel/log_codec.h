@@ -0,0 +1,358 @@
+/*
+ * Framed, compressed log transport: encoder (bridge) and decoder (host)
+ *
+ * Log text is cut into frames of up to FRAME_MAX bytes. Each frame is
+ * compressed against a sliding history of the last HISTORY bytes sent -
+ * the recent lines, where ESP_LOG tags, color codes and message
+ * prefixes repeat - with byte-aligned LZ77 tokens:
+ *
+ *   0xxxxxxx           literal run: x + 1 bytes follow
+ *   1LLLLooo oooooooo  match: L + MIN_MATCH bytes from o + 1 bytes back
+ *
+ * Matches are found through hash chains over the history, CHAIN_DEPTH
+ * candidates deep: cheap enough for the UART event task.
+ *
+ * Frame = flags (KEY, RAW) | seq (u16) | payload | CRC-16/CCITT over
+ * all of it, COBS-encoded and ended by a 0x00 byte.
+ * A lost or damaged frame breaks the decoder's history, so every
+ * KEY_INTERVAL-th frame is a key frame that does not reference earlier
+ * data; the decoder skips frames until the next key and counts them.
+ *
+ * No Arduino dependencies: host/log_decode.cpp includes this file.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace logcodec {
+
+static constexpr int FRAME_MAX = 240;      // Raw bytes per frame
+static constexpr int HISTORY = 2048;       // Sliding dictionary (power of two, 11-bit offsets)
+static constexpr int KEY_INTERVAL = 64;    // Frames between key frames
+static constexpr int MIN_MATCH = 3;
+static constexpr int MAX_MATCH = 15 + MIN_MATCH;
+static constexpr int HASH_BITS = 10;
+static constexpr int CHAIN_DEPTH = 8;
+
+static constexpr uint8_t FLAG_KEY = 0x01;  // No references before this frame
+static constexpr uint8_t FLAG_RAW = 0x02;  // Payload stored, not compressed
+
+static constexpr int HEADER = 3;           // flags, seq (2)
+static constexpr int FRAME_BYTES = HEADER + FRAME_MAX + 2;
+// Worst case on the wire: stored frame, COBS overhead, delimiter
+static constexpr int WIRE_MAX = FRAME_BYTES + FRAME_BYTES / 254 + 2;
+
+inline uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// COBS: out needs len + len / 254 + 1 bytes; returns the encoded length
+inline size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t code = 0, o = 1;
+    uint8_t run = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code] = run;
+            code = o++;
+            run = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++run == 0xFF) {
+            out[code] = run;
+            code = o++;
+            run = 1;
+        }
+    }
+    out[code] = run;
+    return o;
+}
+
+// Returns the decoded length, 0 if malformed
+inline size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t i = 0, o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) return 0;
+        for (uint8_t k = 1; k < code; k++) out[o++] = in[i++];
+        if (code != 0xFF && i < len) out[o++] = 0;
+    }
+    return o;
+}
+
+// COBS and CRC check of one wire frame (without its 0x00 delimiter)
+inline bool validFrame(const uint8_t* wire, size_t len) {
+    uint8_t frame[WIRE_MAX];
+    if (len == 0 || len > sizeof(frame)) return false;
+    size_t n = cobsDecode(wire, len, frame);
+    return n >= (size_t)HEADER + 2 && crc16(frame, n - 2) == (uint16_t)(frame[n - 2] | (frame[n - 1] << 8));
+}
+
+class Encoder {
+public:
+    struct Stats {
+        uint32_t frames;
+        uint32_t rawBytes;
+        uint32_t wireBytes;
+    };
+
+    Encoder() { reset(); }
+
+    void reset() {
+        _pos = 0;
+        _keyBase = 0;
+        _seq = 0;
+        _sinceKey = KEY_INTERVAL;  // First frame is a key frame
+        memset(_head, 0, sizeof(_head));
+        memset(_prev, 0, sizeof(_prev));
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    // Next frame is a key frame (after a mode switch or lost output)
+    void forceKey() { _sinceKey = KEY_INTERVAL; }
+
+    // Encode data as one or more frames; emit(const uint8_t*, size_t)
+    // receives each wire frame including its 0x00 delimiter
+    template <typename Emit>
+    void encode(const uint8_t* data, size_t len, Emit emit) {
+        while (len > 0) {
+            size_t n = len < (size_t)FRAME_MAX ? len : (size_t)FRAME_MAX;
+            encodeFrame(data, n, emit);
+            data += n;
+            len -= n;
+        }
+    }
+
+    const Stats& stats() const { return _stats; }
+
+private:
+    template <typename Emit>
+    void encodeFrame(const uint8_t* data, size_t len, Emit emit) {
+        bool key = _sinceKey >= KEY_INTERVAL;
+        if (key) {
+            _keyBase = _pos;
+            _sinceKey = 0;
+        }
+        _sinceKey++;
+
+        // The frame goes into the history first; matches then reach back
+        // from each position into older frames and this one
+        uint32_t base = _pos;
+        for (size_t i = 0; i < len; i++) _hist[(base + i) & (HISTORY - 1)] = data[i];
+        _pos += len;
+        uint32_t oldest = _pos > (uint32_t)HISTORY ? _pos - HISTORY : 0;
+        if (oldest < _keyBase) oldest = _keyBase;
+
+        uint8_t frame[FRAME_BYTES + FRAME_MAX / 128 + 1];
+        uint8_t* payload = frame + HEADER;
+        size_t out = 0, lit = 0, i = 0;
+        while (i < len) {
+            int best = 0;
+            uint32_t bestOff = 0;
+            if (i + MIN_MATCH <= len) findMatch(data, len, base, i, oldest, &best, &bestOff);
+            if (best) {
+                out = putLiterals(payload, out, data + i - lit, lit);
+                lit = 0;
+                payload[out++] = (uint8_t)(0x80 | (best - MIN_MATCH) << 3 | (bestOff - 1) >> 8);
+                payload[out++] = (uint8_t)(bestOff - 1);
+                for (int k = 1; k < best; k++) insert(data, len, base, i + k);
+                i += best;
+            } else {
+                lit++;
+                i++;
+            }
+            if (out >= len) break;  // Not shrinking: store instead
+        }
+        bool raw = out >= len;
+        if (!raw) {
+            out = putLiterals(payload, out, data + len - lit, lit);
+            raw = out >= len;
+        }
+        if (raw) {
+            for (size_t k = i; k < len; k++) insert(data, len, base, k);  // Keep the chains complete
+            memcpy(payload, data, len);
+            out = len;
+        }
+
+        frame[0] = (key ? FLAG_KEY : 0) | (raw ? FLAG_RAW : 0);
+        frame[1] = (uint8_t)_seq;
+        frame[2] = (uint8_t)(_seq >> 8);
+        uint16_t crc = crc16(frame, HEADER + out);
+        frame[HEADER + out] = (uint8_t)crc;
+        frame[HEADER + out + 1] = (uint8_t)(crc >> 8);
+
+        uint8_t wire[WIRE_MAX];
+        size_t w = cobsEncode(frame, HEADER + out + 2, wire);
+        wire[w++] = 0;
+        emit(wire, w);
+
+        _seq++;
+        _stats.frames++;
+        _stats.rawBytes += len;
+        _stats.wireBytes += w;
+    }
+
+    // Longest match for position i among the last CHAIN_DEPTH positions
+    // with the same hash; inserts i into the chains
+    void findMatch(const uint8_t* data, size_t len, uint32_t base, size_t i, uint32_t oldest, int* best,
+                   uint32_t* bestOff) {
+        uint32_t p = base + i;
+        uint32_t cand = insert(data, len, base, i);
+        int maxLen = (int)(len - i) < MAX_MATCH ? (int)(len - i) : MAX_MATCH;
+        for (int depth = 0; cand && depth < CHAIN_DEPTH; depth++) {
+            uint32_t q = cand - 1;
+            if (q < oldest || q >= p) break;
+            int l = 0;
+            while (l < maxLen && _hist[(q + l) & (HISTORY - 1)] == data[i + l]) l++;
+            if (l > *best) {
+                *best = l;
+                *bestOff = p - q;
+                if (l == maxLen) break;
+            }
+            uint32_t next = _prev[q & (HISTORY - 1)];
+            if (next >= cand) break;  // Slot reused by a newer position
+            cand = next;
+        }
+        if (*best < MIN_MATCH) *best = 0;
+    }
+
+    // Link position i into its hash chain; returns the previous head
+    // (position + 1, 0 = none)
+    uint32_t insert(const uint8_t* data, size_t len, uint32_t base, size_t i) {
+        if (i + MIN_MATCH > len) return 0;
+        uint32_t h = hash(data + i);
+        uint32_t prev = _head[h];
+        _prev[(base + i) & (HISTORY - 1)] = prev;
+        _head[h] = base + i + 1;
+        return prev;
+    }
+
+    static size_t putLiterals(uint8_t* payload, size_t out, const uint8_t* lit, size_t n) {
+        while (n > 0) {
+            size_t run = n < 128 ? n : 128;
+            payload[out++] = (uint8_t)(run - 1);
+            memcpy(payload + out, lit, run);
+            out += run;
+            lit += run;
+            n -= run;
+        }
+        return out;
+    }
+
+    static uint32_t hash(const uint8_t* p) {
+        uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    uint8_t _hist[HISTORY];
+    uint32_t _head[1 << HASH_BITS];  // Newest position + 1 per hash
+    uint32_t _prev[HISTORY];         // Older position + 1 with the same hash
+    uint32_t _pos;                   // Bytes encoded so far
+    uint32_t _keyBase;               // Position of the last key frame
+    uint16_t _seq;
+    int _sinceKey;
+    Stats _stats;
+};
+
+class Decoder {
+public:
+    struct Stats {
+        uint32_t frames;      // Decoded
+        uint32_t badFrames;   // CRC, COBS or token errors
+        uint32_t lostFrames;  // Sequence gaps
+        uint32_t skipped;     // Good frames skipped while waiting for a key frame
+        uint32_t rawBytes;    // Text recovered
+        uint32_t wireBytes;   // Including delimiters
+    };
+
+    Decoder() : _pos(0), _keyBase(0), _synced(false), _expected(0), _haveSeq(false) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    // One wire frame without its 0x00 delimiter. out(const uint8_t*, size_t)
+    // receives the recovered text. Returns false if the frame was bad.
+    template <typename Out>
+    bool decodeFrame(const uint8_t* wire, size_t len, Out out) {
+        _stats.wireBytes += len + 1;
+        if (!validFrame(wire, len)) return bad();
+        uint8_t frame[WIRE_MAX];
+        size_t n = cobsDecode(wire, len, frame);
+
+        uint8_t flags = frame[0];
+        uint16_t seq = frame[1] | (frame[2] << 8);
+        if (_haveSeq && seq != _expected) {
+            _stats.lostFrames += (uint16_t)(seq - _expected);
+            _synced = false;
+        }
+        _haveSeq = true;
+        _expected = seq + 1;
+
+        if (flags & FLAG_KEY) {
+            _synced = true;
+            _keyBase = _pos;
+        }
+        if (!_synced) {
+            _stats.skipped++;
+            return true;
+        }
+
+        const uint8_t* p = frame + HEADER;
+        const uint8_t* end = frame + n - 2;
+        uint32_t start = _pos;
+        if (flags & FLAG_RAW) {
+            if (end - p > FRAME_MAX) return bad();
+            for (; p < end; p++) put(*p);
+        } else {
+            while (p < end) {
+                uint8_t t = *p++;
+                if (t < 0x80) {
+                    size_t run = t + 1;
+                    if ((size_t)(end - p) < run || _pos - start + run > (size_t)FRAME_MAX) return bad();
+                    for (size_t k = 0; k < run; k++) put(*p++);
+                } else {
+                    if (p == end) return bad();
+                    int l = ((t >> 3) & 0x0F) + MIN_MATCH;
+                    uint32_t off = ((t & 0x07) << 8 | *p++) + 1;
+                    if (off > _pos - _keyBase || _pos - start + l > (uint32_t)FRAME_MAX) return bad();
+                    for (int k = 0; k < l; k++) put(_hist[(_pos - off) & (HISTORY - 1)]);
+                }
+            }
+        }
+        // Copy out of the ring (a frame is at most FRAME_MAX < HISTORY)
+        size_t rawLen = _pos - start;
+        uint8_t text[FRAME_MAX];
+        for (size_t k = 0; k < rawLen; k++) text[k] = _hist[(start + k) & (HISTORY - 1)];
+        out(text, rawLen);
+        _stats.frames++;
+        _stats.rawBytes += rawLen;
+        return true;
+    }
+
+    const Stats& stats() const { return _stats; }
+
+private:
+    void put(uint8_t c) { _hist[_pos++ & (HISTORY - 1)] = c; }
+
+    bool bad() {
+        _stats.badFrames++;
+        _synced = false;  // History may now differ from the encoder's
+        return false;
+    }
+
+    uint8_t _hist[HISTORY];
+    uint32_t _pos;
+    uint32_t _keyBase;
+    bool _synced;
+    uint16_t _expected;
+    bool _haveSeq;
+    Stats _stats;
+};
+
+}  // namespace logcodec
@@ -0,0 +1,321 @@
+/*
+ * Streaming ESP_LOG line parser with level/tag filters and timestamps
+ *
+ * Runs on the UART -> USB path in the UART event task, before the ring,
+ * so filtered lines cost no ring space or USB bandwidth. Each line is
+ * buffered only until its header is known:
+ *
+ *   [ESC[0;32m]I (12345) wifi: connected
+ *    color     |  ticks  tag
+ *            level
+ *
+ * Then the filter decides once: the buffered part and the rest of the
+ * line are either passed (optionally after a "[   12.345678] " bridge
+ * timestamp: esp_timer time of the RX event that delivered the line's
+ * first byte) or skipped until the newline. Lines that are not ESP_LOG
+ * output (ROM/bootloader messages, printf, the console prompt) always
+ * pass and are counted under the tag "-". They are recognised from their
+ * first bytes, so a prompt without a newline is not held back.
+ *
+ * Rules come from the loop task (command()); the event task picks them
+ * up through a generation counter, so the tag table is only ever
+ * written by the event task.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "byte_ring.h"
+
+class LogFilter {
+public:
+    static constexpr int MAX_TAGS = 32;
+    static constexpr int MAX_RULES = 8;
+    static constexpr int TAG_LEN = 16;
+    static constexpr int HEADER_MAX = 64;  // Undecided after this many bytes -> not ESP_LOG
+
+    // ESP-IDF esp_log_level_t order
+    enum Level : uint8_t { NONE, ERROR, WARN, INFO, DEBUG, VERBOSE };
+
+    struct TagStats {
+        char name[TAG_LEN];
+        uint32_t lines;
+        uint32_t bytes;     // Received, passed or not
+        uint32_t filtered;  // Lines not passed
+        uint8_t level;      // Effective threshold
+        uint32_t gen;       // Rules generation the level was resolved at
+    };
+
+    LogFilter()
+        : _level(VERBOSE), _timestamps(false), _ruleCount(0), _rulesGen(1), _tagCount(0),
+          _len(0), _state(LINE_START), _pass(true), _tag(nullptr), _startUs(0) {
+        memset(_rules, 0, sizeof(_rules));
+        memset(_tags, 0, sizeof(_tags));
+    }
+
+    // --- Rules (loop task) ---
+
+    void setLevel(uint8_t level) {
+        _level = level;
+        _rulesGen++;
+    }
+    // tag "*" = default level
+    bool setTagLevel(const char* tag, uint8_t level) {
+        if (!strcmp(tag, "*")) {
+            setLevel(level);
+            return true;
+        }
+        int i = 0;
+        while (i < _ruleCount && strncmp(_rules[i].tag, tag, TAG_LEN - 1)) i++;
+        if (i == _ruleCount) {
+            if (_ruleCount >= MAX_RULES) return false;
+            strncpy(_rules[i].tag, tag, TAG_LEN - 1);
+        }
+        _rules[i].level = level;
+        if (i == _ruleCount) _ruleCount++;
+        _rulesGen++;
+        return true;
+    }
+    void clearRules() {
+        _ruleCount = 0;
+        _level = VERBOSE;
+        _rulesGen++;
+    }
+    void setTimestamps(bool on) { _timestamps = on; }
+    bool timestamps() const { return _timestamps; }
+    uint8_t level() const { return _level; }
+
+    static int levelFromChar(char c) {
+        switch (c) {
+            case 'N': case 'n': return NONE;
+            case 'E': case 'e': return ERROR;
+            case 'W': case 'w': return WARN;
+            case 'I': case 'i': return INFO;
+            case 'D': case 'd': return DEBUG;
+            case 'V': case 'v': return VERBOSE;
+            default: return -1;
+        }
+    }
+    static char levelChar(uint8_t level) { return "NEWIDV"[level <= VERBOSE ? level : 0]; }
+
+    // Handle a bridge command line (without the "~~" prefix). Replies go
+    // to out. Returns false for an unknown command.
+    //   level <N|E|W|I|D|V>      default threshold
+    //   tag <name|*> <level>     per-tag threshold
+    //   clear                    remove all rules
+    //   ts <on|off>              bridge timestamps
+    //   stats                    per-tag counters
+    bool command(const char* line, Print& out) {
+        char arg1[32] = "", arg2[8] = "";
+        if (sscanf(line, "level %1s", arg1) == 1 && levelFromChar(arg1[0]) >= 0) {
+            setLevel(levelFromChar(arg1[0]));
+        } else if (sscanf(line, "tag %31s %7s", arg1, arg2) == 2 && levelFromChar(arg2[0]) >= 0) {
+            arg1[TAG_LEN - 1] = '\0';  // Longer tags are matched on this prefix, as parsed
+            if (!setTagLevel(arg1, levelFromChar(arg2[0]))) {
+                out.println("[bridge] too many tag rules");
+                return true;
+            }
+        } else if (!strcmp(line, "clear")) {
+            clearRules();
+        } else if (sscanf(line, "ts %3s", arg1) == 1) {
+            setTimestamps(!strcmp(arg1, "on"));
+        } else if (!strcmp(line, "stats")) {
+            printStats(out);
+            return true;
+        } else {
+            return false;
+        }
+        printRules(out);
+        return true;
+    }
+
+    void printRules(Print& out) {
+        out.printf("[bridge] level %c, timestamps %s", levelChar(_level), _timestamps ? "on" : "off");
+        for (int i = 0; i < _ruleCount; i++) out.printf(", %s=%c", _rules[i].tag, levelChar(_rules[i].level));
+        out.println();
+    }
+
+    void printStats(Print& out) {
+        out.println("[bridge] tag              lines      bytes   filtered  level");
+        int n = _tagCount;
+        for (int i = 0; i < n; i++) {
+            const TagStats& t = _tags[i];
+            out.printf("[bridge] %-16s %6lu %10lu %10lu  %c\n", t.name, (unsigned long)t.lines,
+                       (unsigned long)t.bytes, (unsigned long)t.filtered, t.gen ? levelChar(t.level) : '-');
+        }
+        if (n == MAX_TAGS) out.println("[bridge] (tag table full: further tags counted as \"+\", rules still apply)");
+    }
+
+    int tagCount() const { return _tagCount; }
+    const TagStats& tag(int i) const { return _tags[i]; }
+
+    // --- Data path (UART event task) ---
+
+    void process(const uint8_t* data, size_t len, ByteRing& out) {
+        uint64_t now = esp_timer_get_time();
+        size_t i = 0;
+        while (i < len) {
+            if (_state == LINE_START) {
+                _startUs = now;
+                _len = 0;
+                _state = HEADER;
+            }
+            if (_state == HEADER) {
+                uint8_t c = data[i++];
+                _line[_len++] = c;
+                if (c == '\n' || _len >= HEADER_MAX || headerComplete() || !couldBeHeader()) {
+                    decide(out);
+                    if (c == '\n') endLine();
+                }
+                continue;
+            }
+            // BODY: header decided, stream up to the end of the line
+            const uint8_t* nl = (const uint8_t*)memchr(data + i, '\n', len - i);
+            size_t span = nl ? (size_t)(nl - (data + i)) + 1 : len - i;
+            _tag->bytes += span;
+            if (_pass) out.write(data + i, span);
+            i += span;
+            if (nl) endLine();
+        }
+    }
+
+private:
+    enum State { LINE_START, HEADER, BODY };
+
+    struct Rule {
+        char tag[TAG_LEN];
+        uint8_t level;
+    };
+
+    // After the color escape: "L (ticks) tag: " - true once ": " is seen
+    // after the closing parenthesis
+    bool headerComplete() const {
+        return _len >= 2 && _line[_len - 1] == ' ' && _line[_len - 2] == ':' && memchr(_line, ')', _len);
+    }
+
+    // false once the bytes so far can't start "[ESC[..m]L ("
+    bool couldBeHeader() const {
+        int i = 0;
+        if (_line[0] == 0x1B) {
+            while (i < _len && _line[i] != 'm') {
+                if (++i > 8) return false;
+            }
+            if (i == _len) return true;
+            i++;
+        }
+        if (i < _len && levelFromChar(_line[i]) <= NONE) return false;
+        if (i + 1 < _len && _line[i + 1] != ' ') return false;
+        if (i + 2 < _len && _line[i + 2] != '(') return false;
+        return true;
+    }
+
+    // Parse the buffered header; on success set *level and copy the tag
+    bool parseHeader(uint8_t* level, char* tag) const {
+        int i = 0;
+        if (_len > 0 && _line[0] == 0x1B) {  // ESC [ ... m
+            while (i < _len && _line[i] != 'm') i++;
+            i++;
+        }
+        if (i + 4 > _len) return false;
+        int lv = levelFromChar(_line[i]);
+        if (lv <= NONE || _line[i + 1] != ' ' || _line[i + 2] != '(') return false;
+        i += 3;
+        while (i < _len && _line[i] != ')') i++;  // Ticks or hh:mm:ss.mmm
+        if (i + 2 >= _len || _line[i + 1] != ' ') return false;
+        i += 2;
+        // Tags longer than TAG_LEN - 1 are kept as that prefix
+        int t = 0;
+        while (i < _len && _line[i] != ':' && t < TAG_LEN - 1) tag[t++] = _line[i++];
+        while (i < _len && _line[i] != ':') i++;
+        if (i >= _len || t == 0) return false;
+        tag[t] = '\0';
+        *level = (uint8_t)lv;
+        return true;
+    }
+
+    void decide(ByteRing& out) {
+        uint8_t level;
+        char name[TAG_LEN];
+        if (parseHeader(&level, name)) {
+            _tag = findTag(name);
+            _pass = level <= effectiveLevel(_tag, name);
+        } else {
+            _tag = findTag("-");
+            _pass = true;
+        }
+        if (_tag) {
+            _tag->lines++;
+            _tag->bytes += _len;
+            if (!_pass) _tag->filtered++;
+        }
+        if (_pass) {
+            if (_timestamps) {
+                char ts[24];
+                int n = snprintf(ts, sizeof(ts), "[%5lu.%06lu] ", (unsigned long)(_startUs / 1000000),
+                                 (unsigned long)(_startUs % 1000000));
+                out.write((const uint8_t*)ts, n);
+            }
+            out.write(_line, _len);
+        }
+        _state = BODY;
+    }
+
+    void endLine() {
+        _state = LINE_START;
+        _tag = nullptr;
+    }
+
+    TagStats* findTag(const char* name) {
+        for (int i = 0; i < _tagCount; i++) {
+            if (!strcmp(_tags[i].name, name)) return &_tags[i];
+        }
+        if (_tagCount == MAX_TAGS - 1) {
+            // Last slot collects every further tag
+            name = "+";
+        } else if (_tagCount == MAX_TAGS) {
+            return &_tags[MAX_TAGS - 1];
+        }
+        TagStats* t = &_tags[_tagCount];
+        strncpy(t->name, name, TAG_LEN - 1);
+        t->gen = 0;
+        _tagCount++;
+        return t;
+    }
+
+    // The "+" slot only counts: its tags are looked up by their own name
+    uint8_t effectiveLevel(TagStats* t, const char* name) {
+        if (_tagCount == MAX_TAGS && t == &_tags[MAX_TAGS - 1]) return ruleLevel(name);
+        uint32_t gen = _rulesGen;
+        if (t->gen != gen) {
+            t->level = ruleLevel(t->name);
+            t->gen = gen;
+        }
+        return t->level;
+    }
+
+    uint8_t ruleLevel(const char* name) const {
+        uint8_t level = _level;
+        for (int i = 0; i < _ruleCount; i++) {
+            if (!strcmp(_rules[i].tag, name)) level = _rules[i].level;
+        }
+        return level;
+    }
+
+    // Rules: written by the loop task
+    volatile uint8_t _level;
+    volatile bool _timestamps;
+    Rule _rules[MAX_RULES];
+    volatile int _ruleCount;
+    volatile uint32_t _rulesGen;
+
+    // Tags and line state: written by the event task
+    TagStats _tags[MAX_TAGS];
+    volatile int _tagCount;
+    uint8_t _line[HEADER_MAX];
+    int _len;
+    State _state;
+    bool _pass;
+    TagStats* _tag;
+    uint64_t _startUs;
+};
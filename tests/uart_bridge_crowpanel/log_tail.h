@@ -0,0 +1,221 @@
+/*
+ * Live log tail for the Cardputer display, colored by ESP_LOG level
+ *
+ * Lines arrive from the loop task (the capture scanner, not the UART
+ * event task) and only go into a small model: text without ANSI escapes,
+ * plus a color from the level letter. Nothing is drawn then.
+ *
+ * The view works like a display's hardware scroll, in RAM. The ST7789
+ * scrolls along its native rows, which run left-right in the Cardputer's
+ * landscape rotation, so it cannot scroll text lines itself. Instead:
+ *
+ * - An 8-bit canvas holds one slot per text row, used as a ring.
+ * - A refresh draws only the lines added since the last one, into the
+ *   slots after the newest, and moves the start slot.
+ * - The canvas is then pushed as two clipped pieces: start slot to the
+ *   end, then slot 0 to the start.
+ *
+ * Each line is rasterised once, whatever the scroll distance. A refresh
+ * costs one panel-area push, and the refresh interval grows with the
+ * data rate. refresh() is also skipped while the bridge ring is filling
+ * (USB behind), so the display never takes time forwarding needs.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+
+class LogTail {
+public:
+    static constexpr int COLS = 40;       // Font0 glyphs across 240 px
+    static constexpr int MAX_ROWS = 16;
+    static constexpr uint8_t BUSY_RING_PCT = 50;  // Bridge ring fill that defers a refresh
+
+    struct Stats {
+        uint32_t lines;
+        uint32_t refreshes;
+        uint32_t refreshUs;  // Total
+        uint32_t deferred;   // Skipped: bridge ring busy
+        uint32_t linesSkipped;  // Scrolled past between refreshes, never drawn
+    };
+
+    LogTail() : _lcd(nullptr), _x(0), _y(0), _w(0), _rows(0), _rowH(0), _start(0), _seq(0), _drawnSeq(0),
+                _lastMs(0), _dirty(false) {
+        memset(_lines, 0, sizeof(_lines));
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    bool begin(LovyanGFX* lcd, int x, int y, int w, int rows, int rowH) {
+        _lcd = lcd;
+        _x = x;
+        _y = y;
+        _w = w;
+        _rows = rows > MAX_ROWS ? MAX_ROWS : rows;
+        _rowH = rowH;
+        _canvas.setColorDepth(8);
+        if (!_canvas.createSprite(w, _rows * rowH)) return false;
+        _canvas.setFont(&fonts::Font0);
+        _canvas.setTextSize(1);
+        _canvas.fillScreen(TFT_BLACK);
+        return true;
+    }
+
+    // --- Model (loop task) ---
+
+    void addLine(const char* text, size_t len) {
+        Line& l = _lines[_seq % MAX_ROWS];
+        int n = 0;
+        for (size_t i = 0; i < len && n < COLS; i++) {
+            char c = text[i];
+            if (c == 0x1B) {  // ESC [ ... letter
+                while (i + 1 < len && !isalpha((unsigned char)text[i + 1])) i++;
+                i++;
+                continue;
+            }
+            if (c == '\t') c = ' ';
+            if (c >= 0x20 && c < 0x7F) l.text[n++] = c;
+        }
+        l.text[n] = '\0';
+        l.color = levelColor(l.text);
+        _seq++;
+        _stats.lines++;
+        _dirty = true;
+    }
+
+    // --- View (loop task) ---
+
+    // Refresh when due: every intervalFor(rate) ms, not while the bridge
+    // ring is busy
+    void service(uint32_t nowMs, uint32_t bytesPerSec, uint8_t ringPct) {
+        if (!_dirty || nowMs - _lastMs < intervalFor(bytesPerSec)) return;
+        if (ringPct >= BUSY_RING_PCT) {
+            _stats.deferred++;
+            return;
+        }
+        _lastMs = nowMs;
+        refresh();
+    }
+
+    // Next refresh redraws every row (after the screen was cleared)
+    void invalidate() {
+        _drawnSeq = _seq > (uint32_t)_rows ? _seq - _rows : 0;
+        _start = 0;
+        _canvas.fillScreen(TFT_BLACK);
+        _dirty = true;
+        _lastMs = 0;
+    }
+
+    void refresh() {
+        if (!_lcd) return;
+        uint32_t t0 = micros();
+        // Draw new lines into the slots after the newest; the oldest
+        // visible slot (the start) moves along with them
+        uint32_t from = _drawnSeq;
+        if (_seq - from > (uint32_t)_rows) {
+            _stats.linesSkipped += _seq - from - _rows;
+            from = _seq - _rows;
+        }
+        for (uint32_t s = from; s < _seq; s++) {
+            const Line& l = _lines[s % MAX_ROWS];
+            int slot = (int)(s % _rows);
+            int y = slot * _rowH;
+            _canvas.fillRect(0, y, _w, _rowH, TFT_BLACK);
+            _canvas.setTextColor(l.color, TFT_BLACK);
+            _canvas.drawString(l.text, 0, y);
+        }
+        _drawnSeq = _seq;
+        _start = _seq >= (uint32_t)_rows ? (int)(_seq % _rows) : 0;
+
+        // Start slot at the top, the slots before it below
+        int h = _rows * _rowH;
+        int split = (_rows - _start) * _rowH;
+        _lcd->startWrite();
+        _lcd->setClipRect(_x, _y, _w, split);
+        _canvas.pushSprite(_lcd, _x, _y - _start * _rowH);
+        if (_start > 0) {
+            _lcd->setClipRect(_x, _y + split, _w, h - split);
+            _canvas.pushSprite(_lcd, _x, _y + split);
+        }
+        _lcd->clearClipRect();
+        _lcd->endWrite();
+
+        _dirty = false;
+        _stats.refreshes++;
+        _stats.refreshUs += micros() - t0;
+    }
+
+    // ms between refreshes: every new line while the rate is low, down to
+    // 2 Hz when the display could not keep up anyway
+    static uint32_t intervalFor(uint32_t bytesPerSec) {
+        if (bytesPerSec < 2000) return 50;
+        if (bytesPerSec < 10000) return 100;
+        if (bytesPerSec < 40000) return 250;
+        return 500;
+    }
+
+    const Stats& stats() const { return _stats; }
+
+private:
+    struct Line {
+        char text[COLS + 1];
+        uint16_t color;
+    };
+
+    // "[ESC..m]L (" with the escape already stripped
+    static uint16_t levelColor(const char* text) {
+        if (!text[0] || text[1] != ' ' || text[2] != '(') return TFT_WHITE;
+        switch (text[0]) {
+            case 'E': return TFT_RED;
+            case 'W': return TFT_YELLOW;
+            case 'I': return TFT_GREEN;
+            case 'D': return TFT_CYAN;
+            case 'V': return TFT_DARKGREY;
+            default: return TFT_WHITE;
+        }
+    }
+
+    LovyanGFX* _lcd;
+    M5Canvas _canvas;
+    int _x, _y, _w, _rows, _rowH;
+    int _start;          // Canvas slot shown at the top
+    Line _lines[MAX_ROWS];
+    uint32_t _seq;       // Lines added so far
+    uint32_t _drawnSeq;  // Lines drawn into the canvas so far
+    uint32_t _lastMs;
+    bool _dirty;
+    Stats _stats;
+};
+
+// Bytes/s history drawn as bars (one per status interval)
+class RateSparkline {
+public:
+    static constexpr int SAMPLES = 60;
+
+    RateSparkline() : _next(0), _count(0) { memset(_samples, 0, sizeof(_samples)); }
+
+    void add(uint32_t bytesPerSec) {
+        _samples[_next] = bytesPerSec;
+        _next = (_next + 1) % SAMPLES;
+        if (_count < SAMPLES) _count++;
+    }
+
+    // Scaled to the largest sample shown; newest on the right
+    void draw(LovyanGFX* lcd, int x, int y, int h, uint16_t color) {
+        uint32_t peak = 1;
+        for (int i = 0; i < _count; i++) peak = max(peak, _samples[i]);
+        lcd->startWrite();
+        lcd->fillRect(x, y, SAMPLES, h, TFT_BLACK);
+        for (int i = 0; i < _count; i++) {
+            uint32_t v = _samples[(_next - _count + i + SAMPLES) % SAMPLES];
+            int bar = (int)((uint64_t)v * h / peak);
+            if (v > 0 && bar == 0) bar = 1;
+            if (bar > 0) lcd->drawFastVLine(x + SAMPLES - _count + i, y + h - bar, bar, color);
+        }
+        lcd->endWrite();
+    }
+
+private:
+    uint32_t _samples[SAMPLES];
+    int _next;
+    int _count;
+};
@@ -0,0 +1,104 @@
+/*
+ * Optional compressed transport on the UART -> USB path
+ *
+ * While enabled, the (filtered) log text is collected in a staging ring
+ * in the UART event task and encoded into log_codec.h frames, which go
+ * to the bridge ring instead of the text. host/log_decode.cpp turns the
+ * USB stream back into text and reports the compression ratio and lost
+ * frames.
+ *
+ * During a burst only full frames are sent; what is left is sent when
+ * the burst ends (the UART driver buffer is empty), so a line is never
+ * held back waiting for more data.
+ * A frame goes to the bridge ring whole or not at all (a cut frame would
+ * merge with the next one on the host); when it doesn't fit the next one
+ * is a key frame, so the host recovers right after the loss.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "byte_ring.h"
+#include "log_codec.h"
+
+class LogTransport {
+public:
+    static constexpr uint32_t STAGE_SIZE = 4096;  // Filtered text not yet framed
+
+    LogTransport() : _enabled(false), _keyRequest(true), _ringLost(0) {}
+
+    bool begin() { return _stage.begin(STAGE_SIZE); }
+
+    // Loop task
+    void setEnabled(bool on) {
+        if (on && !_enabled) _keyRequest = true;
+        _enabled = on;
+    }
+    bool enabled() const { return _enabled; }
+
+    // --- Data path (UART event task) ---
+
+    // Where the filter writes while the transport is enabled
+    ByteRing& input() { return _stage; }
+
+    // Encode the staged text into frames in out: whole frames during a
+    // burst, the rest once it ends
+    void flush(ByteRing& out, bool burstEnd) {
+        if (_keyRequest) {
+            _keyRequest = false;
+            _encoder.forceKey();
+        }
+        for (;;) {
+            uint32_t used = _stage.used();
+            if (used == 0 || (used < (uint32_t)logcodec::FRAME_MAX && !burstEnd)) return;
+            uint8_t text[logcodec::FRAME_MAX];
+            uint32_t n = 0;
+            while (n < sizeof(text)) {  // The frame may wrap around the ring end
+                uint32_t span;
+                const uint8_t* p = _stage.readSpan(&span);
+                if (span == 0) break;
+                if (span > sizeof(text) - n) span = sizeof(text) - n;
+                memcpy(text + n, p, span);
+                _stage.consume(span);
+                n += span;
+            }
+            _encoder.encode(text, n, [&](const uint8_t* frame, size_t len) {
+                if (out.space() < len) {
+                    _ringLost++;
+                    _encoder.forceKey();
+                    return;
+                }
+                out.write(frame, len);
+            });
+        }
+    }
+
+    // Handle "transport on|off|stats" (without "~~"); false if not ours
+    bool command(const char* line, Print& out) {
+        char arg[8] = "";
+        if (sscanf(line, "transport %7s", arg) != 1) return false;
+        if (!strcmp(arg, "on")) setEnabled(true);
+        else if (!strcmp(arg, "off")) setEnabled(false);
+        printStats(out);
+        return true;
+    }
+
+    void printStats(Print& out) {
+        const logcodec::Encoder::Stats& s = _encoder.stats();
+        uint32_t raw = s.rawBytes, wire = s.wireBytes;
+        out.printf("[bridge] transport %s: %lu frames, %lu -> %lu bytes (%lu.%02lux), %lu lost (ring full), %lu bytes lost (stage full)\n",
+                   _enabled ? "on" : "off", (unsigned long)s.frames, (unsigned long)raw,
+                   (unsigned long)wire, (unsigned long)(wire ? raw / wire : 0),
+                   (unsigned long)(wire ? raw * 100ull / wire % 100 : 0), (unsigned long)_ringLost,
+                   (unsigned long)_stage.dropped());
+    }
+
+    const logcodec::Encoder::Stats& stats() const { return _encoder.stats(); }
+
+private:
+    volatile bool _enabled;
+    volatile bool _keyRequest;
+    ByteRing _stage;
+    logcodec::Encoder _encoder;
+    volatile uint32_t _ringLost;  // Frames not sent: bridge ring full
+};
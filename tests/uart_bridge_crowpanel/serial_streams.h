@@ -0,0 +1,61 @@
+/*
+ * byte_stream.h ports for the Cardputer: a HardwareSerial UART and the
+ * USB CDC Serial
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "byte_stream.h"
+
+class SerialUart : public UartStream {
+public:
+    explicit SerialUart(HardwareSerial& uart) : _uart(uart) {}
+
+    void begin(const Setup& s, DataFn onData, ErrorFn onError, void* ctx) override {
+        // Buffer sizes must be set before begin()
+        _uart.setRxBufferSize(s.rxBuffer);
+        _uart.setTxBufferSize(s.txBuffer);
+        _uart.begin(s.baud, SERIAL_8N1, s.rxPin, s.txPin);
+        _uart.setRxFIFOFull(s.fifoFull);
+        _uart.setRxTimeout(s.rxTimeout);
+        _uart.onReceiveError([onError, ctx](hardwareSerial_error_t err) { onError(lineError(err), ctx); });
+        _uart.onReceive([onData, ctx]() { onData(ctx); }, false);
+    }
+
+    // Driver buffers are kept
+    void setBaud(uint32_t baud) override { _uart.updateBaudRate(baud); }
+
+    int available() override { return _uart.available(); }
+    size_t read(uint8_t* buf, size_t len) override { return _uart.read(buf, len); }
+    int availableForWrite() override { return _uart.availableForWrite(); }
+    size_t write(const uint8_t* data, size_t len) override { return _uart.write(data, len); }
+
+private:
+    static LineError lineError(hardwareSerial_error_t err) {
+        switch (err) {
+            case UART_FIFO_OVF_ERROR:    return LINE_FIFO_OVERFLOW;
+            case UART_BUFFER_FULL_ERROR: return LINE_BUFFER_FULL;
+            case UART_FRAME_ERROR:       return LINE_FRAME_ERROR;
+            case UART_PARITY_ERROR:      return LINE_PARITY_ERROR;
+            case UART_BREAK_ERROR:       return LINE_BREAK;
+            default:                     return LINE_OTHER;
+        }
+    }
+
+    HardwareSerial& _uart;
+};
+
+// Any Arduino Stream; the USB Serial on the Cardputer
+class SerialPort : public ByteStream {
+public:
+    explicit SerialPort(Stream& s) : _s(s) {}
+
+    int available() override { return _s.available(); }
+    size_t read(uint8_t* buf, size_t len) override { return _s.readBytes(buf, len); }
+    int availableForWrite() override { return _s.availableForWrite(); }
+    size_t write(const uint8_t* data, size_t len) override { return _s.write(data, len); }
+
+private:
+    Stream& _s;
+};
@@ -0,0 +1,354 @@
+/*
+ * Block-based UART <-> USB CDC bridge engine
+ *
+ * UART -> USB: the UART driver moves the hardware FIFO into its RX
+ * buffer when the FIFO passes a threshold or the line goes idle. Each
+ * of those events calls onUartData() (in the driver's event task),
+ * which reads everything available straight into a large ring with one
+ * block read. service() (from loop()) writes the ring to USB in chunks
+ * no larger than what the CDC TX buffer will take, so it never blocks;
+ * a host that stops reading only fills the ring.
+ *
+ * USB -> UART works the same way in reverse, with a smaller ring.
+ *
+ * Every place bytes can be lost is counted: hardware FIFO overflow and
+ * driver buffer full (UART driver), ring full (bridge), plus framing
+ * and parity errors, which usually mean the wrong baud rate.
+ *
+ * A processor (log_filter.h) can sit between the UART and the ring, and
+ * console lines from USB that start with "~~" are handed to a command
+ * handler instead of the UART. With several ports, a drain function
+ * (channel_mux.h) empties the ring to USB instead, and ports other than
+ * the first have no USB -> UART path (txRing 0).
+ *
+ * The UART and USB are byte_stream.h interfaces, so this file needs no
+ * Arduino: serial_streams.h adapts HardwareSerial (Arduino-ESP32 2.0.6
+ * or later, for onReceive()/onReceiveError()) and Serial, and
+ * host/bridge_harness.cpp runs the same code over Linux ptys.
+ */
+
+#pragma once
+
+#include <string.h>
+#include "byte_ring.h"
+#include "byte_stream.h"
+
+// Receives UART bytes instead of the ring while set (baud search)
+typedef void (*RxTapFn)(const uint8_t* data, size_t len, void* ctx);
+// Writes what it keeps of the received bytes to out; called with len 0
+// once the driver buffer is empty (end of a burst)
+typedef void (*RxProcessFn)(const uint8_t* data, size_t len, ByteRing& out, void* ctx);
+// A "~~" console line, without the prefix and line ending
+typedef void (*CommandFn)(const char* line, void* ctx);
+// Empties the ring to USB; returns the bytes written
+typedef size_t (*RxDrainFn)(ByteRing& ring, void* ctx);
+
+class UartBridge {
+public:
+    struct Config {
+        uint32_t baud;
+        int8_t rxPin;
+        int8_t txPin;
+        uint32_t uartRxBuffer;  // UART driver RX buffer (bytes)
+        uint32_t uartTxBuffer;  // UART driver TX buffer (bytes)
+        uint32_t rxRing;        // UART -> USB ring (bytes, power of two)
+        uint32_t txRing;        // USB -> UART ring (bytes, power of two; 0 = RX only)
+        uint8_t fifoFull;       // FIFO threshold for an RX event (bytes, < 128)
+        uint8_t rxTimeout;      // Idle time for an RX event (symbols)
+        uint16_t usbChunk;      // Largest single CDC write
+    };
+
+    struct Stats {
+        uint32_t uartToUsb;      // Bytes written to USB
+        uint32_t usbToUart;      // Bytes written to the UART
+        uint32_t rxEvents;       // onUartData() calls
+        uint32_t fifoOverflows;  // Hardware FIFO overflowed (driver too slow)
+        uint32_t bufferFull;     // Driver RX buffer full (bridge too slow)
+        uint32_t ringDropped;    // UART -> USB bytes lost, ring full
+        uint32_t txDropped;      // USB -> UART bytes lost, ring full
+        uint32_t frameErrors;
+        uint32_t parityErrors;
+        uint32_t breaks;
+        uint32_t usbStalls;      // service() found USB unable to take data
+        uint32_t ringPeak;       // Highest UART -> USB ring fill (bytes)
+    };
+
+    static Config defaultConfig(uint32_t baud, int8_t rxPin, int8_t txPin) {
+        Config c;
+        c.baud = baud;
+        c.rxPin = rxPin;
+        c.txPin = txPin;
+        c.uartRxBuffer = 4096;
+        c.uartTxBuffer = 1024;
+        c.rxRing = 32768;
+        c.txRing = 2048;
+        c.fifoFull = 64;   // 0.7 ms of data at 921600 baud, 64 bytes left in the FIFO
+        c.rxTimeout = 2;
+        c.usbChunk = 512;
+        return c;
+    }
+
+    UartBridge(UartStream& uart, ByteStream& usb)
+        : _uart(uart), _usb(usb), _tap(nullptr), _tapCtx(nullptr), _process(nullptr),
+          _processCtx(nullptr), _drain(nullptr), _drainCtx(nullptr), _command(nullptr), _commandCtx(nullptr),
+          _cmdState(CMD_LINE_START), _cmdLen(0), _lastUsb(0) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    bool begin(const Config& cfg) {
+        _cfg = cfg;
+        if (!_rx.begin(cfg.rxRing) || (cfg.txRing && !_tx.begin(cfg.txRing))) return false;
+
+        UartStream::Setup setup = {cfg.baud,         cfg.rxPin,    cfg.txPin,    cfg.uartRxBuffer,
+                                   cfg.uartTxBuffer, cfg.fifoFull, cfg.rxTimeout};
+        _uart.begin(setup, dataEntry, errorEntry, this);
+        return true;
+    }
+
+    // Call from loop(): drains both rings without blocking
+    void service() {
+        if (_cfg.txRing) {
+            usbToRing();
+            ringToUart();
+        }
+        if (_drain) _stats.uartToUsb += _drain(_rx, _drainCtx);
+        else ringToUsb();
+    }
+
+    // Change the UART rate at runtime (driver buffers are kept)
+    void setBaud(uint32_t baud) {
+        _uart.setBaud(baud);
+        _cfg.baud = baud;
+    }
+
+    // While a tap is set, received bytes go to it and not to USB
+    void setRxTap(RxTapFn fn, void* ctx) {
+        _tapCtx = ctx;
+        _tap = fn;
+    }
+
+    void setRxProcessor(RxProcessFn fn, void* ctx) {
+        _processCtx = ctx;
+        _process = fn;
+    }
+
+    // Before begin() or from the loop task
+    void setRxDrain(RxDrainFn fn, void* ctx) {
+        _drainCtx = ctx;
+        _drain = fn;
+    }
+
+    void setCommandHandler(CommandFn fn, void* ctx) {
+        _command = fn;
+        _commandCtx = ctx;
+    }
+
+    // Handle bytes as if just received: through the processor (filter,
+    // capture, framing) when one is set. Only while a tap is set: the
+    // event task neither processes nor writes the ring then.
+    void injectRx(const uint8_t* data, size_t len) {
+        RxProcessFn process = _process;
+        if (!process) {
+            _rx.write(data, len);
+            return;
+        }
+        process(data, len, _rx, _processCtx);
+        process(nullptr, 0, _rx, _processCtx);  // End of the burst
+    }
+
+    uint32_t baud() const { return _cfg.baud; }
+    uint32_t rxRingUsed() const { return _rx.used(); }
+    uint32_t rxRingSize() const { return _rx.capacity(); }
+    // Last byte ringToUsb() sent (0 before any): 0x00 ends a frame
+    uint8_t lastUsbByte() const { return _lastUsb; }
+
+    Stats stats() const {
+        Stats s = _stats;
+        s.ringDropped = _rx.dropped();
+        s.txDropped = _tx.dropped();
+        s.ringPeak = _rx.peak();
+        return s;
+    }
+    void resetPeak() { _rx.resetPeak(); }
+
+private:
+    static void dataEntry(void* ctx) { static_cast<UartBridge*>(ctx)->onUartData(); }
+    static void errorEntry(LineError err, void* ctx) { static_cast<UartBridge*>(ctx)->onUartError(err); }
+
+    static uint32_t least(uint32_t a, uint32_t b) { return a < b ? a : b; }
+
+    // UART driver event task: FIFO threshold reached or line idle
+    void onUartData() {
+        _stats.rxEvents++;
+        bool processed = false;
+        for (;;) {
+            int avail = _uart.available();
+            if (avail <= 0) break;
+            RxTapFn tap = _tap;
+            if (tap) {
+                uint8_t scratch[64];
+                size_t n = _uart.read(scratch, least(sizeof(scratch), avail));
+                tap(scratch, n, _tapCtx);
+                continue;
+            }
+            RxProcessFn process = _process;
+            if (process) {
+                uint8_t scratch[128];
+                size_t n = _uart.read(scratch, least(sizeof(scratch), avail));
+                process(scratch, n, _rx, _processCtx);
+                processed = true;
+                continue;
+            }
+            uint32_t span;
+            uint8_t* p = _rx.writeSpan(&span);
+            if (span == 0) {
+                // Ring full: keep the driver buffer moving, count the loss
+                uint8_t scratch[64];
+                size_t n = _uart.read(scratch, least(sizeof(scratch), avail));
+                _rx.drop(n);
+                continue;
+            }
+            size_t n = _uart.read(p, least(avail, span));
+            if (n == 0) break;
+            _rx.commit(n);
+        }
+        RxProcessFn process = _process;
+        if (processed && process) process(nullptr, 0, _rx, _processCtx);
+    }
+
+    void onUartError(LineError err) {
+        switch (err) {
+            case LINE_FIFO_OVERFLOW: _stats.fifoOverflows++; break;
+            case LINE_BUFFER_FULL:   _stats.bufferFull++; break;
+            case LINE_FRAME_ERROR:   _stats.frameErrors++; break;
+            case LINE_PARITY_ERROR:  _stats.parityErrors++; break;
+            case LINE_BREAK:         _stats.breaks++; break;
+            default: break;
+        }
+    }
+
+    void ringToUsb() {
+        for (;;) {
+            uint32_t span;
+            const uint8_t* p = _rx.readSpan(&span);
+            if (span == 0) return;
+            int room = _usb.availableForWrite();
+            if (room <= 0) {
+                _stats.usbStalls++;
+                return;
+            }
+            uint32_t n = least(span, least(room, _cfg.usbChunk));
+            size_t written = _usb.write(p, n);
+            if (written) _lastUsb = p[written - 1];
+            _rx.consume(written);
+            _stats.uartToUsb += written;
+            if (written < n) return;
+        }
+    }
+
+    void usbToRing() {
+        if (_command) {
+            usbToRingWithCommands();
+            return;
+        }
+        for (;;) {
+            int avail = _usb.available();
+            if (avail <= 0) return;
+            uint32_t span;
+            uint8_t* p = _tx.writeSpan(&span);
+            if (span == 0) {
+                uint8_t scratch[64];
+                _tx.drop(_usb.read(scratch, least(sizeof(scratch), avail)));
+                continue;
+            }
+            size_t n = _usb.read(p, least(avail, span));
+            if (n == 0) return;
+            _tx.commit(n);
+        }
+    }
+
+    // Console input is typed, so byte-wise scanning costs nothing here
+    void usbToRingWithCommands() {
+        uint8_t buf[64];
+        for (;;) {
+            int avail = _usb.available();
+            if (avail <= 0) return;
+            size_t n = _usb.read(buf, least(sizeof(buf), avail));
+            if (n == 0) return;
+            for (size_t i = 0; i < n; i++) {
+                uint8_t c = buf[i];
+                if (_cmdState == CMD_END_CR) {
+                    _cmdState = CMD_LINE_START;
+                    if (c == '\n') continue;  // CR LF after a command
+                }
+                switch (_cmdState) {
+                    case CMD_LINE_START:
+                    case CMD_TILDE:
+                        if (c == '~') {
+                            if (_cmdState == CMD_TILDE) {
+                                _cmdState = CMD_COMMAND;
+                                _cmdLen = 0;
+                            } else {
+                                _cmdState = CMD_TILDE;
+                            }
+                            continue;
+                        }
+                        if (_cmdState == CMD_TILDE) _tx.write((const uint8_t*)"~", 1);
+                        _cmdState = (c == '\n' || c == '\r') ? CMD_LINE_START : CMD_PASS;
+                        _tx.write(&c, 1);
+                        break;
+                    case CMD_PASS:
+                        if (c == '\n' || c == '\r') _cmdState = CMD_LINE_START;
+                        _tx.write(&c, 1);
+                        break;
+                    case CMD_COMMAND:
+                        if (c == '\n' || c == '\r') {
+                            _cmdBuf[_cmdLen] = '\0';
+                            _command(_cmdBuf, _commandCtx);
+                            _cmdState = c == '\r' ? CMD_END_CR : CMD_LINE_START;
+                        } else if (_cmdLen < sizeof(_cmdBuf) - 1) {
+                            _cmdBuf[_cmdLen++] = (char)c;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    void ringToUart() {
+        for (;;) {
+            uint32_t span;
+            const uint8_t* p = _tx.readSpan(&span);
+            if (span == 0) return;
+            int room = _uart.availableForWrite();
+            if (room <= 0) return;
+            size_t written = _uart.write(p, least(span, room));
+            _tx.consume(written);
+            _stats.usbToUart += written;
+            if (written == 0) return;
+        }
+    }
+
+    UartStream& _uart;
+    ByteStream& _usb;
+    Config _cfg;
+    ByteRing _rx;  // UART -> USB
+    ByteRing _tx;  // USB -> UART
+    Stats _stats;
+    volatile RxTapFn _tap;
+    void* volatile _tapCtx;
+    volatile RxProcessFn _process;
+    void* volatile _processCtx;
+    RxDrainFn _drain;
+    void* _drainCtx;
+
+    enum CmdState { CMD_LINE_START, CMD_TILDE, CMD_COMMAND, CMD_PASS, CMD_END_CR };
+    CommandFn _command;
+    void* _commandCtx;
+    CmdState _cmdState;
+    char _cmdBuf[64];
+    size_t _cmdLen;
+    uint8_t _lastUsb;  // Written and read by the loop() task
+};
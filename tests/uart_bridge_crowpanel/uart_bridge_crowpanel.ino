@@ -5,6 +5,31 @@
  * Receives ESP_LOG data from CrowPanel UART1 (GPIO47/48)
  * via Cardputer Grove Port and forwards to USB Serial Monitor.
  *
+ * Forwarding is block-based (uart_bridge.h): UART driver events fill a
+ * 32 KB ring, loop() empties it into USB CDC in chunks. Bursts and a
+ * slow host are absorbed by the ring; every lost byte is counted.
+ *
+ * The CrowPanel rate is found by auto_baud.h (candidate rates checked
+ * for framing errors and plausible log text), or follows the terminal's
+ * baud setting when the USB port is TinyUSB CDC (USB Mode: USB-OTG).
+ *
+ * log_filter.h parses the ESP_LOG lines on the way: level/tag filters
+ * and bridge timestamps, set from the terminal with "~~" commands.
+ * "~~transport on" switches the USB stream to compressed frames
+ * (log_transport.h); host/log_decode.cpp turns them back into text.
+ *
+ * log_capture.h keeps the last 64 KB of raw UART data; a crash line
+ * ("Guru Meditation", "abort()", or a "~~trigger") saves the lines
+ * around it to SD (or flash) under /capture.
+ *
+ * The display shows a live tail of the log, colored by level, under a
+ * status line with a bytes/s sparkline (log_tail.h); key 'v' switches
+ * to the full status screen.
+ *
+ * MULTI_PORT 1 bridges a second board on UART2 as well. Both ports go
+ * out as channel-tagged frames (channel_mux.h), which host/demux.cpp
+ * splits into one log file per port.
+ *
  * Wiring (CrowPanel J2 -> Cardputer Grove):
  *   CrowPanel GPIO47 (TX) -> Cardputer G1 (RX)
  *   CrowPanel GPIO48 (RX) <- Cardputer G2 (TX)  [optional]
@@ -13,24 +38,222 @@
  */
 
 #include <M5Cardputer.h>
+#include "uart_bridge.h"
+#include "serial_streams.h"
+#include "auto_baud.h"
+#include "log_filter.h"
+#include "log_transport.h"
+#include "log_capture.h"
+#include "log_tail.h"
+#include "channel_mux.h"
+#include <SD.h>
+#include <SPI.h>
+#include <LittleFS.h>
 
 #define CROWN_RX_PIN  1   // Cardputer G1 <- CrowPanel TX (GPIO47)
 #define CROWN_TX_PIN  2   // Cardputer G2 -> CrowPanel RX (GPIO48)
-#define BAUD_RATE     115200
+#define BAUD_RATE     115200  // Starting CrowPanel rate; 921600 and up work too
+#define AUTO_BAUD     1       // 0 = stay on BAUD_RATE (unless the host sets a rate)
+#define HOST_AUTO_BAUD 300    // Terminal set to this rate -> search again
+#define AUTO_BAUD_KEY 'a'     // Cardputer key: search again
+#define LOG_FILTER    1       // 0 = forward bytes untouched
+#define LOG_TRANSPORT 0       // 1 = start with compressed frames (needs host/log_decode)
+#define CAPTURE       1       // 0 = no crash capture
+#define CAPTURE_RING  65536   // Raw UART history (internal RAM: no PSRAM on v1.1)
+#define CAPTURE_PRE   16384   // Saved before the trigger line
+#define CAPTURE_POST  8192    // Saved after it
+#define CAPTURE_DIR   "/capture"
+#define CAPTURE_KEY   'c'     // Cardputer key: capture now
+#define LOG_TAIL      1       // Live log on the display (uses the capture ring)
+#define VIEW_KEY      'v'     // Cardputer key: log tail <-> status screen
+#define MULTI_PORT    0       // 1 = also bridge UART2; channel-tagged frames (needs host/demux)
+#define PORT2_RX_PIN  2       // G2 <- second board's TX (the Grove TX pin: port 1 becomes RX only)
+#define PORT2_BAUD    115200
+#define TAIL_Y        11      // Below the status line
+#define TAIL_ROW_H    9
+#define TAIL_ROWS     13
+
+// Cardputer microSD (HSPI)
+#define SD_SCK   40
+#define SD_MISO  39
+#define SD_MOSI  14
+#define SD_CS    12
+
+#define USB_TX_BUFFER      4096  // CDC TX buffer (Hardware CDC only)
+#define STATUS_INTERVAL_MS 1000
+#define KEYBOARD_INTERVAL_MS 20
 
 HardwareSerial CrownSerial(1);
+SerialUart crownUart(CrownSerial);
+SerialPort usbPort(Serial);
+UartBridge bridge(crownUart, usbPort);
+#if MULTI_PORT
+HardwareSerial Port2Serial(2);
+SerialUart port2Uart(Port2Serial);
+UartBridge bridge2(port2Uart, usbPort);
+ChannelFramer framer1(1);
+ChannelFramer framer2(2);
+ChannelMux mux(usbPort, UartBridge::defaultConfig(0, -1, -1).usbChunk);
+#endif
+AutoBaud autoBaud(bridge);
+LogFilter logFilter;
+LogTransport transport;
+LogCapture capture;
+SPIClass sdSPI(HSPI);
+static const char* capture_storage = "none";
+LogTail logTail;
+RateSparkline sparkline;
+static bool tail_view = false;
+static uint32_t last_rate = 0;  // UART -> USB bytes/s over the last status interval
 
-static uint32_t bytes_received = 0;
 static uint32_t last_status_ms = 0;
+static UartBridge::Stats last_stats;
+static uint32_t peak_rate = 0;  // Highest UART -> USB bytes/s
+static uint32_t last_keyboard_ms = 0;
+static volatile uint32_t host_baud = 0;  // Line coding from the host, applied in loop()
 
-void setup() {
-    auto cfg = M5.config();
-    M5Cardputer.begin(cfg);
+#if ARDUINO_USB_CDC_ON_BOOT && !ARDUINO_USB_MODE
+// TinyUSB CDC: the terminal's baud setting arrives as a line coding
+// request. (Hardware CDC/JTAG never sees it.)
+static void onUsbEvent(void*, esp_event_base_t, int32_t id, void* data) {
+    if (id == ARDUINO_USB_CDC_LINE_CODING_EVENT) {
+        host_baud = ((arduino_usb_cdc_event_data_t*)data)->line_coding.bit_rate;
+    }
+}
+#endif
 
-    Serial.begin(BAUD_RATE);
-    CrownSerial.begin(BAUD_RATE, SERIAL_8N1, CROWN_RX_PIN, CROWN_TX_PIN);
+// UART event task: filter, then frame (len 0: end of a burst)
+static void processRx(const uint8_t* data, size_t len, ByteRing& out, void*) {
+    capture.append(data, len);  // Raw, before filtering
+#if MULTI_PORT
+    ByteRing& dest = framer1.input();
+#else
+    ByteRing& dest = transport.enabled() ? transport.input() : out;
+#endif
+#if LOG_FILTER
+    logFilter.process(data, len, dest);
+#else
+    dest.write(data, len);
+#endif
+#if MULTI_PORT
+    framer1.flush(out);
+#else
+    transport.flush(out, len == 0);  // Nothing staged: no-op
+#endif
+}
 
-    M5Cardputer.Display.setRotation(1);
+#if MULTI_PORT
+// Port 2 is forwarded as received: no filter, capture or tail
+static void processRx2(const uint8_t* data, size_t len, ByteRing& out, void*) { framer2.frame(data, len, out); }
+
+static size_t drainPort(ByteRing& ring, void* port) { return mux.drain(ring, (int)(intptr_t)port); }
+#endif
+
+// Command replies are held here and sent from loop() between frames:
+// the handler runs mid-service(), possibly with half a frame on the wire
+class ReplyBuffer : public Print {
+public:
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t len) override {
+        if (len > sizeof(_buf) - _len) len = sizeof(_buf) - _len;  // Truncate, never block
+        memcpy(_buf + _len, data, len);
+        _len += len;
+        return len;
+    }
+    const uint8_t* data() const { return _buf; }
+    size_t size() const { return _len; }
+    void clear() { _len = 0; }
+
+private:
+    uint8_t _buf[1024];
+    size_t _len = 0;
+};
+static ReplyBuffer reply;
+static bool reply_framed = false;
+
+static void bridgeCommand(const char* line, void*) {
+    // In transport mode the reply is its own 0x00-delimited blob, which
+    // log_decode passes through as text; framed if transport was on
+    // before or after the command
+    reply_framed |= transport.enabled() || MULTI_PORT;
+#if MULTI_PORT
+    uint32_t baud2;
+    if (sscanf(line, "port2 %lu", (unsigned long*)&baud2) == 1 && baud2 >= 300) {
+        bridge2.setBaud(baud2);
+        reply.printf("[bridge] port 2 at %lu baud\n", (unsigned long)baud2);
+    } else if (!strncmp(line, "transport", 9)) {
+        reply.println("[bridge] transport: not available with MULTI_PORT");
+    } else
+#endif
+    if (!transport.command(line, reply) && !capture.command(line, reply) && !logFilter.command(line, reply)) {
+        reply.printf("[bridge] unknown: %s\n", line);
+        reply.println("[bridge] ~~level <N|E|W|I|D|V>, ~~tag <name|*> <level>, ~~clear, ~~ts <on|off>, ~~stats,");
+        reply.println("[bridge] ~~transport <on|off|stats>, ~~trigger [<text>|re <regex>|clear], ~~capture [stats]");
+        if (MULTI_PORT) reply.println("[bridge] ~~port2 <baud>");
+    }
+    reply_framed |= transport.enabled();
+}
+
+// Send a queued reply once no frame is part-way out on USB
+static void sendReply() {
+    if (reply.size() == 0) return;
+    if (reply_framed) {
+#if MULTI_PORT
+        if (!mux.idle()) return;
+#else
+        // Frames enter the ring whole, so an empty ring is a boundary too
+        if (bridge.lastUsbByte() != 0 && bridge.rxRingUsed() != 0) return;
+#endif
+        Serial.write((uint8_t)0);
+    }
+    Serial.write(reply.data(), reply.size());
+    if (reply_framed) Serial.write((uint8_t)0);
+    reply.clear();
+    reply_framed = false;
+}
+
+static void tailLine(const char* line, size_t len, void*) { logTail.addLine(line, len); }
+
+// Capture ring; storage on the SD card if present, else the flash filesystem
+static void setupCapture() {
+    if (!capture.begin(CAPTURE_RING, CAPTURE_PRE, CAPTURE_POST)) {
+        M5Cardputer.Display.println("Capture alloc FAILED");
+        return;
+    }
+#if LOG_TAIL
+    capture.setLineHandler(tailLine, nullptr);
+#endif
+#if CAPTURE
+    sdSPI.begin(SD_SCK, SD_MISO, SD_MOSI, SD_CS);
+    if (SD.begin(SD_CS, sdSPI, 25000000)) {
+        capture.setStorage(&SD, CAPTURE_DIR);
+        capture_storage = "SD";
+    } else if (LittleFS.begin(true)) {
+        capture.setStorage(&LittleFS, CAPTURE_DIR);
+        capture_storage = "flash";
+    }
+    capture.addTrigger("Guru Meditation", false);
+    capture.addTrigger("abort()", false);
+    capture.addTrigger("assert failed:", false);
+#endif
+}
+
+// Second port: RX only, its own (smaller) ring, frames for both ports
+static bool setupPort2() {
+#if MULTI_PORT
+    UartBridge::Config cfg = UartBridge::defaultConfig(PORT2_BAUD, PORT2_RX_PIN, -1);
+    cfg.rxRing = 16384;
+    cfg.txRing = 0;
+    if (!framer1.begin() || !framer2.begin() || !bridge2.begin(cfg)) return false;
+    bridge2.setRxProcessor(processRx2, nullptr);
+    bridge.setRxDrain(drainPort, (void*)1);
+    bridge2.setRxDrain(drainPort, (void*)2);
+#endif
+    return true;
+}
+
+// Top of the status screen
+static void drawHeader() {
     M5Cardputer.Display.fillScreen(TFT_BLACK);
     M5Cardputer.Display.setTextColor(TFT_GREEN, TFT_BLACK);
     M5Cardputer.Display.setTextSize(1.5);
@@ -39,30 +262,192 @@ void setup() {
     M5Cardputer.Display.println("CrowPanel -> Mac");
     M5Cardputer.Display.printf("RX pin: G%d\n", CROWN_RX_PIN);
     M5Cardputer.Display.printf("Baud: %d\n", BAUD_RATE);
+}
+
+static void setView(bool tail) {
+    tail_view = tail;
+    if (tail) {
+        M5Cardputer.Display.fillScreen(TFT_BLACK);
+        logTail.invalidate();
+    } else {
+        drawHeader();
+    }
+}
+
+void setup() {
+    auto cfg = M5.config();
+    M5Cardputer.begin(cfg);
+
+#if ARDUINO_USB_MODE
+    Serial.setTxBufferSize(USB_TX_BUFFER);  // Before begin()
+#endif
+#if ARDUINO_USB_CDC_ON_BOOT && !ARDUINO_USB_MODE
+    Serial.onEvent(ARDUINO_USB_CDC_LINE_CODING_EVENT, onUsbEvent);
+#endif
+    Serial.begin(BAUD_RATE);
+
+    M5Cardputer.Display.setRotation(1);
+    drawHeader();
+
+    // With a second port on G2, port 1 has no TX pin
+    int8_t txPin = (MULTI_PORT && PORT2_RX_PIN == CROWN_TX_PIN) ? -1 : CROWN_TX_PIN;
+    if (!bridge.begin(UartBridge::defaultConfig(BAUD_RATE, CROWN_RX_PIN, txPin)) || !transport.begin() ||
+        !setupPort2()) {
+        M5Cardputer.Display.setTextColor(TFT_RED, TFT_BLACK);
+        M5Cardputer.Display.println("Ring alloc FAILED");
+        for (;;) delay(1000);
+    }
     M5Cardputer.Display.println("Waiting for data...");
+#if CAPTURE || LOG_TAIL
+    setupCapture();
+#endif
+#if LOG_TAIL
+    if (logTail.begin(&M5Cardputer.Display, 0, TAIL_Y, 240, TAIL_ROWS, TAIL_ROW_H)) {
+        delay(1000);  // Leave the start screen up for a moment
+        setView(true);
+    }
+#endif
+    transport.setEnabled(LOG_TRANSPORT);
+    bridge.setRxProcessor(processRx, nullptr);
+    bridge.setCommandHandler(bridgeCommand, nullptr);
+#if AUTO_BAUD
+    autoBaud.search();
+#endif
 
     Serial.println("\n=== CrowPanel UART Bridge ===");
-    Serial.printf("RX from CrowPanel on GPIO%d at %d baud\n", CROWN_RX_PIN, BAUD_RATE);
+    Serial.printf("RX from CrowPanel on GPIO%d at %d baud%s\n", CROWN_RX_PIN, BAUD_RATE,
+                  AUTO_BAUD ? " (auto-baud)" : "");
+#if CAPTURE
+    Serial.printf("Crash capture to %s%s\n", capture_storage, strcmp(capture_storage, "none") ? CAPTURE_DIR : "");
+#endif
+#if MULTI_PORT
+    Serial.printf("Port 2 on GPIO%d at %d baud; channel-tagged frames follow (host/demux)\n", PORT2_RX_PIN,
+                  PORT2_BAUD);
+    mux.begin();
+#endif
     Serial.println("--- Log output below ---\n");
+
+    last_stats = bridge.stats();
+}
+
+// Tail view: one line of status and the rate sparkline above the log
+static void drawStatusLine(const UartBridge::Stats& s, uint32_t rate, uint32_t lost) {
+    char rateText[8];
+    if (rate < 10000) snprintf(rateText, sizeof(rateText), "%lu", (unsigned long)rate);
+    else snprintf(rateText, sizeof(rateText), "%luK", (unsigned long)(rate / 1000));
+    M5Cardputer.Display.setTextSize(1);
+    M5Cardputer.Display.setCursor(0, 0);
+    M5Cardputer.Display.setTextColor(lost || s.frameErrors ? TFT_RED
+                                     : autoBaud.state() == AutoBaud::SEARCHING ? TFT_YELLOW
+                                                                                : TFT_GREEN,
+                                     TFT_BLACK);
+    // Fixed width (29 glyphs, left of the sparkline), so no fillRect is needed
+    M5Cardputer.Display.printf("%-7lu%5sB/s R%2lu%% L%-3lu C%-2lu", (unsigned long)bridge.baud(), rateText,
+                               (unsigned long)(bridge.rxRingUsed() * 100 / bridge.rxRingSize()),
+                               (unsigned long)min(lost, (uint32_t)999),
+                               (unsigned long)min(capture.stats().saved, (uint32_t)99));
+    sparkline.draw(&M5Cardputer.Display, 240 - RateSparkline::SAMPLES, 0, 9, TFT_CYAN);
+}
+
+// Rates over the last interval, ring fill and loss counters
+void drawStatus(uint32_t elapsedMs) {
+    UartBridge::Stats s = bridge.stats();
+    uint32_t rate = (uint32_t)((uint64_t)(s.uartToUsb - last_stats.uartToUsb) * 1000 / elapsedMs);
+    uint32_t txRate = (uint32_t)((uint64_t)(s.usbToUart - last_stats.usbToUart) * 1000 / elapsedMs);
+    if (rate > peak_rate) peak_rate = rate;
+    uint32_t lost = s.fifoOverflows + s.bufferFull + s.ringDropped;
+    last_rate = rate;
+    sparkline.add(rate);
+    if (tail_view) {
+        drawStatusLine(s, rate, lost);
+        last_stats = s;
+        return;
+    }
+
+    // Baud line from setup()
+    static const char* const modes[] = {"", " auto?", " auto"};
+    M5Cardputer.Display.fillRect(0, 36, 240, 12, TFT_BLACK);
+    M5Cardputer.Display.setCursor(0, 36);
+    M5Cardputer.Display.setTextColor(autoBaud.state() == AutoBaud::SEARCHING ? TFT_YELLOW : TFT_GREEN,
+                                     TFT_BLACK);
+    M5Cardputer.Display.printf("Baud: %lu%s", (unsigned long)bridge.baud(), modes[autoBaud.state()]);
+
+#if CAPTURE
+    // Capture line (replaces "Waiting for data...")
+    static const char* const capStates[] = {"", " pending", " saving"};
+    const LogCapture::Stats& cs = capture.stats();
+    M5Cardputer.Display.fillRect(0, 48, 240, 12, TFT_BLACK);
+    M5Cardputer.Display.setCursor(0, 48);
+    M5Cardputer.Display.setTextColor(capture.state() != LogCapture::IDLE ? TFT_YELLOW
+                                     : cs.saved                         ? TFT_ORANGE
+                                                                        : TFT_GREEN,
+                                     TFT_BLACK);
+    M5Cardputer.Display.printf("Cap %s: %lu saved%s", capture_storage, (unsigned long)cs.saved,
+                               capStates[capture.state()]);
+#endif
+
+    M5Cardputer.Display.fillRect(0, 70, 240, 65, TFT_BLACK);
+    M5Cardputer.Display.setCursor(0, 70);
+    M5Cardputer.Display.setTextColor(TFT_GREEN, TFT_BLACK);
+    M5Cardputer.Display.printf("In %lu B/s pk %lu\n", (unsigned long)rate, (unsigned long)peak_rate);
+    M5Cardputer.Display.printf("Out %lu B/s  T: %lus\n", (unsigned long)txRate, millis() / 1000);
+    M5Cardputer.Display.printf("Ring %lu%% pk %lu%%\n",
+                               (unsigned long)(bridge.rxRingUsed() * 100 / bridge.rxRingSize()),
+                               (unsigned long)(s.ringPeak * 100 / bridge.rxRingSize()));
+    M5Cardputer.Display.setTextColor(lost || s.frameErrors ? TFT_RED : TFT_GREEN, TFT_BLACK);
+    M5Cardputer.Display.printf("Ovf %lu Full %lu Drop %lu Fe %lu",
+                               (unsigned long)s.fifoOverflows, (unsigned long)s.bufferFull,
+                               (unsigned long)s.ringDropped, (unsigned long)s.frameErrors);
+#if MULTI_PORT
+    static UartBridge::Stats last2;
+    UartBridge::Stats s2 = bridge2.stats();
+    uint32_t lost2 = s2.fifoOverflows + s2.bufferFull + s2.ringDropped;
+    M5Cardputer.Display.setTextColor(lost2 || s2.frameErrors ? TFT_RED : TFT_GREEN, TFT_BLACK);
+    M5Cardputer.Display.printf("\nP2 %lu B/s Drop %lu Fe %lu",
+                               (unsigned long)((uint64_t)(s2.uartToUsb - last2.uartToUsb) * 1000 / elapsedMs),
+                               (unsigned long)lost2, (unsigned long)s2.frameErrors);
+    last2 = s2;
+#endif
+    last_stats = s;
 }
 
 void loop() {
-    while (CrownSerial.available()) {
-        int c = CrownSerial.read();
-        Serial.write(c);
-        bytes_received++;
+    // CrowPanel -> Mac and Mac -> CrowPanel (interactive console)
+    bridge.service();
+#if MULTI_PORT
+    bridge2.service();
+#endif
+    sendReply();
+
+    uint32_t hb = host_baud;
+    if (hb) {
+        host_baud = 0;
+        if (hb == HOST_AUTO_BAUD) autoBaud.search();
+        else if (hb >= 9600 && hb != bridge.baud()) autoBaud.fix(hb);
+    }
+    autoBaud.service(millis());
+    capture.service(millis());
+
+    if (millis() - last_keyboard_ms >= KEYBOARD_INTERVAL_MS) {
+        last_keyboard_ms = millis();
+        M5Cardputer.update();
+        if (M5Cardputer.Keyboard.isChange()) {
+            if (M5Cardputer.Keyboard.isKeyPressed(AUTO_BAUD_KEY)) autoBaud.search();
+            if (M5Cardputer.Keyboard.isKeyPressed(CAPTURE_KEY)) capture.triggerNow();
+#if LOG_TAIL
+            if (M5Cardputer.Keyboard.isKeyPressed(VIEW_KEY)) setView(!tail_view);
+#endif
+        }
     }
 
-    // Forward Mac -> CrowPanel (for interactive console)
-    while (Serial.available()) {
-        int c = Serial.read();
-        CrownSerial.write(c);
+    // After the bridge: skipped while its ring is filling
+    if (tail_view) {
+        logTail.service(millis(), last_rate, (uint8_t)(bridge.rxRingUsed() * 100 / bridge.rxRingSize()));
     }
 
-    if (millis() - last_status_ms > 5000) {
-        last_status_ms = millis();
-        M5Cardputer.Display.fillRect(0, 70, 240, 30, TFT_BLACK);
-        M5Cardputer.Display.setCursor(0, 70);
-        M5Cardputer.Display.printf("Bytes: %lu  T: %lus", bytes_received, millis() / 1000);
+    uint32_t now = millis();
+    if (now - last_status_ms >= STATUS_INTERVAL_MS) {
+        drawStatus(now - last_status_ms);
+        last_status_ms = now;
     }
 }